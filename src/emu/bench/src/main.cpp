@@ -0,0 +1,418 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project 
+ * (see bentokun.github.com/EKA2L1).
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <common/algorithm.h>
+#include <common/arghandler.h>
+#include <common/log.h>
+#include <common/path.h>
+#include <common/pystr.h>
+
+#include <config/config.h>
+#include <cpu/arm_interface.h>
+#include <drivers/audio/audio.h>
+#include <drivers/graphics/backend/null/graphics_null.h>
+#include <drivers/graphics/graphics.h>
+#include <epoc/epoc.h>
+
+#include <kernel/kernel.h>
+#include <kernel/libmanager.h>
+#include <kernel/process.h>
+#include <kernel/scheduler.h>
+#include <kernel/thread.h>
+#include <kernel/timing.h>
+
+#include <manager/device_manager.h>
+#include <manager/manager.h>
+
+#include <services/applist/applist.h>
+#include <services/window/classes/wingroup.h>
+#include <services/window/screen.h>
+#include <services/window/window.h>
+
+#include <fmt/format.h>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+
+using namespace eka2l1;
+
+// The S60 application shell, which is what the user sees as home screen
+static constexpr std::uint32_t DEFAULT_HOME_APP_UID = 0x101F4CD2;
+static constexpr std::uint32_t DEFAULT_GUEST_SECONDS = 30;
+static constexpr std::uint32_t DEFAULT_DUMP_FPS = 10;
+
+struct bench_options {
+    std::uint32_t app_uid = DEFAULT_HOME_APP_UID;
+    std::uint32_t guest_seconds = DEFAULT_GUEST_SECONDS;
+    bool deterministic = false;
+    bool software_rendering = false;
+    std::string dump_folder;
+    std::uint32_t dump_fps = DEFAULT_DUMP_FPS;
+};
+
+struct bench_state {
+    kernel::process *target = nullptr;
+
+    std::uint64_t ipc_messages = 0;
+
+    bool home_reached = false;
+    std::uint64_t home_guest_us = 0;
+    std::uint64_t home_host_us = 0;
+
+    ntimer *timing = nullptr;
+    std::chrono::steady_clock::time_point host_start;
+};
+
+static bool app_option_handler(common::arg_parser *parser, void *userdata, std::string *err) {
+    const char *tok = parser->next_token();
+
+    if (!tok) {
+        *err = "No application UID specified";
+        return false;
+    }
+
+    reinterpret_cast<bench_options *>(userdata)->app_uid = common::pystr(tok).as_int<std::uint32_t>();
+    return true;
+}
+
+static bool seconds_option_handler(common::arg_parser *parser, void *userdata, std::string *err) {
+    const char *tok = parser->next_token();
+
+    if (!tok) {
+        *err = "No duration specified";
+        return false;
+    }
+
+    reinterpret_cast<bench_options *>(userdata)->guest_seconds = common::pystr(tok).as_int<std::uint32_t>();
+    return true;
+}
+
+static bool deterministic_option_handler(common::arg_parser *parser, void *userdata, std::string *err) {
+    reinterpret_cast<bench_options *>(userdata)->deterministic = true;
+    return true;
+}
+
+static bool software_option_handler(common::arg_parser *parser, void *userdata, std::string *err) {
+    reinterpret_cast<bench_options *>(userdata)->software_rendering = true;
+    return true;
+}
+
+static bool dump_option_handler(common::arg_parser *parser, void *userdata, std::string *err) {
+    const char *tok = parser->next_token();
+
+    if (!tok) {
+        *err = "No dump folder specified";
+        return false;
+    }
+
+    bench_options *options = reinterpret_cast<bench_options *>(userdata);
+
+    // Frames can only be dumped if they are rendered
+    options->dump_folder = tok;
+    options->software_rendering = true;
+
+    return true;
+}
+
+static bool dump_fps_option_handler(common::arg_parser *parser, void *userdata, std::string *err) {
+    const char *tok = parser->next_token();
+
+    if (!tok) {
+        *err = "No dump frame rate specified";
+        return false;
+    }
+
+    reinterpret_cast<bench_options *>(userdata)->dump_fps = common::max<std::uint32_t>(
+        common::pystr(tok).as_int<std::uint32_t>(), 1);
+
+    return true;
+}
+
+static bool help_option_handler(common::arg_parser *parser, void *userdata, std::string *err) {
+    fmt::print("Usage: eka2l1_bench [options]\n{}", parser->get_help_string());
+
+    // Stop without error
+    return false;
+}
+
+static void on_focus_change(void *userdata, epoc::window_group *focus) {
+    bench_state *state = reinterpret_cast<bench_state *>(userdata);
+
+    if (state->home_reached || !focus || !focus->client) {
+        return;
+    }
+
+    kernel::thread *owner = focus->client->get_client();
+
+    if (!owner || (owner->owning_process() != state->target)) {
+        return;
+    }
+
+    state->home_reached = true;
+    state->home_guest_us = state->timing->microseconds();
+    state->home_host_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - state->host_start)
+                              .count();
+}
+
+static void present_screen(drivers::graphics_driver *driver, window_server *winserv) {
+    // Only the first screen is dumped, the swapchain can't hold more than one
+    epoc::screen *scr = winserv->get_screen(-1);
+
+    if (!scr || !scr->screen_texture) {
+        return;
+    }
+
+    auto cmd_list = driver->new_command_list();
+    auto cmd_builder = driver->new_command_builder(cmd_list.get());
+
+    int status = -100;
+
+    {
+        const std::lock_guard<std::mutex> guard(scr->screen_mutex);
+        const eka2l1::vec2 size = scr->size();
+
+        cmd_builder->set_swapchain_size(size);
+        cmd_builder->bind_bitmap(0);
+        cmd_builder->clear({ 0, 0, 0, 0xFF }, drivers::draw_buffer_bit_color_buffer);
+        cmd_builder->draw_bitmap(scr->screen_texture, 0, eka2l1::rect({ 0, 0 }, size), eka2l1::rect({ 0, 0 }, { 0, 0 }));
+        cmd_builder->present(&status);
+    }
+
+    driver->submit_command_list(*cmd_list);
+    driver->wait_for(&status);
+}
+
+static bool boot_system(eka2l1::system *symsys, config::state &conf) {
+    manager::device_manager *dvcmngr = symsys->get_manager_system()->get_device_manager();
+
+    if (dvcmngr->total() == 0) {
+        LOG_ERROR("No device is installed");
+        return false;
+    }
+
+    symsys->startup();
+
+    if (!symsys->set_device(conf.device)) {
+        LOG_ERROR("Device index {} is out of range", conf.device);
+        return false;
+    }
+
+    symsys->mount(drive_c, drive_media::physical, eka2l1::add_path(conf.storage, "/drives/c/"), io_attrib::internal);
+    symsys->mount(drive_d, drive_media::physical, eka2l1::add_path(conf.storage, "/drives/d/"), io_attrib::internal);
+    symsys->mount(drive_e, drive_media::physical, eka2l1::add_path(conf.storage, "/drives/e/"), io_attrib::removeable);
+
+    manager::device *dvc = dvcmngr->get_current();
+    LOG_INFO("Device being used: {} ({})", dvc->model, dvc->firmware_code);
+
+    if (!symsys->load_rom(add_path(conf.storage, add_path("roms", add_path(
+            common::lowercase_string(dvc->firmware_code), "SYM.ROM"))))) {
+        LOG_ERROR("Unable to load the ROM of the device");
+        return false;
+    }
+
+    symsys->mount(drive_z, drive_media::rom,
+        eka2l1::add_path(conf.storage, "/drives/z/"), io_attrib::internal | io_attrib::write_protected);
+
+    symsys->get_lib_manager()->load_patch_libraries(".//patch//");
+    return true;
+}
+
+static kernel::process *launch_app(eka2l1::system *symsys, const std::uint32_t uid) {
+    kernel_system *kern = symsys->get_kernel_system();
+    eka2l1::applist_server *svr = reinterpret_cast<eka2l1::applist_server *>(kern->get_by_name<service::server>(
+        get_app_list_server_name_by_epocver(kern->get_epoc_version())));
+
+    if (!svr) {
+        LOG_ERROR("Can't get app list server");
+        return nullptr;
+    }
+
+    eka2l1::apa_app_registry *registry = svr->get_registration(uid);
+
+    if (!registry) {
+        LOG_ERROR("App with UID 0x{:X} doesn't exist", uid);
+        return nullptr;
+    }
+
+    process_ptr pr = kern->spawn_new_process(registry->mandatory_info.app_path.to_std_string(nullptr), u"");
+
+    if (!pr) {
+        return nullptr;
+    }
+
+    pr->run();
+    return &(*pr);
+}
+
+int main(int argc, char **argv) {
+    eka2l1::log::setup_log(nullptr);
+
+    // Same layout as the emulator itself, so data and patches are found
+    eka2l1::set_current_directory(eka2l1::file_directory(argv[0]));
+
+    bench_options options;
+    common::arg_parser parser(argc, argv);
+
+    parser.add("--app, --a", "UID of the application to launch. Defaults to the application shell.", app_option_handler);
+    parser.add("--seconds, --s", "Guest seconds to run for, unless the application exits first.", seconds_option_handler);
+    parser.add("--deterministic", "Derive guest time from executed instructions.", deterministic_option_handler);
+    parser.add("--software", "Execute draws on the CPU instead of dropping them.", software_option_handler);
+    parser.add("--dump", "Folder to dump frames of the screen to as BMP files. Implies --software.", dump_option_handler);
+    parser.add("--dump-fps", "Frames to dump per guest second. Defaults to 10.", dump_fps_option_handler);
+    parser.add("--help, --h", "Display this help.", help_option_handler);
+
+    if (argc > 1) {
+        std::string err;
+
+        if (!parser.parse(&options, &err)) {
+            if (!err.empty()) {
+                LOG_ERROR("{}", err);
+                return -1;
+            }
+
+            return 0;
+        }
+    }
+
+    config::state conf;
+    conf.deserialize();
+
+    if (options.deterministic) {
+        conf.deterministic_timing = true;
+    }
+
+    std::unique_ptr<eka2l1::system> symsys = std::make_unique<eka2l1::system>(nullptr, nullptr, &conf);
+
+    if (!boot_system(symsys.get(), conf)) {
+        return -2;
+    }
+
+    // Nothing is shown or heard, but everything still flows through the drivers
+    drivers::graphics_driver_ptr graphics_driver = drivers::create_graphics_driver(drivers::graphic_api::null);
+    std::unique_ptr<drivers::audio_driver> audio_driver = drivers::make_audio_driver(drivers::audio_driver_backend::null);
+
+    drivers::null_graphics_driver *null_driver = reinterpret_cast<drivers::null_graphics_driver *>(graphics_driver.get());
+    null_driver->set_software_rendering(options.software_rendering);
+    null_driver->set_frame_dump_folder(options.dump_folder);
+
+    symsys->set_graphics_driver(graphics_driver.get());
+    symsys->set_audio_driver(audio_driver.get());
+
+    std::thread graphics_thread([&]() { graphics_driver->run(); });
+
+    kernel_system *kern = symsys->get_kernel_system();
+    hle::lib_manager *libmngr = symsys->get_lib_manager();
+    ntimer *timing = symsys->get_ntimer();
+
+    bench_state state;
+    state.timing = timing;
+
+    kern->register_ipc_send_callback([&](const std::string &, const int, const ipc_arg &, kernel::thread *) {
+        state.ipc_messages++;
+    });
+
+    window_server *winserv = reinterpret_cast<window_server *>(kern->get_by_name<service::server>(
+        eka2l1::get_winserv_name_by_epocver(symsys->get_symbian_version_use())));
+
+    if (winserv) {
+        for (epoc::screen *scr = winserv->get_screen(-1); scr; scr = scr->next) {
+            scr->add_focus_change_callback(&state, on_focus_change);
+        }
+    }
+
+    libmngr->reset_svc_stats();
+
+    state.host_start = std::chrono::steady_clock::now();
+    state.target = launch_app(symsys.get(), options.app_uid);
+
+    if (!state.target) {
+        graphics_driver->abort();
+        graphics_thread.join();
+
+        return -3;
+    }
+
+    const std::uint64_t guest_start_us = timing->microseconds();
+    const std::uint64_t guest_limit_us = static_cast<std::uint64_t>(options.guest_seconds) * 1000000;
+
+    const std::uint64_t dump_interval_us = 1000000 / options.dump_fps;
+    std::uint64_t next_dump_us = guest_start_us;
+
+    while ((timing->microseconds() - guest_start_us) < guest_limit_us) {
+        if (symsys->loop() == 0) {
+            break;
+        }
+
+        if (winserv && !options.dump_folder.empty() && (timing->microseconds() >= next_dump_us)) {
+            present_screen(graphics_driver.get(), winserv);
+            next_dump_us = timing->microseconds() + dump_interval_us;
+        }
+
+        if (state.target->get_exit_type() != kernel::entity_exit_type::pending) {
+            LOG_INFO("Application exited");
+            break;
+        }
+    }
+
+    const std::uint64_t host_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - state.host_start)
+                                      .count();
+    const std::uint64_t guest_us = timing->microseconds() - guest_start_us;
+
+    std::uint64_t svc_calls = 0;
+
+    libmngr->visit_svcs([&](const sid, const hle::svc_info &info) {
+        svc_calls += info.call_count_;
+    });
+
+    const double host_seconds = static_cast<double>(common::max<std::uint64_t>(host_us, 1)) / 1000000.0;
+    const std::uint64_t instructions = symsys->get_instructions_executed();
+
+    // One metric per line, so CI can grep or parse them as YAML
+    fmt::print("guest_seconds: {:.3f}\n", guest_us / 1000000.0);
+    fmt::print("host_seconds: {:.3f}\n", host_seconds);
+    fmt::print("instructions: {}\n", instructions);
+    fmt::print("instructions_per_second: {:.0f}\n", instructions / host_seconds);
+    fmt::print("svc_calls: {}\n", svc_calls);
+    fmt::print("ipc_messages: {}\n", state.ipc_messages);
+    fmt::print("ipc_messages_per_second: {:.1f}\n", state.ipc_messages / host_seconds);
+    fmt::print("context_switches: {}\n", kern->get_thread_scheduler()->total_context_switches());
+    fmt::print("jit_translation_caches: {}\n", symsys->get_cpu()->get_translation_cache_count());
+
+    if (state.home_reached) {
+        fmt::print("time_to_home_guest_seconds: {:.3f}\n", (state.home_guest_us - guest_start_us) / 1000000.0);
+        fmt::print("time_to_home_host_seconds: {:.3f}\n", state.home_host_us / 1000000.0);
+    } else {
+        fmt::print("time_to_home_guest_seconds: -1\n");
+        fmt::print("time_to_home_host_seconds: -1\n");
+    }
+
+    // The system may still queue commands to the driver while it dies
+    symsys.reset();
+
+    graphics_driver->abort();
+    graphics_thread.join();
+
+    return 0;
+}
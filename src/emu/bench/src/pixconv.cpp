@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project
+ * (see bentokun.github.com/EKA2L1).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Micro-benchmark of the pixel conversion kernels, for each instruction set the host supports.
+
+#include <common/arghandler.h>
+#include <common/cpudetect.h>
+#include <common/log.h>
+#include <common/pixconv.h>
+#include <common/pystr.h>
+
+#include <fmt/format.h>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace eka2l1;
+
+// A portrait S60v3 screen
+static constexpr std::uint32_t DEFAULT_WIDTH = 240;
+static constexpr std::uint32_t DEFAULT_HEIGHT = 320;
+static constexpr std::uint32_t DEFAULT_ITERATIONS = 200;
+
+struct pixconv_bench_options {
+    std::uint32_t width = DEFAULT_WIDTH;
+    std::uint32_t height = DEFAULT_HEIGHT;
+    std::uint32_t iterations = DEFAULT_ITERATIONS;
+};
+
+static bool parse_number_option(common::arg_parser *parser, std::uint32_t &result, std::string *err) {
+    const char *value = parser->next_token();
+
+    if (!value) {
+        *err = "Missing value for option";
+        return false;
+    }
+
+    result = common::pystr(value).as_int<std::uint32_t>();
+
+    if (result == 0) {
+        *err = "Value must be a positive number";
+        return false;
+    }
+
+    return true;
+}
+
+static bool width_option_handler(common::arg_parser *parser, void *userdata, std::string *err) {
+    return parse_number_option(parser, reinterpret_cast<pixconv_bench_options *>(userdata)->width, err);
+}
+
+static bool height_option_handler(common::arg_parser *parser, void *userdata, std::string *err) {
+    return parse_number_option(parser, reinterpret_cast<pixconv_bench_options *>(userdata)->height, err);
+}
+
+static bool iterations_option_handler(common::arg_parser *parser, void *userdata, std::string *err) {
+    return parse_number_option(parser, reinterpret_cast<pixconv_bench_options *>(userdata)->iterations, err);
+}
+
+static bool help_option_handler(common::arg_parser *parser, void *userdata, std::string *err) {
+    fmt::print("Usage: eka2l1_pixconv_bench [options]\n{}", parser->get_help_string());
+    return false;
+}
+
+static const char *isa_to_string(const common::pixel_convert_isa isa) {
+    switch (isa) {
+    case common::pixel_convert_isa_scalar:
+        return "scalar";
+
+    case common::pixel_convert_isa_sse2:
+        return "sse2";
+
+    case common::pixel_convert_isa_avx2:
+        return "avx2";
+
+    case common::pixel_convert_isa_neon:
+        return "neon";
+
+    default:
+        break;
+    }
+
+    return "unknown";
+}
+
+int main(int argc, char **argv) {
+    eka2l1::log::setup_log(nullptr);
+
+    pixconv_bench_options options;
+    common::arg_parser parser(argc, argv);
+
+    parser.add("--width, --w", "Width of the converted image in pixels. Defaults to 240.", width_option_handler);
+    parser.add("--height, --h", "Height of the converted image in pixels. Defaults to 320.", height_option_handler);
+    parser.add("--iterations, --i", "Number of times each kernel converts the image. Defaults to 200.", iterations_option_handler);
+    parser.add("--help", "Display this help.", help_option_handler);
+
+    if (argc > 1) {
+        std::string err;
+
+        if (!parser.parse(&options, &err)) {
+            if (!err.empty()) {
+                LOG_ERROR("{}", err);
+                return -1;
+            }
+
+            return 0;
+        }
+    }
+
+    const std::size_t width = options.width;
+    const std::size_t height = options.height;
+
+    // Source is big enough for the widest format, 32 bpp
+    std::vector<std::uint8_t> source(width * height * 4);
+    std::vector<std::uint32_t> dest(width * height);
+    std::vector<std::uint32_t> palette(256);
+
+    std::mt19937 rng(0x5EED);
+
+    for (auto &byte : source) {
+        byte = static_cast<std::uint8_t>(rng());
+    }
+
+    for (auto &color : palette) {
+        color = rng() & 0xFFFFFF;
+    }
+
+    const common::cpu_info &host = common::get_host_cpu_info();
+
+    fmt::print("cpu: {}\n", host.brand_string);
+    fmt::print("image: {}x{}\n", width, height);
+    fmt::print("best: {}\n", common::get_best_pixel_convert_kernels().name);
+
+    for (int isa = 0; isa < common::pixel_convert_isa_count; isa++) {
+        const common::pixel_convert_isa isa_enum = static_cast<common::pixel_convert_isa>(isa);
+        const common::pixel_convert_kernels *kernels = common::get_pixel_convert_kernels(isa_enum);
+
+        if (!kernels) {
+            continue;
+        }
+
+        // Each kernel converts the image row by row, the same way the window server bitmap cache does.
+        // The source stride is the one of the format, rounded up to a word like Symbian bitmaps.
+        const auto run = [&](const char *kernel_name, const std::size_t source_bits_per_pixel,
+                             const std::function<void(std::uint32_t *, const std::uint8_t *)> &convert_row) {
+            const std::size_t stride = ((width * source_bits_per_pixel + 31) / 32) * 4;
+            const auto start = std::chrono::steady_clock::now();
+
+            for (std::uint32_t i = 0; i < options.iterations; i++) {
+                for (std::size_t y = 0; y < height; y++) {
+                    convert_row(dest.data() + y * width, source.data() + y * stride);
+                }
+            }
+
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            const double mpixels = static_cast<double>(width * height) * options.iterations / 1000000.0;
+
+            fmt::print("{}.{}_mpixels_per_second: {:.1f}\n", isa_to_string(isa_enum), kernel_name, mpixels / seconds);
+        };
+
+        for (const int bpp : { 1, 2, 4, 8 }) {
+            const std::string name = fmt::format("palette{}", bpp);
+
+            run(name.c_str(), bpp, [&](std::uint32_t *dest_row, const std::uint8_t *source_row) {
+                kernels->palette_to_bgra(dest_row, source_row, width, bpp, palette.data());
+            });
+        }
+
+        run("color4k", 16, [&](std::uint32_t *dest_row, const std::uint8_t *source_row) {
+            kernels->color4k_to_bgra(dest_row, reinterpret_cast<const std::uint16_t *>(source_row), width);
+        });
+
+        run("color64k", 16, [&](std::uint32_t *dest_row, const std::uint8_t *source_row) {
+            kernels->color64k_to_bgra(dest_row, reinterpret_cast<const std::uint16_t *>(source_row), width);
+        });
+
+        run("bgr", 24, [&](std::uint32_t *dest_row, const std::uint8_t *source_row) {
+            kernels->bgr_to_bgra(dest_row, source_row, width);
+        });
+
+        run("swap_red_blue", 32, [&](std::uint32_t *dest_row, const std::uint8_t *source_row) {
+            kernels->swap_red_blue(dest_row, reinterpret_cast<const std::uint32_t *>(source_row), width);
+        });
+
+        run("fill_alpha", 32, [&](std::uint32_t *dest_row, const std::uint8_t *source_row) {
+            kernels->fill_alpha(dest_row, reinterpret_cast<const std::uint32_t *>(source_row), width);
+        });
+    }
+
+    return 0;
+}
@@ -25,6 +25,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <mutex>
 #include <vector>
 
@@ -106,4 +107,91 @@ namespace eka2l1::common {
          */
         int allocated_count(const std::uint32_t offset, const std::uint32_t offset_end);
     };
+
+    /**
+     * \brief Thread-safe pool of fixed-size memory chunks.
+     *
+     * Chunks given back are kept for the next acquire instead of being freed, so a steady
+     * stream of short-lived arenas stops hitting the heap once the pool is warm.
+     */
+    class chunk_pool {
+        std::vector<std::uint8_t *> free_chunks_;
+        std::size_t chunk_size_;
+        std::mutex lock_;
+
+    public:
+        explicit chunk_pool(const std::size_t chunk_size);
+        ~chunk_pool();
+
+        chunk_pool(const chunk_pool &) = delete;
+        chunk_pool &operator=(const chunk_pool &) = delete;
+
+        std::size_t chunk_size() const {
+            return chunk_size_;
+        }
+
+        std::uint8_t *acquire();
+        void release(std::uint8_t *chunk);
+    };
+
+    using chunk_pool_ptr = std::shared_ptr<chunk_pool>;
+
+    /**
+     * \brief Linear allocator growing by chunks taken from a pool.
+     *
+     * Memory handed out never moves and is never freed one by one. Everything goes back to the
+     * pool at once on reset or destruction. Requests bigger than a chunk get a dedicated block,
+     * which is freed instead of pooled. Chunks are kept in allocation order.
+     *
+     * An arena is only meant to be used by one thread at a time, but may be moved to another thread.
+     */
+    class linear_arena {
+    public:
+        struct chunk {
+            std::uint8_t *data_;
+            std::size_t size_;
+            std::size_t used_;
+        };
+
+    private:
+        chunk_pool_ptr pool_;
+        std::vector<chunk> chunks_;
+
+        void free_chunk(chunk &target);
+
+    public:
+        explicit linear_arena(chunk_pool_ptr pool = nullptr);
+        ~linear_arena();
+
+        linear_arena(const linear_arena &) = delete;
+        linear_arena &operator=(const linear_arena &) = delete;
+
+        linear_arena(linear_arena &&rhs);
+        linear_arena &operator=(linear_arena &&rhs);
+
+        /**
+         * \brief Allocate memory from the arena.
+         *
+         * Without a pool, chunks are allocated from the heap with the default chunk size.
+         *
+         * \param size       Number of bytes to allocate.
+         * \param alignment  Alignment of the returned pointer. Must be a power of two no larger than 16.
+         *
+         * \returns Pointer to the allocated memory.
+         */
+        void *allocate(const std::size_t size, const std::size_t alignment = 8);
+
+        /**
+         * \brief Give all memory back. Any pointer allocated before becomes invalid.
+         */
+        void reset();
+
+        const std::vector<chunk> &chunks() const {
+            return chunks_;
+        }
+
+        bool empty() const {
+            return chunks_.empty();
+        }
+    };
 }
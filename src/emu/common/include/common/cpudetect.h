@@ -104,8 +104,14 @@ namespace eka2l1::common {
         // Turn the cpu info into a string we can show
         // std::string summarize();
 
-    private:
-        // Detects the various cpu features
+        // Detects the various cpu features of the host
         void detect();
     };
+
+    /**
+     * \brief Get the features of the CPU this program is running on.
+     *
+     * Detection is done once, on the first call.
+     */
+    const cpu_info &get_host_cpu_info();
 }
\ No newline at end of file
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace eka2l1::common {
+    /**
+     * \brief Instruction sets the pixel conversion kernels are written for.
+     */
+    enum pixel_convert_isa {
+        pixel_convert_isa_scalar,
+        pixel_convert_isa_sse2,
+        pixel_convert_isa_avx2,
+        pixel_convert_isa_neon,
+        pixel_convert_isa_count
+    };
+
+    /**
+     * \brief Row converters from Symbian pixel formats to 32 bpp BGRA.
+     *
+     * The destination pixel is a little endian word 0xAARRGGBB, which in memory is B, G, R, A.
+     * All functions convert one row of pixels. Source and destination don't need to be aligned.
+     * Sub-byte pixels are packed starting from the least significant bits, like Symbian does.
+     */
+    struct pixel_convert_kernels {
+        const char *name;
+
+        /**
+         * \brief Convert palette indexed pixels. Destination alpha is set to 0xFF.
+         *
+         * \param dest     Destination row.
+         * \param source   Source row.
+         * \param width    Number of pixels to convert.
+         * \param bpp      Bits per pixel of the source. Must be 1, 2, 4 or 8.
+         * \param palette  Palette with (1 << bpp) entries, each one in form of 0x00RRGGBB.
+         */
+        void (*palette_to_bgra)(std::uint32_t *dest, const std::uint8_t *source, const std::size_t width,
+            const int bpp, const std::uint32_t *palette);
+
+        /**
+         * \brief Convert 12 bpp pixels (0x0RGB, 4 bits each) to BGRA. Destination alpha is set to 0xFF.
+         */
+        void (*color4k_to_bgra)(std::uint32_t *dest, const std::uint16_t *source, const std::size_t width);
+
+        /**
+         * \brief Convert 16 bpp 565 pixels to BGRA. Destination alpha is set to 0xFF.
+         */
+        void (*color64k_to_bgra)(std::uint32_t *dest, const std::uint16_t *source, const std::size_t width);
+
+        /**
+         * \brief Convert 24 bpp BGR pixels to BGRA. Destination alpha is set to 0xFF.
+         */
+        void (*bgr_to_bgra)(std::uint32_t *dest, const std::uint8_t *source, const std::size_t width);
+
+        /**
+         * \brief Swap red and blue channel of 32 bpp pixels, turning BGRA to RGBA and vice versa.
+         */
+        void (*swap_red_blue)(std::uint32_t *dest, const std::uint32_t *source, const std::size_t width);
+
+        /**
+         * \brief Copy 32 bpp pixels, setting the alpha channel to 0xFF.
+         */
+        void (*fill_alpha)(std::uint32_t *dest, const std::uint32_t *source, const std::size_t width);
+    };
+
+    /**
+     * \brief Get the kernels written for an instruction set.
+     *
+     * \returns Nullptr if the kernels are not built for this architecture, or the host CPU
+     *          does not support the instruction set.
+     */
+    const pixel_convert_kernels *get_pixel_convert_kernels(const pixel_convert_isa isa);
+
+    /**
+     * \brief Get the fastest kernels the host CPU supports.
+     *
+     * The choice is made once through the host CPU info.
+     */
+    const pixel_convert_kernels &get_best_pixel_convert_kernels();
+}
@@ -96,6 +96,11 @@ namespace eka2l1 {
             queue.push(val);
         }
 
+        void push(T &&val) {
+            const std::lock_guard<std::mutex> guard(lock);
+            queue.push(std::move(val));
+        }
+
         std::optional<T> pop() {
             const std::lock_guard<std::mutex> guard(lock);
 
@@ -184,6 +189,24 @@ namespace eka2l1 {
             queue_empty_cond_.notify_one();
         }
 
+        void push(T &&item) {
+            {
+                std::unique_lock<std::mutex> ulock(queue_mut_);
+
+                while (!abort_ && queue_.size() == max_pending_count_) {
+                    queue_cond_.wait(ulock);
+                }
+
+                if (abort_) {
+                    return;
+                }
+
+                queue_.push(std::move(item));
+            }
+
+            queue_empty_cond_.notify_one();
+        }
+
         std::optional<T> pop(const int ms = 0) {
             T item{ T() };
 
@@ -204,7 +227,7 @@ namespace eka2l1 {
                     return std::nullopt;
                 }
 
-                item = queue_.front();
+                item = std::move(queue_.front());
                 queue_.pop();
             }
 
@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project
+ * (see bentokun.github.com/EKA2L1).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace eka2l1::common {
+    /**
+     * \brief Lock-free ring buffer with one producer thread and one consumer thread.
+     *
+     * Storage is allocated once. Neither read nor write ever blocks or allocates, which makes
+     * it suitable to feed real-time threads, such as audio callbacks.
+     *
+     * Only one thread may write, and only one other thread may read at a time.
+     */
+    template <typename T>
+    class spsc_ring_buffer {
+        static_assert(std::is_trivially_copyable_v<T>, "Ring buffer element must be trivially copyable");
+
+        std::vector<T> data_;
+        std::size_t mask_;
+
+        // Both positions only grow; they are wrapped with the mask on access.
+        std::atomic<std::size_t> read_pos_;
+        std::atomic<std::size_t> write_pos_;
+
+    public:
+        explicit spsc_ring_buffer(const std::size_t capacity = 0)
+            : mask_(0)
+            , read_pos_(0)
+            , write_pos_(0) {
+            resize(capacity);
+        }
+
+        /**
+         * \brief Reallocate the buffer and drop its content.
+         *
+         * Capacity is rounded up to the next power of two. Must not be called while any
+         * other thread is reading or writing.
+         */
+        void resize(const std::size_t capacity) {
+            std::size_t real_capacity = 1;
+
+            while (real_capacity < capacity) {
+                real_capacity <<= 1;
+            }
+
+            data_.resize(capacity ? real_capacity : 0);
+            mask_ = capacity ? real_capacity - 1 : 0;
+
+            read_pos_.store(0, std::memory_order_relaxed);
+            write_pos_.store(0, std::memory_order_relaxed);
+        }
+
+        std::size_t capacity() const {
+            return data_.size();
+        }
+
+        /**
+         * \brief Number of elements available to read.
+         */
+        std::size_t size() const {
+            return write_pos_.load(std::memory_order_acquire) - read_pos_.load(std::memory_order_acquire);
+        }
+
+        /**
+         * \brief Number of elements that can be written without overwriting unread data.
+         */
+        std::size_t free_space() const {
+            return data_.size() - size();
+        }
+
+        /**
+         * \brief Write elements to the ring. Only call this from the producer thread.
+         *
+         * \returns Number of elements written, which can be less than requested if the ring is full.
+         */
+        std::size_t write(const T *source, const std::size_t count) {
+            const std::size_t write_pos = write_pos_.load(std::memory_order_relaxed);
+            const std::size_t read_pos = read_pos_.load(std::memory_order_acquire);
+
+            const std::size_t to_write = std::min(count, data_.size() - (write_pos - read_pos));
+
+            if (to_write == 0) {
+                return 0;
+            }
+
+            const std::size_t start = write_pos & mask_;
+            const std::size_t first_part = std::min(to_write, data_.size() - start);
+
+            std::memcpy(&data_[start], source, first_part * sizeof(T));
+
+            if (first_part < to_write) {
+                std::memcpy(&data_[0], source + first_part, (to_write - first_part) * sizeof(T));
+            }
+
+            write_pos_.store(write_pos + to_write, std::memory_order_release);
+            return to_write;
+        }
+
+        /**
+         * \brief Read elements from the ring. Only call this from the consumer thread.
+         *
+         * \returns Number of elements read, which can be less than requested if the ring runs dry.
+         */
+        std::size_t read(T *dest, const std::size_t count) {
+            const std::size_t read_pos = read_pos_.load(std::memory_order_relaxed);
+            const std::size_t write_pos = write_pos_.load(std::memory_order_acquire);
+
+            const std::size_t to_read = std::min(count, write_pos - read_pos);
+
+            if (to_read == 0) {
+                return 0;
+            }
+
+            const std::size_t start = read_pos & mask_;
+            const std::size_t first_part = std::min(to_read, data_.size() - start);
+
+            std::memcpy(dest, &data_[start], first_part * sizeof(T));
+
+            if (first_part < to_read) {
+                std::memcpy(dest + first_part, &data_[0], (to_read - first_part) * sizeof(T));
+            }
+
+            read_pos_.store(read_pos + to_read, std::memory_order_release);
+            return to_read;
+        }
+
+        /**
+         * \brief Drop all unread elements. Only call this from the consumer thread.
+         */
+        void skip_all() {
+            read_pos_.store(write_pos_.load(std::memory_order_acquire), std::memory_order_release);
+        }
+    };
+}
@@ -73,6 +73,12 @@ namespace eka2l1::common {
         virtual void start() = 0;
         virtual void stop() = 0;
 
+        /**
+         * @brief Freeze the time. Time spent paused is not counted after resume.
+         */
+        virtual void pause() = 0;
+        virtual void resume() = 0;
+
         virtual bool set_target_frequency(const std::uint32_t freq) = 0;
 
         virtual std::uint64_t ticks() = 0;
@@ -308,4 +308,109 @@ namespace eka2l1::common {
 
         return allocated_count;
     }
+
+    static constexpr std::size_t DEFAULT_ARENA_CHUNK_SIZE = 16 * 1024;
+
+    chunk_pool::chunk_pool(const std::size_t chunk_size)
+        : chunk_size_(chunk_size) {
+    }
+
+    chunk_pool::~chunk_pool() {
+        for (std::uint8_t *chunk : free_chunks_) {
+            delete[] chunk;
+        }
+    }
+
+    std::uint8_t *chunk_pool::acquire() {
+        {
+            const std::lock_guard<std::mutex> guard(lock_);
+
+            if (!free_chunks_.empty()) {
+                std::uint8_t *chunk = free_chunks_.back();
+                free_chunks_.pop_back();
+
+                return chunk;
+            }
+        }
+
+        return new std::uint8_t[chunk_size_];
+    }
+
+    void chunk_pool::release(std::uint8_t *chunk) {
+        const std::lock_guard<std::mutex> guard(lock_);
+        free_chunks_.push_back(chunk);
+    }
+
+    linear_arena::linear_arena(chunk_pool_ptr pool)
+        : pool_(std::move(pool)) {
+    }
+
+    linear_arena::~linear_arena() {
+        reset();
+    }
+
+    linear_arena::linear_arena(linear_arena &&rhs)
+        : pool_(std::move(rhs.pool_))
+        , chunks_(std::move(rhs.chunks_)) {
+        rhs.chunks_.clear();
+    }
+
+    linear_arena &linear_arena::operator=(linear_arena &&rhs) {
+        if (this != &rhs) {
+            reset();
+
+            pool_ = std::move(rhs.pool_);
+            chunks_ = std::move(rhs.chunks_);
+
+            rhs.chunks_.clear();
+        }
+
+        return *this;
+    }
+
+    void linear_arena::free_chunk(chunk &target) {
+        if (pool_ && (target.size_ == pool_->chunk_size())) {
+            pool_->release(target.data_);
+        } else {
+            delete[] target.data_;
+        }
+    }
+
+    void linear_arena::reset() {
+        for (chunk &target : chunks_) {
+            free_chunk(target);
+        }
+
+        chunks_.clear();
+    }
+
+    void *linear_arena::allocate(const std::size_t size, const std::size_t alignment) {
+        if (!chunks_.empty()) {
+            chunk &last = chunks_.back();
+            const std::size_t offset = common::align(last.used_, static_cast<std::uint32_t>(alignment));
+
+            if (offset + size <= last.size_) {
+                last.used_ = offset + size;
+                return last.data_ + offset;
+            }
+        }
+
+        const std::size_t normal_size = pool_ ? pool_->chunk_size() : DEFAULT_ARENA_CHUNK_SIZE;
+        chunk new_chunk;
+
+        if (size > normal_size) {
+            // Dedicated block, its size can never match the pool's
+            new_chunk.size_ = size;
+            new_chunk.data_ = new std::uint8_t[new_chunk.size_];
+        } else {
+            new_chunk.size_ = normal_size;
+            new_chunk.data_ = pool_ ? pool_->acquire() : new std::uint8_t[normal_size];
+        }
+
+        // Heap blocks are aligned for any fundamental type, which covers what is asked here
+        new_chunk.used_ = size;
+        chunks_.push_back(new_chunk);
+
+        return new_chunk.data_;
+    }
 }
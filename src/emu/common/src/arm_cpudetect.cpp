@@ -25,6 +25,16 @@
 #include <stdio.h>
 #include <string.h>
 
+#include <sstream>
+#include <string>
+
+namespace eka2l1::common {
+template <std::size_t N>
+static void truncate_cpy(char (&dest)[N], const char *source) {
+    strncpy(dest, source, N - 1);
+    dest[N - 1] = '\0';
+}
+
 // Only Linux platforms have /proc/cpuinfo
 #if EKA2L1_PLATFORM(LINUX)
 #include <fstream>
@@ -172,10 +182,6 @@ int get_core_count() {
 }
 #endif
 
-cpu_info::cpu_info() {
-    detect();
-}
-
 // Detects the various cpu features
 void cpu_info::detect() {
     // Set some defaults here
@@ -232,36 +238,38 @@ void cpu_info::detect() {
     bFP = false;
     bASIMD = false;
 #else // EKA2L1_PLATFORM(LINUX)
-    truncate_cpy(cpu_string, GetCPUString().c_str());
-    truncate_cpy(brand_string, GetCPUBrandString().c_str());
-
-    bSwp = CheckCPUFeature("swp");
-    bHalf = CheckCPUFeature("half");
-    bThumb = CheckCPUFeature("thumb");
-    bFastMult = CheckCPUFeature("fastmult");
-    bVFP = CheckCPUFeature("vfp");
-    bEDSP = CheckCPUFeature("edsp");
-    bThumbEE = CheckCPUFeature("thumbee");
-    bNEON = CheckCPUFeature("neon");
-    bVFPv3 = CheckCPUFeature("vfpv3");
-    bTLS = CheckCPUFeature("tls");
-    bVFPv4 = CheckCPUFeature("vfpv4");
-    bIDIVa = CheckCPUFeature("idiva");
-    bIDIVt = CheckCPUFeature("idivt");
+    truncate_cpy(cpu_string, get_cpu_string().c_str());
+    truncate_cpy(brand_string, get_cpu_brand_string().c_str());
+
+    bSwp = check_cpu_feature("swp");
+    bHalf = check_cpu_feature("half");
+    bThumb = check_cpu_feature("thumb");
+    bFastMult = check_cpu_feature("fastmult");
+    bVFP = check_cpu_feature("vfp");
+    bEDSP = check_cpu_feature("edsp");
+    bThumbEE = check_cpu_feature("thumbee");
+    bNEON = check_cpu_feature("neon");
+    bVFPv3 = check_cpu_feature("vfpv3");
+    bTLS = check_cpu_feature("tls");
+    bVFPv4 = check_cpu_feature("vfpv4");
+    bIDIVa = check_cpu_feature("idiva");
+    bIDIVt = check_cpu_feature("idivt");
     // Qualcomm Krait supports IDIVA but it doesn't report it. Check for krait (0x4D = Plus, 0x6F = Pro).
-    unsigned short CPUPart = GetCPUPart();
-    if (GetCPUImplementer() == 0x51 && (CPUPart == 0x4D || CPUPart == 0x6F))
+    unsigned short CPUPart = get_cpu_part();
+    if (get_cpu_implementer() == 0x51 && (CPUPart == 0x4D || CPUPart == 0x6F))
         bIDIVa = bIDIVt = true;
     // These two require ARMv8 or higher
-    bFP = CheckCPUFeature("fp");
-    bASIMD = CheckCPUFeature("asimd");
-    num_cores = GetCoreCount();
+    bFP = check_cpu_feature("fp");
+    bASIMD = check_cpu_feature("asimd");
+    num_cores = get_core_count();
 #endif
-#if PPSSPP_ARCH(ARM64)
+#if EKA2L1_ARCH(ARM64)
     // Whether the above detection failed or not, on ARM64 we do have ASIMD/NEON.
     bNEON = true;
     bASIMD = true;
 #endif
 }
 
-#endif
\ No newline at end of file
+}
+
+#endif
@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <common/cpudetect.h>
+#include <common/platform.h>
+
+#include <cstring>
+
+namespace eka2l1::common {
+#if !(EKA2L1_ARCH(X86) || EKA2L1_ARCH(X64) || EKA2L1_ARCH(ARM) || EKA2L1_ARCH(ARM64))
+    void cpu_info::detect() {
+        // Nothing to detect on this architecture. Only generic code paths will be used.
+        std::memset(static_cast<void *>(this), 0, sizeof(cpu_info));
+
+        vendor = VENDOR_OTHER;
+        num_cores = 1;
+        logical_cpu_count = 1;
+
+        std::strcpy(cpu_string, "Unknown");
+        std::strcpy(brand_string, "Unknown");
+    }
+#endif
+
+    const cpu_info &get_host_cpu_info() {
+        static const cpu_info host_info = []() {
+            cpu_info info;
+            info.detect();
+
+            return info;
+        }();
+
+        return host_info;
+    }
+}
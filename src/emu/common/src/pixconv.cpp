@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <common/cpudetect.h>
+#include <common/pixconv.h>
+
+#include "pixconv_kernels.h"
+
+namespace eka2l1::common::pixconv {
+    void palette_to_bgra_scalar(std::uint32_t *dest, const std::uint8_t *source, const std::size_t width,
+        const int bpp, const std::uint32_t *palette) {
+        if (bpp == 8) {
+            for (std::size_t x = 0; x < width; x++) {
+                dest[x] = OPAQUE_ALPHA | palette[source[x]];
+            }
+
+            return;
+        }
+
+        const std::size_t pixels_per_byte = 8 / bpp;
+        const std::uint8_t index_mask = static_cast<std::uint8_t>((1 << bpp) - 1);
+
+        std::size_t x = 0;
+
+        // Whole bytes first, then the pixels left in the last partial byte
+        for (; x + pixels_per_byte <= width; x += pixels_per_byte) {
+            std::uint8_t packed = source[x / pixels_per_byte];
+
+            for (std::size_t i = 0; i < pixels_per_byte; i++) {
+                dest[x + i] = OPAQUE_ALPHA | palette[packed & index_mask];
+                packed >>= bpp;
+            }
+        }
+
+        if (x < width) {
+            std::uint8_t packed = source[x / pixels_per_byte];
+
+            for (; x < width; x++) {
+                dest[x] = OPAQUE_ALPHA | palette[packed & index_mask];
+                packed >>= bpp;
+            }
+        }
+    }
+
+    void color4k_to_bgra_scalar(std::uint32_t *dest, const std::uint16_t *source, const std::size_t width) {
+        for (std::size_t x = 0; x < width; x++) {
+            const std::uint32_t value = source[x];
+
+            // Each 4-bit channel times 17 spreads it to the full 8-bit range
+            dest[x] = OPAQUE_ALPHA | (((value >> 8) & 0xF) * 17) << 16 | (((value >> 4) & 0xF) * 17) << 8 | ((value & 0xF) * 17);
+        }
+    }
+
+    void color64k_to_bgra_scalar(std::uint32_t *dest, const std::uint16_t *source, const std::size_t width) {
+        for (std::size_t x = 0; x < width; x++) {
+            const std::uint32_t value = source[x];
+
+            const std::uint32_t r = (value >> 11) & 0x1F;
+            const std::uint32_t g = (value >> 5) & 0x3F;
+            const std::uint32_t b = value & 0x1F;
+
+            dest[x] = OPAQUE_ALPHA | ((r << 3) | (r >> 2)) << 16 | ((g << 2) | (g >> 4)) << 8 | ((b << 3) | (b >> 2));
+        }
+    }
+
+    void bgr_to_bgra_scalar(std::uint32_t *dest, const std::uint8_t *source, const std::size_t width) {
+        for (std::size_t x = 0; x < width; x++) {
+            dest[x] = OPAQUE_ALPHA | (static_cast<std::uint32_t>(source[x * 3 + 2]) << 16)
+                | (static_cast<std::uint32_t>(source[x * 3 + 1]) << 8) | source[x * 3];
+        }
+    }
+
+    void swap_red_blue_scalar(std::uint32_t *dest, const std::uint32_t *source, const std::size_t width) {
+        for (std::size_t x = 0; x < width; x++) {
+            const std::uint32_t value = source[x];
+            dest[x] = (value & 0xFF00FF00) | ((value >> 16) & 0xFF) | ((value & 0xFF) << 16);
+        }
+    }
+
+    void fill_alpha_scalar(std::uint32_t *dest, const std::uint32_t *source, const std::size_t width) {
+        for (std::size_t x = 0; x < width; x++) {
+            dest[x] = source[x] | OPAQUE_ALPHA;
+        }
+    }
+
+    const pixel_convert_kernels scalar_kernels = {
+        "Scalar",
+        palette_to_bgra_scalar,
+        color4k_to_bgra_scalar,
+        color64k_to_bgra_scalar,
+        bgr_to_bgra_scalar,
+        swap_red_blue_scalar,
+        fill_alpha_scalar
+    };
+}
+
+namespace eka2l1::common {
+    const pixel_convert_kernels *get_pixel_convert_kernels(const pixel_convert_isa isa) {
+        [[maybe_unused]] const cpu_info &info = get_host_cpu_info();
+
+        switch (isa) {
+        case pixel_convert_isa_scalar:
+            return &pixconv::scalar_kernels;
+
+#if EKA2L1_ARCH(X86) || EKA2L1_ARCH(X64)
+        case pixel_convert_isa_sse2:
+            return info.bSSE2 ? &pixconv::sse2_kernels : nullptr;
+
+        case pixel_convert_isa_avx2:
+            return info.bAVX2 ? &pixconv::avx2_kernels : nullptr;
+#endif
+
+#if EKA2L1_ARCH(ARM64)
+        case pixel_convert_isa_neon:
+            return info.bASIMD ? &pixconv::neon_kernels : nullptr;
+#endif
+
+        default:
+            break;
+        }
+
+        return nullptr;
+    }
+
+    const pixel_convert_kernels &get_best_pixel_convert_kernels() {
+        static const pixel_convert_kernels *best = []() {
+            static constexpr pixel_convert_isa PREFERENCE[] = {
+                pixel_convert_isa_avx2,
+                pixel_convert_isa_neon,
+                pixel_convert_isa_sse2
+            };
+
+            for (const pixel_convert_isa isa : PREFERENCE) {
+                if (const pixel_convert_kernels *kernels = get_pixel_convert_kernels(isa)) {
+                    return kernels;
+                }
+            }
+
+            return &pixconv::scalar_kernels;
+        }();
+
+        return *best;
+    }
+}
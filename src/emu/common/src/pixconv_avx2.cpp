@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// This file is compiled with AVX2 enabled. Nothing in here may run before checking the host CPU.
+#include "pixconv_kernels.h"
+
+#if EKA2L1_ARCH(X86) || EKA2L1_ARCH(X64)
+
+#include <immintrin.h>
+#include <cstring>
+
+namespace eka2l1::common::pixconv {
+    static void palette_to_bgra_avx2(std::uint32_t *dest, const std::uint8_t *source, const std::size_t width,
+        const int bpp, const std::uint32_t *palette) {
+        const __m256i alpha = _mm256_set1_epi32(static_cast<int>(OPAQUE_ALPHA));
+        const int *table = reinterpret_cast<const int *>(palette);
+
+        std::size_t x = 0;
+
+        if (bpp == 8) {
+            for (; x + 8 <= width; x += 8) {
+                const __m256i indices = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(source + x)));
+                const __m256i colors = _mm256_i32gather_epi32(table, indices, 4);
+
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(dest + x), _mm256_or_si256(colors, alpha));
+            }
+
+            palette_to_bgra_scalar(dest + x, source + x, width - x, bpp, palette);
+            return;
+        }
+
+        // Eight pixels take exactly bpp bytes. Broadcast them, then shift each pixel's index down in its own lane.
+        const __m256i shifts = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(bpp));
+        const __m256i index_mask = _mm256_set1_epi32((1 << bpp) - 1);
+        const std::size_t pixels_per_byte = 8 / bpp;
+
+        // Palettes up to 16 entries stay in registers. A permute looks up 8 entries, gathers are much slower.
+        std::uint32_t entries[16] = { 0 };
+        std::memcpy(entries, palette, (static_cast<std::size_t>(1) << bpp) * sizeof(std::uint32_t));
+
+        const __m256i table_lo = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(entries));
+        const __m256i table_hi = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(entries + 8));
+        const __m256i seven = _mm256_set1_epi32(7);
+
+        for (; x + 8 <= width; x += 8) {
+            const std::uint8_t *packed_bytes = source + x / pixels_per_byte;
+            std::uint32_t packed = packed_bytes[0];
+
+            if (bpp >= 2) {
+                packed |= static_cast<std::uint32_t>(packed_bytes[1]) << 8;
+            }
+
+            if (bpp == 4) {
+                packed |= static_cast<std::uint32_t>(packed_bytes[2]) << 16 | static_cast<std::uint32_t>(packed_bytes[3]) << 24;
+            }
+
+            const __m256i indices = _mm256_and_si256(_mm256_srlv_epi32(_mm256_set1_epi32(static_cast<int>(packed)), shifts), index_mask);
+            __m256i colors = _mm256_permutevar8x32_epi32(table_lo, indices);
+
+            if (bpp == 4) {
+                // The permute only uses the low 3 bits of the index, pick the upper half where bit 3 is set
+                colors = _mm256_blendv_epi8(colors, _mm256_permutevar8x32_epi32(table_hi, indices),
+                    _mm256_cmpgt_epi32(indices, seven));
+            }
+
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dest + x), _mm256_or_si256(colors, alpha));
+        }
+
+        if (x < width) {
+            palette_to_bgra_scalar(dest + x, source + x / pixels_per_byte, width - x, bpp, palette);
+        }
+    }
+
+    static void color4k_to_bgra_avx2(std::uint32_t *dest, const std::uint16_t *source, const std::size_t width) {
+        const __m256i alpha = _mm256_set1_epi32(static_cast<int>(OPAQUE_ALPHA));
+        const __m256i mask_b = _mm256_set1_epi32(0x00F);
+        const __m256i mask_g = _mm256_set1_epi32(0x0F0);
+        const __m256i mask_r = _mm256_set1_epi32(0xF00);
+
+        std::size_t x = 0;
+
+        for (; x + 8 <= width; x += 8) {
+            const __m256i value = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(source + x)));
+
+            // Move each nibble to the low half of its own byte, then copy it to the high half too
+            const __m256i spread = _mm256_or_si256(_mm256_or_si256(_mm256_and_si256(value, mask_b),
+                                                       _mm256_slli_epi32(_mm256_and_si256(value, mask_g), 4)),
+                _mm256_slli_epi32(_mm256_and_si256(value, mask_r), 8));
+
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dest + x), _mm256_or_si256(_mm256_or_si256(spread,
+                                                                                           _mm256_slli_epi32(spread, 4)),
+                                                                           alpha));
+        }
+
+        color4k_to_bgra_scalar(dest + x, source + x, width - x);
+    }
+
+    static void color64k_to_bgra_avx2(std::uint32_t *dest, const std::uint16_t *source, const std::size_t width) {
+        const __m256i alpha = _mm256_set1_epi32(static_cast<int>(OPAQUE_ALPHA));
+        std::size_t x = 0;
+
+        for (; x + 8 <= width; x += 8) {
+            const __m256i value = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(source + x)));
+
+            // Each channel is shifted to the top of its byte, and its top bits replicated to the bottom
+            const __m256i r = _mm256_or_si256(_mm256_slli_epi32(_mm256_and_si256(value, _mm256_set1_epi32(0xF800)), 8),
+                _mm256_slli_epi32(_mm256_and_si256(value, _mm256_set1_epi32(0xE000)), 3));
+            const __m256i g = _mm256_or_si256(_mm256_slli_epi32(_mm256_and_si256(value, _mm256_set1_epi32(0x07E0)), 5),
+                _mm256_srli_epi32(_mm256_and_si256(value, _mm256_set1_epi32(0x0600)), 1));
+            const __m256i b = _mm256_or_si256(_mm256_slli_epi32(_mm256_and_si256(value, _mm256_set1_epi32(0x001F)), 3),
+                _mm256_srli_epi32(_mm256_and_si256(value, _mm256_set1_epi32(0x001C)), 2));
+
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dest + x), _mm256_or_si256(_mm256_or_si256(r, g),
+                                                                           _mm256_or_si256(b, alpha)));
+        }
+
+        color64k_to_bgra_scalar(dest + x, source + x, width - x);
+    }
+
+    static void bgr_to_bgra_avx2(std::uint32_t *dest, const std::uint8_t *source, const std::size_t width) {
+        const __m256i alpha = _mm256_set1_epi32(static_cast<int>(OPAQUE_ALPHA));
+
+        // Shuffles work inside each 128-bit lane, so each lane gets its own four pixels
+        const __m256i spread = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+            0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+
+        std::size_t x = 0;
+
+        // The second lane's load ends 28 bytes after the first pixel, stop early enough to not read past the row
+        for (; x + 10 <= width; x += 8) {
+            const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + x * 3));
+            const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + x * 3 + 12));
+
+            const __m256i bytes = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dest + x), _mm256_or_si256(_mm256_shuffle_epi8(bytes, spread), alpha));
+        }
+
+        bgr_to_bgra_scalar(dest + x, source + x * 3, width - x);
+    }
+
+    static void swap_red_blue_avx2(std::uint32_t *dest, const std::uint32_t *source, const std::size_t width) {
+        const __m256i swap = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+            2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+
+        std::size_t x = 0;
+
+        for (; x + 8 <= width; x += 8) {
+            const __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(source + x));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dest + x), _mm256_shuffle_epi8(value, swap));
+        }
+
+        swap_red_blue_scalar(dest + x, source + x, width - x);
+    }
+
+    static void fill_alpha_avx2(std::uint32_t *dest, const std::uint32_t *source, const std::size_t width) {
+        const __m256i alpha = _mm256_set1_epi32(static_cast<int>(OPAQUE_ALPHA));
+        std::size_t x = 0;
+
+        for (; x + 8 <= width; x += 8) {
+            const __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(source + x));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dest + x), _mm256_or_si256(value, alpha));
+        }
+
+        fill_alpha_scalar(dest + x, source + x, width - x);
+    }
+
+    const pixel_convert_kernels avx2_kernels = {
+        "AVX2",
+        palette_to_bgra_avx2,
+        color4k_to_bgra_avx2,
+        color64k_to_bgra_avx2,
+        bgr_to_bgra_avx2,
+        swap_red_blue_avx2,
+        fill_alpha_avx2
+    };
+}
+
+#endif
@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <common/pixconv.h>
+#include <common/platform.h>
+
+#include <cstddef>
+#include <cstdint>
+
+// Private to the pixel conversion module. Each instruction set lives in its own translation unit,
+// so that it can be compiled with its own target flags.
+namespace eka2l1::common::pixconv {
+    static constexpr std::uint32_t OPAQUE_ALPHA = 0xFF000000;
+
+    // Scalar kernels. The SIMD kernels use them for tails and for anything they don't vectorize.
+    void palette_to_bgra_scalar(std::uint32_t *dest, const std::uint8_t *source, const std::size_t width,
+        const int bpp, const std::uint32_t *palette);
+    void color4k_to_bgra_scalar(std::uint32_t *dest, const std::uint16_t *source, const std::size_t width);
+    void color64k_to_bgra_scalar(std::uint32_t *dest, const std::uint16_t *source, const std::size_t width);
+    void bgr_to_bgra_scalar(std::uint32_t *dest, const std::uint8_t *source, const std::size_t width);
+    void swap_red_blue_scalar(std::uint32_t *dest, const std::uint32_t *source, const std::size_t width);
+    void fill_alpha_scalar(std::uint32_t *dest, const std::uint32_t *source, const std::size_t width);
+
+    extern const pixel_convert_kernels scalar_kernels;
+
+#if EKA2L1_ARCH(X86) || EKA2L1_ARCH(X64)
+    extern const pixel_convert_kernels sse2_kernels;
+    extern const pixel_convert_kernels avx2_kernels;
+#endif
+
+#if EKA2L1_ARCH(ARM64)
+    extern const pixel_convert_kernels neon_kernels;
+#endif
+}
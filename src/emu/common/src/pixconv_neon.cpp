@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pixconv_kernels.h"
+
+#if EKA2L1_ARCH(ARM64)
+
+#include <arm_neon.h>
+#include <cstring>
+
+namespace eka2l1::common::pixconv {
+    static void palette_to_bgra_neon(std::uint32_t *dest, const std::uint8_t *source, const std::size_t width,
+        const int bpp, const std::uint32_t *palette) {
+        // A 256 entries palette does not fit the table lookup instructions
+        if (bpp == 8) {
+            palette_to_bgra_scalar(dest, source, width, bpp, palette);
+            return;
+        }
+
+        // Split the palette into byte planes, so that each plane can be looked up by one table instruction
+        std::uint8_t planes[3][16] = {};
+        const int entry_count = 1 << bpp;
+
+        for (int i = 0; i < entry_count; i++) {
+            planes[0][i] = static_cast<std::uint8_t>(palette[i]);
+            planes[1][i] = static_cast<std::uint8_t>(palette[i] >> 8);
+            planes[2][i] = static_cast<std::uint8_t>(palette[i] >> 16);
+        }
+
+        const uint8x16_t plane_b = vld1q_u8(planes[0]);
+        const uint8x16_t plane_g = vld1q_u8(planes[1]);
+        const uint8x16_t plane_r = vld1q_u8(planes[2]);
+
+        // Sixteen pixels take exactly (bpp * 2) bytes. Replicate each byte to the pixels it holds, then shift
+        // each pixel's index down in its own lane.
+        std::uint8_t replicate[16];
+        std::int8_t shifts[16];
+
+        const int pixels_per_byte = 8 / bpp;
+
+        for (int i = 0; i < 16; i++) {
+            replicate[i] = static_cast<std::uint8_t>(i / pixels_per_byte);
+            shifts[i] = static_cast<std::int8_t>(-(i % pixels_per_byte) * bpp);
+        }
+
+        const uint8x16_t replicate_vec = vld1q_u8(replicate);
+        const int8x16_t shifts_vec = vld1q_s8(shifts);
+        const uint8x16_t index_mask = vdupq_n_u8(static_cast<std::uint8_t>(entry_count - 1));
+
+        const std::size_t bytes_per_iteration = static_cast<std::size_t>(bpp) * 2;
+        std::size_t x = 0;
+
+        for (; x + 16 <= width; x += 16) {
+            std::uint8_t packed[16] = {};
+            std::memcpy(packed, source + x / pixels_per_byte, bytes_per_iteration);
+
+            const uint8x16_t spread = vqtbl1q_u8(vld1q_u8(packed), replicate_vec);
+            const uint8x16_t indices = vandq_u8(vshlq_u8(spread, shifts_vec), index_mask);
+
+            uint8x16x4_t pixels;
+            pixels.val[0] = vqtbl1q_u8(plane_b, indices);
+            pixels.val[1] = vqtbl1q_u8(plane_g, indices);
+            pixels.val[2] = vqtbl1q_u8(plane_r, indices);
+            pixels.val[3] = vdupq_n_u8(0xFF);
+
+            vst4q_u8(reinterpret_cast<std::uint8_t *>(dest + x), pixels);
+        }
+
+        if (x < width) {
+            palette_to_bgra_scalar(dest + x, source + x / pixels_per_byte, width - x, bpp, palette);
+        }
+    }
+
+    static void color4k_to_bgra_neon(std::uint32_t *dest, const std::uint16_t *source, const std::size_t width) {
+        const uint32x4_t alpha = vdupq_n_u32(OPAQUE_ALPHA);
+        const uint32x4_t mask_b = vdupq_n_u32(0x00F);
+        const uint32x4_t mask_g = vdupq_n_u32(0x0F0);
+        const uint32x4_t mask_r = vdupq_n_u32(0xF00);
+
+        const auto expand = [&](const uint32x4_t value) {
+            // Move each nibble to the low half of its own byte, then copy it to the high half too
+            const uint32x4_t spread = vorrq_u32(vorrq_u32(vandq_u32(value, mask_b), vshlq_n_u32(vandq_u32(value, mask_g), 4)),
+                vshlq_n_u32(vandq_u32(value, mask_r), 8));
+
+            return vorrq_u32(vorrq_u32(spread, vshlq_n_u32(spread, 4)), alpha);
+        };
+
+        std::size_t x = 0;
+
+        for (; x + 8 <= width; x += 8) {
+            const uint16x8_t pixels = vld1q_u16(source + x);
+
+            vst1q_u32(dest + x, expand(vmovl_u16(vget_low_u16(pixels))));
+            vst1q_u32(dest + x + 4, expand(vmovl_high_u16(pixels)));
+        }
+
+        color4k_to_bgra_scalar(dest + x, source + x, width - x);
+    }
+
+    static void color64k_to_bgra_neon(std::uint32_t *dest, const std::uint16_t *source, const std::size_t width) {
+        std::size_t x = 0;
+
+        for (; x + 16 <= width; x += 16) {
+            const uint16x8_t lo = vld1q_u16(source + x);
+            const uint16x8_t hi = vld1q_u16(source + x + 8);
+
+            // Narrow each channel to a byte, with its top bits replicated to the bottom
+            const uint8x16_t r5 = vcombine_u8(vshrn_n_u16(lo, 11), vshrn_n_u16(hi, 11));
+            const uint8x16_t g6 = vandq_u8(vcombine_u8(vshrn_n_u16(lo, 5), vshrn_n_u16(hi, 5)), vdupq_n_u8(0x3F));
+            const uint8x16_t b5 = vandq_u8(vcombine_u8(vmovn_u16(lo), vmovn_u16(hi)), vdupq_n_u8(0x1F));
+
+            uint8x16x4_t pixels;
+            pixels.val[0] = vorrq_u8(vshlq_n_u8(b5, 3), vshrq_n_u8(b5, 2));
+            pixels.val[1] = vorrq_u8(vshlq_n_u8(g6, 2), vshrq_n_u8(g6, 4));
+            pixels.val[2] = vorrq_u8(vshlq_n_u8(r5, 3), vshrq_n_u8(r5, 2));
+            pixels.val[3] = vdupq_n_u8(0xFF);
+
+            vst4q_u8(reinterpret_cast<std::uint8_t *>(dest + x), pixels);
+        }
+
+        color64k_to_bgra_scalar(dest + x, source + x, width - x);
+    }
+
+    static void bgr_to_bgra_neon(std::uint32_t *dest, const std::uint8_t *source, const std::size_t width) {
+        std::size_t x = 0;
+
+        for (; x + 16 <= width; x += 16) {
+            const uint8x16x3_t bgr = vld3q_u8(source + x * 3);
+
+            uint8x16x4_t pixels;
+            pixels.val[0] = bgr.val[0];
+            pixels.val[1] = bgr.val[1];
+            pixels.val[2] = bgr.val[2];
+            pixels.val[3] = vdupq_n_u8(0xFF);
+
+            vst4q_u8(reinterpret_cast<std::uint8_t *>(dest + x), pixels);
+        }
+
+        bgr_to_bgra_scalar(dest + x, source + x * 3, width - x);
+    }
+
+    static void swap_red_blue_neon(std::uint32_t *dest, const std::uint32_t *source, const std::size_t width) {
+        std::size_t x = 0;
+
+        for (; x + 16 <= width; x += 16) {
+            uint8x16x4_t pixels = vld4q_u8(reinterpret_cast<const std::uint8_t *>(source + x));
+            const uint8x16_t first = pixels.val[0];
+
+            pixels.val[0] = pixels.val[2];
+            pixels.val[2] = first;
+
+            vst4q_u8(reinterpret_cast<std::uint8_t *>(dest + x), pixels);
+        }
+
+        swap_red_blue_scalar(dest + x, source + x, width - x);
+    }
+
+    static void fill_alpha_neon(std::uint32_t *dest, const std::uint32_t *source, const std::size_t width) {
+        const uint32x4_t alpha = vdupq_n_u32(OPAQUE_ALPHA);
+        std::size_t x = 0;
+
+        for (; x + 4 <= width; x += 4) {
+            vst1q_u32(dest + x, vorrq_u32(vld1q_u32(source + x), alpha));
+        }
+
+        fill_alpha_scalar(dest + x, source + x, width - x);
+    }
+
+    const pixel_convert_kernels neon_kernels = {
+        "NEON",
+        palette_to_bgra_neon,
+        color4k_to_bgra_neon,
+        color64k_to_bgra_neon,
+        bgr_to_bgra_neon,
+        swap_red_blue_neon,
+        fill_alpha_neon
+    };
+}
+
+#endif
@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pixconv_kernels.h"
+
+#if EKA2L1_ARCH(X86) || EKA2L1_ARCH(X64)
+
+#include <emmintrin.h>
+
+namespace eka2l1::common::pixconv {
+    // Pick between two colors per lane: where the mask is all ones, take the second one.
+    static inline __m128i select_sse2(const __m128i mask, const __m128i zero_color, const __m128i one_color) {
+        return _mm_or_si128(_mm_and_si128(mask, one_color), _mm_andnot_si128(mask, zero_color));
+    }
+
+    static void palette_to_bgra_sse2(std::uint32_t *dest, const std::uint8_t *source, const std::size_t width,
+        const int bpp, const std::uint32_t *palette) {
+        // Without a byte shuffle, table lookups are done by comparing against each index. Only worth it
+        // for the two smallest palettes.
+        if (bpp == 1) {
+            const __m128i color0 = _mm_set1_epi32(static_cast<int>(OPAQUE_ALPHA | palette[0]));
+            const __m128i color1 = _mm_set1_epi32(static_cast<int>(OPAQUE_ALPHA | palette[1]));
+            const __m128i bits_lo = _mm_setr_epi32(1, 2, 4, 8);
+            const __m128i bits_hi = _mm_setr_epi32(16, 32, 64, 128);
+
+            std::size_t x = 0;
+
+            for (; x + 8 <= width; x += 8) {
+                const __m128i packed = _mm_set1_epi32(source[x >> 3]);
+
+                const __m128i mask_lo = _mm_cmpeq_epi32(_mm_and_si128(packed, bits_lo), bits_lo);
+                const __m128i mask_hi = _mm_cmpeq_epi32(_mm_and_si128(packed, bits_hi), bits_hi);
+
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + x), select_sse2(mask_lo, color0, color1));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + x + 4), select_sse2(mask_hi, color0, color1));
+            }
+
+            if (x < width) {
+                palette_to_bgra_scalar(dest + x, source + (x >> 3), width - x, bpp, palette);
+            }
+
+            return;
+        }
+
+        if (bpp == 2) {
+            const __m128i field_mask = _mm_setr_epi32(0x03, 0x0C, 0x30, 0xC0);
+            __m128i colors[4];
+            __m128i keys[4];
+
+            for (int i = 0; i < 4; i++) {
+                colors[i] = _mm_set1_epi32(static_cast<int>(OPAQUE_ALPHA | palette[i]));
+                keys[i] = _mm_setr_epi32(i, i << 2, i << 4, i << 6);
+            }
+
+            std::size_t x = 0;
+
+            for (; x + 4 <= width; x += 4) {
+                const __m128i fields = _mm_and_si128(_mm_set1_epi32(source[x >> 2]), field_mask);
+                __m128i result = colors[0];
+
+                for (int i = 1; i < 4; i++) {
+                    result = select_sse2(_mm_cmpeq_epi32(fields, keys[i]), result, colors[i]);
+                }
+
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + x), result);
+            }
+
+            if (x < width) {
+                palette_to_bgra_scalar(dest + x, source + (x >> 2), width - x, bpp, palette);
+            }
+
+            return;
+        }
+
+        palette_to_bgra_scalar(dest, source, width, bpp, palette);
+    }
+
+    static void color4k_to_bgra_sse2(std::uint32_t *dest, const std::uint16_t *source, const std::size_t width) {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i alpha = _mm_set1_epi32(static_cast<int>(OPAQUE_ALPHA));
+        const __m128i mask_b = _mm_set1_epi32(0x00F);
+        const __m128i mask_g = _mm_set1_epi32(0x0F0);
+        const __m128i mask_r = _mm_set1_epi32(0xF00);
+
+        const auto expand = [&](const __m128i value) {
+            // Move each nibble to the low half of its own byte, then copy it to the high half too
+            const __m128i spread = _mm_or_si128(_mm_or_si128(_mm_and_si128(value, mask_b),
+                                                    _mm_slli_epi32(_mm_and_si128(value, mask_g), 4)),
+                _mm_slli_epi32(_mm_and_si128(value, mask_r), 8));
+
+            return _mm_or_si128(_mm_or_si128(spread, _mm_slli_epi32(spread, 4)), alpha);
+        };
+
+        std::size_t x = 0;
+
+        for (; x + 8 <= width; x += 8) {
+            const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + x));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + x), expand(_mm_unpacklo_epi16(pixels, zero)));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + x + 4), expand(_mm_unpackhi_epi16(pixels, zero)));
+        }
+
+        color4k_to_bgra_scalar(dest + x, source + x, width - x);
+    }
+
+    static void color64k_to_bgra_sse2(std::uint32_t *dest, const std::uint16_t *source, const std::size_t width) {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i alpha = _mm_set1_epi32(static_cast<int>(OPAQUE_ALPHA));
+
+        const auto expand = [&](const __m128i value) {
+            // Each channel is shifted to the top of its byte, and its top bits replicated to the bottom
+            const __m128i r = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(value, _mm_set1_epi32(0xF800)), 8),
+                _mm_slli_epi32(_mm_and_si128(value, _mm_set1_epi32(0xE000)), 3));
+            const __m128i g = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(value, _mm_set1_epi32(0x07E0)), 5),
+                _mm_srli_epi32(_mm_and_si128(value, _mm_set1_epi32(0x0600)), 1));
+            const __m128i b = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(value, _mm_set1_epi32(0x001F)), 3),
+                _mm_srli_epi32(_mm_and_si128(value, _mm_set1_epi32(0x001C)), 2));
+
+            return _mm_or_si128(_mm_or_si128(r, g), _mm_or_si128(b, alpha));
+        };
+
+        std::size_t x = 0;
+
+        for (; x + 8 <= width; x += 8) {
+            const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + x));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + x), expand(_mm_unpacklo_epi16(pixels, zero)));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + x + 4), expand(_mm_unpackhi_epi16(pixels, zero)));
+        }
+
+        color64k_to_bgra_scalar(dest + x, source + x, width - x);
+    }
+
+    static void bgr_to_bgra_sse2(std::uint32_t *dest, const std::uint8_t *source, const std::size_t width) {
+        const __m128i alpha = _mm_set1_epi32(static_cast<int>(OPAQUE_ALPHA));
+        std::size_t x = 0;
+
+        // Each iteration loads 16 bytes for 12 used, stop early enough to not read past the row
+        for (; x + 6 <= width; x += 4) {
+            const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + x * 3));
+
+            const __m128i first_pair = _mm_unpacklo_epi32(bytes, _mm_srli_si128(bytes, 3));
+            const __m128i second_pair = _mm_unpacklo_epi32(_mm_srli_si128(bytes, 6), _mm_srli_si128(bytes, 9));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + x), _mm_or_si128(_mm_unpacklo_epi64(first_pair, second_pair), alpha));
+        }
+
+        bgr_to_bgra_scalar(dest + x, source + x * 3, width - x);
+    }
+
+    static void swap_red_blue_sse2(std::uint32_t *dest, const std::uint32_t *source, const std::size_t width) {
+        const __m128i keep_mask = _mm_set1_epi32(static_cast<int>(0xFF00FF00));
+        const __m128i low_mask = _mm_set1_epi32(0xFF);
+
+        std::size_t x = 0;
+
+        for (; x + 4 <= width; x += 4) {
+            const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + x));
+            const __m128i swapped = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(value, 16), low_mask),
+                _mm_slli_epi32(_mm_and_si128(value, low_mask), 16));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + x), _mm_or_si128(_mm_and_si128(value, keep_mask), swapped));
+        }
+
+        swap_red_blue_scalar(dest + x, source + x, width - x);
+    }
+
+    static void fill_alpha_sse2(std::uint32_t *dest, const std::uint32_t *source, const std::size_t width) {
+        const __m128i alpha = _mm_set1_epi32(static_cast<int>(OPAQUE_ALPHA));
+        std::size_t x = 0;
+
+        for (; x + 4 <= width; x += 4) {
+            const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + x));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + x), _mm_or_si128(value, alpha));
+        }
+
+        fill_alpha_scalar(dest + x, source + x, width - x);
+    }
+
+    const pixel_convert_kernels sse2_kernels = {
+        "SSE2",
+        palette_to_bgra_sse2,
+        color4k_to_bgra_sse2,
+        color64k_to_bgra_sse2,
+        bgr_to_bgra_sse2,
+        swap_red_blue_sse2,
+        fill_alpha_sse2
+    };
+}
+
+#endif
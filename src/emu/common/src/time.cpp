@@ -91,6 +91,20 @@ namespace eka2l1::common {
             end_ = get_current_time_in_microseconds_since_epoch();
         }
 
+        void pause() override {
+            if (end_ == 0) {
+                end_ = get_current_time_in_microseconds_since_epoch();
+            }
+        }
+
+        void resume() override {
+            if (end_ != 0) {
+                // Shift the start so the paused duration is skipped
+                start_ += get_current_time_in_microseconds_since_epoch() - end_;
+                end_ = 0;
+            }
+        }
+
         bool set_target_frequency(const std::uint32_t freq) override {
             target_freq_ = freq;
             return true;
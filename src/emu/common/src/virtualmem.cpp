@@ -198,10 +198,15 @@ namespace eka2l1::common {
             map_size >> 32, static_cast<DWORD>(map_size), NULL);
 
         if (!map_file_handle || map_file_handle == INVALID_HANDLE_VALUE) {
+            CloseHandle(file_handle);
             return nullptr;
         }
 
         auto map_ptr = MapViewOfFile(map_file_handle, map_type, 0, 0, 0);
+
+        // The view keeps its own reference to the mapping and the file
+        CloseHandle(map_file_handle);
+        CloseHandle(file_handle);
 #else
         int open_mode = 0;
         const int prot_mode = translate_protection(perm);
@@ -243,14 +248,25 @@ namespace eka2l1::common {
         }
 
         auto map_ptr = mmap(nullptr, map_size, prot_mode, MAP_PRIVATE, file_handle, 0);
+
+        // The mapping keeps its own reference to the file
+        close(file_handle);
+
+        if (map_ptr == MAP_FAILED) {
+            return nullptr;
+        }
 #endif
 
         return map_ptr;
     }
 
-    bool unmap_file(void *ptr) {
+    bool unmap_file(void *ptr, const std::size_t size) {
 #if EKA2L1_PLATFORM(WIN32)
         UnmapViewOfFile(ptr);
+#else
+        if (size != 0) {
+            return munmap(ptr, size) == 0;
+        }
 #endif
 
         return true;
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <common/platform.h>
+
+#if EKA2L1_ARCH(X86) || EKA2L1_ARCH(X64)
+
+#include <common/cpudetect.h>
+
+#include <cstdint>
+#include <cstring>
+#include <thread>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+namespace eka2l1::common {
+    static void do_cpuid(std::uint32_t *regs, const std::uint32_t leaf, const std::uint32_t subleaf) {
+#ifdef _MSC_VER
+        __cpuidex(reinterpret_cast<int *>(regs), static_cast<int>(leaf), static_cast<int>(subleaf));
+#else
+        __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+    }
+
+    // Read the extended control register 0. Tells which register states the OS saves on context switch.
+    static std::uint64_t do_xgetbv() {
+#ifdef _MSC_VER
+        return _xgetbv(0);
+#else
+        std::uint32_t eax = 0;
+        std::uint32_t edx = 0;
+
+        __asm__ __volatile__("xgetbv"
+                             : "=a"(eax), "=d"(edx)
+                             : "c"(0));
+
+        return (static_cast<std::uint64_t>(edx) << 32) | eax;
+#endif
+    }
+
+    static bool is_bit_set(const std::uint32_t value, const int bit) {
+        return (value >> bit) & 1;
+    }
+
+    void cpu_info::detect() {
+        std::memset(static_cast<void *>(this), 0, sizeof(cpu_info));
+
+#if EKA2L1_ARCH(X64)
+        OS64bit = true;
+        CPU64bit = true;
+        Mode64bit = true;
+#endif
+
+        num_cores = static_cast<int>(std::thread::hardware_concurrency());
+        logical_cpu_count = num_cores;
+
+        std::uint32_t regs[4] = { 0 };
+
+        // Leaf 0: highest leaf and vendor string (EBX, EDX, ECX order)
+        do_cpuid(regs, 0, 0);
+        const std::uint32_t max_leaf = regs[0];
+
+        std::memcpy(cpu_string, &regs[1], 4);
+        std::memcpy(cpu_string + 4, &regs[3], 4);
+        std::memcpy(cpu_string + 8, &regs[2], 4);
+
+        if (std::strcmp(cpu_string, "GenuineIntel") == 0) {
+            vendor = VENDOR_INTEL;
+        } else if (std::strcmp(cpu_string, "AuthenticAMD") == 0) {
+            vendor = VENDOR_AMD;
+        } else {
+            vendor = VENDOR_OTHER;
+        }
+
+        if (max_leaf >= 1) {
+            do_cpuid(regs, 1, 0);
+
+            bSSE = is_bit_set(regs[3], 25);
+            bSSE2 = is_bit_set(regs[3], 26);
+            bFXSR = is_bit_set(regs[3], 24);
+            HTT = is_bit_set(regs[3], 28);
+
+            bSSE3 = is_bit_set(regs[2], 0);
+            bSSSE3 = is_bit_set(regs[2], 9);
+            bFMA = is_bit_set(regs[2], 12);
+            bSSE4_1 = is_bit_set(regs[2], 19);
+            bSSE4_2 = is_bit_set(regs[2], 20);
+            bMOVBE = is_bit_set(regs[2], 22);
+            bPOPCNT = is_bit_set(regs[2], 23);
+            bAES = is_bit_set(regs[2], 25);
+
+            // The OS must also save the YMM state, else AVX instructions will fault
+            const bool os_saves_ymm = is_bit_set(regs[2], 27) && ((do_xgetbv() & 0x6) == 0x6);
+            bAVX = is_bit_set(regs[2], 28) && os_saves_ymm;
+
+            if (!bAVX) {
+                bFMA = false;
+            }
+
+            // Atom family 6, model 0x1C, 0x26 and 0x27
+            const std::uint32_t family = (regs[0] >> 8) & 0xF;
+            const std::uint32_t model = ((regs[0] >> 4) & 0xF) | ((regs[0] >> 12) & 0xF0);
+            bAtom = (vendor == VENDOR_INTEL) && (family == 6) && ((model == 0x1C) || (model == 0x26) || (model == 0x27));
+        }
+
+        if (max_leaf >= 7) {
+            do_cpuid(regs, 7, 0);
+
+            bBMI1 = is_bit_set(regs[1], 3);
+            bAVX2 = is_bit_set(regs[1], 5) && bAVX;
+            bBMI2 = is_bit_set(regs[1], 8);
+        }
+
+        do_cpuid(regs, 0x80000000, 0);
+        const std::uint32_t max_ext_leaf = regs[0];
+
+        if (max_ext_leaf >= 0x80000001) {
+            do_cpuid(regs, 0x80000001, 0);
+
+            bLAHFSAHF64 = is_bit_set(regs[2], 0);
+            bLZCNT = is_bit_set(regs[2], 5);
+            bSSE4A = is_bit_set(regs[2], 6);
+            bLongMode = is_bit_set(regs[3], 29);
+        }
+
+        if (max_ext_leaf >= 0x80000004) {
+            for (std::uint32_t i = 0; i < 3; i++) {
+                do_cpuid(regs, 0x80000002 + i, 0);
+                std::memcpy(brand_string + i * 16, regs, 16);
+            }
+        } else {
+            std::strcpy(brand_string, cpu_string);
+        }
+    }
+}
+
+#endif
@@ -80,6 +80,15 @@ namespace eka2l1::config {
         bool accurate_ipc_timing{ false };
         bool enable_btrace{ false };
 
+        bool enable_e32_cache{ false }; ///< Keep decompressed executables on disk, so they are not decompressed again on next boot.
+        std::uint32_t e32_cache_max_size_mb{ 256 };
+
+        bool deterministic_timing{ false }; ///< Guest time follows executed instructions instead of host time. For reproducible runs.
+        std::uint32_t deterministic_timing_mhz{ 484 };
+
+        std::uint32_t bitmap_cache_capacity{ 1024 }; ///< Maximum number of bitmaps the window server keeps as driver textures.
+        std::uint32_t fbs_glyph_rasterizer_threads{ 2 }; ///< Threads rasterizing common glyphs of new fonts ahead of time. 0 to disable.
+
         std::vector<keybind> keybinds;
 
         void serialize();
@@ -108,6 +108,12 @@ namespace eka2l1::config {
         config_file_emit_single(emitter, "fbs-enable-compression-queue", fbs_enable_compression_queue);
         config_file_emit_single(emitter, "accurate-ipc-timing", accurate_ipc_timing);
         config_file_emit_single(emitter, "enable-btrace", enable_btrace);
+        config_file_emit_single(emitter, "enable-e32-cache", enable_e32_cache);
+        config_file_emit_single(emitter, "e32-cache-max-size-mb", e32_cache_max_size_mb);
+        config_file_emit_single(emitter, "deterministic-timing", deterministic_timing);
+        config_file_emit_single(emitter, "deterministic-timing-mhz", deterministic_timing_mhz);
+        config_file_emit_single(emitter, "bitmap-cache-capacity", bitmap_cache_capacity);
+        config_file_emit_single(emitter, "fbs-glyph-rasterizer-threads", fbs_glyph_rasterizer_threads);
 
         emitter << YAML::EndMap;
 
@@ -168,6 +174,12 @@ namespace eka2l1::config {
         get_yaml_value(node, "fbs-enable-compression-queue", &fbs_enable_compression_queue, false);
         get_yaml_value(node, "accurate-ipc-timing", &accurate_ipc_timing, false);
         get_yaml_value(node, "enable-btrace", &enable_btrace, false);
+        get_yaml_value(node, "enable-e32-cache", &enable_e32_cache, false);
+        get_yaml_value(node, "e32-cache-max-size-mb", &e32_cache_max_size_mb, 256);
+        get_yaml_value(node, "deterministic-timing", &deterministic_timing, false);
+        get_yaml_value(node, "deterministic-timing-mhz", &deterministic_timing_mhz, 484);
+        get_yaml_value(node, "bitmap-cache-capacity", &bitmap_cache_capacity, 1024);
+        get_yaml_value(node, "fbs-glyph-rasterizer-threads", &fbs_glyph_rasterizer_threads, 2);
 
         YAML::Node keybind_node;
         try {
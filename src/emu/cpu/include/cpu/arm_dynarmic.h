@@ -26,25 +26,47 @@
 
 #include <map>
 #include <memory>
+#include <unordered_map>
 
 namespace eka2l1 {
     class ntimer;
 
     namespace arm {
         class dynarmic_core_callback;
+        class dynarmic_core_cp15;
+
+        using dynarmic_page_table = std::array<std::uint8_t *, Dynarmic::A32::UserConfig::NUM_PAGE_TABLE_ENTRIES>;
+
+        /**
+         * \brief Page table and JIT instance of an address space.
+         * 
+         * Dynarmic bakes the page table address into generated code, so each address space
+         * gets its own JIT. Switching address space is then just swapping the active one.
+         */
+        struct dynarmic_addr_space {
+            std::unique_ptr<dynarmic_page_table> page_table_;
+            std::unique_ptr<Dynarmic::A32::Jit> jit_;
+        };
 
         class dynarmic_core : public core {
             friend class dynarmic_core_callback;
 
-            std::unique_ptr<Dynarmic::A32::Jit> jit;
+            Dynarmic::A32::Jit *jit;
+            dynarmic_page_table *page_dyn;
+
             std::unique_ptr<dynarmic_core_callback> cb;
+            std::shared_ptr<dynarmic_core_cp15> cp15;
 
-            std::array<std::uint8_t *, Dynarmic::A32::UserConfig::NUM_PAGE_TABLE_ENTRIES>
-                page_dyn;
+            std::unordered_map<std::int32_t, dynarmic_addr_space> addr_spaces;
+            std::unique_ptr<dynarmic_page_table> global_page_dyn; ///< Mappings shared by all address spaces.
+            std::int32_t current_asid;
 
             std::uint32_t ticks_executed{ 0 };
             std::uint32_t ticks_target{ 0 };
 
+            dynarmic_addr_space &get_or_create_addr_space(const std::int32_t asid);
+            void fill_page_table(dynarmic_page_table &table, address vaddr, size_t size, uint8_t *ptr);
+
         public:
             explicit dynarmic_core();
             ~dynarmic_core() override;
@@ -84,9 +106,17 @@ namespace eka2l1 {
 
             void page_table_changed() override;
 
-            void map_backing_mem(address vaddr, size_t size, uint8_t *ptr, prot protection) override;
+            void map_backing_mem(address vaddr, size_t size, uint8_t *ptr, prot protection,
+                const std::int32_t asid = ASID_CURRENT) override;
+
+            void unmap_memory(address addr, size_t size, const std::int32_t asid = ASID_CURRENT) override;
 
-            void unmap_memory(address addr, size_t size) override;
+            bool keep_page_table_per_addr_space() const override {
+                return true;
+            }
+
+            void set_current_addr_space(const std::int32_t asid) override;
+            void free_addr_space(const std::int32_t asid) override;
 
             void clear_instruction_cache() override;
 
@@ -94,6 +124,11 @@ namespace eka2l1 {
 
             std::uint32_t get_num_instruction_executed() override;
 
+            std::size_t get_translation_cache_count() const override {
+                // One JIT, hence one code cache, per address space
+                return addr_spaces.size();
+            }
+
             bool should_clear_old_memory_map() const override {
                 return false;
             }
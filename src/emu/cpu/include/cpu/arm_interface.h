@@ -35,6 +35,11 @@ namespace eka2l1::arm {
     };
 
     using address = std::uint32_t;
+
+    enum : std::int32_t {
+        ASID_CURRENT = -1, ///< The address space currently active on the core.
+        ASID_GLOBAL = -2 ///< All address spaces, including the ones created later.
+    };
     using memory_operation_8bit_func = std::function<bool(address, std::uint8_t*)>;
     using memory_operation_16bit_func = std::function<bool(address, std::uint16_t*)>;
     using memory_operation_32bit_func = std::function<bool(address, std::uint32_t*)>;
@@ -60,6 +65,15 @@ namespace eka2l1::arm {
         system_call_handler_func system_call_handler;
         handle_exception_func exception_handler;
 
+        /**
+         * \brief Force memory callbacks to always go through the slow path.
+         *
+         * By default, the core resolves memory accesses that reach its callbacks by indexing
+         * its own page table directly, and only calls the read/write functions above on a miss.
+         * Set this to true when every access must reach those functions (for example, to log them).
+         */
+        bool slow_memory_path{ false };
+
         /**
          *  Stores register value and some pointer of the CPU.
         */
@@ -134,9 +148,43 @@ namespace eka2l1::arm {
 
         virtual void page_table_changed() = 0;
 
-        virtual void map_backing_mem(address vaddr, size_t size, uint8_t *ptr, prot protection) = 0;
+        /**
+         * \brief Map host memory to the page table of an address space.
+         * 
+         * \param asid The target address space. ASID_CURRENT or ASID_GLOBAL are also accepted.
+         *             Cores not keeping page table per address space treat all values as ASID_CURRENT.
+         */
+        virtual void map_backing_mem(address vaddr, size_t size, uint8_t *ptr, prot protection,
+            const std::int32_t asid = ASID_CURRENT) = 0;
 
-        virtual void unmap_memory(address addr, size_t size) = 0;
+        virtual void unmap_memory(address addr, size_t size, const std::int32_t asid = ASID_CURRENT) = 0;
+
+        /**
+         * \brief Check if the core keeps a persistent page table for each address space.
+         * 
+         * When this is true, memory does not need to be remapped on process switch. Switching
+         * address space is only a matter of calling set_current_addr_space.
+         */
+        virtual bool keep_page_table_per_addr_space() const {
+            return false;
+        }
+
+        /**
+         * \brief Make the page table of an address space active.
+         * 
+         * Only meaningful for cores keeping page table per address space.
+         */
+        virtual void set_current_addr_space(const std::int32_t asid) {
+        }
+
+        /**
+         * \brief Drop the page table and translated code of an address space.
+         * 
+         * Called by the memory model when the address space is freed, so that a process later
+         * given the same ASID does not run on stale mappings or code.
+         */
+        virtual void free_addr_space(const std::int32_t asid) {
+        }
 
         virtual void clear_instruction_cache() = 0;
 
@@ -147,5 +195,14 @@ namespace eka2l1::arm {
         }
 
         virtual std::uint32_t get_num_instruction_executed() = 0;
+
+        /**
+         * \brief Get the number of translation caches the core currently keeps.
+         *
+         * Cores that do not translate guest code return 0.
+         */
+        virtual std::size_t get_translation_cache_count() const {
+            return 0;
+        }
     };
 }
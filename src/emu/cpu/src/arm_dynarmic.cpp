@@ -27,7 +27,14 @@
 #include <dynarmic/A32/context.h>
 #include <dynarmic/A32/coprocessor.h>
 
+#include <algorithm>
+#include <cstring>
+
 namespace eka2l1::arm {
+    static constexpr std::uint32_t DYNARMIC_PAGE_BITS = 12;
+    static constexpr std::uint32_t DYNARMIC_PAGE_SIZE = 1 << DYNARMIC_PAGE_BITS;
+    static constexpr std::uint32_t DYNARMIC_PAGE_MASK = DYNARMIC_PAGE_SIZE - 1;
+
     class dynarmic_core_cp15 : public Dynarmic::A32::Coprocessor {
         std::uint32_t wrwr;
 
@@ -124,55 +131,89 @@ namespace eka2l1::arm {
             }
         }
 
-        std::uint32_t MemoryReadCode(Dynarmic::A32::VAddr addr) override {
-            std::uint32_t code_result = 0;
-            handle_read_status(parent.read_32bit(addr, &code_result), addr);
+        /**
+         * \brief Get the host pointer of an access directly from the page table.
+         *
+         * \returns Nullptr if the access must go through the slow path: the page is not mapped,
+         *          the access crosses a page boundary or the slow path is forced.
+         */
+        template <typename T>
+        std::uint8_t *get_fast_pointer(const Dynarmic::A32::VAddr addr) {
+            const std::uint32_t offset = addr & DYNARMIC_PAGE_MASK;
+
+            if (parent.slow_memory_path || (offset + sizeof(T) > DYNARMIC_PAGE_SIZE)) {
+                return nullptr;
+            }
+
+            std::uint8_t *page = (*parent.page_dyn)[addr >> DYNARMIC_PAGE_BITS];
+
+            if (!page) {
+                return nullptr;
+            }
 
-            return code_result;
+            return page + offset;
         }
 
-        uint8_t MemoryRead8(Dynarmic::A32::VAddr addr) override {
-            std::uint8_t ret = 0;
-            handle_read_status(parent.read_8bit(addr, &ret), addr);
+        template <typename T, typename F>
+        T read_memory(const Dynarmic::A32::VAddr addr, F &slow_read) {
+            T ret = 0;
+            std::uint8_t *ptr = get_fast_pointer<T>(addr);
+
+            if (ptr) {
+                std::memcpy(&ret, ptr, sizeof(T));
+                return ret;
+            }
 
+            handle_read_status(slow_read(addr, &ret), addr);
             return ret;
         }
 
-        uint16_t MemoryRead16(Dynarmic::A32::VAddr addr) override {
-            std::uint16_t ret = 0;
-            handle_read_status(parent.read_16bit(addr, &ret), addr);
+        template <typename T, typename F>
+        void write_memory(const Dynarmic::A32::VAddr addr, T value, F &slow_write) {
+            std::uint8_t *ptr = get_fast_pointer<T>(addr);
 
-            return ret;
+            if (ptr) {
+                std::memcpy(ptr, &value, sizeof(T));
+                return;
+            }
+
+            handle_write_status(slow_write(addr, &value), addr);
         }
 
-        uint32_t MemoryRead32(Dynarmic::A32::VAddr addr) override {
-            std::uint32_t ret = 0;
-            handle_read_status(parent.read_32bit(addr, &ret), addr);
+        std::uint32_t MemoryReadCode(Dynarmic::A32::VAddr addr) override {
+            return read_memory<std::uint32_t>(addr, parent.read_32bit);
+        }
 
-            return ret;
+        uint8_t MemoryRead8(Dynarmic::A32::VAddr addr) override {
+            return read_memory<std::uint8_t>(addr, parent.read_8bit);
         }
 
-        uint64_t MemoryRead64(Dynarmic::A32::VAddr addr) override {
-            std::uint64_t ret = 0;
-            handle_read_status(parent.read_64bit(addr, &ret), addr);
+        uint16_t MemoryRead16(Dynarmic::A32::VAddr addr) override {
+            return read_memory<std::uint16_t>(addr, parent.read_16bit);
+        }
 
-            return ret;
+        uint32_t MemoryRead32(Dynarmic::A32::VAddr addr) override {
+            return read_memory<std::uint32_t>(addr, parent.read_32bit);
+        }
+
+        uint64_t MemoryRead64(Dynarmic::A32::VAddr addr) override {
+            return read_memory<std::uint64_t>(addr, parent.read_64bit);
         }
 
         void MemoryWrite8(Dynarmic::A32::VAddr addr, uint8_t value) override {
-            handle_write_status(parent.write_8bit(addr, &value), addr);
+            write_memory<std::uint8_t>(addr, value, parent.write_8bit);
         }
 
         void MemoryWrite16(Dynarmic::A32::VAddr addr, uint16_t value) override {
-            handle_write_status(parent.write_16bit(addr, &value), addr);
+            write_memory<std::uint16_t>(addr, value, parent.write_16bit);
         }
 
         void MemoryWrite32(Dynarmic::A32::VAddr addr, uint32_t value) override {
-            handle_write_status(parent.write_32bit(addr, &value), addr);
+            write_memory<std::uint32_t>(addr, value, parent.write_32bit);
         }
 
         void MemoryWrite64(Dynarmic::A32::VAddr addr, uint64_t value) override {
-            handle_write_status(parent.write_64bit(addr, &value), addr);
+            write_memory<std::uint64_t>(addr, value, parent.write_64bit);
         }
 
         void InterpreterFallback(Dynarmic::A32::VAddr addr, size_t num_insts) override {
@@ -223,13 +264,18 @@ namespace eka2l1::arm {
         return std::make_unique<Dynarmic::A32::Jit>(config);
     }
 
-    dynarmic_core::dynarmic_core() {
-        std::shared_ptr<dynarmic_core_cp15> cp15 = std::make_shared<dynarmic_core_cp15>();
+    dynarmic_core::dynarmic_core()
+        : jit(nullptr)
+        , page_dyn(nullptr)
+        , current_asid(ASID_CURRENT) {
+        cp15 = std::make_shared<dynarmic_core_cp15>();
         cb = std::make_unique<dynarmic_core_callback>(*this, cp15);
 
-        std::fill(page_dyn.begin(), page_dyn.end(), nullptr);
+        global_page_dyn = std::make_unique<dynarmic_page_table>();
+        std::fill(global_page_dyn->begin(), global_page_dyn->end(), nullptr);
 
-        jit = make_jit(cb, &page_dyn, cp15);
+        // Address space 0 is the kernel's one in all memory models
+        set_current_addr_space(0);
     }
 
     dynarmic_core::~dynarmic_core() {
@@ -312,6 +358,10 @@ namespace eka2l1::arm {
             LOG_WARN("Dynarmic save context with PC = 0");
         }
 
+        // Each address space has its own JIT, so the FPU state must travel with the thread
+        std::memcpy(ctx.fpu_registers.data(), jit->ExtRegs().data(), sizeof(ctx.fpu_registers));
+        ctx.fpscr = jit->Fpscr();
+
         ctx.wrwr = cb->get_cp15()->get_wrwr();
     }
 
@@ -325,6 +375,9 @@ namespace eka2l1::arm {
         set_lr(ctx.lr);
         set_cpsr(ctx.cpsr);
 
+        std::memcpy(jit->ExtRegs().data(), ctx.fpu_registers.data(), sizeof(ctx.fpu_registers));
+        jit->SetFpscr(ctx.fpscr);
+
         cb->get_cp15()->set_wrwr(ctx.wrwr);
     }
 
@@ -356,30 +409,100 @@ namespace eka2l1::arm {
     void dynarmic_core::page_table_changed() {
     }
 
-    void dynarmic_core::map_backing_mem(address vaddr, size_t size, uint8_t *ptr, prot protection) {
-        const std::uint32_t psize = 0x1000;
-        const std::uint32_t pstart = vaddr / psize;
+    void dynarmic_core::fill_page_table(dynarmic_page_table &table, address vaddr, size_t size, uint8_t *ptr) {
+        const std::uint32_t pstart = vaddr >> DYNARMIC_PAGE_BITS;
 
-        for (std::size_t i = 0; i < size / psize; i++) {
-            page_dyn[pstart + i] = ptr + i * psize;
+        for (std::size_t i = 0; i < (size >> DYNARMIC_PAGE_BITS); i++) {
+            table[pstart + i] = ptr ? (ptr + (i << DYNARMIC_PAGE_BITS)) : nullptr;
         }
     }
 
-    void dynarmic_core::unmap_memory(address addr, size_t size) {
-        const std::uint32_t psize = 0x1000;
-        const std::uint32_t pstart = addr / psize;
+    dynarmic_addr_space &dynarmic_core::get_or_create_addr_space(const std::int32_t asid) {
+        auto space_ite = addr_spaces.find(asid);
+
+        if (space_ite != addr_spaces.end()) {
+            return space_ite->second;
+        }
+
+        // New address space starts with all global mappings in place
+        dynarmic_addr_space &space = addr_spaces[asid];
+        space.page_table_ = std::make_unique<dynarmic_page_table>(*global_page_dyn);
+        space.jit_ = make_jit(cb, space.page_table_.get(), cp15);
 
-        for (std::size_t i = 0; i < size / psize; i++) {
-            page_dyn[pstart + i] = nullptr;
+        return space;
+    }
+
+    void dynarmic_core::set_current_addr_space(const std::int32_t asid) {
+        if ((asid < 0) || (asid == current_asid)) {
+            return;
         }
+
+        dynarmic_addr_space &space = get_or_create_addr_space(asid);
+
+        jit = space.jit_.get();
+        page_dyn = space.page_table_.get();
+        current_asid = asid;
+    }
+
+    void dynarmic_core::free_addr_space(const std::int32_t asid) {
+        // Address space 0 is the kernel's one and lives as long as the core
+        if (asid <= 0) {
+            return;
+        }
+
+        auto space_ite = addr_spaces.find(asid);
+
+        if (space_ite == addr_spaces.end()) {
+            return;
+        }
+
+        if (asid != current_asid) {
+            addr_spaces.erase(space_ite);
+            return;
+        }
+
+        // We may be inside a callback of this JIT (the process killing itself), so it can't be
+        // destroyed yet. Reset it instead, the next owner of the ASID starts clean.
+        std::copy(global_page_dyn->begin(), global_page_dyn->end(), space_ite->second.page_table_->begin());
+        space_ite->second.jit_->ClearCache();
+    }
+
+    void dynarmic_core::map_backing_mem(address vaddr, size_t size, uint8_t *ptr, prot protection, const std::int32_t asid) {
+        switch (asid) {
+        case ASID_CURRENT:
+            fill_page_table(*page_dyn, vaddr, size, ptr);
+            break;
+
+        case ASID_GLOBAL:
+            fill_page_table(*global_page_dyn, vaddr, size, ptr);
+
+            for (auto &[id, space] : addr_spaces) {
+                fill_page_table(*space.page_table_, vaddr, size, ptr);
+            }
+
+            break;
+
+        default:
+            fill_page_table(*get_or_create_addr_space(asid).page_table_, vaddr, size, ptr);
+            break;
+        }
+    }
+
+    void dynarmic_core::unmap_memory(address addr, size_t size, const std::int32_t asid) {
+        map_backing_mem(addr, size, nullptr, prot::none, asid);
     }
 
     void dynarmic_core::clear_instruction_cache() {
-        jit->ClearCache();
+        for (auto &[id, space] : addr_spaces) {
+            space.jit_->ClearCache();
+        }
     }
 
     void dynarmic_core::imb_range(address addr, std::size_t size) {
-        jit->InvalidateCacheRange(addr, size);
+        // Code may live in memory shared between address spaces
+        for (auto &[id, space] : addr_spaces) {
+            space.jit_->InvalidateCacheRange(addr, size);
+        }
     }
 
     std::uint32_t dynarmic_core::get_num_instruction_executed() {
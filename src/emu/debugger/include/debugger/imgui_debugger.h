@@ -64,6 +64,8 @@ namespace eka2l1 {
         bool should_save_state;
         bool should_package_manager;
         bool should_show_disassembler;
+        bool should_show_svc_stats;
+        bool should_show_bitmap_cache;
         bool should_show_logger;
         bool should_show_preferences;
 
@@ -152,6 +154,8 @@ namespace eka2l1 {
         void show_chunks();
         void show_timers();
         void show_disassembler();
+        void show_svc_stats();
+        void show_bitmap_cache();
         void show_menu();
         void show_preferences();
         void show_package_manager();
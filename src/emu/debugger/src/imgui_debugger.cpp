@@ -37,6 +37,7 @@
 #include <kernel/kernel.h>
 #include <kernel/libmanager.h>
 #include <kernel/thread.h>
+#include <mem/mem.h>
 
 #include <services/applist/applist.h>
 #include <services/ui/cap/eiksrv.h>
@@ -96,6 +97,8 @@ namespace eka2l1 {
         , should_show_chunks(false)
         , should_show_window_tree(false)
         , should_show_disassembler(false)
+        , should_show_svc_stats(false)
+        , should_show_bitmap_cache(false)
         , should_show_logger(true)
         , should_show_preferences(false)
         , should_package_manager(false)
@@ -372,6 +375,75 @@ namespace eka2l1 {
     void imgui_debugger::show_timers() {
     }
 
+    void imgui_debugger::show_svc_stats() {
+        if (ImGui::Begin("System calls", &should_show_svc_stats)) {
+            hle::lib_manager *mngr = sys->get_lib_manager();
+            const std::lock_guard<std::mutex> guard(sys->get_kernel_system()->kern_lock_);
+
+            bool profiling = mngr->is_svc_profiling();
+
+            if (ImGui::Checkbox("Measure host time", &profiling)) {
+                mngr->set_svc_profiling(profiling);
+            }
+
+            ImGui::SameLine();
+
+            if (ImGui::Button("Reset")) {
+                mngr->reset_svc_stats();
+            }
+
+            ImGui::Separator();
+
+            ImGui::TextColored(GUI_COLOR_TEXT_TITLE, "%-10s    %-40s    %-12s    %-14s    %-10s", "Ordinal",
+                "Name", "Calls", "Total (us)", "Avg (us)");
+
+            mngr->visit_svcs([](const sid svcnum, const hle::svc_info &info) {
+                if (info.call_count_ == 0) {
+                    return;
+                }
+
+                const double total_time_us = static_cast<double>(info.total_time_ns_) / 1000.0;
+
+                ImGui::TextColored(GUI_COLOR_TEXT, "0x%08X    %-40s    %-12llu    %-14.1f    %-10.3f", svcnum, info.func_.name.c_str(),
+                    static_cast<unsigned long long>(info.call_count_), total_time_us,
+                    total_time_us / static_cast<double>(info.call_count_));
+            });
+        }
+
+        ImGui::End();
+    }
+
+    void imgui_debugger::show_bitmap_cache() {
+        if (!winserv) {
+            return;
+        }
+
+        if (ImGui::Begin("Bitmap cache", &should_show_bitmap_cache)) {
+            const std::lock_guard<std::mutex> guard(sys->get_kernel_system()->kern_lock_);
+            epoc::bitmap_cache *cache = winserv->get_bitmap_cache();
+
+            if (ImGui::Button("Reset")) {
+                cache->reset_stats();
+            }
+
+            ImGui::Separator();
+
+            const epoc::bitmap_cache_stats &stats = cache->get_stats();
+            const std::uint64_t lookups = stats.hits_ + stats.misses_;
+
+            ImGui::TextColored(GUI_COLOR_TEXT, "Entries: %llu / %u", static_cast<unsigned long long>(cache->size()),
+                cache->get_capacity());
+            ImGui::TextColored(GUI_COLOR_TEXT, "Hits: %llu (%.2f%%)", static_cast<unsigned long long>(stats.hits_),
+                (lookups == 0) ? 0.0 : static_cast<double>(stats.hits_) * 100.0 / static_cast<double>(lookups));
+            ImGui::TextColored(GUI_COLOR_TEXT, "Misses: %llu", static_cast<unsigned long long>(stats.misses_));
+            ImGui::TextColored(GUI_COLOR_TEXT, "Evictions: %llu", static_cast<unsigned long long>(stats.evictions_));
+            ImGui::TextColored(GUI_COLOR_TEXT, "Uploads: %llu", static_cast<unsigned long long>(stats.uploads_));
+            ImGui::TextColored(GUI_COLOR_TEXT, "Uploaded: %.2f KB", static_cast<double>(stats.bytes_uploaded_) / 1024.0);
+        }
+
+        ImGui::End();
+    }
+
     void imgui_debugger::show_disassembler() {
         if (ImGui::Begin("Disassembler", &should_show_disassembler)) {
             thread_ptr debug_thread = nullptr;
@@ -425,7 +497,8 @@ namespace eka2l1 {
                         ImGui::Text("0x%08x: %-10u    %s", pc, *reinterpret_cast<std::uint32_t *>(codeptr), dis.c_str());
                     } else {
                         const std::uint32_t svc_num = std::stoul(dis.substr(5), nullptr, 16);
-                        const std::string svc_call_name = sys->get_lib_manager()->svc_funcs_.find(svc_num) != sys->get_lib_manager()->svc_funcs_.end() ? sys->get_lib_manager()->svc_funcs_[svc_num].name : "Unknown";
+                        const hle::svc_info *svc = sys->get_lib_manager()->get_svc_info(svc_num);
+                        const std::string svc_call_name = svc ? svc->func_.name : "Unknown";
 
                         ImGui::Text("0x%08x: %-10u    %s            ; %s", pc, *reinterpret_cast<std::uint32_t *>(codeptr), dis.c_str(), svc_call_name.c_str());
                     }
@@ -541,9 +614,13 @@ namespace eka2l1 {
 
         const float col2 = ImGui::GetWindowSize().x / 2;
 
-        ImGui::Checkbox("CPU Read", &conf->log_read);
+        bool memory_log_changed = ImGui::Checkbox("CPU Read", &conf->log_read);
         ImGui::SameLine(col2);
-        ImGui::Checkbox("CPU write", &conf->log_write);
+        memory_log_changed |= ImGui::Checkbox("CPU write", &conf->log_write);
+
+        if (memory_log_changed && sys->get_memory_system()) {
+            sys->get_memory_system()->get_mmu()->sync_memory_access_path();
+        }
 
         ImGui::Checkbox("IPC", &conf->log_ipc);
         ImGui::SameLine(col2);
@@ -562,6 +639,13 @@ namespace eka2l1 {
             ImGui::SetTooltip("Enable kernel tracing that is used in driver. Slowdown expected on enable");
         }
 
+        ImGui::SameLine(col2);
+        ImGui::Checkbox("Cache executables", &conf->enable_e32_cache);
+
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("Keep decompressed executables on disk to speed up next boot. Takes effect on restart");
+        }
+
         ImGui::NewLine();
         ImGui::Text("System");
         ImGui::Separator();
@@ -1330,6 +1414,7 @@ namespace eka2l1 {
                 ImGui::Separator();
 
                 ImGui::MenuItem("Disassembler", nullptr, &should_show_disassembler);
+                ImGui::MenuItem("System calls", nullptr, &should_show_svc_stats);
 
                 if (ImGui::BeginMenu("Objects")) {
                     ImGui::MenuItem("Threads", nullptr, &should_show_threads);
@@ -1340,6 +1425,7 @@ namespace eka2l1 {
 
                 if (ImGui::BeginMenu("Services")) {
                     ImGui::MenuItem("Window tree", nullptr, &should_show_window_tree);
+                    ImGui::MenuItem("Bitmap cache", nullptr, &should_show_bitmap_cache);
                     ImGui::EndMenu();
                 }
 
@@ -1988,6 +2074,14 @@ namespace eka2l1 {
             show_disassembler();
         }
 
+        if (should_show_svc_stats) {
+            show_svc_stats();
+        }
+
+        if (should_show_bitmap_cache) {
+            show_bitmap_cache();
+        }
+
         if (should_show_preferences) {
             show_preferences();
         }
@@ -26,6 +26,9 @@
 
 #include <utils/reqsts.h>
 
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 // Foward declarations
@@ -43,33 +46,74 @@ namespace eka2l1::dispatch {
         std::uint64_t start_host_;
         audio_event *next_;
 
-        enum {
-            FLAG_COMPLETED = 1 << 0
-        };
+        explicit audio_event();
+    };
 
-        std::uint32_t flags_;
+    struct dsp_epoc_stream;
 
-        explicit audio_event();
+    /**
+     * \brief An audio request that has been completed by the host backend, but not yet by the kernel.
+     */
+    struct audio_completion {
+        epoc::notify_info info_;
+        dsp_epoc_stream *owner_;
+    };
+
+    /**
+     * \brief Audio requests completed by host audio threads, waiting for the kernel to complete them.
+     */
+    struct audio_completion_queue {
+    private:
+        std::vector<audio_completion> completions_;
+        std::atomic<bool> pending_;
+        std::mutex lock_;
+
+    public:
+        explicit audio_completion_queue();
+
+        /**
+         * \brief Queue a completion. This is safe to call from any thread.
+         */
+        void post(dsp_epoc_stream *owner, const epoc::notify_info &info);
+
+        /**
+         * \brief Move all queued completions to the given list, in the order they were posted.
+         * \returns False if nothing was queued. Does not lock in that case.
+         */
+        bool take_all(std::vector<audio_completion> &result);
+
+        /**
+         * \brief Move queued completions of a stream to the given list, in the order they were posted.
+         */
+        void take_owned_by(dsp_epoc_stream *owner, std::vector<audio_completion> &result);
+
+        void clear();
     };
 
     struct dsp_epoc_stream {
+        static constexpr std::size_t EVENT_POOL_CHUNK_SIZE = 16;
+
         std::unique_ptr<drivers::dsp_stream> ll_stream_;
         audio_event evt_queue_;
 
+        std::vector<std::unique_ptr<audio_event[]>> evt_pool_chunks_;
+        audio_event *evt_free_list_;
+
         std::mutex lock_;
 
         explicit dsp_epoc_stream(std::unique_ptr<drivers::dsp_stream> &stream);
-        ~dsp_epoc_stream();
 
+        audio_event *new_event();
         audio_event *get_event(const eka2l1::ptr<epoc::request_status> req_sts);
         void delete_event(audio_event *evt);
-
-        void deliver_audio_events(kernel_system *kern, ntimer *timing);
     };
 
     struct dispatcher {
     private:
-        void shutdown();
+        audio_completion_queue audio_completions_;
+
+        kernel_system *kern_;
+        std::size_t reschedule_callback_handle_;
 
     public:
         window_server *winserv_;
@@ -77,7 +121,6 @@ namespace eka2l1::dispatch {
         object_manager<drivers::player> audio_players_;
         object_manager<dsp_epoc_stream> dsp_streams_;
 
-        int audio_nof_complete_evt_;
         ntimer *timing_;
 
         explicit dispatcher();
@@ -85,7 +128,31 @@ namespace eka2l1::dispatch {
 
         void init(kernel_system *kern, ntimer *timing);
 
+        /**
+         * \brief Drop all streams and queued completions, and detach from the kernel.
+         *
+         * Must be called before the kernel is destroyed.
+         */
+        void shutdown();
+
         void resolve(eka2l1::system *sys, const std::uint32_t function_ord);
         void update_all_screens(eka2l1::system *sys);
+
+        /**
+         * \brief Queue an audio request to be completed by the kernel on its next reschedule.
+         *
+         * This is safe to call from host audio threads.
+         */
+        void post_audio_completion(dsp_epoc_stream *owner, const epoc::notify_info &info);
+
+        /**
+         * \brief Complete all queued audio requests. Must be called with the kernel locked.
+         */
+        void deliver_audio_completions();
+
+        /**
+         * \brief Complete all queued requests of a stream with the given code, instead of success.
+         */
+        void cancel_audio_completions(dsp_epoc_stream *owner, const int code);
     };
 }
\ No newline at end of file
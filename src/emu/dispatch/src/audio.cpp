@@ -35,32 +35,42 @@
 
 namespace eka2l1::dispatch {
     dsp_epoc_stream::dsp_epoc_stream(std::unique_ptr<drivers::dsp_stream> &stream)
-        : ll_stream_(std::move(stream)) {
+        : ll_stream_(std::move(stream))
+        , evt_free_list_(nullptr) {
     }
 
-    dsp_epoc_stream::~dsp_epoc_stream() {
-        audio_event *evt = evt_queue_.next_;
+    audio_event *dsp_epoc_stream::new_event() {
+        if (!evt_free_list_) {
+            // Grow the pool by a chunk. Events never move, since the chunks stay alive with the stream.
+            auto chunk = std::make_unique<audio_event[]>(EVENT_POOL_CHUNK_SIZE);
 
-        while (evt) {
-            audio_event *to_del = evt;
-            evt = evt->next_;
+            for (std::size_t i = 0; i < EVENT_POOL_CHUNK_SIZE; i++) {
+                chunk[i].next_ = evt_free_list_;
+                evt_free_list_ = &chunk[i];
+            }
 
-            delete to_del;
+            evt_pool_chunks_.push_back(std::move(chunk));
         }
+
+        audio_event *evt = evt_free_list_;
+        evt_free_list_ = evt->next_;
+
+        *evt = audio_event();
+        return evt;
     }
 
     audio_event *dsp_epoc_stream::get_event(const eka2l1::ptr<epoc::request_status> req_sts) {
         audio_event *evt = &evt_queue_;
 
         while (evt->next_ != nullptr) {
-            if (evt->info_.sts == req_sts) {
-                return evt;
+            if (evt->next_->info_.sts == req_sts) {
+                return evt->next_;
             }
 
             evt = evt->next_;
         }
 
-        evt->next_ = new audio_event;
+        evt->next_ = new_event();
         return evt->next_;
     }
 
@@ -70,26 +80,11 @@ namespace eka2l1::dispatch {
         while (evt->next_ != nullptr) {
             if (evt->next_ == the_evt) {
                 evt->next_ = the_evt->next_;
-                delete the_evt;
-
-                return;
-            }
-
-            evt = evt->next_;
-        }
-    }
 
-    void dsp_epoc_stream::deliver_audio_events(kernel_system *kern, ntimer *timing) {
-        const std::lock_guard<std::mutex> guard(lock_);
-        audio_event *evt = evt_queue_.next_;
+                the_evt->next_ = evt_free_list_;
+                evt_free_list_ = the_evt;
 
-        while (evt != nullptr) {
-            if (evt->flags_ & audio_event::FLAG_COMPLETED) {
-                kern->lock();
-                evt->info_.complete(epoc::error_none);
-                kern->unlock();
-
-                delete_event(evt);
+                return;
             }
 
             evt = evt->next_;
@@ -277,7 +272,6 @@ namespace eka2l1::dispatch {
     // DSP streams
     BRIDGE_FUNC_DISPATCHER(eka2l1::ptr<void>, eaudio_dsp_out_stream_create, void *) {
         dispatch::dispatcher *dispatcher = sys->get_dispatcher();
-        ntimer *timing = sys->get_ntimer();
         drivers::audio_driver *aud_driver = sys->get_audio_driver();
 
         auto ll_stream = drivers::new_dsp_out_stream(aud_driver, drivers::dsp_stream_backend_ffmpeg);
@@ -289,15 +283,11 @@ namespace eka2l1::dispatch {
 
         drivers::dsp_stream *ll_stream_ptr = ll_stream.get();
         auto stream_new = std::make_unique<dsp_epoc_stream>(ll_stream);
-
-        timing->schedule_event(500, dispatcher->audio_nof_complete_evt_, reinterpret_cast<std::uint64_t>(stream_new.get()));
-
         return dispatcher->dsp_streams_.add_object(stream_new);
     }
 
     BRIDGE_FUNC_DISPATCHER(std::int32_t, eaudio_dsp_stream_destroy, eka2l1::ptr<void> handle) {
         dispatch::dispatcher *dispatcher = sys->get_dispatcher();
-        ntimer *timing = sys->get_ntimer();
         drivers::audio_driver *aud_driver = sys->get_audio_driver();
 
         dsp_epoc_stream *stream = dispatcher->dsp_streams_.get_object(handle.ptr_address());
@@ -306,9 +296,11 @@ namespace eka2l1::dispatch {
             return epoc::error_bad_handle;
         }
 
-        timing->unschedule_event(dispatcher->audio_nof_complete_evt_, reinterpret_cast<std::uint64_t>(stream));
         dispatcher->dsp_streams_.remove_object(handle.ptr_address());
 
+        // The stream is gone along with its backend thread. Drop what it had posted but the kernel has not delivered.
+        dispatcher->cancel_audio_completions(stream, epoc::error_cancel);
+
         return epoc::error_none;
     }
 
@@ -378,8 +370,8 @@ namespace eka2l1::dispatch {
 
     audio_event::audio_event()
         : start_ticks_(0)
-        , next_(nullptr)
-        , flags_(0) {
+        , start_host_(0)
+        , next_(nullptr) {
     }
 
     BRIDGE_FUNC_DISPATCHER(std::int32_t, eaudio_dsp_stream_notify_buffer_ready, eka2l1::ptr<void> handle, eka2l1::ptr<epoc::request_status> req) {
@@ -408,11 +400,13 @@ namespace eka2l1::dispatch {
                 const std::lock_guard<std::mutex> guard(epoc_stream->lock_);
                 audio_event *evt = epoc_stream->evt_queue_.next_;
 
-                while (evt && (evt->flags_ & audio_event::FLAG_COMPLETED)) {
-                    evt = evt->next_;
+                if (!evt) {
+                    return;
                 }
 
-                evt->flags_ |= audio_event::FLAG_COMPLETED;
+                // Hand the request to the kernel, it will be completed on the next reschedule.
+                dispatcher->post_audio_completion(epoc_stream, evt->info_);
+                epoc_stream->delete_event(evt);
             },
             stream);
 
@@ -438,13 +432,16 @@ namespace eka2l1::dispatch {
             while (aud_evt) {
                 aud_evt->info_.complete(epoc::error_cancel);
 
-                audio_event *to_del = aud_evt;
+                audio_event *to_free = aud_evt;
                 aud_evt = aud_evt->next_;
 
-                delete to_del;
+                to_free->next_ = stream->evt_free_list_;
+                stream->evt_free_list_ = to_free;
             }
         }
 
+        dispatcher->cancel_audio_completions(stream, epoc::error_cancel);
+
         return epoc::error_none;
     }
 
@@ -27,9 +27,60 @@
 #include <common/log.h>
 #include <epoc/epoc.h>
 
+#include <algorithm>
+
 namespace eka2l1::dispatch {
+    audio_completion_queue::audio_completion_queue()
+        : pending_(false) {
+    }
+
+    void audio_completion_queue::post(dsp_epoc_stream *owner, const epoc::notify_info &info) {
+        const std::lock_guard<std::mutex> guard(lock_);
+
+        completions_.push_back({ info, owner });
+        pending_.store(true, std::memory_order_release);
+    }
+
+    bool audio_completion_queue::take_all(std::vector<audio_completion> &result) {
+        if (!pending_.load(std::memory_order_acquire)) {
+            return false;
+        }
+
+        const std::lock_guard<std::mutex> guard(lock_);
+
+        result.insert(result.end(), completions_.begin(), completions_.end());
+        completions_.clear();
+
+        pending_.store(false, std::memory_order_release);
+        return true;
+    }
+
+    void audio_completion_queue::take_owned_by(dsp_epoc_stream *owner, std::vector<audio_completion> &result) {
+        const std::lock_guard<std::mutex> guard(lock_);
+
+        auto remove_start = std::stable_partition(completions_.begin(), completions_.end(),
+            [owner](const audio_completion &completion) {
+                return completion.owner_ != owner;
+            });
+
+        result.insert(result.end(), remove_start, completions_.end());
+        completions_.erase(remove_start, completions_.end());
+
+        pending_.store(!completions_.empty(), std::memory_order_release);
+    }
+
+    void audio_completion_queue::clear() {
+        const std::lock_guard<std::mutex> guard(lock_);
+
+        completions_.clear();
+        pending_.store(false, std::memory_order_release);
+    }
+
     dispatcher::dispatcher()
-        : winserv_(nullptr) {
+        : kern_(nullptr)
+        , reschedule_callback_handle_(0)
+        , winserv_(nullptr)
+        , timing_(nullptr) {
     }
 
     dispatcher::~dispatcher() {
@@ -37,16 +88,20 @@ namespace eka2l1::dispatch {
     }
 
     void dispatcher::init(kernel_system *kern, ntimer *timing) {
+        if (kern_) {
+            kern_->unregister_reschedule_callback(reschedule_callback_handle_);
+        }
+
         winserv_ = reinterpret_cast<eka2l1::window_server *>(kern->get_by_name<service::server>(
             eka2l1::get_winserv_name_by_epocver(kern->get_epoc_version())));
 
-        audio_nof_complete_evt_ = timing->register_event("DispatchAudio", [this, kern, timing](std::uint64_t userdata, std::uint64_t late) {
-            dsp_epoc_stream *stream = reinterpret_cast<dsp_epoc_stream *>(userdata);
-            stream->deliver_audio_events(kern, timing);
-            timing->schedule_event(500 - late, audio_nof_complete_evt_, userdata);
+        // Audio completions are posted by the host audio threads, the kernel picks them up when it reschedules.
+        reschedule_callback_handle_ = kern->register_reschedule_callback([this]() {
+            deliver_audio_completions();
         });
 
         // Set global variables
+        kern_ = kern;
         timing_ = timing;
     }
 
@@ -62,9 +117,40 @@ namespace eka2l1::dispatch {
     }
 
     void dispatcher::shutdown() {
-        for (auto &stream : dsp_streams_.objs_) {
-            // Unschedule callback events.
-            timing_->unschedule_event(audio_nof_complete_evt_, reinterpret_cast<std::uint64_t>(stream.get()));
+        // Streams must go first, so no backend thread posts anything after the clear.
+        dsp_streams_.objs_.clear();
+        audio_completions_.clear();
+
+        if (kern_) {
+            // The callback points to us
+            kern_->unregister_reschedule_callback(reschedule_callback_handle_);
+            kern_ = nullptr;
+        }
+    }
+
+    void dispatcher::post_audio_completion(dsp_epoc_stream *owner, const epoc::notify_info &info) {
+        audio_completions_.post(owner, info);
+    }
+
+    void dispatcher::deliver_audio_completions() {
+        std::vector<audio_completion> to_deliver;
+
+        if (!audio_completions_.take_all(to_deliver)) {
+            return;
+        }
+
+        // Completed outside of the queue lock, so audio threads are not held up by the kernel
+        for (audio_completion &completion : to_deliver) {
+            completion.info_.complete(epoc::error_none);
+        }
+    }
+
+    void dispatcher::cancel_audio_completions(dsp_epoc_stream *owner, const int code) {
+        std::vector<audio_completion> to_cancel;
+        audio_completions_.take_owned_by(owner, to_cancel);
+
+        for (audio_completion &completion : to_cancel) {
+            completion.info_.complete(code);
         }
     }
 
@@ -23,13 +23,24 @@
 #include <drivers/audio/dsp.h>
 
 #include <common/queue.h>
+#include <common/ring.h>
 
+#include <atomic>
+#include <condition_variable>
+#include <memory>
 #include <mutex>
+#include <thread>
 #include <vector>
 
 namespace eka2l1::drivers {
     using dsp_buffer = std::vector<std::uint8_t>;
 
+    /**
+     * \brief DSP output stream that decodes on a worker thread.
+     *
+     * Submitted buffers are decoded by a worker, which fills a PCM ring buffer ahead of playback.
+     * The audio callback only copies samples out of the ring, so it never blocks, allocates or decodes.
+     */
     struct dsp_output_stream_shared : public dsp_output_stream {
     protected:
         drivers::audio_driver *aud_;
@@ -39,15 +50,48 @@ namespace eka2l1::drivers {
         std::uint16_t freq_;
 
         threadsafe_cn_queue<dsp_buffer> buffers_;
+        threadsafe_cn_queue<dsp_buffer> free_buffers_; ///< Consumed buffers, kept to avoid reallocating on write.
 
+        common::spsc_ring_buffer<std::int16_t> pcm_ring_;
         dsp_buffer decoded_;
-        std::size_t pointer_;
 
         std::int16_t last_frame_[2];
         std::mutex callback_lock_;
 
+        std::unique_ptr<std::thread> decode_thread_;
+        std::mutex decode_lock_; ///< Held by the worker while decoding and filling the ring.
+        std::condition_variable decode_cond_;
+        std::mutex decode_wait_lock_; ///< Also held when discarding, so the worker takes its buffer and generation together.
+
+        std::condition_variable ring_space_cond_; ///< Signalled by the audio callback after it consumed from the ring.
+        std::mutex ring_space_lock_;
+
+        std::atomic<bool> decode_stop_;
+        std::atomic<std::uint32_t> discard_generation_; ///< Increased on stop, so queued data is dropped.
+        std::atomic<bool> ring_discard_;                ///< Ask the audio callback to drop what's left in the ring.
+
         bool virtual_stop;
 
+        void decode_thread_loop();
+
+        /**
+         * \brief Push decoded samples to the ring, waiting for space if neccessary.
+         * \returns False if the data was discarded while waiting.
+         */
+        bool push_to_ring(const std::int16_t *samples, std::size_t count, const std::uint32_t generation);
+
+        /**
+         * \brief Wake the worker if it's waiting for ring space, so it can see a stop or discard.
+         */
+        void wake_ring_waiter();
+
+        /**
+         * \brief Stop and join the decode worker.
+         *
+         * Derived streams must call this in their destructor, since the worker calls decode_data.
+         */
+        void stop_decode_worker();
+
     public:
         explicit dsp_output_stream_shared(drivers::audio_driver *aud);
         ~dsp_output_stream_shared() override;
@@ -68,4 +112,4 @@ namespace eka2l1::drivers {
         virtual bool start() override;
         virtual bool stop() override;
     };
-}
\ No newline at end of file
+}
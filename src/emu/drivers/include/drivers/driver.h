@@ -20,35 +20,47 @@
 
 #pragma once
 
+#include <common/allocator.h>
 #include <common/queue.h>
+
+#include <algorithm>
 #include <condition_variable>
+#include <cstdint>
+#include <new>
+#include <string>
 
 namespace eka2l1::drivers {
-    static constexpr std::uint32_t MAX_COMMAND_DATA_SIZE = 80;
+    static constexpr std::size_t COMMAND_PACKET_ALIGNMENT = 8;
+
+    static constexpr std::size_t COMMAND_CHUNK_SIZE = 16 * 1024;
+    static constexpr std::size_t STAGING_CHUNK_SIZE = 256 * 1024;
 
     /**
      * \brief Represent a command for driver.
+     *
+     * This is only the header of a command packet. Arguments are packed right after it.
      */
     struct command {
         std::uint16_t opcode_;
-        std::uint8_t data_[MAX_COMMAND_DATA_SIZE];
-
-        command *next_;
+        std::uint16_t size_; ///< Size of the argument data, in bytes.
         int *status_;
 
-        explicit command()
-            : opcode_(0)
-            , data_()
-            , next_(nullptr)
-            , status_(nullptr) {
-        }
-
-        explicit command(const std::uint16_t opcode, int *status = nullptr)
+        explicit command(const std::uint16_t opcode, const std::uint16_t size, int *status = nullptr)
             : opcode_(opcode)
-            , data_()
-            , next_(nullptr)
+            , size_(size)
             , status_(status) {
         }
+
+        std::uint8_t *data() {
+            return reinterpret_cast<std::uint8_t *>(this) + sizeof(command);
+        }
+
+        /**
+         * \brief Size of the whole packet, header included. This is also the distance to the next packet.
+         */
+        std::size_t packet_size() const {
+            return (sizeof(command) + size_ + COMMAND_PACKET_ALIGNMENT - 1) & ~(COMMAND_PACKET_ALIGNMENT - 1);
+        }
     };
 
     struct command_helper {
@@ -61,24 +73,24 @@ namespace eka2l1::drivers {
         }
 
         bool push(const std::uint8_t *data, const std::uint16_t data_size) {
-            if (cursor_ + data_size > MAX_COMMAND_DATA_SIZE) {
+            if (cursor_ + data_size > todo_->size_) {
                 // Data full, abort
                 return false;
             }
 
-            std::copy(data, data + data_size, todo_->data_ + cursor_);
+            std::copy(data, data + data_size, todo_->data() + cursor_);
             cursor_ += data_size;
 
             return true;
         }
 
         bool pop(std::uint8_t *dest, const std::uint16_t dest_size) {
-            if (cursor_ + dest_size > MAX_COMMAND_DATA_SIZE) {
+            if (cursor_ + dest_size > todo_->size_) {
                 // Not possible to pop, abort
                 return false;
             }
 
-            std::copy(todo_->data_ + cursor_, todo_->data_ + cursor_ + dest_size, dest);
+            std::copy(todo_->data() + cursor_, todo_->data() + cursor_ + dest_size, dest);
 
             cursor_ += dest_size;
             return true;
@@ -101,21 +113,14 @@ namespace eka2l1::drivers {
         }
 
         bool push_string(const std::u16string &data) {
-            // Alloc memory for the string
+            // The string is stored inline, the packet must have been made big enough for it
             std::uint16_t length = static_cast<std::uint16_t>(data.length());
 
             if (!push(length)) {
                 return false;
             }
 
-            char16_t *dat = new char16_t[length];
-            std::copy(data.data(), data.data() + length, dat);
-
-            if (!push(dat)) {
-                return false;
-            }
-
-            return true;
+            return push(reinterpret_cast<const std::uint8_t *>(data.data()), static_cast<std::uint16_t>(length * sizeof(char16_t)));
         }
 
         bool pop_string(std::u16string &dat) {
@@ -125,16 +130,78 @@ namespace eka2l1::drivers {
             }
 
             dat.resize(length);
-            char16_t *ptr = nullptr;
+            return pop(reinterpret_cast<std::uint8_t *>(&dat[0]), static_cast<std::uint16_t>(length * sizeof(char16_t)));
+        }
+    };
 
-            if (!pop(ptr)) {
-                return false;
-            }
+    /**
+     * \brief A list of command.
+     *
+     * Command packets are recorded back to back into a linear arena, and walked in order by the driver.
+     * Payloads too big to be passed inline, such as bitmap data, are copied to a separate staging arena.
+     *
+     * All memory is given back to the pools at once when the list is destroyed, which happens after
+     * the driver has consumed it. Lists can be moved but not copied.
+     */
+    struct command_list {
+        common::linear_arena packets_;
+        common::linear_arena staging_;
 
-            std::copy(ptr, ptr + length, &dat[0]);
-            delete ptr;
+        explicit command_list(common::chunk_pool_ptr packet_pool = nullptr, common::chunk_pool_ptr staging_pool = nullptr)
+            : packets_(std::move(packet_pool))
+            , staging_(std::move(staging_pool)) {
+        }
 
-            return true;
+        /**
+         * \brief Allocate a new command packet at the end of the list.
+         *
+         * \param opcode     The opcode of the command.
+         * \param size       Size of the argument data to reserve.
+         * \param status     Pointer to the status to report the result to. Can be null.
+         */
+        command *allocate(const std::uint16_t opcode, const std::uint16_t size, int *status) {
+            command header(opcode, size, status);
+            void *packet = packets_.allocate(header.packet_size(), COMMAND_PACKET_ALIGNMENT);
+
+            return new (packet) command(header);
+        }
+
+        /**
+         * \brief Allocate memory for a payload, that lives as long as this list.
+         */
+        void *allocate_staging(const std::size_t size) {
+            return staging_.allocate(size, 16);
+        }
+
+        /**
+         * \brief Copy a payload to memory that lives as long as this list.
+         */
+        void *stage(const void *source, const std::size_t size) {
+            std::uint8_t *dest = reinterpret_cast<std::uint8_t *>(allocate_staging(size));
+            std::copy(reinterpret_cast<const std::uint8_t *>(source), reinterpret_cast<const std::uint8_t *>(source) + size, dest);
+
+            return dest;
+        }
+
+        bool empty() const {
+            return packets_.empty();
+        }
+
+        /**
+         * \brief Call the given function on each command, in the order they were recorded.
+         */
+        template <typename F>
+        void for_each(F func) {
+            for (const common::linear_arena::chunk &packet_chunk : packets_.chunks()) {
+                std::size_t offset = 0;
+
+                while (offset < packet_chunk.used_) {
+                    command *cmd = reinterpret_cast<command *>(packet_chunk.data_ + offset);
+                    offset += cmd->packet_size();
+
+                    func(cmd);
+                }
+            }
         }
     };
 
@@ -148,8 +215,8 @@ namespace eka2l1::drivers {
     }
 
     template <typename... Args>
-    command *make_command(const std::uint16_t opcode, int *status, Args... arguments) {
-        command *cmd = new command(opcode, status);
+    command *make_command(command_list &list, const std::uint16_t opcode, int *status, Args... arguments) {
+        command *cmd = list.allocate(opcode, static_cast<std::uint16_t>((0 + ... + sizeof(Args))), status);
         command_helper helper(cmd);
 
         if constexpr (sizeof...(Args) > 0)
@@ -158,30 +225,6 @@ namespace eka2l1::drivers {
         return cmd;
     }
 
-    /**
-     * \brief A linked list of command.
-     */
-    struct command_list {
-        command *first_;
-        command *last_;
-
-        explicit command_list()
-            : first_(nullptr) {
-        }
-
-        void add(command *cmd_) {
-            if (first_ == nullptr) {
-                first_ = cmd_;
-                last_ = cmd_;
-
-                return;
-            }
-
-            last_->next_ = cmd_;
-            last_ = cmd_;
-        }
-    };
-
     class driver {
     public:
         std::mutex mut_;
@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <drivers/graphics/backend/graphics_driver_shared.h>
+#include <drivers/graphics/backend/null/objects_null.h>
+
+#include <common/queue.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace eka2l1::drivers {
+    /**
+     * \brief Fixed function state used by the software rasterizer.
+     *
+     * The clip rectangle is stored top-left based, in pixels of the current render target.
+     */
+    struct null_raster_state {
+        bool clipping = false;
+        eka2l1::rect clip;
+
+        bool blend = false;
+        blend_equation rgb_equation = blend_equation::add;
+        blend_equation a_equation = blend_equation::add;
+        blend_factor rgb_frag_out_factor = blend_factor::one;
+        blend_factor rgb_current_factor = blend_factor::zero;
+        blend_factor a_frag_out_factor = blend_factor::one;
+        blend_factor a_current_factor = blend_factor::zero;
+
+        bool stencil = false;
+        condition_func stencil_func = condition_func::always;
+        std::uint8_t stencil_ref = 0;
+        std::uint8_t stencil_func_mask = 0xFF;
+        std::uint8_t stencil_write_mask = 0xFF;
+        stencil_action on_stencil_fail = stencil_action::keep;
+        stencil_action on_stencil_pass_depth_fail = stencil_action::keep;
+        stencil_action on_stencil_depth_pass = stencil_action::keep;
+    };
+
+    /**
+     * \brief Graphics driver that runs without a window or a GPU.
+     *
+     * Objects are tracked as usual so that clients get valid handles back. By default nothing is drawn,
+     * which is the cheapest way to do headless runs, such as benchmarks and automated tests.
+     *
+     * With software rendering enabled, bitmap and rectangle draws, clears, clipping, stencil and blending are
+     * executed on the CPU into the textures' host storage. Draws with custom shader programs are still dropped.
+     * Each presented frame can then be dumped to a folder as BMP files.
+     */
+    class null_graphics_driver : public shared_graphics_driver {
+        eka2l1::request_queue<server_graphics_command_list> list_queue;
+        std::atomic_bool should_stop;
+
+        bool software_rendering;
+        std::string frame_dump_folder;
+        std::uint32_t frame_dumped;
+
+        null_raster_state state;
+        null_raster_state backup;
+
+        std::unique_ptr<null_texture> swapchain_color;
+        std::unique_ptr<null_texture> swapchain_ds;
+
+        void display(command_helper &helper);
+        void native_dialog(command_helper &helper);
+
+        void recreate_swapchain();
+        void dump_frame();
+
+        null_texture *get_render_target();
+        null_texture *get_render_depth_stencil();
+
+        bool stencil_test(std::uint8_t *stencil_value);
+        void write_fragment(std::uint8_t *dest, const float *frag);
+        void blit_texture(null_texture *source, null_texture *mask, const eka2l1::rect &dest_rect, const eka2l1::rect &source_rect,
+            const std::uint32_t flags);
+
+        void clear(command_helper &helper);
+        void draw_bitmap(command_helper &helper);
+        void draw_glyph_run(command_helper &helper);
+        void draw_rectangle(command_helper &helper);
+        void set_clipping(command_helper &helper);
+        void clip_rect(command_helper &helper);
+        void set_stencil(command_helper &helper);
+        void set_blend(command_helper &helper);
+        void blend_formula(command_helper &helper);
+        void set_stencil_action(command_helper &helper);
+        void set_stencil_pass_condition(command_helper &helper);
+        void set_stencil_mask(command_helper &helper);
+
+    public:
+        explicit null_graphics_driver();
+        ~null_graphics_driver() override {}
+
+        /**
+         * \brief Execute draws on the CPU instead of dropping them.
+         *
+         * Must be set before the driver starts running.
+         */
+        void set_software_rendering(const bool enable) {
+            software_rendering = enable;
+        }
+
+        bool is_software_rendering() const {
+            return software_rendering;
+        }
+
+        /**
+         * \brief Dump each presented frame to the given folder. An empty path disables dumping.
+         *
+         * Dumping only has effect with software rendering. Must be set before the driver starts running.
+         */
+        void set_frame_dump_folder(const std::string &folder) {
+            frame_dump_folder = folder;
+        }
+
+        /**
+         * \brief Get the color texture of a bitmap, to read back what was rendered in software.
+         *
+         * Not synchronized with the driver thread. Only call it while no command list is being executed.
+         */
+        null_texture *get_bitmap_texture(const drivers::handle h);
+
+        void set_viewport(const eka2l1::rect &viewport) override;
+        std::unique_ptr<graphics_command_list> new_command_list() override;
+        void submit_command_list(graphics_command_list &command_list) override;
+        std::unique_ptr<graphics_command_list_builder> new_command_builder(graphics_command_list *list) override;
+
+        void run() override;
+        void abort() override;
+        void dispatch(command *cmd) override;
+        void bind_swapchain_framebuf() override;
+    };
+}
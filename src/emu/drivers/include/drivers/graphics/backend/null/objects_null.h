@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <drivers/graphics/buffer.h>
+#include <drivers/graphics/fb.h>
+#include <drivers/graphics/shader.h>
+#include <drivers/graphics/texture.h>
+
+#include <vector>
+
+namespace eka2l1::drivers {
+    /**
+     * \brief Texture of the null graphics driver.
+     *
+     * Only the description is kept, unless the driver does software rendering. In that case, texels are
+     * stored in host memory: four bytes (RGBA) per texel for color textures, and one stencil byte per texel for
+     * depth stencil textures. Storage is allocated on first use, rows are top to bottom.
+     */
+    class null_texture : public texture {
+    protected:
+        int dimensions;
+        int mip_level;
+        vec2 tex_size;
+        texture_format internal_format;
+        texture_format format;
+        texture_data_type tex_data_type;
+        void *tex_data;
+
+        channel_swizzles swizzle;
+        std::vector<std::uint8_t> storage;
+
+    public:
+        explicit null_texture();
+        ~null_texture() override {}
+
+        bool create(graphics_driver *driver, const int dim, const int miplvl, const vec3 &size, const texture_format internal_format,
+            const texture_format format, const texture_data_type data_type, void *data, const std::size_t pixels_per_line = 0) override;
+
+        bool tex(graphics_driver *driver, const bool is_first = false) override;
+
+        void change_size(const vec3 &new_size) override;
+        void change_data(const texture_data_type data_type, void *data) override;
+        void change_texture_format(const texture_format format) override;
+
+        void set_filter_minmag(const bool min, const filter_option op) override;
+        void set_channel_swizzle(channel_swizzles swizz) override;
+
+        void bind(graphics_driver *driver, const int binding) override;
+        void unbind(graphics_driver *driver) override;
+
+        void update_data(graphics_driver *driver, const int mip_lvl, const vec3 &offset, const vec3 &size, const std::size_t byte_width,
+            const texture_format data_format, const texture_data_type data_type, const void *data) override;
+
+        vec2 get_size() const override {
+            return tex_size;
+        }
+
+        texture_format get_format() const override {
+            return internal_format;
+        }
+
+        texture_data_type get_data_type() const override {
+            return tex_data_type;
+        }
+
+        int get_mip_level() const override {
+            return mip_level;
+        }
+
+        int get_total_dimensions() const override {
+            return dimensions;
+        }
+
+        void *get_data_ptr() const override {
+            return tex_data;
+        }
+
+        std::uint64_t texture_handle() override {
+            return reinterpret_cast<std::uint64_t>(this);
+        }
+
+        bool is_depth_stencil() const {
+            return (internal_format == texture_format::depth_stencil) || (internal_format == texture_format::depth24_stencil8);
+        }
+
+        bool has_storage() const {
+            return !storage.empty();
+        }
+
+        /**
+         * \brief Get the texel storage, allocating it if this has not been done yet.
+         */
+        std::uint8_t *get_storage();
+
+        /**
+         * \brief Read a texel as normalized RGBA, with the channel swizzle applied.
+         *
+         * Coordinates are clamped to the texture size.
+         */
+        void sample(int x, int y, float *rgba);
+    };
+
+    class null_framebuffer : public framebuffer {
+        std::int32_t draw_attachment;
+        std::int32_t read_attachment;
+
+    public:
+        explicit null_framebuffer(std::initializer_list<texture *> color_buffer_list,
+            texture *depth_and_stencil_buffer);
+
+        ~null_framebuffer() override {}
+
+        void bind(graphics_driver *driver) override;
+        void unbind(graphics_driver *driver) override;
+
+        std::int32_t set_color_buffer(texture *tex, const std::int32_t position = -1) override;
+        bool set_depth_stencil_buffer(texture *tex) override;
+        bool set_draw_buffer(const std::int32_t attachment_id) override;
+        bool set_read_buffer(const std::int32_t attachment_id) override;
+
+        bool remove_color_buffer(const std::int32_t position) override;
+        bool blit(const eka2l1::rect &source_rect, const eka2l1::rect &dest_rect, const std::uint32_t flags,
+            const filter_option copy_filter) override;
+    };
+
+    class null_shader : public shader {
+    public:
+        ~null_shader() override {}
+
+        bool create(graphics_driver *driver, const char *vert_data, const std::size_t vert_size,
+            const char *frag_data, const std::size_t frag_size) override;
+
+        bool set(graphics_driver *driver, const int binding, const shader_set_var_type var_type, const void *data) override;
+
+        bool use(graphics_driver *driver) override;
+        std::optional<int> get_uniform_location(const std::string &name) override;
+        std::optional<int> get_attrib_location(const std::string &name) override;
+    };
+
+    class null_buffer : public buffer {
+        std::size_t size_;
+
+    public:
+        explicit null_buffer();
+        ~null_buffer() override {}
+
+        void bind(graphics_driver *driver) override;
+        void unbind(graphics_driver *driver) override;
+
+        void attach_descriptors(graphics_driver *driver, const int stride, const bool instance_move,
+            const attribute_descriptor *descriptors, const int total) override;
+
+        bool create(graphics_driver *driver, const std::size_t initial_size, const buffer_hint hint, const buffer_upload_hint use_hint) override;
+        void update_data(graphics_driver *driver, const void *data, const std::size_t offset, const std::size_t size) override;
+    };
+}
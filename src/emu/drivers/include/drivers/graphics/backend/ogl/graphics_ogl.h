@@ -29,6 +29,7 @@
 
 #include <memory>
 #include <queue>
+#include <vector>
 
 namespace eka2l1::drivers {
     struct ogl_state {
@@ -60,6 +61,13 @@ namespace eka2l1::drivers {
         GLuint sprite_vbo;
         GLuint sprite_ibo;
 
+        // Glyph runs are drawn from one vertex buffer, with indices for as many quads as the largest run so far
+        GLuint glyph_vao;
+        GLuint glyph_vbo;
+        GLuint glyph_ibo;
+        std::size_t glyph_ibo_quad_count;
+        std::vector<GLfloat> glyph_verts;
+
         GLuint fill_vao;
         GLuint fill_vbo;
 
@@ -85,6 +93,7 @@ namespace eka2l1::drivers {
 
         void clear(command_helper &helper);
         void draw_bitmap(command_helper &helper);
+        void draw_glyph_run(command_helper &helper);
         void draw_rectangle(command_helper &helper);
         void set_clipping(command_helper &helper);
         void clip_rect(command_helper &helper);
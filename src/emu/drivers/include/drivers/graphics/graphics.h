@@ -56,6 +56,7 @@ namespace eka2l1::drivers {
         graphics_driver_draw_bitmap,
         graphics_driver_draw_rectangle,
         graphics_driver_resize_bitmap,
+        graphics_driver_draw_glyph_run,
 
         // Mode 1: Advance - Lower access to functions
         graphics_driver_create_program,
@@ -88,9 +89,15 @@ namespace eka2l1::drivers {
     protected:
         display_hook disp_hook_;
 
+        // Memory recycled between command lists, once the driver is done with them
+        common::chunk_pool_ptr command_pool_;
+        common::chunk_pool_ptr staging_pool_;
+
     public:
         explicit graphics_driver(graphic_api api)
-            : api_(api) {}
+            : api_(api)
+            , command_pool_(std::make_shared<common::chunk_pool>(COMMAND_CHUNK_SIZE))
+            , staging_pool_(std::make_shared<common::chunk_pool>(STAGING_CHUNK_SIZE)) {}
 
         virtual ~graphics_driver() {
         }
@@ -110,11 +110,26 @@ namespace eka2l1::drivers {
      */
     bool open_native_dialog(graphics_driver *driver, const char *filter, drivers::graphics_driver_dialog_callback callback, const bool is_folder = false);
 
+    /**
+     * \brief A glyph in a glyph run.
+     *
+     * The source rectangle is in pixels of the atlas bitmap, the destination one in pixels of the binded bitmap.
+     */
+    struct glyph_quad {
+        eka2l1::rect source_rect;
+        eka2l1::rect dest_rect;
+    };
+
     struct graphics_command_list {
+        virtual ~graphics_command_list() {}
     };
 
     struct server_graphics_command_list : public graphics_command_list {
         command_list list_;
+
+        explicit server_graphics_command_list(common::chunk_pool_ptr packet_pool = nullptr, common::chunk_pool_ptr staging_pool = nullptr)
+            : list_(std::move(packet_pool), std::move(staging_pool)) {
+        }
     };
 
     class graphics_command_list_builder {
@@ -196,6 +211,19 @@ namespace eka2l1::drivers {
          */
         virtual void draw_bitmap(drivers::handle h, drivers::handle maskh, const eka2l1::rect &dest_rect, const eka2l1::rect &source_rect, const std::uint32_t flags = 0) = 0;
 
+        /**
+         * \brief Draw many glyphs from an atlas bitmap to currently binded bitmap, in one draw.
+         *
+         * Unlike draw_bitmap, empty rectangles are not replaced with the whole bitmap. Quads are copied,
+         * and don't need to exist after calling this function.
+         *
+         * \param atlas_h      The handle of the atlas bitmap to take glyphs from.
+         * \param quads        Pointer to the glyph quads to draw.
+         * \param quad_count   Number of glyph quads.
+         * \param flags        Drawing flags, same as the ones of draw_bitmap.
+         */
+        virtual void draw_glyph_run(drivers::handle atlas_h, const glyph_quad *quads, const std::size_t quad_count, const std::uint32_t flags = 0) = 0;
+
         /**
          * \brief Draw a rectangle with brush color.
          * 
@@ -424,6 +452,8 @@ namespace eka2l1::drivers {
 
         void draw_bitmap(drivers::handle h, drivers::handle maskh, const eka2l1::rect &dest_rect, const eka2l1::rect &source_rect, const std::uint32_t flags = 0) override;
 
+        void draw_glyph_run(drivers::handle atlas_h, const glyph_quad *quads, const std::size_t quad_count, const std::uint32_t flags = 0) override;
+
         void draw_rectangle(const eka2l1::rect &target_rect) override;
 
         void use_program(drivers::handle h) override;
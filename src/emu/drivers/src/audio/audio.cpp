@@ -19,6 +19,7 @@
 
 #include <drivers/audio/audio.h>
 #include <drivers/audio/backend/cubeb/audio_cubeb.h>
+#include <drivers/audio/backend/null/audio_null.h>
 
 namespace eka2l1::drivers {
     std::unique_ptr<audio_driver> make_audio_driver(const audio_driver_backend backend) {
@@ -27,6 +28,10 @@ namespace eka2l1::drivers {
             return std::make_unique<cubeb_audio_driver>();
         }
 
+        case audio_driver_backend::null: {
+            return std::make_unique<null_audio_driver>();
+        }
+
         default:
             break;
         }
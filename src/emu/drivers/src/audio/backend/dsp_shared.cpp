@@ -18,21 +18,53 @@
  */
 
 #include <common/log.h>
+#include <common/thread.h>
 #include <drivers/audio/backend/dsp_shared.h>
 
 namespace eka2l1::drivers {
+    // The ring holds 1/8 of a second of audio. Enough to survive hiccups of the decode worker,
+    // while keeping the buffer copied notification close to actual playback.
+    static constexpr std::uint32_t PCM_RING_LENGTH_DIVISOR = 8;
+
     dsp_output_stream_shared::dsp_output_stream_shared(drivers::audio_driver *aud)
         : aud_(aud)
-        , pointer_(0)
+        , channels_(0)
+        , freq_(0)
+        , decode_stop_(false)
+        , discard_generation_(0)
+        , ring_discard_(false)
         , virtual_stop(true) {
         last_frame_[0] = 0;
         last_frame_[1] = 0;
+
+        decode_thread_ = std::make_unique<std::thread>([this]() {
+            decode_thread_loop();
+        });
     }
 
     dsp_output_stream_shared::~dsp_output_stream_shared() {
         if (stream_) {
             stream_->stop();
         }
+
+        stop_decode_worker();
+    }
+
+    void dsp_output_stream_shared::stop_decode_worker() {
+        if (!decode_thread_) {
+            return;
+        }
+
+        {
+            const std::lock_guard<std::mutex> guard(decode_wait_lock_);
+            decode_stop_ = true;
+        }
+
+        decode_cond_.notify_all();
+        wake_ring_waiter();
+
+        decode_thread_->join();
+        decode_thread_.reset();
     }
 
     bool dsp_output_stream_shared::set_properties(const std::uint32_t freq, const std::uint8_t channels) {
@@ -49,8 +81,23 @@ namespace eka2l1::drivers {
             stream_.reset();
         }
 
-        channels_ = channels;
-        freq_ = freq;
+        {
+            // Make the worker give up on what it's pushing, since nobody is consuming the ring now
+            const std::lock_guard<std::mutex> guard(decode_wait_lock_);
+            discard_generation_++;
+        }
+
+        wake_ring_waiter();
+
+        {
+            const std::lock_guard<std::mutex> guard(decode_lock_);
+
+            channels_ = channels;
+            freq_ = freq;
+
+            pcm_ring_.resize(freq * channels / PCM_RING_LENGTH_DIVISOR);
+            ring_discard_ = false;
+        }
 
         stream_ = aud_->new_output_stream(freq, channels, [this](std::int16_t *buffer, const std::size_t nb_frames) {
             return data_callback(buffer, nb_frames);
@@ -98,10 +145,20 @@ namespace eka2l1::drivers {
         buffer_copied_callback_ = nullptr;
         virtual_stop = true;
 
-        // Discard all buffers
-        while (auto buffer = buffers_.pop()) {
+        {
+            // Discard all buffers, including what has been decoded. The worker takes its buffer and
+            // generation under this lock, so it can't pop a buffer queued before and miss the new generation.
+            const std::lock_guard<std::mutex> guard(decode_wait_lock_);
+            discard_generation_++;
+
+            while (auto buffer = buffers_.pop()) {
+                free_buffers_.push(std::move(buffer.value()));
+            }
         }
 
+        ring_discard_ = true;
+        wake_ring_waiter();
+
         return true;
     }
 
@@ -143,64 +200,136 @@ namespace eka2l1::drivers {
     }
 
     bool dsp_output_stream_shared::write(const std::uint8_t *data, const std::uint32_t data_size) {
-        // Copy buffer to queue
-        dsp_buffer buffer;
-        buffer.resize(data_size);
-
-        std::memcpy(&buffer[0], data, data_size);
+        // Reuse a consumed buffer if there is one, to avoid allocating
+        dsp_buffer buffer = free_buffers_.pop().value_or(dsp_buffer{});
+        buffer.assign(data, data + data_size);
 
         // Push it to the queue
-        buffers_.push(buffer);
+        buffers_.push(std::move(buffer));
+
+        {
+            // Taking the lock makes sure the worker is either waiting, or will see the new buffer
+            const std::lock_guard<std::mutex> guard(decode_wait_lock_);
+        }
 
+        decode_cond_.notify_one();
         return true;
     }
 
-    std::size_t dsp_output_stream_shared::data_callback(std::int16_t *buffer, const std::size_t frame_count) {
-        std::size_t frame_wrote = 0;
+    void dsp_output_stream_shared::wake_ring_waiter() {
+        {
+            // Taking the lock makes sure the worker is either waiting, or will see the change
+            const std::lock_guard<std::mutex> guard(ring_space_lock_);
+        }
+
+        ring_space_cond_.notify_all();
+    }
+
+    bool dsp_output_stream_shared::push_to_ring(const std::int16_t *samples, std::size_t count, const std::uint32_t generation) {
+        // Only push whole frames, so the audio callback never gets half of one. A partial frame
+        // at the end can never be pushed.
+        while ((count > 0) && (count >= channels_)) {
+            if (decode_stop_ || (discard_generation_ != generation) || (pcm_ring_.capacity() == 0)) {
+                return false;
+            }
+
+            std::size_t to_push = std::min<std::size_t>(count, pcm_ring_.free_space());
+            to_push -= to_push % channels_;
 
-        while (frame_wrote < frame_count) {
+            if (to_push == 0) {
+                // Let the audio callback drain some
+                std::unique_lock<std::mutex> ulock(ring_space_lock_);
+                ring_space_cond_.wait(ulock, [&]() {
+                    return decode_stop_ || (discard_generation_ != generation) || (pcm_ring_.free_space() >= channels_);
+                });
+
+                continue;
+            }
+
+            const std::size_t pushed = pcm_ring_.write(samples, to_push);
+
+            samples += pushed;
+            count -= pushed;
+        }
+
+        return true;
+    }
+
+    void dsp_output_stream_shared::decode_thread_loop() {
+        common::set_thread_name("DSP decode thread");
+
+        while (true) {
             std::optional<dsp_buffer> encoded;
+            std::uint32_t generation = 0;
 
-            if ((decoded_.size() == 0) || (decoded_.size() == pointer_)) {
-                encoded = buffers_.pop();
+            {
+                std::unique_lock<std::mutex> ulock(decode_wait_lock_);
 
-                if (!encoded) {
-                    break;
-                }
+                while (!decode_stop_) {
+                    // Taken together with the buffer. See stop.
+                    generation = discard_generation_;
 
-                // Callback that internal buffer has been copied
-                {
-                    const std::lock_guard<std::mutex> guard(callback_lock_);
-                    if (buffer_copied_callback_) {
-                        buffer_copied_callback_(buffer_copied_userdata_);
+                    if ((encoded = buffers_.pop())) {
+                        break;
                     }
+
+                    decode_cond_.wait(ulock);
+                }
+
+                if (decode_stop_) {
+                    break;
                 }
+            }
 
-                pointer_ = 0;
+            bool pushed = false;
+
+            {
+                const std::lock_guard<std::mutex> guard(decode_lock_);
 
                 if (format_ == PCM16_FOUR_CC_CODE) {
-                    decoded_ = encoded.value();
+                    pushed = push_to_ring(reinterpret_cast<const std::int16_t *>(encoded->data()),
+                        encoded->size() / sizeof(std::int16_t), generation);
                 } else {
+                    decoded_.clear();
                     decode_data(encoded.value(), decoded_);
+
+                    pushed = push_to_ring(reinterpret_cast<const std::int16_t *>(decoded_.data()),
+                        decoded_.size() / sizeof(std::int16_t), generation);
                 }
             }
 
-            // We want to decode more
-            std::size_t frame_to_wrote = ((decoded_.size() - pointer_) / channels_ / sizeof(std::int16_t));
-            frame_to_wrote = std::min<std::size_t>(frame_to_wrote, frame_count - frame_wrote);
+            if (pushed) {
+                // Callback that internal buffer has been copied
+                const std::lock_guard<std::mutex> guard(callback_lock_);
 
-            std::memcpy(&buffer[frame_wrote * channels_], &decoded_[pointer_], frame_to_wrote * channels_ * sizeof(std::int16_t));
+                if (buffer_copied_callback_) {
+                    buffer_copied_callback_(buffer_copied_userdata_);
+                }
+            }
 
-            // Set last frame
-            std::memcpy(last_frame_, &decoded_[pointer_ + (frame_to_wrote - 1) * channels_ * sizeof(std::int16_t)], channels_ * sizeof(std::int16_t));
+            free_buffers_.push(std::move(encoded.value()));
+        }
+    }
+
+    std::size_t dsp_output_stream_shared::data_callback(std::int16_t *buffer, const std::size_t frame_count) {
+        // This runs on the audio thread. Do not lock, allocate or decode here.
+        if (ring_discard_.exchange(false)) {
+            pcm_ring_.skip_all();
+        }
+
+        const std::size_t frame_wrote = pcm_ring_.read(buffer, frame_count * channels_) / channels_;
 
-            pointer_ += frame_to_wrote * channels_ * sizeof(std::int16_t);
-            frame_wrote += frame_to_wrote;
+        // Not locking here. If the worker misses this, the next callback wakes it.
+        ring_space_cond_.notify_one();
+
+        if (frame_wrote != 0) {
+            // Set last frame
+            std::memcpy(last_frame_, &buffer[(frame_wrote - 1) * channels_], channels_ * sizeof(std::int16_t));
         }
 
-        for (; frame_wrote < frame_count; frame_wrote++) {
+        for (std::size_t i = frame_wrote; i < frame_count; i++) {
             // We dont want to drain the audio driver, so fill it with last frame
-            std::memcpy(&buffer[frame_wrote * channels_], last_frame_, channels_ * sizeof(std::int16_t));
+            std::memcpy(&buffer[i * channels_], last_frame_, channels_ * sizeof(std::int16_t));
         }
 
         // TODO: What? Is this right
@@ -208,4 +337,4 @@ namespace eka2l1::drivers {
 
         return frame_count;
     }
-}
\ No newline at end of file
+}
@@ -41,6 +41,9 @@ namespace eka2l1::drivers {
     }
 
     dsp_output_stream_ffmpeg::~dsp_output_stream_ffmpeg() {
+        // The worker may still be decoding with our codec
+        stop_decode_worker();
+
         if (codec_) {
             avcodec_free_context(&codec_);
         }
@@ -53,6 +56,10 @@ namespace eka2l1::drivers {
     }
 
     bool dsp_output_stream_ffmpeg::format(const four_cc fmt) {
+        // Data queued for the old codec is useless now. This also stops the worker from waiting on ring space.
+        discard_generation_++;
+        const std::lock_guard<std::mutex> guard(decode_lock_);
+
         auto find_result = FOUR_CC_TO_FFMPEG_CODEC_MAP.find(fmt);
 
         if (find_result == FOUR_CC_TO_FFMPEG_CODEC_MAP.end()) {
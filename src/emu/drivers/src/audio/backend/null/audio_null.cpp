@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <drivers/audio/backend/null/audio_null.h>
+
+#include <chrono>
+
+namespace eka2l1::drivers {
+    static constexpr std::uint32_t NULL_AUDIO_SAMPLE_RATE = 44100;
+    static constexpr std::uint32_t NULL_AUDIO_PULL_INTERVAL_MS = 10;
+
+    null_audio_output_stream::null_audio_output_stream(const std::uint32_t sample_rate, const std::uint8_t channels,
+        data_callback callback)
+        : sample_rate_(sample_rate)
+        , channels_(channels)
+        , callback_(callback)
+        , playing_(false) {
+    }
+
+    null_audio_output_stream::~null_audio_output_stream() {
+        stop();
+    }
+
+    void null_audio_output_stream::pull_loop() {
+        const std::size_t frames = sample_rate_ * NULL_AUDIO_PULL_INTERVAL_MS / 1000;
+        std::vector<std::int16_t> scratch(frames * channels_);
+
+        auto next_pull = std::chrono::steady_clock::now();
+
+        // Consume at the pace a real device would, so the guest sees buffers complete in time
+        while (playing_) {
+            callback_(scratch.data(), frames);
+
+            next_pull += std::chrono::milliseconds(NULL_AUDIO_PULL_INTERVAL_MS);
+            std::this_thread::sleep_until(next_pull);
+        }
+    }
+
+    bool null_audio_output_stream::start() {
+        if (playing_) {
+            return true;
+        }
+
+        playing_ = true;
+        pull_thread_ = std::make_unique<std::thread>([this]() { pull_loop(); });
+
+        return true;
+    }
+
+    bool null_audio_output_stream::stop() {
+        if (!playing_) {
+            return true;
+        }
+
+        playing_ = false;
+
+        if (pull_thread_) {
+            pull_thread_->join();
+            pull_thread_.reset();
+        }
+
+        return true;
+    }
+
+    bool null_audio_output_stream::is_playing() {
+        return playing_;
+    }
+
+    bool null_audio_output_stream::set_volume(const float volume) {
+        return true;
+    }
+
+    std::unique_ptr<audio_output_stream> null_audio_driver::new_output_stream(const std::uint32_t sample_rate,
+        const std::uint8_t channels, data_callback callback) {
+        return std::make_unique<null_audio_output_stream>(sample_rate, channels, callback);
+    }
+
+    std::uint32_t null_audio_driver::native_sample_rate() {
+        return NULL_AUDIO_SAMPLE_RATE;
+    }
+}
@@ -231,8 +231,6 @@ namespace eka2l1::drivers {
         helper.pop(pixels_per_line);
 
         update_bitmap(handle, size, offset, dim, bpp, data, pixels_per_line);
-
-        delete data;
     }
 
     void shared_graphics_driver::create_bitmap(command_helper &helper) {
@@ -480,8 +478,6 @@ namespace eka2l1::drivers {
         }
 
         shobj->set(this, binding, var_type, data);
-
-        delete data;
     }
 
     void shared_graphics_driver::set_swizzle(command_helper &helper) {
@@ -574,8 +570,6 @@ namespace eka2l1::drivers {
         }
 
         bufobj->update_data(this, data, offset, size);
-
-        delete data;
     }
 
     void shared_graphics_driver::attach_descriptors(drivers::handle h, const int stride, const bool instance_move,
@@ -603,8 +597,6 @@ namespace eka2l1::drivers {
         helper.pop(descriptor_count);
 
         attach_descriptors(h, stride, instance_move, descriptors, descriptor_count);
-
-        delete descriptors;
     }
 
     void shared_graphics_driver::destroy_object(command_helper &helper) {
@@ -0,0 +1,764 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <drivers/graphics/backend/null/graphics_null.h>
+
+#include <common/algorithm.h>
+#include <common/bitmap.h>
+#include <common/log.h>
+#include <common/path.h>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <fstream>
+#include <vector>
+
+namespace eka2l1::drivers {
+    static float get_blend_factor(const blend_factor factor, const float *frag, const float *current) {
+        switch (factor) {
+        case blend_factor::one:
+            return 1.0f;
+
+        case blend_factor::zero:
+            return 0.0f;
+
+        case blend_factor::frag_out_alpha:
+            return frag[3];
+
+        case blend_factor::one_minus_frag_out_alpha:
+            return 1.0f - frag[3];
+
+        case blend_factor::current_alpha:
+            return current[3];
+
+        case blend_factor::one_minus_current_alpha:
+            return 1.0f - current[3];
+
+        default:
+            break;
+        }
+
+        return 1.0f;
+    }
+
+    static float do_blend_equation(const blend_equation equation, const float frag, const float current) {
+        switch (equation) {
+        case blend_equation::sub:
+            return frag - current;
+
+        case blend_equation::isub:
+            return current - frag;
+
+        default:
+            break;
+        }
+
+        return frag + current;
+    }
+
+    static bool do_condition_func(const condition_func func, const std::uint8_t ref, const std::uint8_t value) {
+        switch (func) {
+        case condition_func::never:
+            return false;
+
+        case condition_func::less:
+            return ref < value;
+
+        case condition_func::less_or_equal:
+            return ref <= value;
+
+        case condition_func::greater:
+            return ref > value;
+
+        case condition_func::greater_or_equal:
+            return ref >= value;
+
+        case condition_func::equal:
+            return ref == value;
+
+        case condition_func::not_equal:
+            return ref != value;
+
+        default:
+            break;
+        }
+
+        return true;
+    }
+
+    static std::uint8_t do_stencil_action(const stencil_action action, const std::uint8_t ref, const std::uint8_t value) {
+        switch (action) {
+        case stencil_action::replace:
+            return ref;
+
+        case stencil_action::invert:
+            return ~value;
+
+        case stencil_action::increment:
+            return (value == 0xFF) ? value : value + 1;
+
+        case stencil_action::increment_wrap:
+            return value + 1;
+
+        case stencil_action::decrement:
+            return (value == 0) ? value : value - 1;
+
+        case stencil_action::decrement_wrap:
+            return value - 1;
+
+        case stencil_action::set_to_zero:
+            return 0;
+
+        default:
+            break;
+        }
+
+        return value;
+    }
+
+    static bool is_front_face_affected(const stencil_face face) {
+        // Everything drawn here is a screen-aligned quad facing the viewer
+        return (face == stencil_face::front) || (face == stencil_face::back_and_front);
+    }
+
+    null_graphics_driver::null_graphics_driver()
+        : shared_graphics_driver(graphic_api::null)
+        , should_stop(false)
+        , software_rendering(false)
+        , frame_dumped(0) {
+    }
+
+    void null_graphics_driver::recreate_swapchain() {
+        if (swapchain_color && (swapchain_color->get_size() == swapchain_size)) {
+            return;
+        }
+
+        swapchain_color = std::make_unique<null_texture>();
+        swapchain_color->create(this, 2, 0, eka2l1::vec3(swapchain_size.x, swapchain_size.y, 0), texture_format::rgba,
+            texture_format::rgba, texture_data_type::ubyte, nullptr);
+
+        swapchain_ds = std::make_unique<null_texture>();
+        swapchain_ds->create(this, 2, 0, eka2l1::vec3(swapchain_size.x, swapchain_size.y, 0), texture_format::depth24_stencil8,
+            texture_format::depth_stencil, texture_data_type::uint_24_8, nullptr);
+    }
+
+    null_texture *null_graphics_driver::get_bitmap_texture(const drivers::handle h) {
+        bitmap *bmp = get_bitmap(h);
+        return bmp ? reinterpret_cast<null_texture *>(bmp->tex.get()) : nullptr;
+    }
+
+    null_texture *null_graphics_driver::get_render_target() {
+        if (binding) {
+            return reinterpret_cast<null_texture *>(binding->tex.get());
+        }
+
+        return swapchain_color.get();
+    }
+
+    null_texture *null_graphics_driver::get_render_depth_stencil() {
+        if (binding) {
+            return reinterpret_cast<null_texture *>(binding->ds_tex.get());
+        }
+
+        return swapchain_ds.get();
+    }
+
+    bool null_graphics_driver::stencil_test(std::uint8_t *stencil_value) {
+        if (!state.stencil || !stencil_value) {
+            return true;
+        }
+
+        const std::uint8_t old_value = *stencil_value;
+        const bool passed = do_condition_func(state.stencil_func, state.stencil_ref & state.stencil_func_mask,
+            old_value & state.stencil_func_mask);
+
+        // There is no depth buffer to test against, so passing the stencil test also means passing the depth test
+        const std::uint8_t new_value = do_stencil_action(passed ? state.on_stencil_depth_pass : state.on_stencil_fail,
+            state.stencil_ref, old_value);
+
+        *stencil_value = (old_value & ~state.stencil_write_mask) | (new_value & state.stencil_write_mask);
+        return passed;
+    }
+
+    void null_graphics_driver::write_fragment(std::uint8_t *dest, const float *frag) {
+        float result[4];
+
+        if (state.blend) {
+            const float current[4] = { dest[0] / 255.0f, dest[1] / 255.0f, dest[2] / 255.0f, dest[3] / 255.0f };
+
+            for (int i = 0; i < 4; i++) {
+                const bool is_alpha = (i == 3);
+
+                const float frag_factor = get_blend_factor(is_alpha ? state.a_frag_out_factor : state.rgb_frag_out_factor,
+                    frag, current);
+                const float current_factor = get_blend_factor(is_alpha ? state.a_current_factor : state.rgb_current_factor,
+                    frag, current);
+
+                result[i] = do_blend_equation(is_alpha ? state.a_equation : state.rgb_equation, frag[i] * frag_factor,
+                    current[i] * current_factor);
+            }
+        } else {
+            std::copy(frag, frag + 4, result);
+        }
+
+        for (int i = 0; i < 4; i++) {
+            dest[i] = static_cast<std::uint8_t>(common::clamp(0.0f, 1.0f, result[i]) * 255.0f + 0.5f);
+        }
+    }
+
+    static eka2l1::rect get_raster_area(const eka2l1::rect &area, const eka2l1::vec2 &target_size, const null_raster_state &state) {
+        eka2l1::vec2 start = area.top;
+        eka2l1::vec2 end = area.top + area.size;
+
+        if (state.clipping) {
+            start.x = common::max(start.x, state.clip.top.x);
+            start.y = common::max(start.y, state.clip.top.y);
+            end.x = common::min(end.x, state.clip.top.x + state.clip.size.x);
+            end.y = common::min(end.y, state.clip.top.y + state.clip.size.y);
+        }
+
+        start.x = common::max(start.x, 0);
+        start.y = common::max(start.y, 0);
+        end.x = common::min(end.x, target_size.x);
+        end.y = common::min(end.y, target_size.y);
+
+        return eka2l1::rect(start, eka2l1::vec2(common::max(end.x - start.x, 0), common::max(end.y - start.y, 0)));
+    }
+
+    void null_graphics_driver::clear(command_helper &helper) {
+        std::uint8_t color[4] = { 0, 0, 0, 0 };
+        std::uint8_t clear_bits = 0;
+
+        helper.pop(color[0]);
+        helper.pop(color[1]);
+        helper.pop(color[2]);
+        helper.pop(color[3]);
+        helper.pop(clear_bits);
+
+        null_texture *target = get_render_target();
+        null_texture *ds_target = get_render_depth_stencil();
+
+        if (!target) {
+            return;
+        }
+
+        // Clearing respects the scissor box, but not the stencil test nor blending
+        const eka2l1::rect area = get_raster_area(eka2l1::rect({ 0, 0 }, target->get_size()), target->get_size(), state);
+        const int pitch = target->get_size().x;
+
+        if (clear_bits & draw_buffer_bit_color_buffer) {
+            std::uint8_t *data = target->get_storage();
+
+            for (int y = area.top.y; y < area.top.y + area.size.y; y++) {
+                for (int x = area.top.x; x < area.top.x + area.size.x; x++) {
+                    std::copy(color, color + 4, data + (y * pitch + x) * 4);
+                }
+            }
+        }
+
+        if ((clear_bits & draw_buffer_bit_stencil_buffer) && ds_target && (ds_target->get_size() == target->get_size())) {
+            std::uint8_t *data = ds_target->get_storage();
+
+            for (int y = area.top.y; y < area.top.y + area.size.y; y++) {
+                std::uint8_t *row = data + y * pitch;
+
+                for (int x = area.top.x; x < area.top.x + area.size.x; x++) {
+                    row[x] = (row[x] & ~state.stencil_write_mask) | (color[0] & state.stencil_write_mask);
+                }
+            }
+        }
+    }
+
+    void null_graphics_driver::draw_rectangle(command_helper &helper) {
+        eka2l1::rect fill_rect;
+        helper.pop(fill_rect);
+
+        null_texture *target = get_render_target();
+        null_texture *ds_target = get_render_depth_stencil();
+
+        if (!target) {
+            return;
+        }
+
+        const eka2l1::rect area = get_raster_area(fill_rect, target->get_size(), state);
+        const int pitch = target->get_size().x;
+
+        std::uint8_t *data = target->get_storage();
+        std::uint8_t *stencil_data = (ds_target && (ds_target->get_size() == target->get_size())) ? ds_target->get_storage() : nullptr;
+
+        const float color[4] = { brush_color[0] / 255.0f, brush_color[1] / 255.0f, brush_color[2] / 255.0f,
+            brush_color[3] / 255.0f };
+
+        for (int y = area.top.y; y < area.top.y + area.size.y; y++) {
+            for (int x = area.top.x; x < area.top.x + area.size.x; x++) {
+                if (!stencil_test(stencil_data ? stencil_data + y * pitch + x : nullptr)) {
+                    continue;
+                }
+
+                write_fragment(data + (y * pitch + x) * 4, color);
+            }
+        }
+    }
+
+    void null_graphics_driver::draw_bitmap(command_helper &helper) {
+        drivers::handle to_draw = 0;
+        drivers::handle mask_to_use = 0;
+        eka2l1::rect dest_rect;
+        eka2l1::rect source_rect;
+        std::uint32_t flags = 0;
+
+        helper.pop(to_draw);
+        helper.pop(mask_to_use);
+        helper.pop(dest_rect);
+        helper.pop(source_rect);
+        helper.pop(flags);
+
+        bitmap *bmp = get_bitmap(to_draw);
+
+        if (!bmp) {
+            LOG_ERROR("Invalid bitmap handle to draw");
+            return;
+        }
+
+        bitmap *mask_bmp = nullptr;
+
+        if (mask_to_use) {
+            mask_bmp = get_bitmap(mask_to_use);
+
+            if (!mask_bmp) {
+                LOG_ERROR("Mask handle was provided but invalid!");
+                return;
+            }
+        }
+
+        null_texture *source = reinterpret_cast<null_texture *>(bmp->tex.get());
+        null_texture *mask = mask_bmp ? reinterpret_cast<null_texture *>(mask_bmp->tex.get()) : nullptr;
+
+        if (source_rect.size.x == 0) {
+            source_rect.size.x = source->get_size().x;
+        }
+
+        if (source_rect.size.y == 0) {
+            source_rect.size.y = source->get_size().y;
+        }
+
+        if (dest_rect.size.x == 0) {
+            dest_rect.size.x = source_rect.size.x;
+        }
+
+        if (dest_rect.size.y == 0) {
+            dest_rect.size.y = source_rect.size.y;
+        }
+
+        blit_texture(source, mask, dest_rect, source_rect, flags);
+    }
+
+    void null_graphics_driver::draw_glyph_run(command_helper &helper) {
+        drivers::handle atlas_h = 0;
+        const glyph_quad *quads = nullptr;
+        std::size_t quad_count = 0;
+        std::uint32_t flags = 0;
+
+        helper.pop(atlas_h);
+        helper.pop(quads);
+        helper.pop(quad_count);
+        helper.pop(flags);
+
+        bitmap *atlas = get_bitmap(atlas_h);
+
+        if (!atlas) {
+            LOG_ERROR("Invalid atlas bitmap handle to draw glyphs from");
+            return;
+        }
+
+        null_texture *source = reinterpret_cast<null_texture *>(atlas->tex.get());
+
+        for (std::size_t i = 0; i < quad_count; i++) {
+            blit_texture(source, nullptr, quads[i].dest_rect, quads[i].source_rect, flags);
+        }
+    }
+
+    void null_graphics_driver::blit_texture(null_texture *source, null_texture *mask, const eka2l1::rect &dest_rect,
+        const eka2l1::rect &source_rect, const std::uint32_t flags) {
+        null_texture *target = get_render_target();
+        null_texture *ds_target = get_render_depth_stencil();
+
+        if (!target) {
+            return;
+        }
+
+        if ((dest_rect.size.x <= 0) || (dest_rect.size.y <= 0)) {
+            return;
+        }
+
+        float color[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+        if (flags & bitmap_draw_flag_use_brush) {
+            for (int i = 0; i < 4; i++) {
+                color[i] = brush_color[i] / 255.0f;
+            }
+        }
+
+        const float invert = (flags & bitmap_draw_flag_invert_mask) ? 1.0f : 0.0f;
+
+        const eka2l1::rect area = get_raster_area(dest_rect, target->get_size(), state);
+        const int pitch = target->get_size().x;
+
+        std::uint8_t *data = target->get_storage();
+        std::uint8_t *stencil_data = (ds_target && (ds_target->get_size() == target->get_size())) ? ds_target->get_storage() : nullptr;
+
+        float texel[4];
+        float mask_texel[4];
+
+        for (int y = area.top.y; y < area.top.y + area.size.y; y++) {
+            // Sample at the pixel center, nearest filter
+            const int sy = source_rect.top.y + ((y - dest_rect.top.y) * 2 + 1) * source_rect.size.y / (dest_rect.size.y * 2);
+
+            for (int x = area.top.x; x < area.top.x + area.size.x; x++) {
+                if (!stencil_test(stencil_data ? stencil_data + y * pitch + x : nullptr)) {
+                    continue;
+                }
+
+                const int sx = source_rect.top.x + ((x - dest_rect.top.x) * 2 + 1) * source_rect.size.x / (dest_rect.size.x * 2);
+                source->sample(sx, sy, texel);
+
+                if (mask) {
+                    mask->sample(sx, sy, mask_texel);
+                }
+
+                for (int i = 0; i < 4; i++) {
+                    texel[i] *= color[i];
+
+                    if (mask) {
+                        texel[i] *= common::abs(invert - mask_texel[i]);
+                    }
+                }
+
+                write_fragment(data + (y * pitch + x) * 4, texel);
+            }
+        }
+    }
+
+    void null_graphics_driver::set_clipping(command_helper &helper) {
+        helper.pop(state.clipping);
+    }
+
+    void null_graphics_driver::clip_rect(command_helper &helper) {
+        eka2l1::rect clip_rect;
+        helper.pop(clip_rect);
+
+        // Negative height is a top-left rectangle, positive height is bottom-left based like OpenGL
+        state.clip.top.x = clip_rect.top.x;
+        state.clip.top.y = (clip_rect.size.y < 0) ? clip_rect.top.y : (current_fb_height - (clip_rect.top.y + clip_rect.size.y));
+        state.clip.size.x = clip_rect.size.x;
+        state.clip.size.y = common::abs(clip_rect.size.y);
+    }
+
+    void null_graphics_driver::set_stencil(command_helper &helper) {
+        helper.pop(state.stencil);
+    }
+
+    void null_graphics_driver::set_blend(command_helper &helper) {
+        helper.pop(state.blend);
+    }
+
+    void null_graphics_driver::blend_formula(command_helper &helper) {
+        helper.pop(state.rgb_equation);
+        helper.pop(state.a_equation);
+        helper.pop(state.rgb_frag_out_factor);
+        helper.pop(state.rgb_current_factor);
+        helper.pop(state.a_frag_out_factor);
+        helper.pop(state.a_current_factor);
+    }
+
+    void null_graphics_driver::set_stencil_action(command_helper &helper) {
+        stencil_face face_to_operate = stencil_face::back_and_front;
+        stencil_action on_stencil_fail = stencil_action::keep;
+        stencil_action on_stencil_pass_depth_fail = stencil_action::keep;
+        stencil_action on_stencil_depth_pass = stencil_action::replace;
+
+        helper.pop(face_to_operate);
+        helper.pop(on_stencil_fail);
+        helper.pop(on_stencil_pass_depth_fail);
+        helper.pop(on_stencil_depth_pass);
+
+        if (is_front_face_affected(face_to_operate)) {
+            state.on_stencil_fail = on_stencil_fail;
+            state.on_stencil_pass_depth_fail = on_stencil_pass_depth_fail;
+            state.on_stencil_depth_pass = on_stencil_depth_pass;
+        }
+    }
+
+    void null_graphics_driver::set_stencil_pass_condition(command_helper &helper) {
+        condition_func pass_func = condition_func::always;
+        stencil_face face_to_operate = stencil_face::back_and_front;
+        std::int32_t ref_value = 0;
+        std::uint32_t mask = 0xFF;
+
+        helper.pop(face_to_operate);
+        helper.pop(pass_func);
+        helper.pop(ref_value);
+        helper.pop(mask);
+
+        if (is_front_face_affected(face_to_operate)) {
+            state.stencil_func = pass_func;
+            state.stencil_ref = static_cast<std::uint8_t>(ref_value);
+            state.stencil_func_mask = static_cast<std::uint8_t>(mask);
+        }
+    }
+
+    void null_graphics_driver::set_stencil_mask(command_helper &helper) {
+        stencil_face face_to_operate = stencil_face::back_and_front;
+        std::uint32_t mask = 0xFF;
+
+        helper.pop(face_to_operate);
+        helper.pop(mask);
+
+        if (is_front_face_affected(face_to_operate)) {
+            state.stencil_write_mask = static_cast<std::uint8_t>(mask);
+        }
+    }
+
+    void null_graphics_driver::dump_frame() {
+        if (!swapchain_color || !swapchain_color->has_storage()) {
+            return;
+        }
+
+        const eka2l1::vec2 size = swapchain_color->get_size();
+        const std::uint8_t *data = swapchain_color->get_storage();
+
+        std::ofstream dump_file(eka2l1::add_path(frame_dump_folder, fmt::format("frame_{:06d}.bmp", frame_dumped++)),
+            std::ios::binary);
+
+        if (!dump_file) {
+            LOG_WARN("Unable to create frame dump file in {}", frame_dump_folder);
+            return;
+        }
+
+        common::bmp_header header;
+        common::dib_header_v1 info;
+
+        info.size = eka2l1::vec2(size.x, -size.y);
+        info.color_plane_count = 1;
+        info.bit_per_pixels = 32;
+        info.comp = 0;
+        info.uncompressed_size = static_cast<std::uint32_t>(size.x * size.y * 4);
+        info.print_res = eka2l1::vec2(0, 0);
+
+        header.reserved1 = 0;
+        header.reserved2 = 0;
+        header.pixel_array_offset = static_cast<std::uint32_t>(sizeof(common::bmp_header) + sizeof(common::dib_header_v1));
+        header.file_size = header.pixel_array_offset + info.uncompressed_size;
+
+        dump_file.write(reinterpret_cast<const char *>(&header), sizeof(common::bmp_header));
+        dump_file.write(reinterpret_cast<const char *>(&info), sizeof(common::dib_header_v1));
+
+        // BMP stores BGRA. Negative height above makes the rows top to bottom, same as our storage.
+        std::vector<std::uint8_t> row(size.x * 4);
+
+        for (int y = 0; y < size.y; y++) {
+            const std::uint8_t *source = data + y * size.x * 4;
+
+            for (int x = 0; x < size.x; x++) {
+                row[x * 4] = source[x * 4 + 2];
+                row[x * 4 + 1] = source[x * 4 + 1];
+                row[x * 4 + 2] = source[x * 4];
+                row[x * 4 + 3] = source[x * 4 + 3];
+            }
+
+            dump_file.write(reinterpret_cast<const char *>(row.data()), row.size());
+        }
+    }
+
+    void null_graphics_driver::set_viewport(const eka2l1::rect &viewport) {
+    }
+
+    void null_graphics_driver::bind_swapchain_framebuf() {
+    }
+
+    std::unique_ptr<graphics_command_list> null_graphics_driver::new_command_list() {
+        return std::make_unique<server_graphics_command_list>(command_pool_, staging_pool_);
+    }
+
+    std::unique_ptr<graphics_command_list_builder> null_graphics_driver::new_command_builder(graphics_command_list *list) {
+        return std::make_unique<server_graphics_command_list_builder>(list);
+    }
+
+    void null_graphics_driver::submit_command_list(graphics_command_list &command_list) {
+        list_queue.push(std::move(static_cast<server_graphics_command_list &>(command_list)));
+    }
+
+    void null_graphics_driver::display(command_helper &helper) {
+        if (software_rendering && !frame_dump_folder.empty()) {
+            dump_frame();
+        }
+
+        if (disp_hook_) {
+            disp_hook_();
+        }
+
+        helper.finish(this, 0);
+    }
+
+    void null_graphics_driver::native_dialog(command_helper &helper) {
+        // There is no one to pick anything
+        helper.finish(this, 0);
+    }
+
+    void null_graphics_driver::dispatch(command *cmd) {
+        command_helper helper(cmd);
+
+        if (software_rendering) {
+            switch (cmd->opcode_) {
+            case graphics_driver_clear:
+                clear(helper);
+                return;
+
+            case graphics_driver_draw_bitmap:
+                draw_bitmap(helper);
+                return;
+
+            case graphics_driver_draw_glyph_run:
+                draw_glyph_run(helper);
+                return;
+
+            case graphics_driver_draw_rectangle:
+                draw_rectangle(helper);
+                return;
+
+            case graphics_driver_set_clipping:
+                set_clipping(helper);
+                return;
+
+            case graphics_driver_clip_rect:
+                clip_rect(helper);
+                return;
+
+            case graphics_driver_set_stencil:
+                set_stencil(helper);
+                return;
+
+            case graphics_driver_set_blend:
+                set_blend(helper);
+                return;
+
+            case graphics_driver_blend_formula:
+                blend_formula(helper);
+                return;
+
+            case graphics_driver_stencil_set_action:
+                set_stencil_action(helper);
+                return;
+
+            case graphics_driver_stencil_pass_condition:
+                set_stencil_pass_condition(helper);
+                return;
+
+            case graphics_driver_stencil_set_mask:
+                set_stencil_mask(helper);
+                return;
+
+            case graphics_driver_backup_state:
+                backup = state;
+                return;
+
+            case graphics_driver_restore_state:
+                state = backup;
+                return;
+
+            case graphics_driver_set_swapchain_size:
+                shared_graphics_driver::dispatch(cmd);
+                recreate_swapchain();
+
+                return;
+
+            default:
+                break;
+            }
+        }
+
+        switch (cmd->opcode_) {
+        // Rendering state and draws. None of these carries heap data, so they can be dropped.
+        // Indexed draws run custom shader programs, which are never executed on the CPU.
+        case graphics_driver_clear:
+        case graphics_driver_draw_bitmap:
+        case graphics_driver_draw_glyph_run:
+        case graphics_driver_draw_rectangle:
+        case graphics_driver_set_clipping:
+        case graphics_driver_clip_rect:
+        case graphics_driver_draw_indexed:
+        case graphics_driver_set_viewport:
+        case graphics_driver_set_depth:
+        case graphics_driver_set_stencil:
+        case graphics_driver_set_blend:
+        case graphics_driver_set_cull:
+        case graphics_driver_blend_formula:
+        case graphics_driver_stencil_set_action:
+        case graphics_driver_stencil_pass_condition:
+        case graphics_driver_stencil_set_mask:
+        case graphics_driver_set_back_face_rule:
+        case graphics_driver_backup_state:
+        case graphics_driver_restore_state:
+            break;
+
+        case graphics_driver_display: {
+            display(helper);
+            break;
+        }
+
+        case graphics_driver_native_dialog: {
+            native_dialog(helper);
+            break;
+        }
+
+        default:
+            shared_graphics_driver::dispatch(cmd);
+            break;
+        }
+    }
+
+    void null_graphics_driver::run() {
+        if (software_rendering && !frame_dump_folder.empty()) {
+            eka2l1::create_directories(frame_dump_folder);
+        }
+
+        while (!should_stop) {
+            std::optional<server_graphics_command_list> list = list_queue.pop();
+
+            if (!list) {
+                if (!should_stop) {
+                    LOG_ERROR("Corrupted graphics command list! Emulation halt.");
+                }
+
+                break;
+            }
+
+            // Memory of the list goes back to the pools when it goes out of scope
+            list->list_.for_each([this](command *cmd) {
+                dispatch(cmd);
+            });
+        }
+    }
+
+    void null_graphics_driver::abort() {
+        list_queue.abort();
+        should_stop = true;
+    }
+}
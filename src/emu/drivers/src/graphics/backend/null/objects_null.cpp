@@ -0,0 +1,384 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <drivers/graphics/backend/null/graphics_null.h>
+#include <drivers/graphics/backend/null/objects_null.h>
+
+#include <common/algorithm.h>
+
+#include <algorithm>
+
+namespace eka2l1::drivers {
+    static std::size_t get_bytes_per_texel(const texture_format format, const texture_data_type data_type) {
+        if (data_type == texture_data_type::ushort_5_6_5) {
+            return 2;
+        }
+
+        switch (format) {
+        case texture_format::r:
+            return 1;
+
+        case texture_format::rg:
+            return 2;
+
+        case texture_format::rgb:
+        case texture_format::bgr:
+            return 3;
+
+        case texture_format::rgba:
+        case texture_format::bgra:
+            return 4;
+
+        default:
+            break;
+        }
+
+        return 0;
+    }
+
+    static void decode_texel(const std::uint8_t *source, const texture_format format, const texture_data_type data_type,
+        std::uint8_t *dest) {
+        // Missing channels follow the same rule as GPU: color to 0, alpha to 1
+        dest[0] = 0;
+        dest[1] = 0;
+        dest[2] = 0;
+        dest[3] = 0xFF;
+
+        if (data_type == texture_data_type::ushort_5_6_5) {
+            const std::uint16_t value = source[0] | (source[1] << 8);
+
+            dest[0] = static_cast<std::uint8_t>(((value >> 11) & 0x1F) * 255 / 31);
+            dest[1] = static_cast<std::uint8_t>(((value >> 5) & 0x3F) * 255 / 63);
+            dest[2] = static_cast<std::uint8_t>((value & 0x1F) * 255 / 31);
+
+            return;
+        }
+
+        switch (format) {
+        case texture_format::r:
+            dest[0] = source[0];
+            break;
+
+        case texture_format::rg:
+            dest[0] = source[0];
+            dest[1] = source[1];
+            break;
+
+        case texture_format::rgb:
+            std::copy(source, source + 3, dest);
+            break;
+
+        case texture_format::bgr:
+            dest[0] = source[2];
+            dest[1] = source[1];
+            dest[2] = source[0];
+            break;
+
+        case texture_format::rgba:
+            std::copy(source, source + 4, dest);
+            break;
+
+        case texture_format::bgra:
+            dest[0] = source[2];
+            dest[1] = source[1];
+            dest[2] = source[0];
+            dest[3] = source[3];
+            break;
+
+        default:
+            break;
+        }
+    }
+    null_texture::null_texture()
+        : dimensions(0)
+        , mip_level(0)
+        , tex_size(0, 0)
+        , internal_format(texture_format::none)
+        , format(texture_format::none)
+        , tex_data_type(texture_data_type::ubyte)
+        , tex_data(nullptr)
+        , swizzle({ channel_swizzle::red, channel_swizzle::green, channel_swizzle::blue, channel_swizzle::alpha }) {
+    }
+
+    std::uint8_t *null_texture::get_storage() {
+        if (storage.empty() && (tex_size.x > 0) && (tex_size.y > 0)) {
+            storage.resize(tex_size.x * tex_size.y * (is_depth_stencil() ? 1 : 4), 0);
+        }
+
+        return storage.data();
+    }
+
+    void null_texture::sample(int x, int y, float *rgba) {
+        const std::uint8_t *data = get_storage();
+
+        if (!data || is_depth_stencil()) {
+            std::fill(rgba, rgba + 4, 0.0f);
+            return;
+        }
+
+        x = common::clamp(0, tex_size.x - 1, x);
+        y = common::clamp(0, tex_size.y - 1, y);
+
+        const std::uint8_t *texel = data + (y * tex_size.x + x) * 4;
+
+        for (int i = 0; i < 4; i++) {
+            switch (swizzle[i]) {
+            case channel_swizzle::zero:
+                rgba[i] = 0.0f;
+                break;
+
+            case channel_swizzle::one:
+                rgba[i] = 1.0f;
+                break;
+
+            default:
+                rgba[i] = texel[static_cast<int>(swizzle[i])] / 255.0f;
+                break;
+            }
+        }
+    }
+
+    bool null_texture::create(graphics_driver *driver, const int dim, const int miplvl, const vec3 &size, const texture_format internal_format,
+        const texture_format format, const texture_data_type data_type, void *data, const std::size_t pixels_per_line) {
+        this->dimensions = dim;
+        this->mip_level = miplvl;
+        this->tex_size = vec2(size.x, size.y);
+        this->internal_format = internal_format;
+        this->format = format;
+        this->tex_data_type = data_type;
+        this->tex_data = data;
+
+        storage.clear();
+
+        if (data) {
+            update_data(driver, miplvl, vec3(0, 0, 0), size, pixels_per_line, format, data_type, data);
+        }
+
+        return true;
+    }
+
+    bool null_texture::tex(graphics_driver *driver, const bool is_first) {
+        return true;
+    }
+
+    void null_texture::change_size(const vec3 &new_size) {
+        tex_size = vec2(new_size.x, new_size.y);
+
+        // Content is undefined after a resize, same as on GPU
+        storage.clear();
+    }
+
+    void null_texture::change_data(const texture_data_type data_type, void *data) {
+        tex_data_type = data_type;
+        tex_data = data;
+    }
+
+    void null_texture::change_texture_format(const texture_format format) {
+        this->format = format;
+    }
+
+    void null_texture::set_filter_minmag(const bool min, const filter_option op) {
+    }
+
+    void null_texture::set_channel_swizzle(channel_swizzles swizz) {
+        swizzle = swizz;
+    }
+
+    void null_texture::bind(graphics_driver *driver, const int binding) {
+    }
+
+    void null_texture::unbind(graphics_driver *driver) {
+    }
+
+    void null_texture::update_data(graphics_driver *driver, const int mip_lvl, const vec3 &offset, const vec3 &size, const std::size_t byte_width,
+        const texture_format data_format, const texture_data_type data_type, const void *data) {
+        if (!data || (mip_lvl != 0) || is_depth_stencil() || !reinterpret_cast<null_graphics_driver *>(driver)->is_software_rendering()) {
+            return;
+        }
+
+        const std::size_t texel_size = get_bytes_per_texel(data_format, data_type);
+
+        if (texel_size == 0) {
+            return;
+        }
+
+        // Here byte width is the number of pixels per line. Rows are aligned to 4 bytes, like the default GPU unpack rule.
+        const std::size_t source_pitch = common::align((byte_width ? byte_width : size.x) * texel_size, 4);
+        const std::uint8_t *source = reinterpret_cast<const std::uint8_t *>(data);
+
+        std::uint8_t *dest = get_storage();
+
+        const int width = common::min<int>(size.x, tex_size.x - offset.x);
+        const int height = common::min<int>(size.y, tex_size.y - offset.y);
+
+        for (int y = 0; y < height; y++) {
+            const std::uint8_t *source_row = source + y * source_pitch;
+            std::uint8_t *dest_row = dest + ((offset.y + y) * tex_size.x + offset.x) * 4;
+
+            for (int x = 0; x < width; x++) {
+                decode_texel(source_row + x * texel_size, data_format, data_type, dest_row + x * 4);
+            }
+        }
+    }
+
+    null_framebuffer::null_framebuffer(std::initializer_list<texture *> color_buffer_list,
+        texture *depth_and_stencil_buffer)
+        : framebuffer(color_buffer_list, depth_and_stencil_buffer)
+        , draw_attachment(0)
+        , read_attachment(0) {
+    }
+
+    void null_framebuffer::bind(graphics_driver *driver) {
+    }
+
+    void null_framebuffer::unbind(graphics_driver *driver) {
+    }
+
+    std::int32_t null_framebuffer::set_color_buffer(texture *tex, const std::int32_t position) {
+        if (position < 0) {
+            color_buffers.push_back(tex);
+            return static_cast<std::int32_t>(color_buffers.size() - 1);
+        }
+
+        if (color_buffers.size() <= static_cast<std::size_t>(position)) {
+            color_buffers.resize(position + 1, nullptr);
+        }
+
+        color_buffers[position] = tex;
+        return position;
+    }
+
+    bool null_framebuffer::set_depth_stencil_buffer(texture *tex) {
+        depth_and_stencil_buffer = tex;
+        return true;
+    }
+
+    bool null_framebuffer::set_draw_buffer(const std::int32_t attachment_id) {
+        if (!is_attachment_id_valid(attachment_id)) {
+            return false;
+        }
+
+        draw_attachment = attachment_id;
+        return true;
+    }
+
+    bool null_framebuffer::set_read_buffer(const std::int32_t attachment_id) {
+        if (!is_attachment_id_valid(attachment_id)) {
+            return false;
+        }
+
+        read_attachment = attachment_id;
+        return true;
+    }
+
+    bool null_framebuffer::remove_color_buffer(const std::int32_t position) {
+        if (!is_attachment_id_valid(position)) {
+            return false;
+        }
+
+        color_buffers[position] = nullptr;
+        return true;
+    }
+
+    bool null_framebuffer::blit(const eka2l1::rect &source_rect, const eka2l1::rect &dest_rect, const std::uint32_t flags,
+        const filter_option copy_filter) {
+        if (!(flags & draw_buffer_bit_color_buffer) || !is_attachment_id_valid(read_attachment) || !is_attachment_id_valid(draw_attachment)) {
+            return true;
+        }
+
+        null_texture *source = reinterpret_cast<null_texture *>(color_buffers[read_attachment]);
+        null_texture *dest = reinterpret_cast<null_texture *>(color_buffers[draw_attachment]);
+
+        // Nothing was ever rendered in software to the source
+        if (!source->has_storage() || (source_rect.size.x <= 0) || (source_rect.size.y <= 0)) {
+            return true;
+        }
+
+        const eka2l1::vec2 dest_size = dest->get_size();
+        const eka2l1::vec2 source_size = source->get_size();
+
+        const std::uint8_t *source_data = source->get_storage();
+        std::uint8_t *dest_data = dest->get_storage();
+
+        for (int y = common::max(0, dest_rect.top.y); y < common::min(dest_size.y, dest_rect.top.y + dest_rect.size.y); y++) {
+            const int sy = source_rect.top.y + (y - dest_rect.top.y) * source_rect.size.y / dest_rect.size.y;
+
+            if ((sy < 0) || (sy >= source_size.y)) {
+                continue;
+            }
+
+            for (int x = common::max(0, dest_rect.top.x); x < common::min(dest_size.x, dest_rect.top.x + dest_rect.size.x); x++) {
+                const int sx = source_rect.top.x + (x - dest_rect.top.x) * source_rect.size.x / dest_rect.size.x;
+
+                if ((sx < 0) || (sx >= source_size.x)) {
+                    continue;
+                }
+
+                std::copy(source_data + (sy * source_size.x + sx) * 4, source_data + (sy * source_size.x + sx) * 4 + 4,
+                    dest_data + (y * dest_size.x + x) * 4);
+            }
+        }
+
+        return true;
+    }
+
+    bool null_shader::create(graphics_driver *driver, const char *vert_data, const std::size_t vert_size,
+        const char *frag_data, const std::size_t frag_size) {
+        return true;
+    }
+
+    bool null_shader::set(graphics_driver *driver, const int binding, const shader_set_var_type var_type, const void *data) {
+        return true;
+    }
+
+    bool null_shader::use(graphics_driver *driver) {
+        return true;
+    }
+
+    std::optional<int> null_shader::get_uniform_location(const std::string &name) {
+        return std::nullopt;
+    }
+
+    std::optional<int> null_shader::get_attrib_location(const std::string &name) {
+        return std::nullopt;
+    }
+
+    null_buffer::null_buffer()
+        : size_(0) {
+    }
+
+    void null_buffer::bind(graphics_driver *driver) {
+    }
+
+    void null_buffer::unbind(graphics_driver *driver) {
+    }
+
+    void null_buffer::attach_descriptors(graphics_driver *driver, const int stride, const bool instance_move,
+        const attribute_descriptor *descriptors, const int total) {
+    }
+
+    bool null_buffer::create(graphics_driver *driver, const std::size_t initial_size, const buffer_hint hint, const buffer_upload_hint use_hint) {
+        size_ = initial_size;
+        return true;
+    }
+
+    void null_buffer::update_data(graphics_driver *driver, const void *data, const std::size_t offset, const std::size_t size) {
+        size_ = std::max(size_, offset + size);
+    }
+}
@@ -31,6 +31,7 @@
 namespace eka2l1::drivers {
     ogl_graphics_driver::ogl_graphics_driver()
         : shared_graphics_driver(graphic_api::opengl)
+        , glyph_ibo_quad_count(0)
         , should_stop(false) {
         init_graphics_library(eka2l1::drivers::graphic_api::opengl);
         list_queue.max_pending_count_ = 128;
@@ -72,6 +73,19 @@ namespace eka2l1::drivers {
         glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), (GLvoid *)0);
         glBindVertexArray(0);
 
+        // Make glyph run VAO and VBO. Same layout as the sprite one.
+        glGenVertexArrays(1, &glyph_vao);
+        glGenBuffers(1, &glyph_vbo);
+        glBindVertexArray(glyph_vao);
+        glBindBuffer(GL_ARRAY_BUFFER, glyph_vbo);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (GLvoid *)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (GLvoid *)(2 * sizeof(GLfloat)));
+        glBindVertexArray(0);
+
+        glGenBuffers(1, &glyph_ibo);
+
         glGenBuffers(1, &sprite_ibo);
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sprite_ibo);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
@@ -320,6 +334,126 @@ namespace eka2l1::drivers {
         glBindVertexArray(0);
     }
 
+    // Indices are 16-bit, four vertices per quad
+    static constexpr std::size_t MAX_GLYPH_QUADS_PER_DRAW = 0x10000 / 4;
+
+    void ogl_graphics_driver::draw_glyph_run(command_helper &helper) {
+        if (!sprite_program) {
+            do_init();
+        }
+
+        drivers::handle atlas_h = 0;
+        const glyph_quad *quads = nullptr;
+        std::size_t quad_count = 0;
+        std::uint32_t flags = 0;
+
+        helper.pop(atlas_h);
+        helper.pop(quads);
+        helper.pop(quad_count);
+        helper.pop(flags);
+
+        bitmap *atlas = get_bitmap(atlas_h);
+
+        if (!atlas) {
+            LOG_ERROR("Invalid atlas bitmap handle to draw glyphs from");
+            return;
+        }
+
+        if (quad_count == 0) {
+            return;
+        }
+
+        sprite_program->use(this);
+
+        const float texel_width = 1.0f / atlas->tex->get_size().x;
+        const float texel_height = 1.0f / atlas->tex->get_size().y;
+
+        // Vertices are already in pixels, the model matrix stays identity.
+        // Same vertex order as a sprite: bottom left, top right, top left, bottom right.
+        glyph_verts.resize(quad_count * 16);
+        GLfloat *vert = glyph_verts.data();
+
+        for (std::size_t i = 0; i < quad_count; i++) {
+            const eka2l1::rect &source = quads[i].source_rect;
+            const eka2l1::rect &dest = quads[i].dest_rect;
+
+            const GLfloat left = static_cast<GLfloat>(dest.top.x);
+            const GLfloat top = static_cast<GLfloat>(dest.top.y);
+            const GLfloat right = static_cast<GLfloat>(dest.top.x + dest.size.x);
+            const GLfloat bottom = static_cast<GLfloat>(dest.top.y + dest.size.y);
+
+            const GLfloat u0 = source.top.x * texel_width;
+            const GLfloat v0 = source.top.y * texel_height;
+            const GLfloat u1 = (source.top.x + source.size.x) * texel_width;
+            const GLfloat v1 = (source.top.y + source.size.y) * texel_height;
+
+            const GLfloat quad_verts[16] = {
+                left, bottom, u0, v1,
+                right, top, u1, v0,
+                left, top, u0, v0,
+                right, bottom, u1, v1
+            };
+
+            std::copy(quad_verts, quad_verts + 16, vert);
+            vert += 16;
+        }
+
+        glBindVertexArray(glyph_vao);
+        glBindBuffer(GL_ARRAY_BUFFER, glyph_vbo);
+        glBufferData(GL_ARRAY_BUFFER, glyph_verts.size() * sizeof(GLfloat), nullptr, GL_STREAM_DRAW);
+        glBufferData(GL_ARRAY_BUFFER, glyph_verts.size() * sizeof(GLfloat), glyph_verts.data(), GL_STREAM_DRAW);
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, glyph_ibo);
+
+        const std::size_t quads_per_draw = common::min(quad_count, MAX_GLYPH_QUADS_PER_DRAW);
+
+        if (glyph_ibo_quad_count < quads_per_draw) {
+            std::vector<GLushort> indices(quads_per_draw * 6);
+
+            for (std::size_t i = 0; i < quads_per_draw; i++) {
+                const GLushort base = static_cast<GLushort>(i * 4);
+
+                indices[i * 6] = base;
+                indices[i * 6 + 1] = base + 1;
+                indices[i * 6 + 2] = base + 2;
+                indices[i * 6 + 3] = base;
+                indices[i * 6 + 4] = base + 3;
+                indices[i * 6 + 5] = base + 1;
+            }
+
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLushort), indices.data(), GL_STATIC_DRAW);
+            glyph_ibo_quad_count = quads_per_draw;
+        }
+
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, static_cast<GLuint>(atlas->tex->texture_handle()));
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        const glm::mat4 model_matrix = glm::identity<glm::mat4>();
+
+        glUniformMatrix4fv(model_loc, 1, false, glm::value_ptr(model_matrix));
+        glUniformMatrix4fv(proj_loc, 1, false, glm::value_ptr(projection_matrix));
+
+        const GLfloat color[] = { 255.0f, 255.0f, 255.0f, 255.0f };
+
+        if (flags & bitmap_draw_flag_use_brush) {
+            glUniform4fv(color_loc, 1, brush_color.elements.data());
+        } else {
+            glUniform4fv(color_loc, 1, color);
+        }
+
+        // Runs longer than what 16-bit indices can address are split, each part starting at its own base vertex
+        for (std::size_t drawn = 0; drawn < quad_count; drawn += quads_per_draw) {
+            const std::size_t count = common::min(quad_count - drawn, quads_per_draw);
+
+            glDrawElementsBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(count * 6), GL_UNSIGNED_SHORT, nullptr,
+                static_cast<GLint>(drawn * 4));
+        }
+
+        glBindVertexArray(0);
+    }
+
     void ogl_graphics_driver::set_clipping(command_helper &helper) {
         bool enable = false;
         helper.pop(enable);
@@ -696,7 +830,7 @@ namespace eka2l1::drivers {
     }
 
     std::unique_ptr<graphics_command_list> ogl_graphics_driver::new_command_list() {
-        return std::make_unique<server_graphics_command_list>();
+        return std::make_unique<server_graphics_command_list>(command_pool_, staging_pool_);
     }
 
     std::unique_ptr<graphics_command_list_builder> ogl_graphics_driver::new_command_builder(graphics_command_list *list) {
@@ -704,7 +838,7 @@ namespace eka2l1::drivers {
     }
 
     void ogl_graphics_driver::submit_command_list(graphics_command_list &command_list) {
-        list_queue.push(static_cast<server_graphics_command_list &>(command_list));
+        list_queue.push(std::move(static_cast<server_graphics_command_list &>(command_list)));
     }
 
     void ogl_graphics_driver::display(command_helper &helper) {
@@ -721,6 +855,11 @@ namespace eka2l1::drivers {
             break;
         }
 
+        case graphics_driver_draw_glyph_run: {
+            draw_glyph_run(helper);
+            break;
+        }
+
         case graphics_driver_set_clipping: {
             set_clipping(helper);
             break;
@@ -817,18 +956,10 @@ namespace eka2l1::drivers {
                 break;
             }
 
-            command *cmd = list->list_.first_;
-            command *next = nullptr;
-
-            while (cmd) {
+            // Memory of the list goes back to the pools when it goes out of scope
+            list->list_.for_each([this](command *cmd) {
                 dispatch(cmd);
-                next = cmd->next_;
-
-                // TODO: If any command list requires not rebuilding the buffer, dont delete the command.
-                // For now, not likely
-                delete cmd;
-                cmd = next;
-            }
+            });
         }
     }
 
@@ -1,3 +1,4 @@
+#include <drivers/graphics/backend/null/objects_null.h>
 #include <drivers/graphics/backend/ogl/buffer_ogl.h>
 #include <drivers/graphics/buffer.h>
 #include <drivers/graphics/graphics.h>
@@ -9,6 +10,10 @@ namespace eka2l1::drivers {
             return std::make_unique<ogl_buffer>();
         }
 
+        case graphic_api::null: {
+            return std::make_unique<null_buffer>();
+        }
+
         default:
             break;
         }
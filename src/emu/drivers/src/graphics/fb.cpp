@@ -17,6 +17,7 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <drivers/graphics/backend/null/objects_null.h>
 #include <drivers/graphics/backend/ogl/fb_ogl.h>
 #include <drivers/graphics/fb.h>
 #include <drivers/graphics/graphics.h>
@@ -42,6 +43,10 @@ namespace eka2l1::drivers {
             break;
         }
 
+        case graphic_api::null: {
+            return std::make_unique<null_framebuffer>(color_buffer_list, depth_and_stencil_buffer);
+        }
+
         default:
             break;
         }
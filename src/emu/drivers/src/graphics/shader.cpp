@@ -18,6 +18,7 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <drivers/graphics/backend/null/objects_null.h>
 #include <drivers/graphics/backend/ogl/shader_ogl.h>
 #include <drivers/graphics/graphics.h>
 #include <drivers/graphics/shader.h>
@@ -31,6 +32,10 @@ namespace eka2l1::drivers {
             return std::make_unique<ogl_shader>();
         }
 
+        case graphic_api::null: {
+            return std::make_unique<null_shader>();
+        }
+
         default:
             break;
         }
@@ -17,6 +17,7 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <drivers/graphics/backend/null/objects_null.h>
 #include <drivers/graphics/backend/ogl/texture_ogl.h>
 #include <drivers/graphics/graphics.h>
 #include <drivers/graphics/texture.h>
@@ -29,6 +30,10 @@ namespace eka2l1::drivers {
             break;
         }
 
+        case graphic_api::null: {
+            return std::make_unique<null_texture>();
+        }
+
         default:
             break;
         }
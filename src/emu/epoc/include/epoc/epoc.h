@@ -156,6 +156,9 @@ namespace eka2l1 {
         void request_exit();
         bool should_exit() const;
 
+        /*! \brief Get the total number of guest instructions executed since startup. */
+        std::uint64_t get_instructions_executed() const;
+
         void add_new_hal(uint32_t hal_category, hal_instance &hal_com);
         epoc::hal *get_hal(uint32_t category);
 
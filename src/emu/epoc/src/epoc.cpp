@@ -45,6 +45,7 @@
 
 #include <atomic>
 #include <fstream>
+#include <limits>
 #include <string>
 
 #include <disasm/disasm.h>
@@ -111,6 +112,9 @@ namespace eka2l1 {
         bool exit = false;
         bool paused = false;
 
+        //! Total guest instructions executed since startup.
+        std::uint64_t instructions_executed = 0;
+
         std::unordered_map<std::string, bool> bool_configs;
         std::unordered_map<uint32_t, hal_instance> hals;
 
@@ -308,6 +312,10 @@ namespace eka2l1 {
             return exit;
         }
 
+        std::uint64_t get_instructions_executed() const {
+            return instructions_executed;
+        }
+
         void add_new_hal(uint32_t hal_category, hal_instance &hal_com);
         epoc::hal *get_hal(uint32_t category);
     };
@@ -338,11 +346,27 @@ namespace eka2l1 {
 
     static constexpr std::uint32_t DEFAULT_CPU_HZ = 484000000;
 
+    // The timer takes the frequency in Hz as a 32-bit value
+    static constexpr std::uint32_t MAX_DETERMINISTIC_TIMING_MHZ = std::numeric_limits<std::uint32_t>::max() / 1000000;
+
     void system_impl::startup() {
         exit = false;
+        instructions_executed = 0;
 
         // Initialize all the system that doesn't depend on others first
-        timing = std::make_unique<ntimer>(DEFAULT_CPU_HZ);
+        if (conf->deterministic_timing) {
+            const std::uint32_t timing_mhz = common::clamp<std::uint32_t>(1, MAX_DETERMINISTIC_TIMING_MHZ,
+                conf->deterministic_timing_mhz);
+
+            if (timing_mhz != conf->deterministic_timing_mhz) {
+                LOG_WARN("Deterministic timing frequency {} MHz is out of range, using {} MHz",
+                    conf->deterministic_timing_mhz, timing_mhz);
+            }
+
+            timing = std::make_unique<ntimer>(timing_mhz * 1000000, true);
+        } else {
+            timing = std::make_unique<ntimer>(DEFAULT_CPU_HZ);
+        }
         asmdis.init();
 
         file_system_inst physical_fs = create_physical_filesystem(epocver::epoc94, "");
@@ -445,13 +469,33 @@ namespace eka2l1 {
         }
 
         if (kern->crr_thread() == nullptr) {
+            // Nothing to run. Guest time would stand still in deterministic mode, so jump to the next event.
+            timing->idle();
             prepare_reschedule();
         } else {
             kernel::thread *thr = kern->crr_thread();
 
             if (!should_step) {
-                cpu->run(thr->get_remaining_screenticks());
-                thr->add_ticks(cpu->get_num_instruction_executed());
+                std::uint32_t slice = static_cast<std::uint32_t>(thr->get_remaining_screenticks());
+
+                if (timing->is_deterministic()) {
+                    // Stop right at the next event, so it fires on the exact tick
+                    const std::optional<std::uint64_t> ticks_to_event = timing->ticks_to_next_event();
+
+                    if (ticks_to_event) {
+                        const std::uint64_t until_event = common::min<std::uint64_t>(slice, ticks_to_event.value());
+                        slice = static_cast<std::uint32_t>(common::max<std::uint64_t>(1, until_event));
+                    }
+                }
+
+                cpu->run(slice);
+
+                const std::uint32_t executed = cpu->get_num_instruction_executed();
+
+                thr->add_ticks(executed);
+                timing->add_ticks(executed);
+
+                instructions_executed += executed;
             } else {
                 cpu->step();
 
@@ -464,6 +508,9 @@ namespace eka2l1 {
 #endif
 
                 thr->add_ticks(1);
+                timing->add_ticks(1);
+
+                instructions_executed++;
             }
         }
 
@@ -530,6 +577,7 @@ namespace eka2l1 {
     }
 
     void system_impl::shutdown() {
+        dispatcher.shutdown();
         kern.reset();
         mem.reset();
         asmdis.shutdown();
@@ -734,6 +782,10 @@ namespace eka2l1 {
         return impl->should_exit();
     }
 
+    std::uint64_t system::get_instructions_executed() const {
+        return impl->get_instructions_executed();
+    }
+
     void system::add_new_hal(uint32_t hal_category, hal_instance &hal_com) {
         return impl->add_new_hal(hal_category, hal_com);
     }
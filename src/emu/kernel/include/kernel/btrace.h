@@ -19,28 +19,50 @@
 
 #pragma once
 
+#include <common/ring.h>
 #include <vfs/vfs.h>
+
+#include <atomic>
+#include <condition_variable>
 #include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 namespace eka2l1 {
     class kernel_system;
     class io_system;
 }
 
-namespace eka2l1::kernel {
-    enum btrace_header_structure {
-        btrace_header_size_index = 0,
-        btrace_header_flag_index = 1,
-        btrace_header_category_index = 2,
-        btrace_header_subcategory_index = 3
-    };
+namespace eka2l1::loader::btrace {
+    struct record;
+}
 
+namespace eka2l1::kernel {
+    /**
+     * \brief Capture trace calls made by the guest.
+     *
+     * Records are stored raw in a ring buffer. A separate thread writes them to the capture
+     * file in batches, which can be decoded later with the btracedump tool.
+     */
     struct btrace {
+        using record_ring = common::spsc_ring_buffer<loader::btrace::record>;
+
         io_system *io_;
         kernel_system *kern_;
 
         symfile trace_;
 
+        std::unique_ptr<record_ring> records_;
+        std::unique_ptr<std::thread> flush_thread_;
+
+        std::mutex flush_lock_;
+        std::condition_variable flush_cond_;
+        std::atomic<bool> flush_stop_;
+
+        void flush_thread_loop();
+        void flush_records();
+
     public:
         explicit btrace(kernel_system *kern, io_system *io);
         ~btrace();
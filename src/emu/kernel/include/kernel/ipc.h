@@ -123,5 +123,5 @@ namespace eka2l1 {
             : own_thr(own) {}
     };
 
-    using ipc_msg_ptr = std::shared_ptr<ipc_msg>;
+    using ipc_msg_ptr = ipc_msg *;
 }
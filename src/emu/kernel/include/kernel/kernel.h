@@ -204,6 +204,13 @@ namespace eka2l1 {
      */
     using codeseg_loaded_callback = std::function<void(const std::string&, kernel::process*, codeseg_ptr)>;
 
+    /**
+     * @brief Callback invoked when the kernel is about to reschedule, with the kernel locked.
+     * 
+     * Used to deliver work that host threads have posted, such as completed requests.
+     */
+    using reschedule_callback = std::function<void()>;
+
     struct kernel_global_data {
         kernel::char_set char_set_;
 
@@ -217,7 +224,10 @@ namespace eka2l1 {
         friend class gdbstub;
         friend class kernel::process;
 
-        std::array<ipc_msg_ptr, 0x1000> msgs_;
+        // Messages live here for the whole kernel lifetime. Free slots are kept in a stack, so
+        // the most recently freed message, which is likely still hot in cache, is reused first.
+        std::array<ipc_msg, 0x1000> msgs_;
+        std::vector<std::uint32_t> free_msg_slots_;
         std::mutex kern_lock_;
 
         std::vector<kernel_obj_unq_ptr> threads_;
@@ -269,11 +279,32 @@ namespace eka2l1 {
         common::identity_container<breakpoint_callback> breakpoint_callbacks_;
         common::identity_container<process_switch_callback> process_switch_callback_funcs_;
         common::identity_container<codeseg_loaded_callback> codeseg_loaded_callback_funcs_;
+        common::identity_container<reschedule_callback> reschedule_callback_funcs_;
+
+        /**
+         * \brief Kernel objects of a type, indexed by full name.
+         * 
+         * Full name depends on the owner chain. Renaming or changing owner of an object re-keys it,
+         * except for processes and threads, which own other objects: that marks all indexes dirty.
+         * A dirty index is rebuilt on next lookup.
+         */
+        struct object_name_index {
+            std::unordered_map<std::string, kernel_obj_ptr> objects_;
+            bool has_duplicates_ = false; ///< Some objects share a full name with an indexed one.
+            bool dirty_ = true;
+        };
+
+        std::array<object_name_index, static_cast<std::size_t>(kernel::object_type::unk)> name_indexes_;
 
     protected:
         void setup_new_process(process_ptr pr);
         void cpu_exception_thread_handle(arm::core *core);
 
+        std::vector<kernel_obj_unq_ptr> *get_object_container(const kernel::object_type type);
+
+        void add_object_to_name_index(kernel_obj_ptr obj);
+        void remove_object_from_name_index(kernel_obj_ptr obj);
+
     public:
         explicit kernel_system(system *esys, ntimer *timing, io_system *io_sys, config::state *conf,
             loader::rom *rom_info, arm::core *cpu, disasm *diassembler);
@@ -300,8 +331,10 @@ namespace eka2l1 {
         std::size_t register_breakpoint_hit_callback(breakpoint_callback callback);
         std::size_t register_process_switch_callback(process_switch_callback callback);
         std::size_t register_codeseg_loaded_callback(codeseg_loaded_callback callback);
+        std::size_t register_reschedule_callback(reschedule_callback callback);
         
         bool unregister_codeseg_loaded_callback(const std::size_t handle);
+        bool unregister_reschedule_callback(const std::size_t handle);
         bool unregister_ipc_send_callback(const std::size_t handle);
         bool unregister_ipc_complete_callback(const std::size_t handle);
         bool unregister_thread_kill_callback(const std::size_t handle);
@@ -321,6 +354,16 @@ namespace eka2l1 {
 
         void free_msg(ipc_msg_ptr msg);
 
+        /**
+         * \brief Complete a message: signal its sender, then give its slot back to the pool.
+         *
+         * Locked messages (the synchronous message of each thread) stay allocated.
+         *
+         * \param msg           The message to complete.
+         * \param complete_code The code written to the request status of the sender.
+         */
+        void complete_msg(ipc_msg_ptr msg, const int complete_code);
+
         /*! \brief Completely destroy a message. */
         void destroy_msg(ipc_msg_ptr msg);
 
@@ -339,6 +382,7 @@ namespace eka2l1 {
             }
 
             servers_.push_back(std::move(svr));
+            add_object_to_name_index(servers_.back().get());
         }
 
         bool destroy(kernel_obj_ptr obj);
@@ -463,43 +507,33 @@ namespace eka2l1 {
             return result;
         }
 
-        template <typename T>
-        T *get_by_name_and_type(const std::string &name, const kernel::object_type obj_type) {
-            switch (obj_type) {
-#define OBJECT_SEARCH(obj_type, obj_map)                                               \
-    case kernel::object_type::obj_type: {                                              \
-        auto res = std::find_if(obj_map.begin(), obj_map.end(), [&](const auto &rhs) { \
-            std::string the_full_name;                                                 \
-            rhs->full_name(the_full_name);                                             \
-            return the_full_name == name;                                              \
-        });                                                                            \
-        if (res == obj_map.end())                                                      \
-            return nullptr;                                                            \
-        return reinterpret_cast<T *>(res->get());                                      \
-    }
-
-                OBJECT_SEARCH(mutex, mutexes_)
-                OBJECT_SEARCH(sema, semas_)
-                OBJECT_SEARCH(chunk, chunks_)
-                OBJECT_SEARCH(thread, threads_)
-                OBJECT_SEARCH(process, processes_)
-                OBJECT_SEARCH(change_notifier, change_notifiers_)
-                OBJECT_SEARCH(library, libraries_)
-                OBJECT_SEARCH(codeseg, codesegs_)
-                OBJECT_SEARCH(server, servers_)
-                OBJECT_SEARCH(prop, props_)
-                OBJECT_SEARCH(prop_ref, prop_refs_)
-                OBJECT_SEARCH(session, sessions_)
-                OBJECT_SEARCH(timer, timers_)
-                OBJECT_SEARCH(msg_queue, message_queues_)
+        /**
+         * \brief Get kernel object of a type by its full name.
+         * 
+         * If many objects share the same full name, the oldest one is returned.
+         */
+        kernel_obj_ptr get_by_full_name(const std::string &name, const kernel::object_type obj_type);
 
-#undef OBJECT_SEARCH
+        /**
+         * \brief Mark all object name indexes outdated.
+         * 
+         * Call this when the full names of many existing objects may have changed.
+         */
+        void invalidate_object_name_indexes();
 
-            default:
-                break;
-            }
+        /**
+         * \brief Move an object to its new full name in the name index of its type.
+         * 
+         * Objects not indexed yet (still being created) are left alone.
+         * 
+         * \param obj           The object which full name changed.
+         * \param old_full_name The full name of the object before the change.
+         */
+        void reindex_object_name(kernel_obj_ptr obj, const std::string &old_full_name);
 
-            return nullptr;
+        template <typename T>
+        T *get_by_name_and_type(const std::string &name, const kernel::object_type obj_type) {
+            return reinterpret_cast<T *>(get_by_full_name(name, obj_type));
         }
 
         /*! \brief Get kernel object by name
@@ -567,6 +601,7 @@ namespace eka2l1 {
     case type:                                                     \
         additional_setup;                                          \
         container.push_back(std::move(obj));                       \
+        add_object_to_name_index(container.back().get());          \
         return reinterpret_cast<T *>(container.back().get());
 
             switch (obj_type) {
@@ -106,6 +106,11 @@ namespace eka2l1 {
                 , owner(owner) {
             }
 
+            /*! \brief Update the kernel's name index after the full name of this object changed.
+             * \param old_full_name The full name before the change.
+             */
+            void full_name_changed(const std::string &old_full_name);
+
         public:
             virtual ~kernel_obj() {}
             virtual void close() {}
@@ -131,18 +136,14 @@ namespace eka2l1 {
                 return access;
             }
 
-            void set_access_type(kernel::access_type acc) {
-                access = acc;
-            }
+            void set_access_type(kernel::access_type acc);
 
             object_type get_object_type() const {
                 return obj_type;
             }
 
             // WARNING: This function have not ever set child owner. Child owner stays the same.
-            void set_owner(kernel_obj *new_owner) {
-                owner = new_owner;
-            }
+            void set_owner(kernel_obj *new_owner);
 
             void full_name(std::string &name_will_full);
 
@@ -158,9 +159,7 @@ namespace eka2l1 {
             /*! \brief Rename the kernel object. 
              * \param new_name The new name of object.
              */
-            virtual void rename(const std::string &new_name) {
-                obj_name = new_name;
-            }
+            virtual void rename(const std::string &new_name);
 
             virtual void do_state(common::chunkyseri &seri);
         };
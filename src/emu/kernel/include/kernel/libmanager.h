@@ -29,8 +29,10 @@
 #include <functional>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace YAML {
@@ -65,6 +67,8 @@ namespace eka2l1 {
         struct e32img;
         struct romimg;
 
+        class e32_payload_cache;
+
         using e32img_ptr = std::shared_ptr<e32img>;
         using romimg_ptr = std::shared_ptr<romimg>;
     }
@@ -73,6 +77,69 @@ namespace eka2l1 {
         using export_table = std::vector<std::uint32_t>;
         using symbols = std::vector<std::string>;
 
+        /**
+         * \brief A HLE system call slot, along with its profiling counters.
+         */
+        struct svc_info {
+            epoc_import_func func_;
+
+            std::uint64_t call_count_ = 0;
+            std::uint64_t total_time_ns_ = 0; ///< Cumulative host time spent in the call. Only counted while profiling.
+        };
+
+        using svc_visitor = std::function<void(const sid, const svc_info &)>;
+        using parsed_image = std::pair<loader::e32img_ptr, loader::romimg_ptr>;
+
+        /**
+         * \brief Parsed and decompressed images, kept around for the next load.
+         * 
+         * An image is only returned while the last write time and size of its file stay the
+         * same as when it was added. Least recently used images are dropped when full.
+         */
+        class image_cache {
+            struct cached_image {
+                std::uint64_t last_write_ = 0;
+                std::uint64_t size_ = 0;
+                std::uint64_t last_use_ = 0;
+
+                parsed_image image_;
+            };
+
+            std::unordered_map<std::u16string, cached_image> images_; ///< Lowercased path to image.
+            std::uint64_t use_counter_;
+            std::size_t capacity_;
+
+        public:
+            explicit image_cache(const std::size_t capacity);
+
+            /**
+             * \brief Get a cached image.
+             * 
+             * \param path          Full path of the image file.
+             * \param last_write    Current last write time of the file.
+             * \param size          Current size of the file.
+             * \param need_rom      The cached image must be a ROM image.
+             * 
+             * \returns Nothing if not cached, or if the file has been modified since it was cached.
+             */
+            std::optional<parsed_image> get(const std::u16string &path, const std::uint64_t last_write,
+                const std::uint64_t size, const bool need_rom);
+
+            void add(const std::u16string &path, const std::uint64_t last_write, const std::uint64_t size,
+                const parsed_image &image);
+
+            /**
+             * \brief Drop all images whose path starts with the given lowercased directory path.
+             */
+            void remove_in_directory(const std::u16string &dir);
+
+            void clear();
+
+            std::size_t size() const {
+                return images_.size();
+            }
+        };
+
         /**
          * \brief Manage libraries and HLE functions.
 		 * 
@@ -90,6 +157,34 @@ namespace eka2l1 {
 
             kernel::chunk *bootstrap_chunk_;
             bool log_svc{ false };
+            bool profile_svc_{ false };
+
+            // System calls are looked up on every guest SVC instruction, so keep dense ordinals
+            // in flat tables. Fast executive calls start from 0, slow ones from SVC_SLOW_EXEC_BASE.
+            std::vector<svc_info> svc_fast_table_;
+            std::vector<svc_info> svc_slow_table_;
+
+            // EKA1 executive ordinals (0x80xxxx and 0xC0xxxx) are few and far apart.
+            std::unordered_map<sid, svc_info> svc_sparse_table_;
+
+            /**
+             * \brief Results of probing files in a directory, while searching for libraries.
+             * 
+             * Only directories that are watched for changes (or on ROM, which never changes) are
+             * cached, so the results can be dropped when the directory content changes.
+             */
+            struct probed_directory {
+                std::int64_t watch_ = -1;
+                std::unordered_map<std::u16string, bool> entries_; ///< Lowercased file name to existence.
+            };
+
+            static constexpr std::size_t MAX_CACHED_IMAGES = 32;
+
+            std::mutex cache_lock_;
+            std::unordered_map<std::u16string, probed_directory> probed_dirs_;
+            image_cache image_cache_{ MAX_CACHED_IMAGES };
+
+            std::unique_ptr<loader::e32_payload_cache> e32_cache_; ///< Decompressed payloads persisted across runs.
 
         protected:
             const std::uint8_t *entry_points_call_routine_;
@@ -97,8 +192,27 @@ namespace eka2l1 {
 
             drive_number get_drive_rom();
 
+            /**
+             * \brief Check if a file exists, remembering the result while its directory stays unchanged.
+             */
+            bool exist_cached(const std::u16string &path);
+
+            /**
+             * \brief Open and parse an image, or get it from the cache if the file has not been modified since.
+             * 
+             * \param path       The full path of the image.
+             * \param try_rom    Parse the image as a ROM image if it's not an E32 image.
+             * 
+             * \returns Both nullptr if the image can't be parsed.
+             */
+            parsed_image parse_image_cached(const std::u16string &path, const bool try_rom);
+
+            void on_probed_directory_changed(const std::u16string &dir);
+
         public:
-            std::map<sid, epoc_import_func> svc_funcs_;
+            static constexpr sid SVC_SLOW_EXEC_BASE = 0x800000;
+            static constexpr sid SVC_MAX_FAST_EXEC_TABLE_SIZE = 0x1000;
+
             std::vector<std::u16string> search_paths;
 
             explicit lib_manager(kernel_system *kern, io_system *ios, memory_system *mems);
@@ -115,6 +229,47 @@ namespace eka2l1 {
 			*/
             bool call_svc(sid svcnum);
 
+            /**
+             * \brief Register HLE system calls.
+             * 
+             * Existing system calls with the same ordinal are kept.
+             * 
+             * \param funcs Map of system call ordinals to their implementation.
+             */
+            void register_svcs(const func_map &funcs);
+
+            /**
+             * \brief Get a registered HLE system call.
+             * 
+             * \param svcnum The system call ordinal.
+             * \returns Nullptr if the system call is not implemented.
+             */
+            svc_info *get_svc_info(const sid svcnum);
+
+            /**
+             * \brief Visit all registered system calls, in ordinal order.
+             */
+            void visit_svcs(svc_visitor visitor);
+
+            /**
+             * \brief Reset call counters and host time of all system calls.
+             */
+            void reset_svc_stats();
+
+            /**
+             * \brief Enable measuring host time spent in each system call.
+             * 
+             * Call counters are always updated. Timing costs two clock reads per call,
+             * so it is only done on demand.
+             */
+            void set_svc_profiling(const bool enable) {
+                profile_svc_ = enable;
+            }
+
+            bool is_svc_profiling() const {
+                return profile_svc_;
+            }
+
             /**
              * \brief Load a codeseg/library/exe from name
              *
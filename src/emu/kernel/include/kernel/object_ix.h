@@ -45,13 +45,20 @@ namespace eka2l1 {
             bool free = true;
         };
 
+        /*! \brief Number of records the handle table grows by each time it runs out of slots. */
+        static constexpr std::size_t OBJECT_IX_GROW_CHUNK = 0x100;
+
+        /*! \brief Maximum number of records, limited by the 15-bit index field of a handle. */
+        static constexpr std::size_t OBJECT_IX_MAX_SLOTS = 0x8000;
+
         /*! \brief The ultimate object handles holder. */
         class object_ix {
             uint64_t uid;
 
             size_t next_instance;
 
-            std::array<object_ix_record, 0x100> objects;
+            std::vector<object_ix_record> objects;
+            std::vector<std::uint32_t> free_slots; ///< Stack of free record indexes. Top is reused first.
             std::vector<std::uint32_t> handles;
 
             handle_array_owner owner;
@@ -59,6 +66,12 @@ namespace eka2l1 {
 
             uint32_t make_handle(size_t index);
 
+            /**
+             * @brief   Add a chunk of free records to the table.
+             * @returns False if the table already reached the maximum size a handle can index.
+             */
+            bool grow();
+
             kernel_system *kern;
 
         public:
@@ -1,6 +1,6 @@
 #pragma once
 
-#define ADD_SVC_REGISTERS(mngr, map) mngr.svc_funcs_.insert(map.begin(), map.end())
+#define ADD_SVC_REGISTERS(mngr, map) mngr.register_svcs(map)
 
 namespace eka2l1::hle {
     class lib_manager;
@@ -66,6 +66,8 @@ namespace eka2l1 {
             int yield_evt;
             std::uint32_t ticks_yield;
 
+            std::uint64_t context_switches;
+
         protected:
             kernel::thread *next_ready_thread();
             void switch_context(kernel::thread *oldt, kernel::thread *newt);
@@ -98,6 +100,13 @@ namespace eka2l1 {
             kernel::process *current_process() const {
                 return crr_process;
             }
+
+            /**
+             * \brief Get the number of times the running thread has been replaced by another one.
+             */
+            std::uint64_t total_context_switches() const {
+                return context_switches;
+            }
         };
     }
 }
@@ -46,7 +46,7 @@ namespace eka2l1 {
     class memory;
 
     struct ipc_msg;
-    using ipc_msg_ptr = std::shared_ptr<ipc_msg>;
+    using ipc_msg_ptr = ipc_msg *;
 
     namespace kernel {
         class mutex;
@@ -22,10 +22,13 @@
 #include <common/queue.h>
 #include <common/time.h>
 
+#include <atomic>
 #include <cstdint>
 #include <functional>
 #include <mutex>
+#include <optional>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 namespace eka2l1 {
@@ -46,6 +49,24 @@ namespace eka2l1 {
         int event_type;
         uint64_t event_time;
         uint64_t event_user_data;
+        uint64_t event_order; ///< Schedule order. Breaks ties between events firing at the same time.
+        std::size_t heap_index; ///< Position of this event in the timer's heap.
+    };
+
+    /**
+     * \brief Identify scheduled events for cancellation.
+     */
+    struct event_key {
+        int event_type;
+        uint64_t event_user_data;
+
+        bool operator==(const event_key &rhs) const {
+            return (event_type == rhs.event_type) && (event_user_data == rhs.event_user_data);
+        }
+    };
+
+    struct event_key_hash {
+        std::size_t operator()(const event_key &key) const;
     };
 
     namespace common {
@@ -59,7 +80,12 @@ namespace eka2l1 {
      */
     class ntimer {
     private:
-        std::vector<event> events_;
+        std::vector<event> events_; ///< Event slots. Freed slots are reused.
+        std::vector<std::uint32_t> free_event_slots_;
+        std::vector<std::uint32_t> event_heap_; ///< Min-heap of slot indexes, ordered by fire time.
+        std::unordered_multimap<event_key, std::uint32_t, event_key_hash> event_lookup_;
+        std::uint64_t event_order_counter_;
+
         std::mutex lock_;
         std::mutex new_event_avail_lock_;
 
@@ -74,11 +100,27 @@ namespace eka2l1 {
         std::atomic<bool> should_stop_;
         std::atomic<bool> should_paused_;
 
+        bool deterministic_; ///< Guest time only moves with executed instructions. No timer thread.
+        std::atomic<std::uint64_t> virtual_ticks_;
+
     protected:
         void loop();
 
+        bool is_event_before(const std::uint32_t lhs, const std::uint32_t rhs) const;
+        void swap_heap_entries(const std::size_t lhs, const std::size_t rhs);
+        void heap_sift_up(std::size_t pos);
+        void heap_sift_down(std::size_t pos);
+        void remove_event_at(const std::size_t heap_pos);
+
     public:
-        explicit ntimer(const std::uint32_t cpu_hz);
+        /**
+         * @brief Construct the timer.
+         * 
+         * @param cpu_hz            Frequency of the guest CPU.
+         * @param deterministic     If true, guest time is only advanced through add_ticks(), and events
+         *                          are fired by the thread that calls it, rather than by a timer thread.
+         */
+        explicit ntimer(const std::uint32_t cpu_hz, const bool deterministic = false);
         ~ntimer();
 
         inline int64_t ms_to_cycles(int ms) {
@@ -127,6 +169,30 @@ namespace eka2l1 {
         bool is_paused() const;
         void set_paused(const bool should_pause);
 
+        bool is_deterministic() const {
+            return deterministic_;
+        }
+
+        /**
+         * @brief Advance guest time by the number of instructions executed, and fire events that are due.
+         * 
+         * Only used in deterministic mode.
+         */
+        void add_ticks(const std::uint64_t ticks);
+
+        /**
+         * @brief Get the number of ticks left until the earliest event fires.
+         * @returns Nothing if no event is scheduled.
+         */
+        std::optional<std::uint64_t> ticks_to_next_event();
+
+        /**
+         * @brief Jump guest time to the earliest event and fire it. Called when no thread is ready to run.
+         * 
+         * Only used in deterministic mode.
+         */
+        void idle();
+
         /**
          * @brief       Advance the timer.
          * @returns     Nanoseconds to next timer.
@@ -139,6 +205,14 @@ namespace eka2l1 {
         void remove_event(int event_type);
 
         void schedule_event(int64_t us_into_future, int event_type, std::uint64_t userdata);
+
+        /**
+         * @brief Cancel a scheduled event.
+         * 
+         * If several events share the type and userdata, the one that would fire first is cancelled.
+         * 
+         * @returns False if no such event is scheduled.
+         */
         bool unschedule_event(int event_type, uint64_t userdata);
 
         bool set_clock_frequency_mhz(const std::uint32_t cpu_mhz);
@@ -1,11 +1,24 @@
 #include <common/log.h>
 #include <kernel/btrace.h>
+#include <kernel/kernel.h>
+#include <kernel/thread.h>
+#include <kernel/timing.h>
+#include <loader/btrace.h>
+
+#include <array>
+#include <chrono>
 
 namespace eka2l1::kernel {
+    // 2MB worth of records. Flushing starts once half of it is filled.
+    static constexpr std::size_t BTRACE_RING_RECORD_COUNT = 0x10000;
+    static constexpr std::size_t BTRACE_FLUSH_BATCH_COUNT = 0x400;
+    static constexpr std::uint32_t BTRACE_FLUSH_INTERVAL_MS = 100;
+
     btrace::btrace(kernel_system *kern, io_system *io)
         : io_(io)
         , kern_(kern)
-        , trace_(nullptr) {
+        , trace_(nullptr)
+        , flush_stop_(false) {
     }
 
     btrace::~btrace() {
@@ -17,8 +30,22 @@ namespace eka2l1::kernel {
             return false;
         }
 
-        trace_ = io_->open_file(trace_path, WRITE_MODE);
-        return (trace_ != nullptr);
+        trace_ = io_->open_file(trace_path, WRITE_MODE | BIN_MODE);
+
+        if (!trace_) {
+            return false;
+        }
+
+        const loader::btrace::capture_header header{ loader::btrace::CAPTURE_MAGIC, loader::btrace::CAPTURE_VERSION,
+            sizeof(loader::btrace::record), 0 };
+
+        trace_->write_file(&header, sizeof(header), 1);
+
+        records_ = std::make_unique<record_ring>(BTRACE_RING_RECORD_COUNT);
+        flush_stop_ = false;
+        flush_thread_ = std::make_unique<std::thread>([this]() { flush_thread_loop(); });
+
+        return true;
     }
 
     bool btrace::close_trace_session() {
@@ -26,10 +53,49 @@ namespace eka2l1::kernel {
             return false;
         }
 
+        if (flush_thread_) {
+            {
+                const std::lock_guard<std::mutex> guard(flush_lock_);
+                flush_stop_ = true;
+            }
+
+            flush_cond_.notify_one();
+            flush_thread_->join();
+            flush_thread_.reset();
+        }
+
         return trace_->close();
     }
 
-    static const std::u16string DEFAULT_TRACE_FILE = u"c:\\btrace.txt";
+    void btrace::flush_records() {
+        std::array<loader::btrace::record, BTRACE_FLUSH_BATCH_COUNT> batch;
+        std::size_t count = 0;
+
+        while ((count = records_->read(batch.data(), batch.size())) != 0) {
+            trace_->write_file(batch.data(), sizeof(loader::btrace::record), static_cast<std::uint32_t>(count));
+        }
+
+        trace_->flush();
+    }
+
+    void btrace::flush_thread_loop() {
+        while (true) {
+            {
+                std::unique_lock<std::mutex> ulock(flush_lock_);
+                flush_cond_.wait_for(ulock, std::chrono::milliseconds(BTRACE_FLUSH_INTERVAL_MS), [this]() {
+                    return flush_stop_.load() || (records_->size() >= records_->capacity() / 2);
+                });
+            }
+
+            flush_records();
+
+            if (flush_stop_) {
+                break;
+            }
+        }
+    }
+
+    static const std::u16string DEFAULT_TRACE_FILE = u"c:\\btrace.bin";
 
     bool btrace::out(const std::uint32_t a0, const std::uint32_t a1, const std::uint32_t a2,
         const std::uint32_t a3) {
@@ -37,25 +103,31 @@ namespace eka2l1::kernel {
             return false;
         }
 
-        // Check out the header
-        const std::uint32_t args_size = (a0 >> (btrace_header_size_index * 8)) & 0xFF;
-        const std::uint32_t flags = (a0 >> (btrace_header_flag_index * 8)) & 0xFF;
-        const std::uint32_t category = (a0 >> (btrace_header_category_index * 8)) & 0xFF;
-        const std::uint32_t subcategory = (a0 >> (btrace_header_subcategory_index * 8)) & 0xFF;
+        if (!flush_thread_) {
+            return false;
+        }
 
-        if (trace_) {
-            std::string message = "Trace out (data size = {}, flags = {}, category = {}, subcategory = {}):\n"
-                                  "\ta1 = 0x{:X}\n"
-                                  "\ta2 = 0x{:X}\n"
-                                  "\ta3 = 0x{:X}\n"
-                                  "\n";
+        kernel::thread *crr = kern_->crr_thread();
+
+        loader::btrace::record rec;
+        rec.timestamp_ = kern_->get_ntimer()->microseconds();
+        rec.thread_id_ = crr ? static_cast<std::uint32_t>(crr->unique_id()) : 0;
+        rec.args_[0] = a0;
+        rec.args_[1] = a1;
+        rec.args_[2] = a2;
+        rec.args_[3] = a3;
+        rec.reserved_ = 0;
 
-            message = fmt::format(message, args_size, flags, category, subcategory, a1, a2, a3);
-            trace_->write_file(&message[0], static_cast<std::uint32_t>(message.size()), 1);
+        // Should rarely happen. Wait for the flush thread rather than losing the record.
+        while (records_->write(&rec, 1) == 0) {
+            flush_cond_.notify_one();
+            std::this_thread::yield();
+        }
 
-            trace_->flush();
+        if (records_->size() >= records_->capacity() / 2) {
+            flush_cond_.notify_one();
         }
 
         return true;
     }
-}
\ No newline at end of file
+}
@@ -98,6 +98,15 @@ namespace eka2l1 {
         // Get base time
         base_time_ = common::get_current_time_in_microseconds_since_1ad();
         locale_ = std::make_unique<std::locale>("");
+
+        // Lower slots are given out first
+        free_msg_slots_.resize(msgs_.size());
+
+        for (std::uint32_t i = 0; i < static_cast<std::uint32_t>(msgs_.size()); i++) {
+            msgs_[i].id = i;
+            msgs_[i].free = true;
+            free_msg_slots_[i] = static_cast<std::uint32_t>(msgs_.size()) - i - 1;
+        }
     }
 
     kernel_system::~kernel_system() {
@@ -111,7 +120,8 @@ namespace eka2l1 {
     for (auto &obj: container) {                        \
         obj->destroy();                                 \
     }                                                   \
-    container.clear();
+    container.clear();                                  \
+    invalidate_object_name_indexes();
 
         // Delete one by one in order. Do not change the order
         OBJECT_CONTAINER_CLEANUP(sessions_);
@@ -254,6 +264,11 @@ namespace eka2l1 {
 
     void kernel_system::reschedule() {
         lock();
+
+        for (auto &reschedule_callback_func: reschedule_callback_funcs_) {
+            reschedule_callback_func();
+        }
+
         thr_sch_->reschedule();
         unlock();
     }
@@ -345,32 +360,39 @@ namespace eka2l1 {
         return codeseg_loaded_callback_funcs_.remove(handle);
     }
 
-    ipc_msg_ptr kernel_system::create_msg(kernel::owner_type owner) {
-        auto slot_free = std::find_if(msgs_.begin(), msgs_.end(),
-            [](auto slot) { return !slot || slot->free; });
-
-        if (slot_free != msgs_.end()) {
-            if (!*slot_free) {
-                ipc_msg_ptr msg = std::make_shared<ipc_msg>(crr_thread());
-                *slot_free = std::move(msg);
-            }
+    std::size_t kernel_system::register_reschedule_callback(reschedule_callback callback) {
+        return reschedule_callback_funcs_.add(callback);
+    }
 
-            slot_free->get()->own_thr = crr_thread();
-            slot_free->get()->free = false;
-            slot_free->get()->id = static_cast<std::uint32_t>(slot_free - msgs_.begin());
+    bool kernel_system::unregister_reschedule_callback(const std::size_t handle) {
+        return reschedule_callback_funcs_.remove(handle);
+    }
 
-            return *slot_free;
+    ipc_msg_ptr kernel_system::create_msg(kernel::owner_type owner) {
+        if (free_msg_slots_.empty()) {
+            return nullptr;
         }
 
-        return nullptr;
+        const std::uint32_t slot = free_msg_slots_.back();
+        free_msg_slots_.pop_back();
+
+        ipc_msg_ptr msg = &msgs_[slot];
+        msg->own_thr = crr_thread();
+        msg->msg_session = nullptr;
+        msg->session_ptr_lle = 0;
+        msg->request_sts = 0;
+        msg->attrib = 0;
+        msg->free = false;
+
+        return msg;
     }
 
     ipc_msg_ptr kernel_system::get_msg(int handle) {
-        if (msgs_.size() <= handle) {
+        if ((handle < 0) || (msgs_.size() <= handle)) {
             return nullptr;
         }
 
-        return msgs_[handle];
+        return &msgs_[handle];
     }
 
     bool kernel_system::destroy(kernel_obj_ptr obj) {
@@ -382,6 +404,7 @@ namespace eka2l1 {
         });                                                                                                      \
         if (res == obj_map.end())                                                                                \
             return false;                                                                                        \
+        remove_object_from_name_index(res->get());                                                               \
         (*res)->destroy();                                                                                       \
         obj_map.erase(res);                                                                                      \
         return true;                                                                                             \
@@ -569,16 +592,30 @@ namespace eka2l1 {
     }
 
     void kernel_system::free_msg(ipc_msg_ptr msg) {
-        if (msg->locked()) {
+        // Messages may be freed more than once (for example by both server destroy and destructor),
+        // so make sure the slot does not end up in the free stack twice.
+        if (msg->locked() || msg->free) {
             return;
         }
 
         msg->free = true;
+        free_msg_slots_.push_back(msg->id);
+    }
+
+    void kernel_system::complete_msg(ipc_msg_ptr msg, const int complete_code) {
+        if (msg->request_sts) {
+            *(msg->request_sts.get(msg->own_thr->owning_process())) = complete_code;
+            msg->own_thr->signal_request();
+        }
+
+        call_ipc_complete_callbacks(msg, complete_code);
+        free_msg(msg);
     }
 
     /*! \brief Completely destroy a message. */
     void kernel_system::destroy_msg(ipc_msg_ptr msg) {
-        (msgs_.begin() + msg->id)->reset();
+        msg->unlock_free();
+        free_msg(msg);
     }
 
     property_ptr kernel_system::get_prop(int category, int key) {
@@ -799,6 +836,165 @@ namespace eka2l1 {
         return std::nullopt;
     }
 
+    std::vector<kernel_obj_unq_ptr> *kernel_system::get_object_container(const kernel::object_type type) {
+        switch (type) {
+        case kernel::object_type::mutex:
+            return &mutexes_;
+
+        case kernel::object_type::sema:
+            return &semas_;
+
+        case kernel::object_type::chunk:
+            return &chunks_;
+
+        case kernel::object_type::thread:
+            return &threads_;
+
+        case kernel::object_type::process:
+            return &processes_;
+
+        case kernel::object_type::change_notifier:
+            return &change_notifiers_;
+
+        case kernel::object_type::library:
+            return &libraries_;
+
+        case kernel::object_type::codeseg:
+            return &codesegs_;
+
+        case kernel::object_type::server:
+            return &servers_;
+
+        case kernel::object_type::prop:
+            return &props_;
+
+        case kernel::object_type::prop_ref:
+            return &prop_refs_;
+
+        case kernel::object_type::session:
+            return &sessions_;
+
+        case kernel::object_type::timer:
+            return &timers_;
+
+        case kernel::object_type::msg_queue:
+            return &message_queues_;
+
+        default:
+            break;
+        }
+
+        return nullptr;
+    }
+
+    void kernel_system::add_object_to_name_index(kernel_obj_ptr obj) {
+        object_name_index &index = name_indexes_[static_cast<std::size_t>(obj->get_object_type())];
+
+        if (index.dirty_) {
+            return;
+        }
+
+        std::string the_full_name;
+        obj->full_name(the_full_name);
+
+        // Keep the oldest object on name clash, like a linear search would do
+        if (!index.objects_.emplace(std::move(the_full_name), obj).second) {
+            index.has_duplicates_ = true;
+        }
+    }
+
+    void kernel_system::remove_object_from_name_index(kernel_obj_ptr obj) {
+        object_name_index &index = name_indexes_[static_cast<std::size_t>(obj->get_object_type())];
+
+        if (index.dirty_) {
+            return;
+        }
+
+        std::string the_full_name;
+        obj->full_name(the_full_name);
+
+        auto ite = index.objects_.find(the_full_name);
+
+        if ((ite == index.objects_.end()) || (ite->second != obj)) {
+            return;
+        }
+
+        index.objects_.erase(ite);
+
+        if (index.has_duplicates_) {
+            // Another object may now own this name. Let the next lookup sort it out.
+            index.dirty_ = true;
+        }
+    }
+
+    void kernel_system::reindex_object_name(kernel_obj_ptr obj, const std::string &old_full_name) {
+        object_name_index &index = name_indexes_[static_cast<std::size_t>(obj->get_object_type())];
+
+        if (index.dirty_) {
+            return;
+        }
+
+        auto ite = index.objects_.find(old_full_name);
+
+        if ((ite == index.objects_.end()) || (ite->second != obj)) {
+            // Either not added yet, or hidden behind an older object with the same name
+            if (index.has_duplicates_) {
+                index.dirty_ = true;
+            }
+
+            return;
+        }
+
+        index.objects_.erase(ite);
+
+        std::string new_full_name;
+        obj->full_name(new_full_name);
+
+        // An object may now own the old name, or clash with the new one. Which one wins depends on
+        // the creation order, let the next lookup sort it out.
+        if (index.has_duplicates_ || !index.objects_.emplace(std::move(new_full_name), obj).second) {
+            index.dirty_ = true;
+        }
+    }
+
+    void kernel_system::invalidate_object_name_indexes() {
+        for (object_name_index &index : name_indexes_) {
+            index.dirty_ = true;
+        }
+    }
+
+    kernel_obj_ptr kernel_system::get_by_full_name(const std::string &name, const kernel::object_type obj_type) {
+        if (obj_type >= kernel::object_type::unk) {
+            return nullptr;
+        }
+
+        object_name_index &index = name_indexes_[static_cast<std::size_t>(obj_type)];
+
+        if (index.dirty_) {
+            std::vector<kernel_obj_unq_ptr> *container = get_object_container(obj_type);
+
+            if (!container) {
+                return nullptr;
+            }
+
+            index.objects_.clear();
+            index.has_duplicates_ = false;
+            index.dirty_ = false;
+
+            for (auto &obj : *container) {
+                add_object_to_name_index(obj.get());
+            }
+        }
+
+        auto ite = index.objects_.find(name);
+
+        if (ite == index.objects_.end()) {
+            return nullptr;
+        }
+
+        return ite->second;
+    }
+
     bool kernel_system::should_terminate() {
         return thr_sch_->should_terminate();
     }
@@ -52,6 +52,50 @@ namespace eka2l1 {
             seri.absorb(access_count);
         }
 
+        void kernel_obj::full_name_changed(const std::string &old_full_name) {
+            // Processes and threads own other objects, which full names change too.
+            // Those are rare (renames), so just rebuild everything.
+            if ((obj_type == object_type::process) || (obj_type == object_type::thread)) {
+                kern->invalidate_object_name_indexes();
+                return;
+            }
+
+            kern->reindex_object_name(this, old_full_name);
+        }
+
+        void kernel_obj::set_access_type(kernel::access_type acc) {
+            if (access == acc) {
+                return;
+            }
+
+            // Full name depends on access type
+            std::string old_full_name;
+            full_name(old_full_name);
+
+            access = acc;
+            full_name_changed(old_full_name);
+        }
+
+        void kernel_obj::set_owner(kernel_obj *new_owner) {
+            if (owner == new_owner) {
+                return;
+            }
+
+            std::string old_full_name;
+            full_name(old_full_name);
+
+            owner = new_owner;
+            full_name_changed(old_full_name);
+        }
+
+        void kernel_obj::rename(const std::string &new_name) {
+            std::string old_full_name;
+            full_name(old_full_name);
+
+            obj_name = new_name;
+            full_name_changed(old_full_name);
+        }
+
         void kernel_obj::full_name(std::string &name_will_full) {
             // If there is a owner and its access type is not global
             if (owner && (access != kernel::access_type::global_access)) {
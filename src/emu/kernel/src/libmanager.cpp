@@ -25,6 +25,7 @@
 #include <common/log.h>
 #include <common/path.h>
 #include <common/random.h>
+#include <common/watcher.h>
 
 #include <kernel/common.h>
 #include <kernel/libmanager.h>
@@ -33,6 +34,7 @@
 #include <common/configure.h>
 #include <config/config.h>
 
+#include <loader/e32cache.h>
 #include <loader/e32img.h>
 #include <loader/romimage.h>
 #include <mem/page.h>
@@ -42,7 +44,9 @@
 #include <kernel/kernel.h>
 #include <kernel/codeseg.h>
 
+#include <algorithm>
 #include <cctype>
+#include <chrono>
 
 namespace eka2l1::hle {
     // Given relocation entries, relocate the code and data
@@ -329,7 +333,7 @@ namespace eka2l1::hle {
                 eka2l1::ro_file_stream image_data_stream(e32imgfile.get());
 
                 // Try to load them to ROM section
-                auto e32img = loader::parse_e32img(reinterpret_cast<common::ro_stream *>(&image_data_stream));
+                auto e32img = loader::parse_e32img(reinterpret_cast<common::ro_stream *>(&image_data_stream), true, e32_cache_.get());
 
                 if (!e32img) {
                     // Ignore.
@@ -592,35 +596,17 @@ namespace eka2l1::hle {
             std::pair<std::optional<loader::e32img>, std::optional<loader::romimg>>
                 result{ std::nullopt, std::nullopt };
 
-            if (io_->exist(lib_path)) {
-                symfile f = io_->open_file(path, READ_MODE | BIN_MODE);
-                if (!f) {
-                    return result;
-                }
-
-                eka2l1::ro_file_stream image_data_stream(f.get());
-
-                auto parse_result = loader::parse_e32img(reinterpret_cast<common::ro_stream *>(&image_data_stream));
-                if (parse_result != std::nullopt) {
-                    f->close();
-                    result.first = std::move(parse_result);
-
-                    return result;
-                }
+            if (exist_cached(path)) {
+                auto [e32, rom] = parse_image_cached(path, false);
 
-                image_data_stream.seek(0, common::seek_where::beg);
-                auto parse_result_2 = loader::parse_romimg(reinterpret_cast<common::ro_stream *>(&image_data_stream), mem_);
-                if (parse_result_2 != std::nullopt) {
-                    f->close();
-                    result.second = std::move(parse_result_2);
-
-                    return result;
+                if (e32) {
+                    result.first = *e32;
+                } else if (rom) {
+                    result.second = *rom;
                 }
-
-                f->close();
             }
 
-            return std::pair<std::optional<loader::e32img>, std::optional<loader::romimg>>{};
+            return result;
         };
 
         if (!eka2l1::has_root_dir(lib_path)) {
@@ -630,6 +616,7 @@ namespace eka2l1::hle {
 
                 for (drive_number drv = drive_z; drv >= drive_a; drv = static_cast<drive_number>(static_cast<int>(drv) - 1)) {
                     const char16_t drvc = drive_to_char16(drv);
+                    lib_path.clear();
 
                     if (!only_once) {
                         lib_path = drvc;
@@ -668,22 +655,20 @@ namespace eka2l1::hle {
             auto entry = io_->get_drive_entry(drv);
 
             if (entry) {
-                symfile f = io_->open_file(lib_path, READ_MODE | BIN_MODE);
-                if (!f) {
-                    return nullptr;
-                }
-
-                eka2l1::ro_file_stream image_data_stream(f.get());
-
                 if (entry->media_type == drive_media::rom && io_->is_entry_in_rom(lib_path)) {
-                    auto romimg = loader::parse_romimg(reinterpret_cast<common::ro_stream *>(&image_data_stream), mem_);
+                    auto romimg = parse_image_cached(lib_path, true).second;
                     if (!romimg) {
                         return nullptr;
                     }
 
                     return load_as_romimg(*romimg, pr, lib_path);
                 } else {
-                    auto e32img = loader::parse_e32img(reinterpret_cast<common::ro_stream *>(&image_data_stream));
+                    // Already loaded, no need to parse and decompress the image again
+                    if (auto seg = kern_->get_by_name<kernel::codeseg>(get_e32_codeseg_name_from_path(lib_path))) {
+                        return seg;
+                    }
+
+                    auto e32img = parse_image_cached(lib_path, false).first;
                     if (!e32img) {
                         return nullptr;
                     }
@@ -716,7 +701,7 @@ namespace eka2l1::hle {
                     lib_path += search_paths[i];
                     lib_path += name;
 
-                    if (io_->exist(lib_path)) {
+                    if (exist_cached(lib_path)) {
                         auto result = load_depend_on_drive(drv, lib_path);
                         if (result != nullptr) {
                             result->set_full_path(lib_path);
@@ -733,7 +718,7 @@ namespace eka2l1::hle {
         }
 
         drive_number drv = char16_to_drive(lib_path[0]);
-        if (!io_->exist(lib_path)) {
+        if (!exist_cached(lib_path)) {
             return nullptr;
         }
 
@@ -750,25 +735,302 @@ namespace eka2l1::hle {
         return nullptr;
     }
 
+    bool lib_manager::exist_cached(const std::u16string &path) {
+        if (!eka2l1::has_root_name(path, true)) {
+            return io_->exist(path);
+        }
+
+        const drive_number drv = char16_to_drive(path[0]);
+        const std::optional<drive> entry = io_->get_drive_entry(drv);
+
+        if (!entry) {
+            return false;
+        }
+
+        const std::u16string dir = common::lowercase_ucs2_string(eka2l1::file_directory(path, true));
+        const std::u16string name = common::lowercase_ucs2_string(eka2l1::filename(path, true));
+
+        const std::lock_guard<std::mutex> guard(cache_lock_);
+        auto dir_ite = probed_dirs_.find(dir);
+
+        if (dir_ite == probed_dirs_.end()) {
+            // Can't watch a directory that does not exist yet, so don't remember anything about it
+            if (!io_->exist(dir)) {
+                return false;
+            }
+
+            probed_directory probed;
+
+            // ROM never changes. Other directories must be watched, else results can't be trusted later.
+            if (entry->media_type != drive_media::rom) {
+                probed.watch_ = io_->watch_directory(
+                    dir, [this, dir](void *userdata, common::directory_changes &changes) {
+                        on_probed_directory_changed(dir);
+                    },
+                    nullptr, common::directory_change_move | common::directory_change_last_write);
+
+                if (probed.watch_ == -1) {
+                    return io_->exist(path);
+                }
+            }
+
+            dir_ite = probed_dirs_.emplace(dir, std::move(probed)).first;
+        }
+
+        auto file_ite = dir_ite->second.entries_.find(name);
+
+        if (file_ite != dir_ite->second.entries_.end()) {
+            return file_ite->second;
+        }
+
+        const bool exists = io_->exist(path);
+        dir_ite->second.entries_.emplace(name, exists);
+
+        return exists;
+    }
+
+    void lib_manager::on_probed_directory_changed(const std::u16string &dir) {
+        const std::lock_guard<std::mutex> guard(cache_lock_);
+        auto dir_ite = probed_dirs_.find(dir);
+
+        if (dir_ite != probed_dirs_.end()) {
+            dir_ite->second.entries_.clear();
+        }
+
+        // Images in this directory may have been replaced
+        image_cache_.remove_in_directory(dir);
+    }
+
+    image_cache::image_cache(const std::size_t capacity)
+        : use_counter_(0)
+        , capacity_(capacity) {
+    }
+
+    std::optional<parsed_image> image_cache::get(const std::u16string &path, const std::uint64_t last_write,
+        const std::uint64_t size, const bool need_rom) {
+        auto ite = images_.find(common::lowercase_ucs2_string(path));
+
+        if (ite == images_.end()) {
+            return std::nullopt;
+        }
+
+        cached_image &cached = ite->second;
+
+        if ((cached.last_write_ != last_write) || (cached.size_ != size) || (need_rom && !cached.image_.second)) {
+            images_.erase(ite);
+            return std::nullopt;
+        }
+
+        cached.last_use_ = ++use_counter_;
+        return cached.image_;
+    }
+
+    void image_cache::add(const std::u16string &path, const std::uint64_t last_write, const std::uint64_t size,
+        const parsed_image &image) {
+        const std::u16string key = common::lowercase_ucs2_string(path);
+
+        if ((images_.size() >= capacity_) && (images_.find(key) == images_.end())) {
+            auto lru = std::min_element(images_.begin(), images_.end(), [](const auto &lhs, const auto &rhs) {
+                return lhs.second.last_use_ < rhs.second.last_use_;
+            });
+
+            images_.erase(lru);
+        }
+
+        cached_image &cached = images_[key];
+
+        cached.last_write_ = last_write;
+        cached.size_ = size;
+        cached.last_use_ = ++use_counter_;
+        cached.image_ = image;
+    }
+
+    void image_cache::remove_in_directory(const std::u16string &dir) {
+        for (auto ite = images_.begin(); ite != images_.end();) {
+            if (ite->first.compare(0, dir.length(), dir) == 0) {
+                ite = images_.erase(ite);
+            } else {
+                ite++;
+            }
+        }
+    }
+
+    void image_cache::clear() {
+        images_.clear();
+    }
+
+    parsed_image lib_manager::parse_image_cached(const std::u16string &path, const bool is_rom_image) {
+        parsed_image result{ nullptr, nullptr };
+        std::optional<entry_info> info = io_->get_entry_info(path);
+
+        if (!info) {
+            return result;
+        }
+
+        {
+            const std::lock_guard<std::mutex> guard(cache_lock_);
+            std::optional<parsed_image> cached = image_cache_.get(path, info->last_write, info->size, is_rom_image);
+
+            if (cached) {
+                return cached.value();
+            }
+        }
+
+        symfile f = io_->open_file(path, READ_MODE | BIN_MODE);
+        if (!f) {
+            return result;
+        }
+
+        eka2l1::ro_file_stream image_data_stream(f.get());
+
+        if (!is_rom_image) {
+            auto e32 = loader::parse_e32img(reinterpret_cast<common::ro_stream *>(&image_data_stream), true, e32_cache_.get());
+
+            if (e32) {
+                result.first = std::make_shared<loader::e32img>(std::move(*e32));
+            } else {
+                image_data_stream.seek(0, common::seek_where::beg);
+            }
+        }
+
+        if (!result.first) {
+            auto rom = loader::parse_romimg(reinterpret_cast<common::ro_stream *>(&image_data_stream), mem_);
+
+            if (rom) {
+                result.second = std::make_shared<loader::romimg>(std::move(*rom));
+            }
+        }
+
+        f->close();
+
+        if (!result.first && !result.second) {
+            return result;
+        }
+
+        const std::lock_guard<std::mutex> guard(cache_lock_);
+        image_cache_.add(path, info->last_write, info->size, result);
+
+        return result;
+    }
+
+    void lib_manager::register_svcs(const func_map &funcs) {
+        for (const auto &[svcnum, func] : funcs) {
+            std::vector<svc_info> *table = nullptr;
+            sid index = svcnum;
+
+            if (svcnum < SVC_MAX_FAST_EXEC_TABLE_SIZE) {
+                table = &svc_fast_table_;
+            } else if (!kern_->is_eka1() && (svcnum >= SVC_SLOW_EXEC_BASE) && (svcnum < SVC_SLOW_EXEC_BASE + SVC_MAX_FAST_EXEC_TABLE_SIZE)) {
+                table = &svc_slow_table_;
+                index = svcnum - SVC_SLOW_EXEC_BASE;
+            }
+
+            if (!table) {
+                svc_sparse_table_.emplace(svcnum, svc_info{ func });
+                continue;
+            }
+
+            if (table->size() <= index) {
+                table->resize(index + 1);
+            }
+
+            if (!(*table)[index].func_.func) {
+                (*table)[index].func_ = func;
+            }
+        }
+    }
+
+    svc_info *lib_manager::get_svc_info(const sid svcnum) {
+        svc_info *info = nullptr;
+
+        if (svcnum < svc_fast_table_.size()) {
+            info = &svc_fast_table_[svcnum];
+        } else if ((svcnum >= SVC_SLOW_EXEC_BASE) && (svcnum - SVC_SLOW_EXEC_BASE < svc_slow_table_.size())) {
+            info = &svc_slow_table_[svcnum - SVC_SLOW_EXEC_BASE];
+        } else {
+            auto res = svc_sparse_table_.find(svcnum);
+
+            if (res != svc_sparse_table_.end()) {
+                info = &res->second;
+            }
+        }
+
+        if (!info || !info->func_.func) {
+            return nullptr;
+        }
+
+        return info;
+    }
+
+    void lib_manager::visit_svcs(svc_visitor visitor) {
+        for (sid i = 0; i < static_cast<sid>(svc_fast_table_.size()); i++) {
+            if (svc_fast_table_[i].func_.func) {
+                visitor(i, svc_fast_table_[i]);
+            }
+        }
+
+        for (sid i = 0; i < static_cast<sid>(svc_slow_table_.size()); i++) {
+            if (svc_slow_table_[i].func_.func) {
+                visitor(SVC_SLOW_EXEC_BASE + i, svc_slow_table_[i]);
+            }
+        }
+
+        std::vector<sid> sparse_nums;
+        sparse_nums.reserve(svc_sparse_table_.size());
+
+        for (const auto &[svcnum, info] : svc_sparse_table_) {
+            sparse_nums.push_back(svcnum);
+        }
+
+        std::sort(sparse_nums.begin(), sparse_nums.end());
+
+        for (const sid svcnum : sparse_nums) {
+            visitor(svcnum, svc_sparse_table_[svcnum]);
+        }
+    }
+
+    void lib_manager::reset_svc_stats() {
+        auto reset_info = [](svc_info &info) {
+            info.call_count_ = 0;
+            info.total_time_ns_ = 0;
+        };
+
+        std::for_each(svc_fast_table_.begin(), svc_fast_table_.end(), reset_info);
+        std::for_each(svc_slow_table_.begin(), svc_slow_table_.end(), reset_info);
+
+        for (auto &[svcnum, info] : svc_sparse_table_) {
+            reset_info(info);
+        }
+    }
+
     bool lib_manager::call_svc(sid svcnum) {
         // Lock the kernel so SVC call can operate in safety
         kern_->lock();
-        auto res = svc_funcs_.find(svcnum);
+        svc_info *info = get_svc_info(svcnum);
 
-        if (res == svc_funcs_.end()) {
+        if (!info) {
             LOG_ERROR("Unimplement system call: 0x{:X}!", svcnum);
 
             kern_->unlock();
             return false;
         }
 
-        epoc_import_func func = res->second;
-
         if (kern_->get_config()->log_svc) {
-            LOG_TRACE("Calling SVC 0x{:x} {}", svcnum, func.name);
+            LOG_TRACE("Calling SVC 0x{:x} {}", svcnum, info->func_.name);
         }
 
-        func.func(kern_, kern_->crr_process(), kern_->get_cpu());
+        info->call_count_++;
+
+        if (profile_svc_) {
+            // Monotonic and fine grained. Most calls are well under a microsecond.
+            const auto start = std::chrono::steady_clock::now();
+            info->func_.func(kern_, kern_->crr_process(), kern_->get_cpu());
+
+            info->total_time_ns_ += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
+        } else {
+            info->func_.func(kern_, kern_->crr_process(), kern_->get_cpu());
+        }
 
         kern_->unlock();
         return true;
@@ -954,6 +1216,13 @@ namespace eka2l1::hle {
             break;
         }
 
+        config::state *conf = kern_->get_config();
+
+        if (conf && conf->enable_e32_cache) {
+            e32_cache_ = std::make_unique<loader::e32_payload_cache>(eka2l1::add_path(conf->storage, "cache/e32/"),
+                common::MB(conf->e32_cache_max_size_mb));
+        }
+
         if (kern_->is_eka1()) {
             search_paths.push_back(u"\\System\\Libs\\");
             search_paths.push_back(u"\\System\\Programs\\");
@@ -964,7 +1233,18 @@ namespace eka2l1::hle {
     }
     
     lib_manager::~lib_manager() {
-        svc_funcs_.clear();
+        for (auto &[dir, probed] : probed_dirs_) {
+            if (probed.watch_ != -1) {
+                io_->unwatch_directory(probed.watch_);
+            }
+        }
+
+        probed_dirs_.clear();
+        image_cache_.clear();
+
+        svc_fast_table_.clear();
+        svc_slow_table_.clear();
+        svc_sparse_table_.clear();
     }
 
     system *lib_manager::get_sys() {
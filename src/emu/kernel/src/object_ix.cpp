@@ -22,6 +22,7 @@
 #include <kernel/chunk.h>
 #include <kernel/object_ix.h>
 
+#include <common/algorithm.h>
 #include <common/chunkyseri.h>
 #include <common/log.h>
 
@@ -62,7 +63,8 @@ namespace eka2l1::kernel {
     std::uint32_t object_ix::make_handle(size_t index) {
         std::uint32_t handle = 0;
 
-        handle |= static_cast<std::uint32_t>(next_instance & 0xFFFF) << 16;
+        // Only 13 bits of instance are available, the rest belongs to the owner flags
+        handle |= static_cast<std::uint32_t>(next_instance & 0b0001111111111111) << 16;
         handle |= index;
 
         if (owner == handle_array_owner::thread) {
@@ -79,26 +81,46 @@ namespace eka2l1::kernel {
         return handle;
     }
 
-    std::uint32_t object_ix::add_object(kernel_obj_ptr obj) {
-        auto slot = std::find_if(objects.begin(), objects.end(), [](const object_ix_record &record) {
-            return record.free;
-        });
+    bool object_ix::grow() {
+        const std::size_t old_size = objects.size();
+
+        if (old_size >= OBJECT_IX_MAX_SLOTS) {
+            return false;
+        }
 
-        if (slot != objects.end()) {
-            next_instance++;
-            std::uint32_t ret_handle = make_handle(slot - objects.begin());
+        const std::size_t new_size = common::min(old_size + OBJECT_IX_GROW_CHUNK, OBJECT_IX_MAX_SLOTS);
+        objects.resize(new_size);
 
-            slot->associated_handle = ret_handle;
-            slot->free = false;
-            slot->object = obj;
+        // Push in reverse so lower indexes are given out first
+        for (std::size_t i = new_size; i > old_size; i--) {
+            free_slots.push_back(static_cast<std::uint32_t>(i - 1));
+        }
 
-            obj->increase_access_count();
+        return true;
+    }
 
-            totals++;
-            return ret_handle;
+    std::uint32_t object_ix::add_object(kernel_obj_ptr obj) {
+        if (free_slots.empty() && !grow()) {
+            LOG_ERROR("Handle table is full, can't add more object!");
+            return INVALID_HANDLE;
         }
 
-        return INVALID_HANDLE;
+        const std::uint32_t index = free_slots.back();
+        free_slots.pop_back();
+
+        object_ix_record &slot = objects[index];
+
+        next_instance++;
+        std::uint32_t ret_handle = make_handle(index);
+
+        slot.associated_handle = ret_handle;
+        slot.free = false;
+        slot.object = obj;
+
+        obj->increase_access_count();
+
+        totals++;
+        return ret_handle;
     }
 
     std::uint32_t object_ix::last_handle() {
@@ -177,6 +199,8 @@ namespace eka2l1::kernel {
             objects[info.object_ix_index].free = true;
             objects[info.object_ix_index].object = nullptr;
 
+            free_slots.push_back(static_cast<std::uint32_t>(info.object_ix_index));
+
             return ret_value;
         }
 
@@ -210,7 +234,9 @@ namespace eka2l1::kernel {
         , owner(owner)
         , next_instance(0)
         , uid(kern->next_uid())
-        , totals(0) {}
+        , totals(0) {
+        grow();
+    }
 
     void object_ix::do_state(common::chunkyseri &seri) {
         auto s = seri.section("ObjectIx", 1);
@@ -251,6 +277,14 @@ namespace eka2l1::kernel {
 
             seri.absorb(next_slot_use);
             seri.absorb(obj_id);
+
+            while ((seri.get_seri_mode() == common::SERI_MODE_READ) && (next_slot_use >= objects.size())) {
+                if (!grow()) {
+                    LOG_ERROR("Handle index {} in saved state is out of range", next_slot_use);
+                    return;
+                }
+            }
+
             seri.absorb(objects[next_slot_use].associated_handle);
 
             if (seri.get_seri_mode() == common::SERI_MODE_READ) {
@@ -260,6 +294,16 @@ namespace eka2l1::kernel {
             }
         }
 
+        if (seri.get_seri_mode() == common::SERI_MODE_READ) {
+            free_slots.clear();
+
+            for (std::size_t i = objects.size(); i > 0; i--) {
+                if (objects[i - 1].free) {
+                    free_slots.push_back(static_cast<std::uint32_t>(i - 1));
+                }
+            }
+        }
+
         // Hey, we need to save last thread handle too
         seri.absorb_container(handles);
     }
@@ -39,7 +39,8 @@ namespace eka2l1::kernel {
         , timing(timing)
         , run_core(cpu)
         , crr_thread(nullptr)
-        , crr_process(nullptr) {
+        , crr_process(nullptr)
+        , context_switches(0) {
         wakeup_evt = timing->get_register_event("SchedulerWakeUpThread");
 
         if (wakeup_evt == -1) {
@@ -59,6 +60,10 @@ namespace eka2l1::kernel {
     }
 
     void thread_scheduler::switch_context(kernel::thread *oldt, kernel::thread *newt) {
+        if (newt && (oldt != newt)) {
+            context_switches++;
+        }
+
         if (oldt) {
             oldt->lrt = timing->ticks();
             run_core->save_context(oldt->ctx);
@@ -76,17 +81,23 @@ namespace eka2l1::kernel {
             crr_thread->state = thread_state::run;
 
             if (crr_process != newt->owning_process()) {
-                if (crr_process) {
+                memory_system *mem = kern->get_memory_system();
+
+                // CPUs keeping a page table per address space only need to swap the active one
+                const bool should_remap = mem->get_mmu()->should_remap_cpu_on_switch();
+
+                if (crr_process && should_remap) {
                     crr_process->get_mem_model()->unmap_from_cpu();
                 }
 
                 kern->call_process_switch_callbacks(run_core, crr_process, newt->owning_process());
                 crr_process = newt->owning_process();
 
-                memory_system *mem = kern->get_memory_system();
                 mem->get_mmu()->set_current_addr_space(crr_process->get_mem_model()->address_space_id());
 
-                crr_process->get_mem_model()->remap_to_cpu();
+                if (should_remap) {
+                    crr_process->get_mem_model()->remap_to_cpu();
+                }
             }
 
             run_core->load_context(crr_thread->ctx);
@@ -558,17 +558,8 @@ namespace eka2l1::epoc {
     BRIDGE_FUNC(void, message_complete, std::int32_t msg_handle, std::int32_t val) {
         ipc_msg_ptr msg = kern->get_msg(msg_handle);
 
-        if (msg->request_sts) {
-            *(msg->request_sts.get(msg->own_thr->owning_process())) = val;
-            msg->own_thr->signal_request();
-        }
-
         LOG_TRACE("Message completed with code: {}, thread to signal: {}", val, msg->own_thr->name());
-
-        kern->call_ipc_complete_callbacks(msg.get(), val);
-
-        // Free the message
-        msg->free = true;
+        kern->complete_msg(msg, val);
     }
 
      BRIDGE_FUNC(void, message_complete_handle, std::int32_t msg_handle, std::int32_t handle) {
@@ -576,17 +567,8 @@ namespace eka2l1::epoc {
 
         ipc_msg_ptr msg = kern->get_msg(msg_handle);
 
-        if (msg->request_sts) {
-            *(msg->request_sts.get(msg->own_thr->owning_process())) = dup_handle;
-            msg->own_thr->signal_request();
-        }
-
         LOG_TRACE("Message completed with code: {}, thread to signal: {}", dup_handle, msg->own_thr->name());
-
-        kern->call_ipc_complete_callbacks(msg.get(), dup_handle);
-
-        // Free the message
-        msg->free = true;
+        kern->complete_msg(msg, dup_handle);
     }
 
     BRIDGE_FUNC(void, message_kill, kernel::handle h, kernel::entity_exit_type etype, std::int32_t reason, eka2l1::ptr<desc8> cage) {
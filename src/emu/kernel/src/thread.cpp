@@ -327,6 +327,12 @@ namespace eka2l1 {
             // Unlink from proces's thread list
             process_thread_link.deque();
             owning_process()->decrease_thread_count();
+
+            // The synchronous message is locked for the thread's whole life, give the slot back now
+            if (sync_msg) {
+                kern->destroy_msg(sync_msg);
+                sync_msg = nullptr;
+            }
         }
 
         tls_slot *thread::get_tls_slot(uint32_t handle, uint32_t dll_uid) {
@@ -20,71 +20,232 @@
 
 #include <common/algorithm.h>
 #include <common/chunkyseri.h>
+#include <common/hash.h>
 #include <common/log.h>
 
 #include <kernel/timing.h>
 
 #include <algorithm>
+#include <iterator>
 #include <mutex>
 #include <thread>
 #include <vector>
 
 namespace eka2l1 {
-    ntimer::ntimer(const std::uint32_t cpu_hz) {
+    std::size_t event_key_hash::operator()(const event_key &key) const {
+        std::size_t seed = 0;
+
+        common::hash_combine(seed, key.event_type);
+        common::hash_combine(seed, key.event_user_data);
+
+        return seed;
+    }
+
+    ntimer::ntimer(const std::uint32_t cpu_hz, const bool deterministic)
+        : event_order_counter_(0)
+        , deterministic_(deterministic)
+        , virtual_ticks_(0) {
         CPU_HZ_ = cpu_hz;
         should_stop_ = false;
         should_paused_ = false;
         teletimer_ = common::make_teletimer(cpu_hz);
 
-        timer_thread_ = std::make_unique<std::thread>([this]() {
-            loop();
-        });
+        // In deterministic mode, events are fired by the emulation thread when it adds ticks
+        if (!deterministic_) {
+            timer_thread_ = std::make_unique<std::thread>([this]() {
+                loop();
+            });
+        }
 
         teletimer_->start();
     }
 
     ntimer::~ntimer() {
-        should_stop_ = true;
-        should_paused_ = true;
+        {
+            const std::lock_guard<std::mutex> guard(new_event_avail_lock_);
+            should_stop_ = true;
+        }
+
         new_event_avail_var_.notify_one();
 
-        timer_thread_->join();
+        if (timer_thread_) {
+            timer_thread_->join();
+        }
     }
 
     void ntimer::loop() {
         while (!should_stop_) {
-            while (!should_paused_) {
-                const std::optional<std::uint64_t> next_microseconds = advance();
+            if (should_paused_) {
+                // Park until resumed or stopped. Flags are changed with the lock held, so no wake up is lost.
                 std::unique_lock<std::mutex> unqlock(new_event_avail_lock_);
+                new_event_avail_var_.wait(unqlock, [this]() {
+                    return should_stop_ || !should_paused_;
+                });
+
+                continue;
+            }
+
+            const std::optional<std::uint64_t> next_microseconds = advance();
+            std::unique_lock<std::mutex> unqlock(new_event_avail_lock_);
 
-                if (next_microseconds) {
-                    new_event_avail_var_.wait_for(unqlock, std::chrono::microseconds(next_microseconds.value()));
-                } else {
-                    new_event_avail_var_.wait(unqlock);
-                }
+            if (should_stop_ || should_paused_) {
+                continue;
+            }
+
+            if (next_microseconds) {
+                new_event_avail_var_.wait_for(unqlock, std::chrono::microseconds(next_microseconds.value()));
+            } else {
+                new_event_avail_var_.wait(unqlock);
             }
         }
     }
 
     const std::uint64_t ntimer::ticks() {
+        if (deterministic_) {
+            return virtual_ticks_.load();
+        }
+
         return teletimer_->ticks();
     }
 
     const std::uint64_t ntimer::microseconds() {
+        if (deterministic_) {
+            return virtual_ticks_.load() / (CPU_HZ_ / common::microsecs_per_sec);
+        }
+
         return teletimer_->microseconds();
     }
 
+    void ntimer::add_ticks(const std::uint64_t ticks) {
+        if (!deterministic_ || should_paused_) {
+            return;
+        }
+
+        virtual_ticks_ += ticks;
+        advance();
+    }
+
+    std::optional<std::uint64_t> ntimer::ticks_to_next_event() {
+        const std::lock_guard<std::mutex> guard(lock_);
+
+        if (event_heap_.empty()) {
+            return std::nullopt;
+        }
+
+        const std::uint64_t event_ticks = events_[event_heap_.front()].event_time * (CPU_HZ_ / common::microsecs_per_sec);
+        const std::uint64_t now = ticks();
+
+        return (event_ticks > now) ? (event_ticks - now) : 0;
+    }
+
+    void ntimer::idle() {
+        if (!deterministic_ || should_paused_) {
+            return;
+        }
+
+        const std::optional<std::uint64_t> ticks_left = ticks_to_next_event();
+
+        if (!ticks_left) {
+            // Nothing will happen in guest time. Only the host (input, audio...) can wake a thread now.
+            std::this_thread::yield();
+            return;
+        }
+
+        add_ticks(ticks_left.value());
+    }
+
+    bool ntimer::is_event_before(const std::uint32_t lhs, const std::uint32_t rhs) const {
+        const event &lhs_evt = events_[lhs];
+        const event &rhs_evt = events_[rhs];
+
+        if (lhs_evt.event_time != rhs_evt.event_time) {
+            return lhs_evt.event_time < rhs_evt.event_time;
+        }
+
+        return lhs_evt.event_order < rhs_evt.event_order;
+    }
+
+    void ntimer::swap_heap_entries(const std::size_t lhs, const std::size_t rhs) {
+        std::swap(event_heap_[lhs], event_heap_[rhs]);
+
+        events_[event_heap_[lhs]].heap_index = lhs;
+        events_[event_heap_[rhs]].heap_index = rhs;
+    }
+
+    void ntimer::heap_sift_up(std::size_t pos) {
+        while (pos > 0) {
+            const std::size_t parent = (pos - 1) >> 1;
+
+            if (!is_event_before(event_heap_[pos], event_heap_[parent])) {
+                break;
+            }
+
+            swap_heap_entries(pos, parent);
+            pos = parent;
+        }
+    }
+
+    void ntimer::heap_sift_down(std::size_t pos) {
+        while (true) {
+            const std::size_t left = (pos << 1) + 1;
+            const std::size_t right = left + 1;
+
+            std::size_t smallest = pos;
+
+            if ((left < event_heap_.size()) && is_event_before(event_heap_[left], event_heap_[smallest])) {
+                smallest = left;
+            }
+
+            if ((right < event_heap_.size()) && is_event_before(event_heap_[right], event_heap_[smallest])) {
+                smallest = right;
+            }
+
+            if (smallest == pos) {
+                break;
+            }
+
+            swap_heap_entries(pos, smallest);
+            pos = smallest;
+        }
+    }
+
+    void ntimer::remove_event_at(const std::size_t heap_pos) {
+        const std::uint32_t slot = event_heap_[heap_pos];
+        const event &evt = events_[slot];
+
+        // Drop the lookup entry pointing to this slot
+        auto lookup_range = event_lookup_.equal_range(event_key{ evt.event_type, evt.event_user_data });
+
+        for (auto ite = lookup_range.first; ite != lookup_range.second; ite++) {
+            if (ite->second == slot) {
+                event_lookup_.erase(ite);
+                break;
+            }
+        }
+
+        // Move the last entry to the hole, then restore the heap property
+        const std::size_t last_pos = event_heap_.size() - 1;
+
+        if (heap_pos != last_pos) {
+            swap_heap_entries(heap_pos, last_pos);
+        }
+
+        event_heap_.pop_back();
+        free_event_slots_.push_back(slot);
+
+        if (heap_pos < event_heap_.size()) {
+            heap_sift_down(heap_pos);
+            heap_sift_up(heap_pos);
+        }
+    }
+
     std::optional<std::uint64_t> ntimer::advance() {
         std::unique_lock<std::mutex> unq(lock_);
-        std::uint64_t global_timer = teletimer_->microseconds();
-
-        while (!events_.empty() && events_.back().event_time <= global_timer) {
-            event evt = std::move(events_.back());
-            events_.pop_back();
+        std::uint64_t global_timer = microseconds();
 
-            std::stable_sort(events_.begin(), events_.end(), [](const event &lhs, const event &rhs) {
-                return lhs.event_time > rhs.event_time;
-            });
+        while (!event_heap_.empty() && events_[event_heap_.front()].event_time <= global_timer) {
+            const event evt = events_[event_heap_.front()];
+            remove_event_at(0);
 
             unq.unlock();
             event_types_[evt.event_type]
@@ -92,8 +253,8 @@ namespace eka2l1 {
             unq.lock();
         }
 
-        if (!events_.empty()) {
-            return static_cast<std::uint64_t>(events_.back().event_time - global_timer);
+        if (!event_heap_.empty()) {
+            return static_cast<std::uint64_t>(events_[event_heap_.front()].event_time - global_timer);
         }
 
         return std::nullopt;
@@ -102,20 +263,31 @@ namespace eka2l1 {
     void ntimer::schedule_event(int64_t us_into_future, int event_type, std::uint64_t userdata) {
         const std::lock_guard<std::mutex> guard(lock_);
 
-        event evt;
+        std::uint32_t slot = 0;
 
-        evt.event_time = teletimer_->microseconds() + us_into_future;
+        if (!free_event_slots_.empty()) {
+            slot = free_event_slots_.back();
+            free_event_slots_.pop_back();
+        } else {
+            slot = static_cast<std::uint32_t>(events_.size());
+            events_.emplace_back();
+        }
+
+        event &evt = events_[slot];
+
+        evt.event_time = microseconds() + us_into_future;
         evt.event_type = event_type;
         evt.event_user_data = userdata;
+        evt.event_order = event_order_counter_++;
+        evt.heap_index = event_heap_.size();
 
-        bool should_nof = (events_.empty()) ||  (events_.back().event_time > evt.event_time);
-        events_.push_back(evt);
+        event_heap_.push_back(slot);
+        event_lookup_.emplace(event_key{ event_type, userdata }, slot);
 
-        std::stable_sort(events_.begin(), events_.end(), [](const event &lhs, const event &rhs) {
-            return lhs.event_time > rhs.event_time;
-        });
+        heap_sift_up(evt.heap_index);
 
-        if (should_nof) {
+        // Wake the timer thread only if the earliest deadline changed
+        if (event_heap_.front() == slot) {
             new_event_avail_var_.notify_one();
         }
     }
@@ -123,20 +295,23 @@ namespace eka2l1 {
     bool ntimer::unschedule_event(int event_type, uint64_t userdata) {
         const std::lock_guard<std::mutex> guard(lock_);
 
-        auto res = std::find_if(events_.begin(), events_.end(),
-            [&](auto evt) { return (evt.event_type == event_type) && (evt.event_user_data == userdata); });
+        auto lookup_range = event_lookup_.equal_range(event_key{ event_type, userdata });
 
-        if (res != events_.end()) {
-            events_.erase(res);
+        if (lookup_range.first == lookup_range.second) {
+            return false;
+        }
 
-            std::stable_sort(events_.begin(), events_.end(), [](const event &lhs, const event &rhs) {
-                return lhs.event_time > rhs.event_time;
-            });
+        // Lookup order is unspecified. Always cancel the one that would fire first.
+        std::uint32_t earliest_slot = lookup_range.first->second;
 
-            return true;
+        for (auto ite = std::next(lookup_range.first); ite != lookup_range.second; ite++) {
+            if (is_event_before(ite->second, earliest_slot)) {
+                earliest_slot = ite->second;
+            }
         }
 
-        return false;
+        remove_event_at(events_[earliest_slot].heap_index);
+        return true;
     }
 
     bool ntimer::set_clock_frequency_mhz(const std::uint32_t cpu_mhz) {
@@ -201,6 +376,27 @@ namespace eka2l1 {
     }
 
     void ntimer::set_paused(const bool should_pause) {
-        should_paused_ = should_pause;
+        {
+            const std::lock_guard<std::mutex> guard(new_event_avail_lock_);
+
+            if (should_paused_ == should_pause) {
+                return;
+            }
+
+            should_paused_ = should_pause;
+        }
+
+        {
+            // Freeze guest time, so it does not jump forward after resume
+            const std::lock_guard<std::mutex> guard(lock_);
+
+            if (should_pause) {
+                teletimer_->pause();
+            } else {
+                teletimer_->resume();
+            }
+        }
+
+        new_event_avail_var_.notify_one();
     }
 }
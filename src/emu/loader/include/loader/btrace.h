@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project
+ * (see bentokun.github.com/EKA2L1).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace eka2l1::common {
+    class ro_stream;
+}
+
+namespace eka2l1::loader::btrace {
+    static constexpr std::uint32_t CAPTURE_MAGIC = 0x43525442; // BTRC
+    static constexpr std::uint32_t CAPTURE_VERSION = 1;
+
+    enum header_structure {
+        header_size_index = 0,
+        header_flag_index = 1,
+        header_category_index = 2,
+        header_subcategory_index = 3
+    };
+
+    struct capture_header {
+        std::uint32_t magic_;
+        std::uint32_t version_;
+        std::uint32_t record_size_;
+        std::uint32_t reserved_;
+    };
+
+    /**
+     * \brief A trace call, as captured by the kernel.
+     *
+     * Arguments are stored untouched. The first one is the BTrace header, which contains
+     * the category of the record.
+     */
+    struct record {
+        std::uint64_t timestamp_; ///< Guest time in microseconds.
+        std::uint32_t thread_id_; ///< Unique ID of the thread that made the call.
+        std::uint32_t args_[4];
+        std::uint32_t reserved_;
+    };
+
+    static_assert(sizeof(record) == 32, "BTrace record must stay 32 bytes");
+
+    inline std::uint8_t get_header_field(const std::uint32_t a0, const header_structure field) {
+        return static_cast<std::uint8_t>((a0 >> (field * 8)) & 0xFF);
+    }
+
+    /**
+     * \brief Read all records of a BTrace capture file.
+     *
+     * \param stream    Stream of the capture file.
+     * \param records   Vector to append records to.
+     *
+     * \returns False if the file is not a capture, or was made by another version.
+     */
+    bool read_capture(common::ro_stream *stream, std::vector<record> &records);
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project
+ * (see bentokun.github.com/EKA2L1).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace eka2l1::loader {
+    /**
+     * \brief Persistent cache of decompressed E32 image payloads.
+     *
+     * Each payload is stored in its own file in the cache folder, named after the key, which
+     * is the hash of the compressed image. Payloads are memory-mapped on first read, and the view
+     * is kept until the payload is evicted or the cache is destroyed. A payload which file was
+     * modified outside of the cache is dropped.
+     *
+     * When the total size of all payloads exceeds the limit, the least recently used ones
+     * are removed. Usage order is kept between runs in an index file.
+     */
+    class e32_payload_cache {
+        struct payload_info {
+            std::uint64_t size_ = 0;
+            std::uint64_t last_use_ = 0;
+            std::uint64_t last_write_ = 0;
+
+            void *view_ = nullptr;
+        };
+
+        using payload_map = std::unordered_map<std::uint64_t, payload_info>;
+
+        std::string folder_;
+        std::uint64_t max_size_;
+        std::uint64_t total_size_;
+        std::uint64_t use_counter_;
+
+        payload_map payloads_;
+        std::mutex lock_;
+
+        std::string get_payload_path(const std::uint64_t key) const;
+        std::uint64_t get_payload_last_write(const std::uint64_t key) const;
+
+        /**
+         * \brief Unmap the payload's view, delete its file and forget about it.
+         */
+        payload_map::iterator drop(payload_map::iterator ite);
+
+        void load_index();
+        void save_index();
+
+        /**
+         * \brief Remove least recently used payloads until the given amount of bytes can be added.
+         */
+        void evict(const std::uint64_t incoming_size);
+
+    public:
+        explicit e32_payload_cache(const std::string &folder, const std::uint64_t max_size);
+        ~e32_payload_cache();
+
+        /**
+         * \brief Copy a cached payload to the destination.
+         *
+         * \param key       The hash of the compressed image.
+         * \param dest      Destination buffer.
+         * \param size      The expected size of the payload.
+         *
+         * \returns False if the payload is not cached, its size differs, or its file was modified.
+         */
+        bool read(const std::uint64_t key, void *dest, const std::size_t size);
+
+        /**
+         * \brief Add a payload to the cache.
+         *
+         * \param key       The hash of the compressed image.
+         * \param source    Pointer to the decompressed payload.
+         * \param size      Size of the payload.
+         *
+         * \returns True on success.
+         */
+        bool write(const std::uint64_t key, const void *source, const std::size_t size);
+
+        std::uint64_t total_size() const {
+            return total_size_;
+        }
+    };
+}
@@ -194,15 +194,19 @@ namespace eka2l1 {
             std::vector<std::string> dll_names;
         };
 
+        class e32_payload_cache;
+
         /**
          * @brief Parse an E32 Image from stream.
          * 
          * @param stream     The stream to parse from.
          * @param read_reloc If this is true, relocation section will be parsed.
+         * @param cache      Optional cache of decompressed payloads. If the image is compressed, the payload
+         *                   is taken from here when available, else it's added after decompression.
          * 
          * @returns An optional contains E32 Image. Nullopt if invalid.
          */
-        std::optional<e32img> parse_e32img(common::ro_stream *stream, bool read_reloc = true);
+        std::optional<e32img> parse_e32img(common::ro_stream *stream, bool read_reloc = true, e32_payload_cache *cache = nullptr);
 
         /**
          * @brief Check if the stream content is E32 Image.
@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project
+ * (see bentokun.github.com/EKA2L1).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <common/buffer.h>
+#include <loader/btrace.h>
+
+namespace eka2l1::loader::btrace {
+    bool read_capture(common::ro_stream *stream, std::vector<record> &records) {
+        capture_header header;
+
+        if (stream->read(&header, sizeof(capture_header)) != sizeof(capture_header)) {
+            return false;
+        }
+
+        if ((header.magic_ != CAPTURE_MAGIC) || (header.version_ != CAPTURE_VERSION) || (header.record_size_ != sizeof(record))) {
+            return false;
+        }
+
+        record rec;
+
+        // A session that was not closed properly may leave a partial record at the end, ignore it.
+        while (stream->read(&rec, sizeof(record)) == sizeof(record)) {
+            records.push_back(rec);
+        }
+
+        return true;
+    }
+}
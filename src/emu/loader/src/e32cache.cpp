@@ -0,0 +1,277 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project
+ * (see bentokun.github.com/EKA2L1).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <loader/e32cache.h>
+
+#include <common/cvt.h>
+#include <common/fileutils.h>
+#include <common/log.h>
+#include <common/path.h>
+#include <common/virtualmem.h>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace eka2l1::loader {
+    static constexpr std::uint32_t PAYLOAD_MAGIC = 0x43323345; // E32C
+    static constexpr std::uint32_t INDEX_MAGIC = 0x49323345; // E32I
+    static constexpr std::uint32_t CACHE_VERSION = 2;
+    static constexpr const char *INDEX_FILE_NAME = "index.bin";
+
+    struct payload_header {
+        std::uint32_t magic_;
+        std::uint32_t version_;
+        std::uint64_t size_;
+    };
+
+    struct index_entry {
+        std::uint64_t key_;
+        std::uint64_t last_use_;
+        std::uint64_t last_write_;
+    };
+
+    e32_payload_cache::e32_payload_cache(const std::string &folder, const std::uint64_t max_size)
+        : folder_(folder)
+        , max_size_(max_size)
+        , total_size_(0)
+        , use_counter_(0) {
+        eka2l1::create_directories(folder_);
+        load_index();
+    }
+
+    e32_payload_cache::~e32_payload_cache() {
+        save_index();
+
+        for (auto &[key, info] : payloads_) {
+            if (info.view_) {
+                common::unmap_file(info.view_, static_cast<std::size_t>(info.size_));
+            }
+        }
+    }
+
+    std::string e32_payload_cache::get_payload_path(const std::uint64_t key) const {
+        return eka2l1::add_path(folder_, fmt::format("{:016X}.bin", key));
+    }
+
+    std::uint64_t e32_payload_cache::get_payload_last_write(const std::uint64_t key) const {
+        return common::get_last_modifiy_since_ad(common::utf8_to_ucs2(get_payload_path(key)));
+    }
+
+    e32_payload_cache::payload_map::iterator e32_payload_cache::drop(payload_map::iterator ite) {
+        // A file can't be deleted while it's still mapped on Windows
+        if (ite->second.view_) {
+            common::unmap_file(ite->second.view_, static_cast<std::size_t>(ite->second.size_));
+        }
+
+        common::remove(get_payload_path(ite->first));
+
+        total_size_ -= ite->second.size_;
+        return payloads_.erase(ite);
+    }
+
+    void e32_payload_cache::load_index() {
+        // Payloads on disk are the truth. The index only tells how recently each one was used.
+        common::dir_iterator ite(folder_);
+
+        if (!ite.is_valid()) {
+            return;
+        }
+
+        ite.detail = true;
+        common::dir_entry entry;
+
+        while (ite.next_entry(entry) == 0) {
+            if ((entry.type != common::FILE_REGULAR) || (entry.name.length() != 20) || (entry.name.substr(16) != ".bin")) {
+                continue;
+            }
+
+            const std::uint64_t key = std::strtoull(entry.name.substr(0, 16).c_str(), nullptr, 16);
+            payload_info &info = payloads_[key];
+
+            info.size_ = entry.size;
+            info.last_write_ = get_payload_last_write(key);
+            total_size_ += entry.size;
+        }
+
+        std::ifstream index_file(eka2l1::add_path(folder_, INDEX_FILE_NAME), std::ios::binary);
+
+        if (!index_file) {
+            return;
+        }
+
+        std::uint32_t magic = 0;
+        std::uint32_t version = 0;
+        std::uint32_t count = 0;
+
+        index_file.read(reinterpret_cast<char *>(&magic), sizeof(magic));
+        index_file.read(reinterpret_cast<char *>(&version), sizeof(version));
+        index_file.read(reinterpret_cast<char *>(&count), sizeof(count));
+
+        if (!index_file || (magic != INDEX_MAGIC) || (version != CACHE_VERSION)) {
+            return;
+        }
+
+        for (std::uint32_t i = 0; i < count; i++) {
+            index_entry ientry;
+            index_file.read(reinterpret_cast<char *>(&ientry), sizeof(index_entry));
+
+            if (!index_file) {
+                break;
+            }
+
+            auto payload_ite = payloads_.find(ientry.key_);
+
+            if (payload_ite != payloads_.end()) {
+                payload_ite->second.last_use_ = ientry.last_use_;
+                payload_ite->second.last_write_ = ientry.last_write_;
+                use_counter_ = std::max(use_counter_, ientry.last_use_);
+            }
+        }
+    }
+
+    void e32_payload_cache::save_index() {
+        const std::lock_guard<std::mutex> guard(lock_);
+        std::ofstream index_file(eka2l1::add_path(folder_, INDEX_FILE_NAME), std::ios::binary);
+
+        if (!index_file) {
+            LOG_WARN("Unable to save E32 payload cache index");
+            return;
+        }
+
+        const std::uint32_t count = static_cast<std::uint32_t>(payloads_.size());
+
+        index_file.write(reinterpret_cast<const char *>(&INDEX_MAGIC), sizeof(INDEX_MAGIC));
+        index_file.write(reinterpret_cast<const char *>(&CACHE_VERSION), sizeof(CACHE_VERSION));
+        index_file.write(reinterpret_cast<const char *>(&count), sizeof(count));
+
+        for (const auto &[key, info] : payloads_) {
+            const index_entry ientry{ key, info.last_use_, info.last_write_ };
+            index_file.write(reinterpret_cast<const char *>(&ientry), sizeof(index_entry));
+        }
+    }
+
+    void e32_payload_cache::evict(const std::uint64_t incoming_size) {
+        if (total_size_ + incoming_size <= max_size_) {
+            return;
+        }
+
+        std::vector<std::pair<std::uint64_t, std::uint64_t>> by_use;
+        by_use.reserve(payloads_.size());
+
+        for (const auto &[key, info] : payloads_) {
+            by_use.emplace_back(info.last_use_, key);
+        }
+
+        std::sort(by_use.begin(), by_use.end());
+
+        for (const auto &[last_use, key] : by_use) {
+            if (total_size_ + incoming_size <= max_size_) {
+                break;
+            }
+
+            drop(payloads_.find(key));
+        }
+    }
+
+    bool e32_payload_cache::read(const std::uint64_t key, void *dest, const std::size_t size) {
+        const std::lock_guard<std::mutex> guard(lock_);
+        auto ite = payloads_.find(key);
+
+        if ((ite == payloads_.end()) || (ite->second.size_ != size + sizeof(payload_header))) {
+            return false;
+        }
+
+        payload_info &info = ite->second;
+
+        if (get_payload_last_write(key) != info.last_write_) {
+            // Replaced or touched by someone else, the view may not match the file anymore
+            drop(ite);
+            return false;
+        }
+
+        if (!info.view_) {
+            info.view_ = common::map_file(get_payload_path(key), prot::read, static_cast<std::size_t>(info.size_));
+
+            if (!info.view_) {
+                return false;
+            }
+        }
+
+        const std::uint8_t *mapped = reinterpret_cast<const std::uint8_t *>(info.view_);
+
+        payload_header header;
+        std::memcpy(&header, mapped, sizeof(payload_header));
+
+        if ((header.magic_ != PAYLOAD_MAGIC) || (header.version_ != CACHE_VERSION) || (header.size_ != size)) {
+            drop(ite);
+            return false;
+        }
+
+        std::memcpy(dest, mapped + sizeof(payload_header), size);
+        info.last_use_ = ++use_counter_;
+
+        return true;
+    }
+
+    bool e32_payload_cache::write(const std::uint64_t key, const void *source, const std::size_t size) {
+        const std::uint64_t file_size = size + sizeof(payload_header);
+
+        if (file_size > max_size_) {
+            return false;
+        }
+
+        const std::lock_guard<std::mutex> guard(lock_);
+
+        if (payloads_.find(key) != payloads_.end()) {
+            return true;
+        }
+
+        evict(file_size);
+
+        std::ofstream payload_file(get_payload_path(key), std::ios::binary);
+
+        if (!payload_file) {
+            return false;
+        }
+
+        const payload_header header{ PAYLOAD_MAGIC, CACHE_VERSION, size };
+
+        payload_file.write(reinterpret_cast<const char *>(&header), sizeof(payload_header));
+        payload_file.write(reinterpret_cast<const char *>(source), size);
+        payload_file.close();
+
+        if (!payload_file) {
+            common::remove(get_payload_path(key));
+            return false;
+        }
+
+        payload_info &info = payloads_[key];
+        info.size_ = file_size;
+        info.last_use_ = ++use_counter_;
+        info.last_write_ = get_payload_last_write(key);
+
+        total_size_ += file_size;
+        return true;
+    }
+}
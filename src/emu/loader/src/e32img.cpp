@@ -20,6 +20,7 @@
 #include <common/buffer.h>
 #include <common/cvt.h>
 
+#include <loader/e32cache.h>
 #include <loader/e32img.h>
 
 #include <common/algorithm.h>
@@ -33,6 +34,9 @@
 #include <miniz.h>
 #include <sstream>
 
+#define XXH_INLINE_ALL
+#include <xxhash.h>
+
 namespace eka2l1::loader {
     struct e32img_import_sec_header {
         uint32_t size;
@@ -171,7 +175,7 @@ namespace eka2l1::loader {
         return result;
     }
 
-    std::optional<e32img> parse_e32img(common::ro_stream *stream, bool read_reloc) {
+    std::optional<e32img> parse_e32img(common::ro_stream *stream, bool read_reloc, e32_payload_cache *cache) {
         if (!stream) {
             return std::nullopt;
         }
@@ -308,7 +312,20 @@ namespace eka2l1::loader {
                 LOG_ERROR("File reading improperly");
             }
 
-            if (ctype == compress_type::deflate_c) {
+            std::uint64_t cache_key = 0;
+            bool payload_cached = false;
+
+            if (cache) {
+                // Hashing is much faster than decompressing, so look up the cache with the whole file content
+                cache_key = XXH64(img.data.data(), img.header.code_offset, 0);
+                cache_key = XXH64(temp_buf.data(), temp_buf.size(), cache_key);
+
+                payload_cached = cache->read(cache_key, &img.data[img.header.code_offset], img.uncompressed_size);
+            }
+
+            if (payload_cached) {
+                // Nothing to decompress
+            } else if (ctype == compress_type::deflate_c) {
                 flate::bit_input input(reinterpret_cast<uint8_t *>(temp_buf.data()),
                     static_cast<int>(temp_buf.size() * 8));
 
@@ -330,6 +347,10 @@ namespace eka2l1::loader {
                 auto codesize = bpstream.read_pages(&img.data[img.header.code_offset], img.header.code_size);
                 auto restsize = bpstream.read_pages(&img.data[img.header.code_offset + img.header.code_size], img.uncompressed_size);
             }
+
+            if (cache && !payload_cached) {
+                cache->write(cache_key, &img.data[img.header.code_offset], img.uncompressed_size);
+            }
         } else {
             img.uncompressed_size = static_cast<uint32_t>(file_size);
 
@@ -34,6 +34,9 @@ namespace eka2l1::mem {
     constexpr std::size_t PAGE_SIZE_BYTES_12B = 0x1000;
     constexpr std::size_t PAGE_SIZE_BYTES_20B = 0x100000;
 
+    constexpr asid ASID_CURRENT = -1; ///< Map to the CPU page table of the current address space.
+    constexpr asid ASID_GLOBAL = -2; ///< Map to the CPU page tables of all address spaces.
+
     enum {
         MMU_ASSIGN_LOCAL_GLOBAL_REGION = 1 << 0,
         MMU_ASSIGN_GLOBAL = 1 << 1
@@ -78,8 +81,31 @@ namespace eka2l1::mem {
 
         virtual const mem_model_type model_type() const = 0;
 
-        void map_to_cpu(const vm_address addr, const std::size_t size, void *ptr, const prot perm);
-        void unmap_from_cpu(const vm_address addr, const std::size_t size);
+        void map_to_cpu(const vm_address addr, const std::size_t size, void *ptr, const prot perm, const asid id = ASID_CURRENT);
+        void unmap_from_cpu(const vm_address addr, const std::size_t size, const asid id = ASID_CURRENT);
+
+        /**
+         * \brief Check if memory of an address space can be mapped to the CPU right now.
+         * 
+         * If the CPU keeps a page table per address space, this is always true. Else only
+         * global memory and memory of the current address space can be mapped. The rest is
+         * mapped on process switch.
+         */
+        bool can_map_to_cpu(const asid id) const;
+
+        /**
+         * \brief Check if the CPU needs to be remapped when the current address space changes.
+         */
+        bool should_remap_cpu_on_switch() const;
+
+        /**
+         * \brief Choose between the CPU's fast memory path and the MMU's slow path.
+         * 
+         * The slow path walks the page directory on every access and can log it. It's only forced
+         * when memory read or write logging is enabled in the config. Call this again after
+         * the logging options change at runtime.
+         */
+        void sync_memory_access_path();
 
         /**
          * \brief Get number of bytes a page occupy
@@ -122,6 +148,13 @@ namespace eka2l1::mem {
          */
         virtual asid rollover_fresh_addr_space() = 0;
 
+        /**
+         * \brief Give an address space back, so its ID can be reused.
+         * 
+         * \param id The ASID of the address space to free.
+         */
+        virtual void free_addr_space(const asid id) = 0;
+
         /**
          * \brief Set current MMU's address space.
          * 
@@ -49,6 +49,7 @@ namespace eka2l1::mem::flexible {
         const asid current_addr_space() const override;
 
         asid rollover_fresh_addr_space() override;
+        void free_addr_space(const asid id) override;
         bool set_current_addr_space(const asid id) override;
 
         void assign_page_table(page_table *tab, const vm_address linear_addr, const std::uint32_t flags,
@@ -52,6 +52,7 @@ namespace eka2l1::mem {
         const asid current_addr_space() const override;
 
         asid rollover_fresh_addr_space() override;
+        void free_addr_space(const asid id) override;
         bool set_current_addr_space(const asid id) override;
 
         page_table *get_page_table_by_addr(const vm_address addr);
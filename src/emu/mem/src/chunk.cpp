@@ -19,6 +19,7 @@
 
 #include <mem/chunk.h>
 #include <mem/mmu.h>
+#include <mem/process.h>
 #include <mem/model/flexible/chunk.h>
 #include <mem/model/multiple/chunk.h>
 
@@ -82,12 +83,14 @@ namespace eka2l1::mem {
             return;
         }
 
+        const asid cpu_asid = process ? process->address_space_id() : ASID_CURRENT;
+
         auto do_the_map = [&](const std::uint32_t start_index, const std::uint32_t page_count) {
             if (map) {
                 mmu_->map_to_cpu(base_addr + (start_index << mmu_->page_size_bits_), page_count << mmu_->page_size_bits_,
-                    reinterpret_cast<std::uint8_t *>(host_base()) + (start_index << mmu_->page_size_bits_), permission_);
+                    reinterpret_cast<std::uint8_t *>(host_base()) + (start_index << mmu_->page_size_bits_), permission_, cpu_asid);
             } else {
-                mmu_->unmap_from_cpu(base_addr + (start_index << mmu_->page_size_bits_), page_count << mmu_->page_size_bits_);
+                mmu_->unmap_from_cpu(base_addr + (start_index << mmu_->page_size_bits_), page_count << mmu_->page_size_bits_, cpu_asid);
             }
         };
 
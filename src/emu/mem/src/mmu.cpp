@@ -62,18 +62,33 @@ namespace eka2l1::mem {
         cpu->write_16bit = [this](const vm_address addr, std::uint16_t* data) { return write_16bit_data(addr, data); };
         cpu->write_32bit = [this](const vm_address addr, std::uint32_t* data) { return write_32bit_data(addr, data); };
         cpu->write_64bit = [this](const vm_address addr, std::uint64_t* data) { return write_64bit_data(addr, data); };
+
+        sync_memory_access_path();
+    }
+
+    void mmu_base::sync_memory_access_path() {
+        cpu_->slow_memory_path = conf_->log_read || conf_->log_write;
     }
 
     page_table *mmu_base::create_new_page_table() {
         return alloc_->create_new(page_size_bits_);
     }
 
-    void mmu_base::map_to_cpu(const vm_address addr, const std::size_t size, void *ptr, const prot perm) {
-        cpu_->map_backing_mem(addr, size, reinterpret_cast<std::uint8_t *>(ptr), perm);
+    void mmu_base::map_to_cpu(const vm_address addr, const std::size_t size, void *ptr, const prot perm, const asid id) {
+        cpu_->map_backing_mem(addr, size, reinterpret_cast<std::uint8_t *>(ptr), perm, id);
+    }
+
+    void mmu_base::unmap_from_cpu(const vm_address addr, const std::size_t size, const asid id) {
+        cpu_->unmap_memory(addr, size, id);
+    }
+
+    bool mmu_base::can_map_to_cpu(const asid id) const {
+        return (id == ASID_GLOBAL) || (id == ASID_CURRENT) || (id == current_addr_space())
+            || cpu_->keep_page_table_per_addr_space();
     }
 
-    void mmu_base::unmap_from_cpu(const vm_address addr, const std::size_t size) {
-        cpu_->unmap_memory(addr, size);
+    bool mmu_base::should_remap_cpu_on_switch() const {
+        return !cpu_->keep_page_table_per_addr_space();
     }
 
     mmu_impl make_new_mmu(page_table_allocator *alloc, arm::core *cpu, config::state *conf, const std::size_t psize_bits, const bool mem_map_old,
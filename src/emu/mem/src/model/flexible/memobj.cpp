@@ -20,7 +20,7 @@
 #include <mem/model/flexible/addrspace.h>
 #include <mem/model/flexible/memobj.h>
 #include <mem/model/flexible/mapping.h>
-#include <mem/mmu.h>
+#include <mem/model/flexible/mmu.h>
 
 #include <common/algorithm.h>
 #include <common/log.h>
@@ -51,6 +51,15 @@ namespace eka2l1::mem::flexible {
         }
     }
 
+    static asid get_mapping_cpu_asid(mmu_base *mmu, mapping *target) {
+        // Kernel mappings are visible in every address space
+        if (target->owner_ == reinterpret_cast<mmu_flexible *>(mmu)->kern_addr_space_.get()) {
+            return ASID_GLOBAL;
+        }
+
+        return target->owner_->id();
+    }
+
     bool memory_object::commit(const std::uint32_t page_offset, const std::size_t total_pages, const prot perm) {
         if (page_offset + total_pages > page_occupied_) {
             return false;
@@ -78,10 +87,12 @@ namespace eka2l1::mem::flexible {
                 LOG_WARN("Unable to map committed memory to a mapping!");
             }
 
-            if (mapping->owner_->id() == mmu_->current_addr_space()) {
+            const asid cpu_asid = get_mapping_cpu_asid(mmu_, mapping);
+
+            if (mmu_->can_map_to_cpu(cpu_asid)) {
                 // Map it to CPU right away
                 mmu_->map_to_cpu(mapping->base_ + start_offset, size_to_commit, reinterpret_cast<std::uint8_t*>(data_) +
-                    start_offset, perm);
+                    start_offset, perm, cpu_asid);
             }
         }
 
@@ -111,9 +122,11 @@ namespace eka2l1::mem::flexible {
                 LOG_WARN("Unable to unmap decommitted memory from a mapping!");
             }
             
-            if (mapping->owner_->id() == mmu_->current_addr_space()) {
+            const asid cpu_asid = get_mapping_cpu_asid(mmu_, mapping);
+
+            if (mmu_->can_map_to_cpu(cpu_asid)) {
                 // Unmap from to CPU right away
-                mmu_->unmap_from_cpu(mapping->base_ + start_offset, size_to_decommit);
+                mmu_->unmap_from_cpu(mapping->base_ + start_offset, size_to_decommit, cpu_asid);
             }
         }
 
@@ -19,6 +19,7 @@
 
 #include <mem/model/flexible/mmu.h>
 #include <common/log.h>
+#include <cpu/arm_interface.h>
 
 namespace eka2l1::mem::flexible {
     static constexpr std::uint32_t MAX_PAGE_DIR_ALLOW = 512;
@@ -77,6 +78,12 @@ namespace eka2l1::mem::flexible {
         return new_dir->id();
     }
     
+    void mmu_flexible::free_addr_space(const asid id) {
+        if (dir_mngr_->free(id)) {
+            cpu_->free_addr_space(id);
+        }
+    }
+
     bool mmu_flexible::set_current_addr_space(const asid id) {
         // Try to get the page directory associated with this ID
         // Cố tìm page directory găn với cái ID này
@@ -87,6 +94,8 @@ namespace eka2l1::mem::flexible {
         }
 
         cur_dir_ = associated_dir;
+        cpu_->set_current_addr_space(id);
+
         return true;
     }
 
@@ -23,6 +23,11 @@
 #include <common/log.h>
 
 namespace eka2l1::mem::flexible {
+    static bool should_do_cpu_manipulate(const std::uint32_t flags) {
+        return (flags & MEM_MODEL_CHUNK_REGION_USER_LOCAL) || (flags & MEM_MODEL_CHUNK_REGION_USER_GLOBAL)
+            || (flags & MEM_MODEL_CHUNK_REGION_DLL_STATIC_DATA) || (flags & MEM_MODEL_CHUNK_REGION_USER_CODE);
+    }
+
     const asid flexible_mem_model_process::address_space_id() const {
         return addr_space_->id();
     }
@@ -32,6 +37,12 @@ namespace eka2l1::mem::flexible {
         addr_space_ = std::make_unique<address_space>(reinterpret_cast<mmu_flexible*>(mmu));
     }
 
+    flexible_mem_model_process::~flexible_mem_model_process() {
+        if (addr_space_->dir_) {
+            mmu_->free_addr_space(addr_space_->id());
+        }
+    }
+
     int flexible_mem_model_process::create_chunk(mem_model_chunk *&chunk, const mem_model_chunk_creation_info &create_info) {
         mmu_flexible *fl_mmu = reinterpret_cast<mmu_flexible*>(mmu_);
 
@@ -111,6 +122,11 @@ namespace eka2l1::mem::flexible {
         // Ok nice nice nice. Add this to list of attachment
         attachs_.push_back(std::move(attach_info));
 
+        if (!mmu_->should_remap_cpu_on_switch() && should_do_cpu_manipulate(fl_chunk->flags_)) {
+            // The CPU won't remap on switch, so put what is already committed in our page table now
+            fl_chunk->map_to_cpu(this);
+        }
+
         return true;
     }
 
@@ -127,17 +143,17 @@ namespace eka2l1::mem::flexible {
 
         // Remove the mapping attached to this memory object
         flexible_mem_model_chunk *fl_chunk = reinterpret_cast<flexible_mem_model_chunk*>(chunk);
+
+        if (!mmu_->should_remap_cpu_on_switch() && should_do_cpu_manipulate(fl_chunk->flags_)) {
+            fl_chunk->unmap_from_cpu(this);
+        }
+
         fl_chunk->mem_obj_->detach_mapping(chunk_ite->map_.get());
 
         attachs_.erase(chunk_ite);
         return true;
     }
 
-    static bool should_do_cpu_manipulate(const std::uint32_t flags) {
-        return (flags & MEM_MODEL_CHUNK_REGION_USER_LOCAL) || (flags & MEM_MODEL_CHUNK_REGION_USER_GLOBAL)
-            || (flags & MEM_MODEL_CHUNK_REGION_DLL_STATIC_DATA) || (flags & MEM_MODEL_CHUNK_REGION_USER_CODE);
-    }
-
     void flexible_mem_model_process::unmap_from_cpu() {
         for (auto &attached: attachs_) {
             if (should_do_cpu_manipulate(attached.chunk_->flags_)) {
@@ -71,6 +71,10 @@ namespace eka2l1::mem {
             const vm_address crr_base_addr = base_;
             multiple_mem_model_process *mul_process = reinterpret_cast<multiple_mem_model_process*>(own_process_);
 
+            // Only local and code chunks are private to the owner. The rest is visible in every address space
+            const asid cpu_asid = (own_process_ && (is_local || is_code)) ? mul_process->addr_space_id_ : ASID_GLOBAL;
+            const bool should_map_cpu = mmu_->can_map_to_cpu(cpu_asid);
+
             // Fill the entry
             for (int poff = ps_off; poff < ps_off + page_num; poff++) {
                 // If the entry has not yet been committed.
@@ -88,8 +92,8 @@ namespace eka2l1::mem {
                     }
                 } else {
                     // Map those just mapped to the CPU. It will love this
-                    if (size_just_mapped != 0 && (!own_process_ || mul_process->addr_space_id_ == mmu_->current_addr_space())) {
-                        mmu_->map_to_cpu(off_start_just_mapped, size_just_mapped, host_start_just_mapped, permission_);
+                    if (size_just_mapped != 0 && should_map_cpu) {
+                        mmu_->map_to_cpu(off_start_just_mapped, size_just_mapped, host_start_just_mapped, permission_, cpu_asid);
                         
                         if (!is_external_host) {    
                             // Clear the committed memory
@@ -104,9 +108,9 @@ namespace eka2l1::mem {
             }
 
             // Map the rest
-            if (size_just_mapped != 0 && (!own_process_ || mul_process->addr_space_id_ == mmu_->current_addr_space())) {
+            if (size_just_mapped != 0 && should_map_cpu) {
                 //LOG_TRACE("Mapped to CPU: 0x{:X}, size 0x{:X}", off_start_just_mapped, size_just_mapped);
-                mmu_->map_to_cpu(off_start_just_mapped, size_just_mapped, host_start_just_mapped, permission_);
+                mmu_->map_to_cpu(off_start_just_mapped, size_just_mapped, host_start_just_mapped, permission_, cpu_asid);
 
                 if (!is_external_host) {    
                     // Clear the committed memory
@@ -169,6 +173,9 @@ namespace eka2l1::mem {
 
             multiple_mem_model_process *mul_process = reinterpret_cast<multiple_mem_model_process*>(own_process_);
 
+            const asid cpu_asid = (own_process_ && (is_local || is_code)) ? mul_process->addr_space_id_ : ASID_GLOBAL;
+            const bool should_unmap_cpu = mmu_->can_map_to_cpu(cpu_asid);
+
             // Fill the entry
             for (int poff = ps_off; poff < ps_off + page_num; poff++) {
                 // If the entry has not yet been committed.
@@ -184,8 +191,8 @@ namespace eka2l1::mem {
                     }
                 } else {
                     // Map those just mapped to the CPU. It will love this
-                    if (size_just_unmapped != 0 && (!own_process_ || mul_process->addr_space_id_ == mmu_->current_addr_space())) {
-                        mmu_->unmap_from_cpu(off_start_just_unmapped, size_just_unmapped);
+                    if (size_just_unmapped != 0 && should_unmap_cpu) {
+                        mmu_->unmap_from_cpu(off_start_just_unmapped, size_just_unmapped, cpu_asid);
 
                         size_just_unmapped = 0;
                         off_start_just_unmapped = 0;
@@ -194,9 +201,9 @@ namespace eka2l1::mem {
             }
 
             // Unmap the rest
-            if (size_just_unmapped != 0 && (!own_process_ || mul_process->addr_space_id_ == mmu_->current_addr_space())) {
+            if (size_just_unmapped != 0 && should_unmap_cpu) {
                 //LOG_TRACE("Unmapped from CPU: 0x{:X}, size 0x{:X}", off_start_just_unmapped, size_just_unmapped);
-                mmu_->unmap_from_cpu(off_start_just_unmapped, size_just_unmapped);
+                mmu_->unmap_from_cpu(off_start_just_unmapped, size_just_unmapped, cpu_asid);
             }
 
             // Decommit the memory from the host
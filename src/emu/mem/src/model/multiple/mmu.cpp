@@ -18,6 +18,7 @@
  */
 
 #include <algorithm>
+#include <cpu/arm_interface.h>
 #include <mem/model/multiple/mmu.h>
 
 namespace eka2l1::mem {
@@ -53,9 +54,20 @@ namespace eka2l1::mem {
         return static_cast<asid>(dirs_.size());
     }
 
+    void mmu_multiple::free_addr_space(const asid id) {
+        if ((id <= 0) || (dirs_.size() < id)) {
+            return;
+        }
+
+        dirs_[id - 1]->occupied(false);
+        cpu_->free_addr_space(id);
+    }
+
     bool mmu_multiple::set_current_addr_space(const asid id) {
         if (id == 0) {
             cur_dir_ = &global_dir_;
+            cpu_->set_current_addr_space(id);
+
             return true;
         }
 
@@ -64,6 +76,8 @@ namespace eka2l1::mem {
         }
 
         cur_dir_ = dirs_[id - 1].get();
+        cpu_->set_current_addr_space(id);
+
         return true;
     }
 
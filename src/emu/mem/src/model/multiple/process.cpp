@@ -35,6 +35,12 @@ namespace eka2l1::mem {
         , user_dll_static_data_sec_(mmu->mem_map_old_ ? dll_static_data_eka1 : dll_static_data, mmu->mem_map_old_ ? dll_static_data_eka1_end : shared_data, mmu->page_size()) {
     }
 
+    multiple_mem_model_process::~multiple_mem_model_process() {
+        if (addr_space_id_ > 0) {
+            mmu_->free_addr_space(addr_space_id_);
+        }
+    }
+
     static constexpr std::size_t MAX_CHUNK_ALLOW_PER_PROCESS = 512;
 
     multiple_mem_model_chunk *multiple_mem_model_process::allocate_chunk_struct_ptr() {
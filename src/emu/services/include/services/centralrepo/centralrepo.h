@@ -23,6 +23,7 @@
 #include <kernel/server.h>
 
 #include <atomic>
+#include <functional>
 #include <map>
 #include <string>
 #include <unordered_map>
@@ -32,6 +33,8 @@
 
 namespace eka2l1 {
     class io_system;
+    class kernel_system;
+    class ntimer;
 
     namespace manager {
         class device_manager;
@@ -45,6 +48,49 @@ namespace eka2l1 {
 
     class central_repo_server;
 
+    /**
+     * \brief Run a flush function once no change has been made for a while.
+     *
+     * The flush fires from a timer event, which runs on the timer thread unless timing is
+     * deterministic. The kernel lock is held during the flush, like when the guest modifies repos.
+     */
+    class central_repo_idle_flusher {
+    public:
+        using flush_func = std::function<void()>;
+
+    private:
+        kernel_system *kern_;
+        ntimer *timing_;
+
+        flush_func flush_;
+        std::int64_t idle_time_us_;
+
+        int flush_evt_;
+        std::atomic<bool> scheduled_;
+
+        static void on_flush_due(std::uint64_t userdata, const int cycles_late);
+
+    public:
+        explicit central_repo_idle_flusher(kernel_system *kern, ntimer *timing, flush_func flush,
+            const std::int64_t idle_time_us);
+
+        ~central_repo_idle_flusher();
+
+        /**
+         * \brief Flush after the idle time, pushing back any flush already waiting.
+         */
+        void schedule();
+
+        /**
+         * \brief Drop the flush waiting for the idle time, if any.
+         */
+        void cancel();
+
+        bool is_scheduled() const {
+            return scheduled_;
+        }
+    };
+
     struct central_repo_client_session {
         central_repo_server *server;
 
@@ -83,6 +129,8 @@ namespace eka2l1 {
 
         bool first_repo = true;
 
+        central_repo_idle_flusher flusher;
+
     protected:
         void rescan_drives(eka2l1::io_system *io);
 
@@ -98,6 +146,11 @@ namespace eka2l1 {
         void redirect_msg_to_session(service::ipc_context &ctx);
 
         explicit central_repo_server(eka2l1::system *sys);
+
+        /**
+         * \brief Write pending changes before the server goes away.
+         */
+        ~central_repo_server() override;
         eka2l1::central_repo *get_initial_repo(eka2l1::io_system *io, manager::device_manager *mngr, const std::uint32_t key);
 
         /**
@@ -107,6 +160,19 @@ namespace eka2l1 {
          */
         eka2l1::central_repo *load_repo_with_lookup(eka2l1::io_system *io, manager::device_manager *mngr, const std::uint32_t key);
 
+        /**
+         * \brief Write modified repos back to disk once the server has been idle for a while.
+         * 
+         * Each call pushes the write further back, so a burst of modifications results in only
+         * one write per repo. A repo is also written when a subsession using it closes.
+         */
+        void schedule_flush();
+
+        /**
+         * \brief Write all modified repos to disk now.
+         */
+        void flush_changes();
+
         void connect(service::ipc_context &ctx) override;
         void disconnect(service::ipc_context &ctx) override;
     };
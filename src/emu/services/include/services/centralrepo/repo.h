@@ -95,6 +95,7 @@ namespace eka2l1 {
 
         std::uint32_t owner_uid;
 
+        // Sorted by key, so that both single key and key range lookups are binary searches
         std::vector<central_repo_entry> entries;
         std::vector<central_repo_client_subsession *> attached;
 
@@ -109,9 +110,53 @@ namespace eka2l1 {
 
         std::vector<std::uint32_t> deleted_settings;
 
+        // Entries were modified since the last time the repo was written to disk
+        bool dirty = false;
+
         void write_changes(eka2l1::io_system *io, manager::device_manager *mngr);
+
+        /**
+         * \brief Write the repo to disk, only if it has changes not yet written.
+         * \returns True if the repo was written.
+         */
+        bool flush_changes(eka2l1::io_system *io, manager::device_manager *mngr);
+
+        void mark_dirty() {
+            dirty = true;
+        }
+
+        /**
+         * \brief Sort the entries by key, if they are not already.
+         * 
+         * Must be called after filling the entry list directly, not through add_new_entry.
+         */
+        void sort_entries();
+
         central_repo_entry *find_entry(const std::uint32_t key);
 
+        /**
+         * \brief Find all entries with key inside [low_key, high_key].
+         * 
+         * \param low_key         The lowest key of the range, inclusive.
+         * \param high_key        The highest key of the range, inclusive.
+         * \param matched_entries Reference to vector containing entries, in key order.
+         */
+        void find_entries_in_range(const std::uint32_t low_key, const std::uint32_t high_key,
+            std::vector<central_repo_entry *> &matched_entries);
+
+        /**
+         * \brief Find all entries whose key equals the partial key on all bits set in the mask.
+         * 
+         * Only the key range that can possibly match is visited: every bit of the mask is fixed,
+         * so matching keys are between (partial_key & mask) and (partial_key & mask) | ~mask.
+         * 
+         * \param partial_key     The bit pattern to be matched.
+         * \param mask            The mask that marks the bits to be compared.
+         * \param matched_entries Reference to vector containing entries, in key order.
+         */
+        void find_entries_by_mask(const std::uint32_t partial_key, const std::uint32_t mask,
+            std::vector<central_repo_entry *> &matched_entries);
+
         std::uint32_t get_default_meta_for_new_key(const std::uint32_t key);
 
         bool add_new_entry(const std::uint32_t key, const central_repo_entry_variant &var);
@@ -202,7 +247,11 @@ namespace eka2l1 {
         explicit central_repo_client_subsession();
 
         int reset_key(eka2l1::central_repo *init_repo, const std::uint32_t key);
-        void write_changes(eka2l1::io_system *io, manager::device_manager *mngr);
+
+        /**
+         * \brief Mark the attached repo as modified, and let the server write it back later.
+         */
+        void mark_modified();
 
         void find(service::ipc_context *ctx);
         void reset(service::ipc_context *ctx);
@@ -21,15 +21,21 @@
 #pragma once
 
 #include <services/ecom/plugin.h>
+#include <services/ecom/registry.h>
 #include <services/framework.h>
 #include <common/uid.h>
+#include <common/watcher.h>
 
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
 namespace eka2l1 {
     class io_system;
 
+    struct entry_info;
+
     namespace epoc::fs {
         struct entry;
     }
@@ -108,16 +114,53 @@ namespace eka2l1 {
         // We may need to reconsider this.
         std::vector<ecom_implementation_info_ptr> implementations;
 
+        // Parsed plugin sources, persisted between runs
+        std::unique_ptr<ecom_registry_cache> registry_cache;
+
+        // Paths of the sources installed, in the order they are installed
+        std::vector<std::u16string> sources;
+
+        std::vector<std::int64_t> watchs;
+
+        // Plugin resources changed since the last request, reported by the directory watchers
+        std::vector<std::u16string> changed_sources;
+        std::mutex changed_sources_lock;
+
         bool init{ false };
 
     protected:
         bool register_implementation(const std::uint32_t interface_uid, ecom_implementation_info_ptr &impl);
 
+        void install_record(const ecom_plugin_record &record);
+
+        /**
+         * \brief Clear all interfaces, and install every source again from their records.
+         */
+        void reinstall_records();
+
         bool load_plugins(eka2l1::io_system *io);
-        bool load_and_install_plugin_from_buffer(const std::u16string &name, std::uint8_t *buf, const std::size_t size,
-            const drive_number drv);
 
-        bool load_plugin_on_drive(eka2l1::io_system *io, const drive_number drv);
+        /**
+         * \brief Load plugins on first use, or pick up the plugin resources changed since.
+         */
+        void refresh_plugins(eka2l1::io_system *io);
+
+        /**
+         * \brief Get the record of a plugin source, from the cache, or reading and parsing the source.
+         *
+         * \param jobs If not null, parsing of sources not in the cache is left to the caller, by
+         *             adding a job to this list.
+         *
+         * \returns The record, or null if it's not in the cache yet, or the source can't be read.
+         */
+        ecom_plugin_record *get_plugin_record(eka2l1::io_system *io, const entry_info &source, const bool archive,
+            std::vector<ecom_plugin_parse_job> *jobs);
+
+        std::vector<entry_info> get_plugin_resources_on_drive(eka2l1::io_system *io, const drive_number drv);
+
+        void watch_plugin_directory(eka2l1::io_system *io, const drive_number drv);
+        void on_plugin_directory_changes(const std::u16string &base, common::directory_changes &changes);
+        void apply_plugin_changes(eka2l1::io_system *io);
 
         /*
          * \brief Search the ROM and ROFS for an archive of plugins.
@@ -129,16 +172,13 @@ namespace eka2l1 {
          * 
          * \returns A vector contains all canidates.
          */
-        std::vector<std::string> get_ecom_plugin_archives(eka2l1::io_system *io);
-
-        /*! \brief Load archives
-         */
-        bool load_archives(eka2l1::io_system *io);
+        std::vector<entry_info> get_ecom_plugin_archives(eka2l1::io_system *io);
 
         void connect(service::ipc_context &ctx) override;
 
     public:
         explicit ecom_server(eka2l1::system *sys);
+        ~ecom_server() override;
 
         /**
          * \brief Get interface info of a given UID.
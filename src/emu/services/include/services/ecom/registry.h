@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <services/ecom/plugin.h>
+#include <common/types.h>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace eka2l1 {
+    /**
+     * \brief All interfaces and implementations described by one plugin source.
+     *
+     * A source is either a plugin resource file in \Resource\Plugins\, or a plugin archive (SPI)
+     * containing many of them.
+     */
+    struct ecom_plugin_record {
+        std::u16string path_; ///< Virtual path of the source.
+        drive_number drv_ = drive_z;
+
+        std::uint64_t last_write_ = 0;
+        std::uint64_t size_ = 0;
+
+        bool archive_ = false;
+
+        std::vector<ecom_interface_info> interfaces_;
+    };
+
+    struct ecom_plugin_parse_job {
+        ecom_plugin_record record_;
+        std::vector<std::uint8_t> data_;
+    };
+
+    /**
+     * \brief Parse a plugin source into the record.
+     *
+     * Path, drive and archive flag of the record must be filled before. This does no IO, and can
+     * be called from any thread.
+     *
+     * \returns False if the source, or any plugin inside it, is invalid. Plugins parsed before
+     *          the failure are kept in the record.
+     */
+    bool parse_ecom_plugin_source(ecom_plugin_record &record, std::uint8_t *data, const std::size_t size);
+
+    /**
+     * \brief Parse many plugin sources, spread over all host cores.
+     *
+     * Buffers of the jobs are freed once parsed.
+     */
+    void parse_ecom_plugin_sources(std::vector<ecom_plugin_parse_job> &jobs);
+
+    /**
+     * \brief Parsed plugin sources persisted between runs.
+     *
+     * Records are keyed by the lowercased path of their source. A record is only reused when the
+     * source's last write time and size are still the same, else the source is parsed again.
+     */
+    class ecom_registry_cache {
+        std::string path_;
+        std::unordered_map<std::u16string, ecom_plugin_record> records_;
+
+        bool dirty_;
+
+    public:
+        explicit ecom_registry_cache(const std::string &path);
+
+        /**
+         * \brief Load the records from disk, replacing the current ones.
+         * \returns False if the cache file does not exist, or is invalid or from another version.
+         */
+        bool load();
+
+        /**
+         * \brief Write the records to disk if they were changed since the last load or save.
+         * \returns True on success, or if there is nothing to save.
+         */
+        bool save();
+
+        ecom_plugin_record *get_record(const std::u16string &path);
+
+        /**
+         * \brief Get the record of a source, only if it was made from the source as it is now.
+         */
+        ecom_plugin_record *get_up_to_date_record(const std::u16string &path, const std::uint64_t last_write,
+            const std::uint64_t size);
+
+        ecom_plugin_record &add_record(ecom_plugin_record &&record);
+        bool remove_record(const std::u16string &path);
+
+        /**
+         * \brief Remove the records of all sources not in the given list.
+         *
+         * \param paths Paths of sources that still exist.
+         */
+        void retain_records(const std::vector<std::u16string> &paths);
+
+        std::size_t size() const {
+            return records_.size();
+        }
+    };
+}
@@ -43,6 +43,9 @@ namespace eka2l1::epoc::adapter {
 
     /**
      * \brief Base class for adapter.
+     *
+     * Adapters are used by the FBS glyph rasterizer threads as well as the emulation thread, so
+     * every function must be safe to call from multiple threads at once.
      */
     class font_file_adapter_base {
     public:
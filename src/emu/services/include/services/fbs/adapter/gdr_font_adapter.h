@@ -26,6 +26,7 @@
 #include <common/container.h>
 #include <loader/gdr.h>
 
+#include <mutex>
 #include <vector>
 
 namespace eka2l1::epoc::adapter {
@@ -43,6 +44,9 @@ namespace eka2l1::epoc::adapter {
         std::vector<std::uint32_t*> dynamic_alloc_list_;
         common::identity_container<gdr_font_atlas_pack_context> pack_contexts_;
 
+        // Guards the allocation list and pack contexts
+        std::mutex lock_;
+
     protected:
         loader::gdr::character *get_character(const std::size_t idx, std::uint32_t code);
 
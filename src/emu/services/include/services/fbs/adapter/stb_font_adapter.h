@@ -21,6 +21,7 @@
 
 #include <map>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 #include <common/container.h>
@@ -40,6 +41,9 @@ namespace eka2l1::epoc::adapter {
 
         std::uint8_t flags_;
 
+        // Guards the font info cache and pack contexts. Rasterization itself runs without it.
+        std::mutex lock_;
+
         enum {
             FLAGS_CONTEXT_INITED = 1 << 0
         };
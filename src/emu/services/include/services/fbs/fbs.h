@@ -28,6 +28,9 @@
 #include <services/fbs/compress_queue.h>
 #include <services/fbs/font.h>
 #include <services/fbs/font_atlas.h>
+#include <services/fbs/glyph_bitmap_cache.h>
+#include <services/fbs/glyph_cache.h>
+#include <services/fbs/glyph_prerasterize_pool.h>
 #include <services/fbs/font_store.h>
 #include <services/framework.h>
 #include <services/window/common.h>
@@ -39,6 +42,7 @@
 
 #include <atomic>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <thread>
 #include <unordered_map>
@@ -221,8 +225,6 @@ namespace eka2l1 {
         explicit fbsfont()
             : fbsobj(fbsobj_kind::font) {
         }
-
-        void deref() override;
     };
 
     struct fbsbitmap : public fbsobj {
@@ -296,6 +298,53 @@ namespace eka2l1 {
         explicit fbs_bitmap_data_info();
     };
 
+    /**
+     * \brief Generation of a bitwise bitmap, as known by the server.
+     */
+    struct fbs_bitmap_generation {
+        std::uint64_t generation_ = 0; ///< Bumped each time the server writes to the bitmap.
+
+        /**
+         * True if the bitmap is a draw target of guest code. Guest writes its pixels
+         * directly in the large chunk, without telling the server.
+         */
+        bool guest_writable_ = false;
+    };
+
+    /**
+     * \brief Generations of the bitwise bitmaps known by the server.
+     * 
+     * Shared between the server, its compressor thread and the window server's bitmap cache.
+     */
+    class fbs_bitmap_generation_table {
+        std::unordered_map<const epoc::bitwise_bitmap *, fbs_bitmap_generation> generations_;
+        std::uint64_t counter_{ 0 };
+        std::mutex lock_;
+
+    public:
+        /**
+         * \brief Give the bitwise bitmap a new generation number.
+         */
+        void touch(const epoc::bitwise_bitmap *bmp);
+
+        /**
+         * \brief Mark the bitwise bitmap as writable by guest code.
+         */
+        void mark_guest_writable(const epoc::bitwise_bitmap *bmp);
+
+        /**
+         * \brief Forget about a bitwise bitmap which is being freed.
+         */
+        void remove(const epoc::bitwise_bitmap *bmp);
+
+        /**
+         * \brief  Get the generation of a bitwise bitmap.
+         * \returns Generation info. If the bitmap is unknown, generation number is 0 and the bitmap
+         *          is reported as guest writable.
+         */
+        fbs_bitmap_generation get(const epoc::bitwise_bitmap *bmp);
+    };
+
     class fbs_server : public service::typical_server {
         friend struct fbscli;
         friend struct fbsfont;
@@ -317,9 +366,15 @@ namespace eka2l1 {
 
         std::unordered_map<fbsbitmap_cache_info, fbsbitmap *> shared_bitmaps;
 
+        fbs_bitmap_generation_table bitmap_generations;
+
         std::unique_ptr<fbs_chunk_allocator> shared_chunk_allocator;
         std::unique_ptr<fbs_chunk_allocator> large_chunk_allocator;
 
+        epoc::glyph_cache open_font_glyph_cache;
+        epoc::glyph_bitmap_cache open_font_glyph_bitmap_cache;
+        std::unique_ptr<epoc::glyph_prerasterize_pool> glyph_prerasterizer;
+
         std::unique_ptr<compress_queue> compressor;
         std::unique_ptr<std::thread> compressor_thread;
 
@@ -376,6 +431,40 @@ namespace eka2l1 {
          */
         bool free_bitmap(fbsbitmap *bmp);
 
+        /**
+         * \brief Give the bitwise bitmap a new generation number.
+         * 
+         * Called each time the server constructs or writes to a bitwise bitmap, so that caches
+         * keyed by the bitmap address can tell if its content changed since they last saw it.
+         * 
+         * \param bmp The bitwise bitmap that has been (re)constructed or written to.
+         */
+        void touch_bitmap(const epoc::bitwise_bitmap *bmp);
+
+        /**
+         * \brief Mark the bitwise bitmap as writable by guest code.
+         * 
+         * The generation number of such bitmaps can't be trusted to cover all writes. Every
+         * bitmap handed to a client is one: guest can write its pixels through the data address,
+         * or draw to it with a bitmap device.
+         * 
+         * \param bmp The bitwise bitmap handed to the guest.
+         */
+        void mark_bitmap_guest_writable(const epoc::bitwise_bitmap *bmp);
+
+        /**
+         * \brief  Get the generation of a bitwise bitmap.
+         * \returns Generation info. If the bitmap is not known to the server, generation number is 0
+         *          and the bitmap is reported as guest writable.
+         * 
+         * \see    touch_bitmap
+         */
+        fbs_bitmap_generation get_bitmap_generation(const epoc::bitwise_bitmap *bmp);
+
+        fbs_bitmap_generation_table *get_bitmap_generations() {
+            return &bitmap_generations;
+        }
+
         /**
          * \brief Check if we are working on legacy FBS.
          */
@@ -383,6 +472,25 @@ namespace eka2l1 {
 
         drivers::graphics_driver *get_graphics_driver();
 
+        /**
+         * \brief Get the cache of glyphs rasterized from open fonts, shared by all fonts.
+         */
+        epoc::glyph_cache *get_glyph_cache() {
+            return &open_font_glyph_cache;
+        }
+
+        /**
+         * \brief Get the cache of glyph bitmaps given to clients through the rasterize glyph request.
+         */
+        epoc::glyph_bitmap_cache *get_glyph_bitmap_cache() {
+            return &open_font_glyph_bitmap_cache;
+        }
+
+        /**
+         * \brief Queue the common glyphs of a new font to be rasterized on the glyph rasterizer threads.
+         */
+        void prerasterize_font(fbsfont *font);
+
         fbsfont *look_for_font_with_address(const eka2l1::address addr);
 
         std::uint8_t *get_shared_chunk_base() {
@@ -22,11 +22,8 @@
 #include <services/fbs/adapter/font_adapter.h>
 #include <services/window/common.h>
 
-#include <deque>
-#include <map>
-#include <memory>
 #include <string>
-#include <vector>
+#include <utility>
 
 namespace eka2l1::drivers {
     class graphics_driver;
@@ -34,42 +31,37 @@ namespace eka2l1::drivers {
 }
 
 namespace eka2l1::epoc {
-#define ESTIMATE_MAX_CHAR_IN_ATLAS_WIDTH 50
+    class glyph_cache;
 
     /**
-     * \brief Font atlas is a texture contains glyph bitmaps.
-     * 
-     * The atlas dimension is a square, and height is equals to font_size *
-     * estimate_max_char_in_atlas.
+     * \brief Font atlas draws text of a font, with glyphs from the shared glyph cache.
+     *
+     * The initial range of characters is rasterized in one batch on the first draw.
      */
     struct font_atlas {
-        std::map<char16_t, adapter::character_info> characters_;
-        drivers::handle atlas_handle_;
+        glyph_cache *cache_;
         adapter::font_file_adapter_base *adapter_;
         int size_;
 
-        std::vector<int> last_use_;
-
         std::pair<char16_t, char16_t> initial_range_;
-        std::unique_ptr<std::uint8_t[]> atlas_data_;
+        bool initial_range_loaded_;
 
         std::size_t typeface_idx_;
-        std::int32_t pack_handle_;
 
     public:
         explicit font_atlas();
 
-        explicit font_atlas(adapter::font_file_adapter_base *adapter, const std::size_t typeface_idx, const char16_t initial_start,
-            const char16_t initial_char_count, int font_size);
-
-        void init(adapter::font_file_adapter_base *adapter, const std::size_t typeface_idx, const char16_t initial_start,
-            const char16_t initial_char_count, int font_size);
+        explicit font_atlas(glyph_cache *cache, adapter::font_file_adapter_base *adapter, const std::size_t typeface_idx,
+            const char16_t initial_start, const char16_t initial_char_count, int font_size);
 
-        void free(drivers::graphics_driver *driver);
+        void init(glyph_cache *cache, adapter::font_file_adapter_base *adapter, const std::size_t typeface_idx,
+            const char16_t initial_start, const char16_t initial_char_count, int font_size);
 
-        int get_atlas_width() const;
+        bool is_initialized() const {
+            return cache_ != nullptr;
+        }
 
         bool draw_text(const std::u16string &text, const eka2l1::rect &box, const epoc::text_alignment alignment, drivers::graphics_driver *driver,
             drivers::graphics_command_list_builder *builder);
     };
-}
\ No newline at end of file
+}
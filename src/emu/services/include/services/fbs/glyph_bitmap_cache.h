@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <services/fbs/adapter/font_adapter.h>
+#include <services/fbs/font.h>
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace eka2l1::epoc {
+    constexpr std::size_t DEFAULT_GLYPH_BITMAP_CACHE_MAX_BYTES = 4 * 1024 * 1024;
+
+    struct glyph_bitmap_key {
+        adapter::font_file_adapter_base *adapter_;
+        std::size_t typeface_idx_;
+        float scale_x_;
+        float scale_y_;
+        std::uint32_t code_;
+    };
+
+    inline bool operator==(const glyph_bitmap_key &lhs, const glyph_bitmap_key &rhs) {
+        return (lhs.adapter_ == rhs.adapter_) && (lhs.typeface_idx_ == rhs.typeface_idx_) && (lhs.scale_x_ == rhs.scale_x_)
+            && (lhs.scale_y_ == rhs.scale_y_) && (lhs.code_ == rhs.code_);
+    }
+
+    struct glyph_bitmap_key_hash {
+        std::size_t operator()(const glyph_bitmap_key &key) const noexcept;
+    };
+
+    /**
+     * \brief A glyph rasterized the way FBS clients expect it in their session cache.
+     */
+    struct rasterized_glyph {
+        bool exists_ = false; ///< False if the typeface does not have this glyph.
+
+        std::vector<std::uint8_t> data_;
+        int width_ = 0;
+        int height_ = 0;
+
+        glyph_bitmap_type bitmap_type_ = glyph_bitmap_type::default_glyph_bitmap;
+        open_font_character_metric metric_; ///< Metric with no baseline offset.
+    };
+
+    using rasterized_glyph_ptr = std::shared_ptr<const rasterized_glyph>;
+
+    /**
+     * \brief Thread-safe cache of glyph bitmaps rasterized through the font adapters.
+     *
+     * Glyphs are filled by the FBS rasterizer threads ahead of time, and by the rasterize glyph
+     * request on a miss. When the total bitmap size is over budget, the oldest glyphs are dropped.
+     * Glyphs are shared, so a dropped glyph stays alive for whoever still holds it.
+     */
+    class glyph_bitmap_cache {
+        std::unordered_map<glyph_bitmap_key, rasterized_glyph_ptr, glyph_bitmap_key_hash> glyphs;
+        std::deque<glyph_bitmap_key> insert_order;
+
+        std::size_t total_bytes{ 0 };
+        std::size_t max_bytes;
+
+        mutable std::mutex lock;
+
+        void add(const glyph_bitmap_key &key, rasterized_glyph_ptr &glyph);
+
+    public:
+        explicit glyph_bitmap_cache(const std::size_t max_bytes_ = DEFAULT_GLYPH_BITMAP_CACHE_MAX_BYTES);
+
+        /**
+         * \brief Get a glyph, rasterizing it if it's not in the cache yet.
+         *
+         * Rasterization happens outside of the cache lock.
+         *
+         * \returns The glyph. Never null, check exists_ to know if the typeface has it.
+         */
+        rasterized_glyph_ptr get_or_rasterize(adapter::font_file_adapter_base *adapter, const std::size_t typeface_idx,
+            const float scale_x, const float scale_y, const std::uint32_t code);
+
+        /**
+         * \brief Get a glyph only if it's already in the cache.
+         */
+        rasterized_glyph_ptr get(const glyph_bitmap_key &key) const;
+
+        std::size_t size() const {
+            const std::lock_guard<std::mutex> guard(lock);
+            return glyphs.size();
+        }
+
+        std::size_t get_total_bytes() const {
+            const std::lock_guard<std::mutex> guard(lock);
+            return total_bytes;
+        }
+    };
+}
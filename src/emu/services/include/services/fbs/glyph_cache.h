@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <common/vecx.h>
+#include <drivers/graphics/common.h>
+#include <services/fbs/adapter/font_adapter.h>
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace eka2l1::drivers {
+    class graphics_driver;
+    class graphics_command_list_builder;
+}
+
+namespace eka2l1::epoc {
+    constexpr int DEFAULT_GLYPH_PAGE_SIZE = 1024;
+    constexpr std::size_t DEFAULT_GLYPH_PAGE_MAX_COUNT = 4;
+
+    /**
+     * Empty pixels kept at the right and bottom of each glyph, so that filtering does not
+     * bleed into the neighbour glyph.
+     */
+    constexpr int GLYPH_PADDING = 1;
+
+    struct glyph_cache_key {
+        adapter::font_file_adapter_base *adapter_;
+        std::size_t typeface_idx_;
+        int size_;
+        char16_t code_;
+    };
+
+    inline bool operator==(const glyph_cache_key &lhs, const glyph_cache_key &rhs) {
+        return (lhs.adapter_ == rhs.adapter_) && (lhs.typeface_idx_ == rhs.typeface_idx_) && (lhs.size_ == rhs.size_)
+            && (lhs.code_ == rhs.code_);
+    }
+
+    struct glyph_cache_key_hash {
+        std::size_t operator()(const glyph_cache_key &key) const noexcept;
+    };
+
+    /**
+     * \brief A glyph resident in the cache.
+     *
+     * Atlas coordinates of the character info are in pixels of the page the glyph lives in.
+     */
+    struct cached_glyph {
+        int page_ = -1; ///< Page index. -1 for glyphs without any pixel, such as space.
+        adapter::character_info info_;
+    };
+
+    struct glyph_cache_stats {
+        std::uint64_t hits_ = 0;
+        std::uint64_t misses_ = 0;
+        std::uint64_t evictions_ = 0;
+        std::uint64_t uploads_ = 0;
+        std::uint64_t bytes_uploaded_ = 0;
+    };
+
+    /**
+     * \brief Glyph bitmaps of all open fonts, packed into 8 bpp atlas pages.
+     *
+     * Glyphs are keyed by (typeface, size, codepoint), so fonts that share a typeface and a size share
+     * their glyphs. Each page is packed with shelves: rows of glyphs with similar height. Space freed
+     * by evicted glyphs is reused by glyphs that fit the shelf.
+     *
+     * When no page has room and no more page can be added, the least recently used glyphs are evicted
+     * until the new glyph fits. Glyphs acquired since the last call to begin_use are never evicted, so
+     * that a string being drawn keeps all of its glyphs.
+     *
+     * Only the regions of pages that changed are uploaded to the driver, on flush.
+     *
+     * The cache is thread-safe. Glyphs can be rasterized ahead of time on other threads through
+     * prerasterize, while the window server draws with them.
+     */
+    class glyph_cache {
+    public:
+        static constexpr std::uint32_t INVALID_SLOT = 0xFFFFFFFF;
+
+    private:
+        struct shelf_span {
+            int x_;
+            int width_;
+        };
+
+        struct shelf {
+            int y_;
+            int height_;
+            std::vector<shelf_span> free_spans_; ///< Sorted by position.
+        };
+
+        struct page {
+            drivers::handle bitmap_ = 0;
+            std::vector<std::uint8_t> data_;
+            std::vector<shelf> shelves_;
+            int next_shelf_y_ = 0;
+            eka2l1::rect dirty_; ///< Region not yet uploaded. Empty if clean.
+        };
+
+        struct entry {
+            glyph_cache_key key_;
+            cached_glyph glyph_;
+
+            // Space taken in the page, padding included
+            int shelf_ = -1;
+            int slot_x_ = 0;
+            int slot_width_ = 0;
+
+            std::uint64_t use_serial_ = 0;
+
+            // Intrusive LRU list links. Head is the most recently used.
+            std::uint32_t prev_ = INVALID_SLOT;
+            std::uint32_t next_ = INVALID_SLOT;
+        };
+
+        std::vector<page> pages;
+        std::deque<entry> entries; ///< Deque so that glyph pointers survive new entries.
+        std::vector<std::uint32_t> free_slots;
+        std::unordered_map<glyph_cache_key, std::uint32_t, glyph_cache_key_hash> slot_lookup;
+
+        std::uint32_t lru_head;
+        std::uint32_t lru_tail;
+
+        int page_size;
+        std::size_t max_page_count;
+
+        std::uint64_t current_serial{ 1 };
+        std::vector<std::uint8_t> scratch;
+        glyph_cache_stats stats;
+
+        mutable std::mutex lock;
+
+        void lru_unlink(const std::uint32_t slot);
+        void lru_push_front(const std::uint32_t slot);
+
+        bool allocate_in_page(page &target, const int width, const int height, int &shelf_idx, int &x);
+        void free_in_page(page &target, const int shelf_idx, const int x, const int width);
+
+        /**
+         * \brief Find room for a glyph, adding pages or evicting glyphs if needed.
+         * \returns False if the glyph can't fit without evicting glyphs still in use.
+         */
+        bool allocate(const int width, const int height, int &page_idx, int &shelf_idx, int &x);
+
+        /**
+         * \brief Evict the least recently used glyph.
+         * \returns False if every glyph is still in use.
+         */
+        bool evict_one();
+
+        /**
+         * \brief Rasterize glyphs through the font adapter into a page sized buffer.
+         *
+         * Atlas coordinates in the result are in the buffer. This does not touch the cache, and can be
+         * called without holding the lock.
+         */
+        bool rasterize(adapter::font_file_adapter_base *adapter, const std::size_t typeface_idx, const int font_size,
+            std::vector<int> &codes, std::vector<adapter::character_info> &infos, std::vector<std::uint8_t> &buffer);
+
+        /**
+         * \brief Rasterize glyphs in batches, falling back to one by one for batches that do not fit the buffer.
+         *
+         * Each rasterized batch is given to the callback, along with its codes and infos.
+         */
+        template <typename F>
+        void rasterize_batches(adapter::font_file_adapter_base *adapter, const std::size_t typeface_idx, const int font_size,
+            const std::vector<int> &codes, std::vector<std::uint8_t> &buffer, F add_batch);
+
+        /**
+         * \brief Copy a glyph rasterized in a buffer to a page, and add it to the cache.
+         *
+         * \param use_serial  Serial the glyph was last used at. Glyphs with the current serial are not evicted.
+         * \returns Slot of the glyph, INVALID_SLOT on failure.
+         */
+        std::uint32_t add_glyph(const glyph_cache_key &key, const adapter::character_info &source_info,
+            const std::vector<std::uint8_t> &source, const std::uint64_t use_serial);
+
+    public:
+        explicit glyph_cache(const int page_size_ = DEFAULT_GLYPH_PAGE_SIZE,
+            const std::size_t max_page_count_ = DEFAULT_GLYPH_PAGE_MAX_COUNT);
+
+        /**
+         * \brief Start a new use. Glyphs acquired before can be evicted again.
+         */
+        void begin_use() {
+            const std::lock_guard<std::mutex> guard(lock);
+            current_serial++;
+        }
+
+        /**
+         * \brief Get glyphs of a string, rasterizing the ones not yet in the cache.
+         *
+         * Missing glyphs are rasterized in one batch. Acquired glyphs become the most recently used,
+         * and can't be evicted until the next begin_use.
+         *
+         * \param adapter       The font file adapter to rasterize missing glyphs with.
+         * \param typeface_idx  Index of the typeface in the font file.
+         * \param font_size     Size of the font in pixels.
+         * \param text          The string to get glyphs of.
+         * \param result        Glyph of each character in the string. Null for characters that could not be cached.
+         *                      Pointers stay valid until the next begin_use.
+         *
+         * \returns False if some glyphs could not be cached.
+         */
+        bool get_glyphs(adapter::font_file_adapter_base *adapter, const std::size_t typeface_idx, const int font_size,
+            const std::u16string &text, std::vector<const cached_glyph *> &result);
+
+        /**
+         * \brief Rasterize glyphs of a string that are not yet in the cache, without using them.
+         *
+         * Rasterization happens outside of the cache lock, so this is meant to be called from worker
+         * threads. New glyphs are not pinned, and may evict other glyphs not in use.
+         *
+         * \returns Number of glyphs added to the cache.
+         */
+        std::size_t prerasterize(adapter::font_file_adapter_base *adapter, const std::size_t typeface_idx, const int font_size,
+            const std::u16string &text);
+
+        /**
+         * \brief Create driver bitmaps of new pages, and upload regions of pages that changed.
+         */
+        void flush(drivers::graphics_driver *driver, drivers::graphics_command_list_builder *builder);
+
+        /**
+         * \brief Get the driver bitmap of a page. 0 if the page has not been flushed yet.
+         */
+        drivers::handle get_page_bitmap(const int page_idx) const;
+
+        /**
+         * \brief Check if the given glyph is in the cache, without touching it.
+         */
+        bool contains(const glyph_cache_key &key) const {
+            const std::lock_guard<std::mutex> guard(lock);
+            return slot_lookup.find(key) != slot_lookup.end();
+        }
+
+        std::size_t size() const {
+            const std::lock_guard<std::mutex> guard(lock);
+            return slot_lookup.size();
+        }
+
+        std::size_t page_count() const {
+            const std::lock_guard<std::mutex> guard(lock);
+            return pages.size();
+        }
+
+        int get_page_size() const {
+            return page_size;
+        }
+
+        glyph_cache_stats get_stats() const {
+            const std::lock_guard<std::mutex> guard(lock);
+            return stats;
+        }
+
+        void reset_stats() {
+            const std::lock_guard<std::mutex> guard(lock);
+            stats = glyph_cache_stats{};
+        }
+    };
+}
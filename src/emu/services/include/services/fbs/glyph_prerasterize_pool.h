@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <common/queue.h>
+#include <services/fbs/adapter/font_adapter.h>
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace eka2l1::epoc {
+    class glyph_cache;
+    class glyph_bitmap_cache;
+
+    /**
+     * \brief Range of glyphs rasterized ahead of time for every font: printable ASCII and Latin-1.
+     */
+    constexpr char16_t PRERASTERIZE_GLYPH_START = 0x20;
+    constexpr char16_t PRERASTERIZE_GLYPH_COUNT = 0xFF - 0x20;
+
+    struct glyph_prerasterize_request {
+        adapter::font_file_adapter_base *adapter_ = nullptr;
+        std::size_t typeface_idx_ = 0;
+
+        float scale_x_ = 1.0f; ///< Scale of the glyph bitmaps given to FBS clients.
+        float scale_y_ = 1.0f;
+
+        int font_size_ = 0; ///< Size in pixels of the glyphs drawn by the window server.
+    };
+
+    inline bool operator==(const glyph_prerasterize_request &lhs, const glyph_prerasterize_request &rhs) {
+        return (lhs.adapter_ == rhs.adapter_) && (lhs.typeface_idx_ == rhs.typeface_idx_) && (lhs.scale_x_ == rhs.scale_x_)
+            && (lhs.scale_y_ == rhs.scale_y_) && (lhs.font_size_ == rhs.font_size_);
+    }
+
+    /**
+     * \brief Pool of threads that rasterize the common glyphs of new fonts.
+     *
+     * Glyphs go to both the FBS glyph bitmap cache, which serves glyph rasterize requests from
+     * clients, and the window server glyph cache, which text is drawn from. Opening a text heavy
+     * screen then finds most glyphs already rasterized, instead of rasterizing them one by one on
+     * the emulation thread.
+     */
+    class glyph_prerasterize_pool {
+        request_queue<glyph_prerasterize_request> queue_;
+        std::vector<std::thread> workers_;
+
+        glyph_bitmap_cache *bitmap_cache_;
+        glyph_cache *atlas_cache_;
+
+        // Fonts already requested, so that each one is only done once
+        std::vector<glyph_prerasterize_request> requested_;
+        std::mutex requested_lock_;
+
+        std::atomic<std::uint32_t> pending_count_;
+
+    protected:
+        void prerasterize(const glyph_prerasterize_request &request);
+        void run();
+
+    public:
+        explicit glyph_prerasterize_pool(glyph_bitmap_cache *bitmap_cache, glyph_cache *atlas_cache, const std::uint32_t thread_count);
+        ~glyph_prerasterize_pool();
+
+        /**
+         * \brief Queue a font to be prerasterized.
+         *
+         * Fonts that were queued before are ignored.
+         *
+         * \param request Font to prerasterize.
+         */
+        void queue(const glyph_prerasterize_request &request);
+
+        /**
+         * \brief Get the number of requests not yet finished.
+         */
+        std::uint32_t pending_count() const {
+            return pending_count_;
+        }
+
+        /**
+         * \brief Stop the workers. Pending requests are dropped.
+         */
+        void abort();
+    };
+}
@@ -77,4 +77,9 @@ namespace eka2l1::epoc {
         0x00ffcc00, 0x00ffcc33, 0x00ffcc66, 0x00ffcc99, 0x00ffcccc, 0x00ffccff,
         0x00ffff00, 0x00ffff33, 0x00ffff66, 0x00ffff99, 0x00ffffcc, 0x00ffffff
     };
+
+    static std::array<common::rgb, 16> color_16_palette = {
+        0x00000000, 0x00555555, 0x00000080, 0x00008080, 0x00008000, 0x000000ff, 0x0000ffff, 0x0000ff00,
+        0x00ff00ff, 0x00ff0000, 0x00ffff00, 0x00800080, 0x00800000, 0x00808000, 0x00aaaaaa, 0x00ffffff
+    };
 }
@@ -27,59 +27,128 @@
 #include <drivers/itc.h>
 #include <services/fbs/bitmap.h>
 
-#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
 
 namespace eka2l1 {
     class kernel_system;
+    class fbs_bitmap_generation_table;
 }
 
 namespace eka2l1::epoc {
-    constexpr std::uint32_t MAX_CACHE_SIZE = 1024;
+    constexpr std::uint32_t DEFAULT_BITMAP_CACHE_CAPACITY = 1024;
+
+    /**
+     * Number of pixel rows hashed together. When the content of a cached bitmap changes,
+     * only the bands whose hash changed are uploaded to the driver.
+     */
+    constexpr std::int32_t BITMAP_CACHE_BAND_ROWS = 16;
+
+    struct bitmap_cache_stats {
+        std::uint64_t hits_ = 0;
+        std::uint64_t misses_ = 0;
+        std::uint64_t uploads_ = 0;
+        std::uint64_t bytes_uploaded_ = 0;
+        std::uint64_t evictions_ = 0;
+    };
 
     class bitmap_cache {
     public:
-        using driver_texture_handle_array = std::array<drivers::handle, MAX_CACHE_SIZE>;
-        using bitmap_array = std::array<epoc::bitwise_bitmap *, MAX_CACHE_SIZE>;
-        using timestamps_array = std::array<std::uint64_t, MAX_CACHE_SIZE>;
-        using hashes_array = timestamps_array;
+        static constexpr std::uint32_t INVALID_SLOT = 0xFFFFFFFF;
+
+        struct entry {
+            epoc::bitwise_bitmap *bitmap_ = nullptr;
+            drivers::handle driver_texture_ = 0;
+            eka2l1::vec2 texture_size_ = { 0, 0 };
+
+            std::uint64_t hash_ = 0;
+            std::uint64_t generation_ = 0;
+            std::uint64_t verified_epoch_ = 0;
+            std::vector<std::uint64_t> band_hashes_;
+
+            // Intrusive LRU list links. Head is the most recently used.
+            std::uint32_t prev_ = INVALID_SLOT;
+            std::uint32_t next_ = INVALID_SLOT;
+        };
 
     private:
-        driver_texture_handle_array driver_textures;
-        bitmap_array bitmaps;
-        timestamps_array timestamps;
-        hashes_array hashes;
+        std::vector<entry> entries;
+        std::vector<std::uint32_t> free_slots;
+        std::unordered_map<const epoc::bitwise_bitmap *, std::uint32_t> slot_lookup;
+
+        std::uint32_t lru_head;
+        std::uint32_t lru_tail;
+        std::uint32_t capacity;
 
         std::uint8_t *base_large_chunk;
 
         kernel_system *kern;
-        drivers::graphics_driver *driver;
+        fbs_bitmap_generation_table *generations;
+
+        std::uint64_t current_epoch{ 1 };
+        bitmap_cache_stats stats;
 
-        std::int64_t last_free{ 0 };
+        void lru_unlink(const std::uint32_t slot);
+        void lru_push_front(const std::uint32_t slot);
+
+        /**
+         * \brief Forget everything about the bitmap previously held in a slot, except its driver texture.
+         */
+        void recycle_slot(const std::uint32_t slot);
+
+        /**
+         * \brief Get a slot for a bitmap not yet in the cache.
+         * 
+         * Free slots are used first. When the cache is full, the least recently used
+         * entry is evicted. Its driver texture is kept for reuse.
+         */
+        std::uint32_t acquire_slot();
 
     protected:
+        /**
+         * \brief Hash the bitmap's layout: header, byte width, UID and data location.
+         * 
+         * If this changes, the bitmap is reuploaded as a whole.
+         */
         std::uint64_t hash_bitwise_bitmap(epoc::bitwise_bitmap *bw_bmp);
 
-    public:
-        explicit bitmap_cache(kernel_system *kern_);
+        /**
+         * \brief Hash the bitmap's data, band by band.
+         * 
+         * Compressed bitmaps can't be split into rows, so their data is hashed as a single band.
+         */
+        void hash_bitmap_bands(epoc::bitwise_bitmap *bw_bmp, std::vector<std::uint64_t> &result);
 
-        const driver_texture_handle_array &texture_array() {
-            return driver_textures;
-        }
+        /**
+         * \brief Upload the pixel rows in range [y_start, y_end) of the bitmap to the driver texture.
+         * 
+         * Compressed bitmaps are always uploaded whole.
+         */
+        void upload_rows(drivers::graphics_command_list_builder *builder, const drivers::handle h,
+            epoc::bitwise_bitmap *bmp, int y_start, int y_end);
 
-        const bitmap_array &bitwise_bitmap_array() {
-            return bitmaps;
-        }
+    public:
+        explicit bitmap_cache(kernel_system *kern_, const std::uint32_t capacity_ = DEFAULT_BITMAP_CACHE_CAPACITY);
 
-        std::int64_t get_suitable_bitmap_index();
+        /**
+         * \brief Construct a cache which reads bitmap data and generations from the given places,
+         *        instead of looking up the FBS server through the kernel.
+         */
+        explicit bitmap_cache(fbs_bitmap_generation_table *generations_, std::uint8_t *base_large_chunk_,
+            const std::uint32_t capacity_ = DEFAULT_BITMAP_CACHE_CAPACITY);
 
         /**
          * \brief   Add a bitmap to texture cache if not available in the cache, and get
          *          the driver's texture handle.
          * 
-         * If the cache is full, this will find the least used bitmap (by sorting out 
-         * last used timestamp). Also, since bitwise bitmap modify itself by user's will
-         * without a method to notify the user, this also hashes bitmap data (using xxHash),
-         * and will reupload the bitmap to driver if the texture data is different.
+         * Lookup is done through a hash map. If the cache is full, the least recently used bitmap
+         * is evicted.
+         * 
+         * The bitmap data is only hashed (using xxHash, in bands of rows) when its FBS generation
+         * changed, or when it is drawn to by guest code, which does not notify anyone. Only the bands
+         * whose data is different are reuploaded. Guest drawn bitmaps are verified once per epoch.
+         * Inside an epoch, guest code does not run, so the bitmap data can't change.
          * 
          * \param   driver  Pointer
          * \param   bmp     The pointer to bitwise bitmap.
@@ -90,9 +159,38 @@ namespace eka2l1::epoc {
 
         /**
          * \brief   Remove the bitmap from cache.
+         * 
+         * The driver texture is kept, and will be reused by the next bitmap added.
+         * 
          * \returns True if success. False if bitmap not found. Likely that the bitmap has been
          *          purged from cache
          */
         bool remove(epoc::bitwise_bitmap *bmp);
+
+        /**
+         * \brief Start a new verification epoch.
+         * 
+         * Call this before handling a new batch of client commands, since guest code may have
+         * modified the bitmaps since the last batch.
+         */
+        void invalidate_verification() {
+            current_epoch++;
+        }
+
+        std::uint32_t get_capacity() const {
+            return capacity;
+        }
+
+        std::size_t size() const {
+            return slot_lookup.size();
+        }
+
+        const bitmap_cache_stats &get_stats() const {
+            return stats;
+        }
+
+        void reset_stats() {
+            stats = bitmap_cache_stats{};
+        }
     };
 }
@@ -27,6 +27,8 @@
 #include <services/centralrepo/centralrepo.h>
 #include <services/centralrepo/cre.h>
 #include <services/context.h>
+#include <kernel/kernel.h>
+#include <kernel/timing.h>
 #include <manager/device_manager.h>
 #include <manager/manager.h>
 
@@ -39,6 +41,9 @@
 #include <vector>
 
 namespace eka2l1 {
+    // Time without any modification before modified repos are written back to disk
+    static constexpr std::int64_t CENTRAL_REPO_FLUSH_IDLE_TIME_US = 2000000;
+
     // TODO: Security check. This include reading keyspace file (.cre) to get policies
     // information and reading capabilities section
     bool indentify_central_repo_entry_var_type(const std::string &tok, central_repo_entry_type &t) {
@@ -205,9 +210,54 @@ namespace eka2l1 {
         return true;
     }
 
+    central_repo_idle_flusher::central_repo_idle_flusher(kernel_system *kern, ntimer *timing, flush_func flush,
+        const std::int64_t idle_time_us)
+        : kern_(kern)
+        , timing_(timing)
+        , flush_(flush)
+        , idle_time_us_(idle_time_us)
+        , scheduled_(false) {
+        flush_evt_ = timing_->register_event("cenrep_flush_evt", on_flush_due);
+    }
+
+    central_repo_idle_flusher::~central_repo_idle_flusher() {
+        cancel();
+        timing_->remove_event(flush_evt_);
+    }
+
+    void central_repo_idle_flusher::on_flush_due(std::uint64_t userdata, const int cycles_late) {
+        central_repo_idle_flusher *flusher = reinterpret_cast<central_repo_idle_flusher *>(userdata);
+
+        // Not on the emulation thread with real timing. Repos are modified with the kernel lock held.
+        flusher->kern_->lock();
+
+        // A change may have rescheduled the flush while this one waited for the lock. This flush covers it.
+        flusher->cancel();
+        flusher->flush_();
+
+        flusher->kern_->unlock();
+    }
+
+    void central_repo_idle_flusher::schedule() {
+        if (scheduled_) {
+            timing_->unschedule_event(flush_evt_, reinterpret_cast<std::uint64_t>(this));
+        }
+
+        timing_->schedule_event(idle_time_us_, flush_evt_, reinterpret_cast<std::uint64_t>(this));
+        scheduled_ = true;
+    }
+
+    void central_repo_idle_flusher::cancel() {
+        if (scheduled_) {
+            timing_->unschedule_event(flush_evt_, reinterpret_cast<std::uint64_t>(this));
+            scheduled_ = false;
+        }
+    }
+
     central_repo_server::central_repo_server(eka2l1::system *sys)
         : service::server(sys->get_kernel_system(), sys, CENTRAL_REPO_SERVER_NAME, true)
-        , id_counter(0) {
+        , id_counter(0)
+        , flusher(sys->get_kernel_system(), sys->get_ntimer(), [this]() { flush_changes(); }, CENTRAL_REPO_FLUSH_IDLE_TIME_US) {
         REGISTER_IPC(central_repo_server, redirect_msg_to_session, cen_rep_init, "CenRep::Init");
         REGISTER_IPC(central_repo_server, redirect_msg_to_session, cen_rep_close, "CenRep::Close");
         REGISTER_IPC(central_repo_server, redirect_msg_to_session, cen_rep_reset, "CenRep::Reset");
@@ -443,6 +493,11 @@ namespace eka2l1 {
         return load_repo(io, mngr, key);
     }
 
+    central_repo_server::~central_repo_server() {
+        // Changes may still be waiting for the idle timer. Don't lose them.
+        flush_changes();
+    }
+
     eka2l1::central_repo *central_repo_server::get_initial_repo(eka2l1::io_system *io,
         manager::device_manager *mngr, const std::uint32_t key) {
         // Load from cache first
@@ -461,6 +516,23 @@ namespace eka2l1 {
         return repo;
     }
 
+    void central_repo_server::schedule_flush() {
+        flusher.schedule();
+    }
+
+    void central_repo_server::flush_changes() {
+        flusher.cancel();
+
+        io_system *io = sys->get_io_system();
+        manager::device_manager *mngr = sys->get_manager_system()->get_device_manager();
+
+        for (auto &[key, repo] : repos) {
+            if (repo.flush_changes(io, mngr)) {
+                LOG_TRACE("Repo 0x{:X}: changes saved", key);
+            }
+        }
+    }
+
     void central_repo_client_session::handle_message(service::ipc_context *ctx) {
         switch (ctx->msg->function) {
         case cen_rep_init: {
@@ -568,9 +640,10 @@ namespace eka2l1 {
         }
 
         // Sensei, did i do it correct
-        // Save it and than wipe it out
-        repo_subsession.write_changes(io, mngr);
-        LOG_TRACE("Repo 0x{:X}: changes saved", repo_subsession.attach_repo->uid);
+        // Save it and than wipe it out. Nothing to write if the repo has not changed since the last save
+        if (repo_subsession.attach_repo->flush_changes(io, mngr)) {
+            LOG_TRACE("Repo 0x{:X}: changes saved", repo_subsession.attach_repo->uid);
+        }
 
         // Remove from attach
         auto &all_attached = repo_subsession.attach_repo->attached;
@@ -223,6 +223,10 @@ namespace eka2l1 {
             }
         }
 
+        if (seri.get_seri_mode() == common::SERI_MODE_READ) {
+            repo.sort_entries();
+        }
+
         if (repo.ver >= 1) {
             std::uint32_t deleted_settings_count = static_cast<std::uint32_t>(repo.deleted_settings.size());
             seri.absorb(deleted_settings_count);
@@ -268,9 +272,16 @@ namespace eka2l1 {
 
         f->write_file(&bufs[0], 1, static_cast<std::uint32_t>(bufs.size()));
         f->close();
+
+        dirty = false;
     }
 
-    void central_repo_client_subsession::write_changes(eka2l1::io_system *io, manager::device_manager *mngr) {
-        attach_repo->write_changes(io, mngr);
+    bool central_repo::flush_changes(eka2l1::io_system *io, manager::device_manager *mngr) {
+        if (!dirty) {
+            return false;
+        }
+
+        write_changes(io, mngr);
+        return true;
     }
 }
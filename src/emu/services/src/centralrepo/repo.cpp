@@ -50,6 +50,34 @@ namespace eka2l1 {
         return default_meta;
     }
 
+    static bool entry_key_less(const central_repo_entry &entry, const std::uint32_t key) {
+        return entry.key < key;
+    }
+
+    static bool key_entry_less(const std::uint32_t key, const central_repo_entry &entry) {
+        return key < entry.key;
+    }
+
+    static void insert_entry(std::vector<central_repo_entry> &entries, const central_repo_entry &entry) {
+        // Most entries come in key order from the files, so check the back first
+        if (entries.empty() || (entries.back().key < entry.key)) {
+            entries.push_back(entry);
+            return;
+        }
+
+        entries.insert(std::lower_bound(entries.begin(), entries.end(), entry.key, entry_key_less), entry);
+    }
+
+    void central_repo::sort_entries() {
+        auto compare_key = [](const central_repo_entry &lhs, const central_repo_entry &rhs) {
+            return lhs.key < rhs.key;
+        };
+
+        if (!std::is_sorted(entries.begin(), entries.end(), compare_key)) {
+            std::stable_sort(entries.begin(), entries.end(), compare_key);
+        }
+    }
+
     bool central_repo::add_new_entry(const std::uint32_t key, const central_repo_entry_variant &var) {
         if (find_entry(key)) {
             return false;
@@ -61,7 +89,7 @@ namespace eka2l1 {
         entry.key = key;
         entry.data = var;
 
-        entries.push_back(entry);
+        insert_entry(entries, entry);
 
         return true;
     }
@@ -78,31 +106,66 @@ namespace eka2l1 {
         entry.key = key;
         entry.data = var;
 
-        entries.push_back(entry);
+        insert_entry(entries, entry);
 
         return true;
     }
 
     central_repo_entry *central_repo::find_entry(const std::uint32_t key) {
-        auto ite = std::find_if(entries.begin(), entries.end(), [=](const central_repo_entry &e) {
-            return e.key == key;
-        });
+        auto ite = std::lower_bound(entries.begin(), entries.end(), key, entry_key_less);
 
-        if (ite == entries.end()) {
+        if ((ite == entries.end()) || (ite->key != key)) {
             return nullptr;
         }
 
         return &(*ite);
     }
 
+    void central_repo::find_entries_in_range(const std::uint32_t low_key, const std::uint32_t high_key,
+        std::vector<central_repo_entry *> &matched_entries) {
+        if (low_key > high_key) {
+            return;
+        }
+
+        auto ite = std::lower_bound(entries.begin(), entries.end(), low_key, entry_key_less);
+        auto end = std::upper_bound(ite, entries.end(), high_key, key_entry_less);
+
+        for (; ite != end; ite++) {
+            matched_entries.push_back(&(*ite));
+        }
+    }
+
+    void central_repo::find_entries_by_mask(const std::uint32_t partial_key, const std::uint32_t mask,
+        std::vector<central_repo_entry *> &matched_entries) {
+        const std::uint32_t low_key = partial_key & mask;
+        const std::uint32_t high_key = low_key | ~mask;
+
+        auto ite = std::lower_bound(entries.begin(), entries.end(), low_key, entry_key_less);
+        auto end = std::upper_bound(ite, entries.end(), high_key, key_entry_less);
+
+        for (; ite != end; ite++) {
+            if ((ite->key & mask) == low_key) {
+                matched_entries.push_back(&(*ite));
+            }
+        }
+    }
+
     void central_repo::query_entries(const std::uint32_t partial_key, const std::uint32_t mask,
         std::vector<central_repo_entry *> &matched_entries,
         const central_repo_entry_type etype) {
         std::uint32_t required_mask = mask & partial_key;
 
-        for (auto &entry : entries) {
-            if ((entry.key & required_mask) && (entry.data.etype == etype)) {
-                matched_entries.push_back(&entry);
+        if (!required_mask) {
+            return;
+        }
+
+        // A key can only share a bit with the required mask if it is at least as large as its lowest bit
+        const std::uint32_t lowest_key = required_mask & (~required_mask + 1);
+        auto ite = std::lower_bound(entries.begin(), entries.end(), lowest_key, entry_key_less);
+
+        for (; ite != entries.end(); ite++) {
+            if ((ite->key & required_mask) && (ite->data.etype == etype)) {
+                matched_entries.push_back(&(*ite));
             }
         }
     }
@@ -112,6 +175,14 @@ namespace eka2l1 {
         set_transaction_mode(central_repo_transaction_mode::read_write);
     }
 
+    void central_repo_client_subsession::mark_modified() {
+        attach_repo->mark_dirty();
+
+        if (server) {
+            server->schedule_flush();
+        }
+    }
+
     void central_repo_client_subsession::modification_success(const std::uint32_t key) {
         // Iters through all
         for (std::size_t i = 0; i < notifies.size(); i++) {
@@ -185,14 +256,7 @@ namespace eka2l1 {
         // If not in transaction, or if we are in transaction but read-mode
         // Directly get the repo data
         if (!active || mode == 0) {
-            auto result = std::find_if(attach_repo->entries.begin(), attach_repo->entries.end(),
-                [&](const central_repo_entry &entry) { return entry.key == key; });
-
-            if (result == attach_repo->entries.end()) {
-                return nullptr;
-            }
-
-            return &(*result);
+            return attach_repo->find_entry(key);
         }
 
         transactor.changes.emplace(key, central_repo_entry{});
@@ -285,8 +349,8 @@ namespace eka2l1 {
             return;
         }
 
-        // Write committed changes to disk
-        write_changes(io, mngr);
+        // Committed changes are written back to disk later
+        mark_modified();
         modification_success(key);
 
         ctx->complete(epoc::error_none);
@@ -346,6 +410,7 @@ namespace eka2l1 {
         }
 
         // Success in modifying
+        mark_modified();
         modification_success(entry->key);
         ctx->complete(epoc::error_none);
     }
@@ -451,13 +516,12 @@ namespace eka2l1 {
         // Set found count to 0
         found_uid_result_array[0] = 0;
 
-        for (auto &entry : attach_repo->entries) {
-            // Try to match the key first
-            if ((entry.key & filter->id_mask) != (filter->partial_key & filter->id_mask)) {
-                // Mask doesn't match, abandon this entry
-                continue;
-            }
+        // Only visit entries whose key matches the filter
+        std::vector<central_repo_entry *> matched_entries;
+        attach_repo->find_entries_by_mask(filter->partial_key, filter->id_mask, matched_entries);
 
+        for (central_repo_entry *matched_entry : matched_entries) {
+            central_repo_entry &entry = *matched_entry;
             std::uint32_t key_found = 0;
             bool find_not_eq = false;
 
@@ -18,9 +18,10 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include <cassert>
+#include <algorithm>
 #include <regex>
 
+#include <common/algorithm.h>
 #include <common/buffer.h>
 #include <common/chunkyseri.h>
 #include <common/cvt.h>
@@ -31,8 +32,11 @@
 #include <services/ecom/ecom.h>
 #include <vfs/vfs.h>
 
+#include <config/config.h>
 #include <epoc/epoc.h>
-#include <loader/spi.h>
+#include <kernel/kernel.h>
+#include <manager/device_manager.h>
+#include <manager/manager.h>
 #include <common/uid.h>
 
 #include <common/wildcard.h>
@@ -42,33 +46,54 @@
 #include <utils/err.h>
 
 namespace eka2l1 {
+    static bool compare_implementation_uid(const ecom_implementation_info_ptr &lhs, const ecom_implementation_info_ptr &rhs) {
+        return lhs->uid < rhs->uid;
+    }
+
     bool ecom_server::register_implementation(const std::uint32_t interface_uid,
         ecom_implementation_info_ptr &impl) {
         auto &interface = interfaces[interface_uid];
+        auto insert_pos = std::lower_bound(interface.implementations.begin(), interface.implementations.end(), impl,
+            compare_implementation_uid);
 
-        if (!std::binary_search(interface.implementations.begin(), interface.implementations.end(), impl,
-                [&](const ecom_implementation_info_ptr &impl1, const ecom_implementation_info_ptr &impl2) { return impl1->uid < impl2->uid; })) {
-            interface.implementations.push_back(impl);
-            implementations.push_back(impl);
+        if ((insert_pos != interface.implementations.end()) && ((*insert_pos)->uid == impl->uid)) {
+            return false;
+        }
 
-            // Sort
-            std::sort(interface.implementations.begin(), interface.implementations.end(),
-                [](const ecom_implementation_info_ptr &lhs, const ecom_implementation_info_ptr &rhs) {
-                    return lhs->uid < rhs->uid;
-                });
+        // Both lists stay sorted by UID
+        interface.implementations.insert(insert_pos, impl);
+        implementations.insert(std::upper_bound(implementations.begin(), implementations.end(), impl, compare_implementation_uid),
+            impl);
 
-            std::sort(implementations.begin(), implementations.end(),
-                [](const ecom_implementation_info_ptr &lhs, const ecom_implementation_info_ptr &rhs) {
-                    return lhs->uid < rhs->uid;
-                });
+        return true;
+    }
 
-            return true;
+    void ecom_server::install_record(const ecom_plugin_record &record) {
+        for (const ecom_interface_info &pinterface : record.interfaces_) {
+            // Get from the current interface on server
+            auto &interface_on_server = interfaces[pinterface.uid];
+            interface_on_server.uid = pinterface.uid;
+
+            for (ecom_implementation_info_ptr impl : pinterface.implementations) {
+                if (!register_implementation(pinterface.uid, impl)) {
+                    LOG_WARN("Implementation 0x{:X} from {} is already registered", impl->uid, common::ucs2_to_utf8(record.path_));
+                }
+            }
         }
+    }
 
-        return false;
+    void ecom_server::reinstall_records() {
+        interfaces.clear();
+        implementations.clear();
+
+        for (const std::u16string &source : sources) {
+            if (ecom_plugin_record *record = registry_cache->get_record(source)) {
+                install_record(*record);
+            }
+        }
     }
 
-    std::vector<std::string> ecom_server::get_ecom_plugin_archives(eka2l1::io_system *io) {
+    std::vector<entry_info> ecom_server::get_ecom_plugin_archives(eka2l1::io_system *io) {
         std::u16string pattern = u"";
 
         // Get ROM drive first
@@ -93,62 +118,19 @@ namespace eka2l1 {
             return {};
         }
 
-        std::vector<std::string> results;
+        std::vector<entry_info> results;
 
         while (auto entry = ecom_private_dir->get_next_entry()) {
             if (utils::is_file_compatible_with_language(entry->full_path, ".spi", sys->get_system_language())) {
-                results.push_back(entry->full_path);
+                results.push_back(std::move(entry.value()));
             }
         }
 
         return results;
     }
 
-    bool ecom_server::load_and_install_plugin_from_buffer(const std::u16string &name, std::uint8_t *buf, const std::size_t size,
-        const drive_number drv) {
-        common::ro_buf_stream stream(buf, size);
-        loader::rsc_file rsc(reinterpret_cast<common::ro_stream *>(&stream));
-
-        ecom_plugin plugin;
-
-        bool result = load_plugin(rsc, plugin);
-
-        if (!result) {
-            return false;
-        }
-
-        for (auto &pinterface : plugin.interfaces) {
-            // Get from the current interface on server
-            auto &interface_on_server = interfaces[pinterface.uid];
-            interface_on_server.uid = pinterface.uid;
-
-            for (auto &impl : pinterface.implementations) {
-                impl->drv = drv;
-                impl->original_name = eka2l1::replace_extension(eka2l1::filename(name), u"");
-
-                if (impl->original_name.back() == u'\0') {
-                    impl->original_name.pop_back();
-                }
-
-                if (!register_implementation(pinterface.uid, impl)) {
-                    return false;
-                }
-            }
-
-            pinterface.implementations.clear();
-        }
-
-        return true;
-    }
-
     ecom_interface_info *ecom_server::get_interface(const epoc::uid interface_uid) {
-        if (!init) {
-            if (!load_plugins(sys->get_io_system())) {
-                LOG_ERROR("An error happens with initialization of ECom");
-            }
-
-            init = true;
-        }
+        refresh_plugins(sys->get_io_system());
 
         // First, lookup the interface
         auto interface_ite = interfaces.find(interface_uid);
@@ -162,13 +144,7 @@ namespace eka2l1 {
     }
 
     bool ecom_server::get_resolved_implementations(std::vector<ecom_implementation_info_ptr> &collect_vector, const epoc::uid interface_uid, const ecom_resolver_params &params, const bool generic_wildcard_match) {
-        if (!init) {
-            if (!load_plugins(sys->get_io_system())) {
-                LOG_ERROR("An error happens with initialization of ECom");
-            }
-
-            init = true;
-        }
+        refresh_plugins(sys->get_io_system());
 
          // First, lookup the interface
         auto interface_ite = interfaces.find(interface_uid);
@@ -238,59 +214,50 @@ namespace eka2l1 {
         return true;
     }
 
-    bool ecom_server::load_archives(eka2l1::io_system *io) {
-        std::vector<std::string> archives = get_ecom_plugin_archives(io);
-
-        for (const std::string &archive : archives) {
-            const drive_number drv = char16_to_drive(archive[0]);
-
-            symfile f = io->open_file(common::utf8_to_ucs2(archive), READ_MODE | BIN_MODE);
-            std::vector<std::uint8_t> buf;
-            buf.resize(f->size());
+    ecom_plugin_record *ecom_server::get_plugin_record(eka2l1::io_system *io, const entry_info &source, const bool archive,
+        std::vector<ecom_plugin_parse_job> *jobs) {
+        const std::u16string path = common::utf8_to_ucs2(source.full_path);
 
-            f->read_file(&buf[0], static_cast<std::uint32_t>(buf.size()), 1);
-            f->close();
-
-            common::chunkyseri seri(buf.data(), buf.size(), common::SERI_MODE_READ);
-            loader::spi_file spi(0);
+        if (ecom_plugin_record *record = registry_cache->get_up_to_date_record(path, source.last_write, source.size)) {
+            return record;
+        }
 
-            bool result = spi.do_state(seri);
+        symfile f = io->open_file(path, READ_MODE | BIN_MODE);
 
-            if (!result) {
-                LOG_TRACE("SPI file {} corrupted!", archive);
-                return false;
-            }
+        if (!f) {
+            LOG_ERROR("Can't open plugin source {}", source.full_path);
+            return nullptr;
+        }
 
-            for (auto &entry : spi.entries) {
-                result = load_and_install_plugin_from_buffer(
-                    common::utf8_to_ucs2(entry.name), &entry.file[0], entry.file.size(), drv);
+        ecom_plugin_parse_job job;
+        job.data_.resize(f->size());
 
-                if (!result) {
-                    LOG_WARN("Can't load and install plugin \"{}\"", entry.name);
-                }
-            }
+        if (!job.data_.empty()) {
+            f->read_file(&job.data_[0], static_cast<std::uint32_t>(job.data_.size()), 1);
         }
 
-        return true;
-    }
+        f->close();
 
-    bool ecom_server::load_plugins(eka2l1::io_system *io) {
-        // Load archives first
-        if (!load_archives(io)) {
-            return false;
+        job.record_.path_ = path;
+        job.record_.drv_ = char16_to_drive(path[0]);
+        job.record_.last_write_ = source.last_write;
+        job.record_.size_ = source.size;
+        job.record_.archive_ = archive;
+
+        if (jobs) {
+            jobs->push_back(std::move(job));
+            return nullptr;
         }
 
-        for (drive_number drv = drive_a; drv <= drive_z; drv = (drive_number)((int)drv + 1)) {
-            if (io->get_drive_entry(drv)) {
-                // Load and ignore invalid plugins
-                load_plugin_on_drive(io, drv);
-            }
+        if (!parse_ecom_plugin_source(job.record_, job.data_.data(), job.data_.size())) {
+            LOG_ERROR("Can't load plugins description {}", source.full_path);
         }
 
-        return true;
+        // Still keep the record of invalid sources, so they are not parsed again until changed
+        return &registry_cache->add_record(std::move(job.record_));
     }
 
-    bool ecom_server::load_plugin_on_drive(eka2l1::io_system *io, const drive_number drv) {
+    std::vector<entry_info> ecom_server::get_plugin_resources_on_drive(eka2l1::io_system *io, const drive_number drv) {
         // Opening directory
         std::u16string plugin_dir_path;
         plugin_dir_path += drive_to_char16(drv);
@@ -301,38 +268,181 @@ namespace eka2l1 {
             LOG_TRACE("Plugins directory for drive {} not found!",
                 static_cast<char>(plugin_dir_path[0]));
 
-            return false;
+            return {};
         }
 
+        std::vector<entry_info> results;
+
         while (auto entry = plugin_dir->get_next_entry()) {
-            symfile f = io->open_file(common::utf8_to_ucs2(entry->full_path), READ_MODE | BIN_MODE);
+            results.push_back(std::move(entry.value()));
+        }
+
+        return results;
+    }
 
-            assert(f);
+    bool ecom_server::load_plugins(eka2l1::io_system *io) {
+        if (!registry_cache) {
+            std::string cache_name = "default";
 
-            std::vector<std::uint8_t> dat;
-            dat.resize(f->size());
-            f->read_file(&dat[0], static_cast<std::uint32_t>(dat.size()), 1);
-            f->close();
+            if (manager::device *current_device = sys->get_manager_system()->get_device_manager()->get_current()) {
+                cache_name = common::lowercase_string(current_device->firmware_code);
+            }
 
-            if (!load_and_install_plugin_from_buffer(common::utf8_to_ucs2(entry->full_path), &dat[0], dat.size(), drv)) {
-                LOG_ERROR("Can't load and install plugins description {}", entry->name);
-                return false;
+            // Records made for one device mean nothing on another
+            registry_cache = std::make_unique<ecom_registry_cache>(eka2l1::add_path(kern->get_config()->storage,
+                "cache/ecom/" + cache_name + ".bin"));
+
+            registry_cache->load();
+        }
+
+        // Archives go first, than plugin resources from drive A to Z
+        std::vector<std::pair<entry_info, bool>> all_sources;
+
+        for (entry_info &archive : get_ecom_plugin_archives(io)) {
+            all_sources.emplace_back(std::move(archive), true);
+        }
+
+        for (drive_number drv = drive_a; drv <= drive_z; drv = (drive_number)((int)drv + 1)) {
+            if (io->get_drive_entry(drv)) {
+                for (entry_info &resource : get_plugin_resources_on_drive(io, drv)) {
+                    all_sources.emplace_back(std::move(resource), false);
+                }
+
+                watch_plugin_directory(io, drv);
             }
         }
 
-        // TODO: Register a notification to the server side
+        // Read the sources not in the cache, than parse them all at once on all cores
+        std::vector<ecom_plugin_parse_job> jobs;
+        sources.clear();
+
+        for (auto &[source, archive] : all_sources) {
+            get_plugin_record(io, source, archive, &jobs);
+            sources.push_back(common::utf8_to_ucs2(source.full_path));
+        }
+
+        LOG_TRACE("ECom plugin sources: {} total, {} not in registry cache", sources.size(), jobs.size());
+
+        parse_ecom_plugin_sources(jobs);
+
+        for (ecom_plugin_parse_job &job : jobs) {
+            registry_cache->add_record(std::move(job.record_));
+        }
+
+        registry_cache->retain_records(sources);
+        registry_cache->save();
 
+        reinstall_records();
         return true;
     }
 
-    void ecom_server::connect(service::ipc_context &ctx) {
+    void ecom_server::watch_plugin_directory(eka2l1::io_system *io, const drive_number drv) {
+        const std::optional<eka2l1::drive> drv_entry = io->get_drive_entry(drv);
+
+        // ROM never changes
+        if (!drv_entry || (drv_entry->media_type == drive_media::rom)) {
+            return;
+        }
+
+        const std::u16string base_dir = std::u16string(1, drive_to_char16(drv)) + u":\\Resource\\Plugins\\";
+
+        const std::int64_t watch = io->watch_directory(
+            base_dir, [this, base_dir](void *userdata, common::directory_changes &changes) {
+                on_plugin_directory_changes(base_dir, changes);
+            },
+            nullptr, common::directory_change_move | common::directory_change_last_write);
+
+        if (watch != -1) {
+            watchs.push_back(watch);
+        }
+    }
+
+    void ecom_server::on_plugin_directory_changes(const std::u16string &base, common::directory_changes &changes) {
+        // Called from the watcher thread. Changes are picked up on the next request instead.
+        const std::lock_guard<std::mutex> guard(changed_sources_lock);
+
+        for (auto &change : changes) {
+            if (change.filename_.empty()) {
+                continue;
+            }
+
+            changed_sources.push_back(eka2l1::add_path(base, common::utf8_to_ucs2(change.filename_)));
+        }
+    }
+
+    void ecom_server::apply_plugin_changes(eka2l1::io_system *io) {
+        std::vector<std::u16string> changed;
+
+        {
+            const std::lock_guard<std::mutex> guard(changed_sources_lock);
+            changed.swap(changed_sources);
+        }
+
+        if (changed.empty()) {
+            return;
+        }
+
+        bool reinstall = false;
+
+        for (const std::u16string &path : changed) {
+            const std::u16string ext = common::lowercase_ucs2_string(eka2l1::path_extension(path));
+
+            if ((ext.length() < 2) || (ext[1] != u'r')) {
+                continue;
+            }
+
+            auto source_ite = std::find_if(sources.begin(), sources.end(), [&](const std::u16string &source) {
+                return common::compare_ignore_case(source, path) == 0;
+            });
+
+            std::optional<entry_info> source = io->get_entry_info(path);
+
+            if (!source || (source->type == io_component_type::dir)) {
+                // Deleted or moved away
+                if (source_ite != sources.end()) {
+                    sources.erase(source_ite);
+                    registry_cache->remove_record(path);
+
+                    reinstall = true;
+                }
+
+                continue;
+            }
+
+            if (!get_plugin_record(io, source.value(), false, nullptr)) {
+                continue;
+            }
+
+            if (source_ite == sources.end()) {
+                sources.push_back(path);
+            }
+
+            reinstall = true;
+        }
+
+        if (reinstall) {
+            LOG_TRACE("ECom plugin resources changed, updating the registry");
+
+            registry_cache->save();
+            reinstall_records();
+        }
+    }
+
+    void ecom_server::refresh_plugins(eka2l1::io_system *io) {
         if (!init) {
-            if (!load_plugins(ctx.sys->get_io_system())) {
+            if (!load_plugins(io)) {
                 LOG_ERROR("An error happens with initialization of ECom");
             }
+
+            init = true;
+            return;
         }
 
-        init = true;
+        apply_plugin_changes(io);
+    }
+
+    void ecom_server::connect(service::ipc_context &ctx) {
+        refresh_plugins(ctx.sys->get_io_system());
 
         create_session<ecom_session>(&ctx);
         ctx.complete(epoc::error_none);
@@ -583,4 +693,12 @@ namespace eka2l1 {
     ecom_server::ecom_server(eka2l1::system *sys)
         : service::typical_server(sys, "!ecomserver") {
     }
+
+    ecom_server::~ecom_server() {
+        io_system *io = sys->get_io_system();
+
+        for (const std::int64_t watch : watchs) {
+            io->unwatch_directory(watch);
+        }
+    }
 }
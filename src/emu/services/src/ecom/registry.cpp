@@ -0,0 +1,356 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <services/ecom/registry.h>
+
+#include <common/algorithm.h>
+#include <common/buffer.h>
+#include <common/chunkyseri.h>
+#include <common/cvt.h>
+#include <common/log.h>
+#include <common/path.h>
+
+#include <loader/rsc.h>
+#include <loader/spi.h>
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <thread>
+
+namespace eka2l1 {
+    static constexpr std::uint32_t REGISTRY_CACHE_MAGIC = 0x47524345; // ECRG
+    static constexpr std::uint32_t REGISTRY_CACHE_VERSION = 1;
+
+    // Only flags that come from parsing the source are persisted
+    static constexpr std::uint32_t REGISTRY_CACHE_IMPL_FLAGS = ecom_implementation_info::FLAG_ROM_ONLY
+        | ecom_implementation_info::FLAG_HINT_NO_EXTENDED_INTERFACE;
+
+    static bool parse_plugin_into_record(ecom_plugin_record &record, const std::u16string &name, std::uint8_t *data,
+        const std::size_t size) {
+        common::ro_buf_stream stream(data, size);
+        loader::rsc_file rsc(reinterpret_cast<common::ro_stream *>(&stream));
+
+        ecom_plugin plugin;
+
+        if (!load_plugin(rsc, plugin)) {
+            return false;
+        }
+
+        std::u16string original_name = eka2l1::replace_extension(eka2l1::filename(name), u"");
+
+        if (!original_name.empty() && (original_name.back() == u'\0')) {
+            original_name.pop_back();
+        }
+
+        for (auto &pinterface : plugin.interfaces) {
+            for (auto &impl : pinterface.implementations) {
+                impl->drv = record.drv_;
+                impl->original_name = original_name;
+            }
+
+            record.interfaces_.push_back(std::move(pinterface));
+        }
+
+        return true;
+    }
+
+    bool parse_ecom_plugin_source(ecom_plugin_record &record, std::uint8_t *data, const std::size_t size) {
+        if (!data || !size) {
+            return false;
+        }
+
+        if (!record.archive_) {
+            return parse_plugin_into_record(record, record.path_, data, size);
+        }
+
+        common::chunkyseri seri(data, size, common::SERI_MODE_READ);
+        loader::spi_file spi(0);
+
+        if (!spi.do_state(seri)) {
+            return false;
+        }
+
+        bool result = true;
+
+        for (auto &entry : spi.entries) {
+            if (entry.file.empty() || !parse_plugin_into_record(record, common::utf8_to_ucs2(entry.name), &entry.file[0], entry.file.size())) {
+                LOG_WARN("Can't load plugin \"{}\" in archive {}", entry.name, common::ucs2_to_utf8(record.path_));
+                result = false;
+            }
+        }
+
+        return result;
+    }
+
+    void parse_ecom_plugin_sources(std::vector<ecom_plugin_parse_job> &jobs) {
+        if (jobs.empty()) {
+            return;
+        }
+
+        std::atomic<std::size_t> next_job{ 0 };
+
+        auto parse_jobs = [&]() {
+            std::size_t i = 0;
+
+            while ((i = next_job++) < jobs.size()) {
+                ecom_plugin_parse_job &job = jobs[i];
+
+                if (!parse_ecom_plugin_source(job.record_, job.data_.data(), job.data_.size())) {
+                    LOG_ERROR("Can't load plugins description {}", common::ucs2_to_utf8(job.record_.path_));
+                }
+
+                job.data_ = std::vector<std::uint8_t>{};
+            }
+        };
+
+        const std::size_t thread_count = common::min<std::size_t>(jobs.size(),
+            common::max<std::size_t>(std::thread::hardware_concurrency(), 1));
+
+        // The calling thread takes jobs too
+        std::vector<std::thread> workers;
+
+        for (std::size_t i = 1; i < thread_count; i++) {
+            workers.emplace_back(parse_jobs);
+        }
+
+        parse_jobs();
+
+        for (std::thread &worker : workers) {
+            worker.join();
+        }
+    }
+
+    static void absorb_implementation(common::chunkyseri &seri, ecom_implementation_info &impl) {
+        seri.absorb(impl.uid);
+        seri.absorb(impl.version);
+        seri.absorb(impl.format);
+
+        std::uint32_t flags = impl.flags & REGISTRY_CACHE_IMPL_FLAGS;
+        seri.absorb(flags);
+
+        std::uint32_t drv32 = static_cast<std::uint32_t>(impl.drv);
+        seri.absorb(drv32);
+
+        if (seri.get_seri_mode() == common::SERI_MODE_READ) {
+            impl.flags = flags & REGISTRY_CACHE_IMPL_FLAGS;
+            impl.drv = static_cast<drive_number>(drv32);
+        }
+
+        seri.absorb(impl.original_name);
+        seri.absorb(impl.display_name);
+        seri.absorb(impl.default_data);
+        seri.absorb(impl.opaque_data);
+        seri.absorb_container(impl.extended_interfaces);
+    }
+
+    static void absorb_record(common::chunkyseri &seri, ecom_plugin_record &record) {
+        seri.absorb(record.path_);
+
+        std::uint32_t drv32 = static_cast<std::uint32_t>(record.drv_);
+        seri.absorb(drv32);
+
+        std::uint8_t archive = record.archive_;
+        seri.absorb(archive);
+
+        if (seri.get_seri_mode() == common::SERI_MODE_READ) {
+            record.drv_ = static_cast<drive_number>(drv32);
+            record.archive_ = static_cast<bool>(archive);
+        }
+
+        seri.absorb(record.last_write_);
+        seri.absorb(record.size_);
+
+        seri.absorb_container(record.interfaces_, [](common::chunkyseri &seri, ecom_interface_info &interface) {
+            seri.absorb(interface.uid);
+            seri.absorb_container(interface.implementations, [](common::chunkyseri &seri, ecom_implementation_info_ptr &impl) {
+                if (seri.get_seri_mode() == common::SERI_MODE_READ) {
+                    impl = std::make_shared<ecom_implementation_info>();
+                }
+
+                absorb_implementation(seri, *impl);
+            });
+        });
+    }
+
+    static void absorb_records(common::chunkyseri &seri, std::vector<ecom_plugin_record> &records) {
+        std::uint32_t magic = REGISTRY_CACHE_MAGIC;
+        std::uint32_t version = REGISTRY_CACHE_VERSION;
+
+        seri.absorb(magic);
+        seri.absorb(version);
+
+        if ((magic != REGISTRY_CACHE_MAGIC) || (version != REGISTRY_CACHE_VERSION)) {
+            return;
+        }
+
+        seri.absorb_container(records, absorb_record);
+
+        // Catches files cut short, the read past the end leaves this untouched
+        std::uint32_t end_magic = (seri.get_seri_mode() == common::SERI_MODE_READ) ? 0 : REGISTRY_CACHE_MAGIC;
+        seri.absorb(end_magic);
+
+        if (end_magic != REGISTRY_CACHE_MAGIC) {
+            records.clear();
+        }
+    }
+
+    ecom_registry_cache::ecom_registry_cache(const std::string &path)
+        : path_(path)
+        , dirty_(false) {
+    }
+
+    bool ecom_registry_cache::load() {
+        std::ifstream cache_file(path_, std::ios::binary | std::ios::ate);
+
+        if (!cache_file) {
+            return false;
+        }
+
+        std::vector<std::uint8_t> buf(static_cast<std::size_t>(cache_file.tellg()));
+
+        if (buf.empty()) {
+            return false;
+        }
+
+        cache_file.seekg(0, std::ios::beg);
+        cache_file.read(reinterpret_cast<char *>(buf.data()), buf.size());
+
+        if (!cache_file) {
+            return false;
+        }
+
+        std::vector<ecom_plugin_record> records;
+
+        common::chunkyseri seri(buf.data(), buf.size(), common::SERI_MODE_READ);
+        absorb_records(seri, records);
+
+        records_.clear();
+        dirty_ = false;
+
+        if (records.empty()) {
+            return false;
+        }
+
+        for (ecom_plugin_record &record : records) {
+            const std::u16string key = common::lowercase_ucs2_string(record.path_);
+            records_.emplace(key, std::move(record));
+        }
+
+        return true;
+    }
+
+    bool ecom_registry_cache::save() {
+        if (!dirty_) {
+            return true;
+        }
+
+        std::vector<ecom_plugin_record> records;
+        records.reserve(records_.size());
+
+        for (auto &[key, record] : records_) {
+            records.push_back(record);
+        }
+
+        std::vector<std::uint8_t> buf;
+
+        {
+            common::chunkyseri seri(nullptr, 0, common::SERI_MODE_MEASURE);
+            absorb_records(seri, records);
+
+            buf.resize(seri.size());
+        }
+
+        common::chunkyseri seri(buf.data(), buf.size(), common::SERI_MODE_WRITE);
+        absorb_records(seri, records);
+
+        eka2l1::create_directories(eka2l1::file_directory(path_));
+        std::ofstream cache_file(path_, std::ios::binary);
+
+        if (!cache_file) {
+            LOG_ERROR("Can't write ECom registry cache to {}", path_);
+            return false;
+        }
+
+        cache_file.write(reinterpret_cast<const char *>(buf.data()), buf.size());
+
+        if (!cache_file) {
+            return false;
+        }
+
+        dirty_ = false;
+        return true;
+    }
+
+    ecom_plugin_record *ecom_registry_cache::get_record(const std::u16string &path) {
+        auto result = records_.find(common::lowercase_ucs2_string(path));
+
+        if (result == records_.end()) {
+            return nullptr;
+        }
+
+        return &result->second;
+    }
+
+    ecom_plugin_record *ecom_registry_cache::get_up_to_date_record(const std::u16string &path, const std::uint64_t last_write,
+        const std::uint64_t size) {
+        ecom_plugin_record *record = get_record(path);
+
+        if (!record || (record->last_write_ != last_write) || (record->size_ != size)) {
+            return nullptr;
+        }
+
+        return record;
+    }
+
+    ecom_plugin_record &ecom_registry_cache::add_record(ecom_plugin_record &&record) {
+        const std::u16string key = common::lowercase_ucs2_string(record.path_);
+        dirty_ = true;
+
+        return records_.insert_or_assign(key, std::move(record)).first->second;
+    }
+
+    bool ecom_registry_cache::remove_record(const std::u16string &path) {
+        if (records_.erase(common::lowercase_ucs2_string(path))) {
+            dirty_ = true;
+            return true;
+        }
+
+        return false;
+    }
+
+    void ecom_registry_cache::retain_records(const std::vector<std::u16string> &paths) {
+        std::vector<std::u16string> keys;
+
+        for (const std::u16string &path : paths) {
+            keys.push_back(common::lowercase_ucs2_string(path));
+        }
+
+        std::sort(keys.begin(), keys.end());
+
+        for (auto ite = records_.begin(); ite != records_.end();) {
+            if (!std::binary_search(keys.begin(), keys.end(), ite->first)) {
+                ite = records_.erase(ite);
+                dirty_ = true;
+            } else {
+                ite++;
+            }
+        }
+    }
+}
@@ -298,11 +298,13 @@ namespace eka2l1::epoc::adapter {
         }
 
         // In case this adapter get destroyed. It will free this data.
+        const std::lock_guard<std::mutex> guard(lock_);
         dynamic_alloc_list_.push_back(compressed_bitmap);
         return reinterpret_cast<std::uint8_t*>(compressed_bitmap);
     }
 
     void gdr_font_file_adapter::free_glyph_bitmap(std::uint8_t *data) {
+        const std::lock_guard<std::mutex> guard(lock_);
         auto store_result = std::find(dynamic_alloc_list_.begin(), dynamic_alloc_list_.end(), reinterpret_cast<std::uint32_t*>(data));
 
         if (store_result != dynamic_alloc_list_.end()) {
@@ -320,6 +322,7 @@ namespace eka2l1::epoc::adapter {
         context.pack_dest_ = atlas_ptr;
         context.pack_size_ = atlas_size;
 
+        const std::lock_guard<std::mutex> guard(lock_);
         return static_cast<std::int32_t>(pack_contexts_.add(context));
     }
 
@@ -329,6 +332,8 @@ namespace eka2l1::epoc::adapter {
 
     bool gdr_font_file_adapter::get_glyph_atlas(const std::int32_t handle, const std::size_t idx, const char16_t start_code, int *unicode_point, const char16_t num_code,
         const int font_size, character_info *info) {
+        // Contexts are kept by value, hold the lock so they don't move while packing
+        const std::lock_guard<std::mutex> guard(lock_);
         gdr_font_atlas_pack_context *context = pack_contexts_.get(handle);
 
         if (!context) {
@@ -417,6 +422,7 @@ namespace eka2l1::epoc::adapter {
     }
 
     void gdr_font_file_adapter::end_get_atlas(const std::int32_t handle) {
+        const std::lock_guard<std::mutex> guard(lock_);
         pack_contexts_.remove(handle);
     }
 }
\ No newline at end of file
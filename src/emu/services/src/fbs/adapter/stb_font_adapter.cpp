@@ -54,6 +54,8 @@ namespace eka2l1::epoc::adapter {
         }
 
         *off = stbtt_GetFontOffsetForIndex(&data_[0], static_cast<int>(idx));
+
+        const std::lock_guard<std::mutex> guard(lock_);
         auto result = cache_info.find(*off);
 
         if (result != cache_info.end()) {
@@ -286,23 +288,32 @@ namespace eka2l1::epoc::adapter {
             return -1;
         }
 
+        const std::lock_guard<std::mutex> guard(lock_);
         return static_cast<std::int32_t>(contexts_.add(context));
     }
 
     void stb_font_file_adapter::end_get_atlas(const std::int32_t handle) {
+        const std::lock_guard<std::mutex> guard(lock_);
         contexts_.remove(static_cast<std::size_t>(handle));
     }
 
     bool stb_font_file_adapter::get_glyph_atlas(const std::int32_t handle, const std::size_t idx, const char16_t start_code, int *unicode_point,
         const char16_t num_code, const int font_size, character_info *info) {
         auto character_infos = std::make_unique<stbtt_packedchar[]>(num_code);
-        std::unique_ptr<stbtt_pack_context> *context_ptr = contexts_.get(handle);
+        stbtt_pack_context *context = nullptr;
 
-        if (!context_ptr) {
-            return false;
+        {
+            // The context is only used by the thread that began it, it can be packed outside of the lock
+            const std::lock_guard<std::mutex> guard(lock_);
+            std::unique_ptr<stbtt_pack_context> *context_ptr = contexts_.get(handle);
+
+            if (!context_ptr) {
+                return false;
+            }
+
+            context = context_ptr->get();
         }
 
-        stbtt_pack_context *context = context_ptr->get();
         stbtt_PackSetOversampling(context, 2, 2);
 
         stbtt_pack_range range;
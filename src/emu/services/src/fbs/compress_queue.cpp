@@ -184,6 +184,9 @@ namespace eka2l1 {
         clean_bitmap->bitmap_->data_offset_ = static_cast<int>(new_data - data_base);
         clean_bitmap->bitmap_->header_.bitmap_size = static_cast<std::uint32_t>(estimated_size + sizeof(loader::sbm_header));
 
+        serv_->touch_bitmap(clean_bitmap->bitmap_);
+        serv_->mark_bitmap_guest_writable(clean_bitmap->bitmap_);
+
         // Notify dirty bitmaps
         {
             const std::lock_guard<std::mutex> guard(notify_mutex_);
@@ -357,6 +357,12 @@ namespace eka2l1 {
             compressor = std::make_unique<compress_queue>(this);
             compressor_thread = std::make_unique<std::thread>(compressor_thread_func, compressor.get());
         }
+
+        // Create glyph rasterizer threads
+        if (sys->get_config()->fbs_glyph_rasterizer_threads != 0) {
+            glyph_prerasterizer = std::make_unique<epoc::glyph_prerasterize_pool>(&open_font_glyph_bitmap_cache,
+                &open_font_glyph_cache, sys->get_config()->fbs_glyph_rasterizer_threads);
+        }
     }
 
     void fbs_server::connect(service::ipc_context &context) {
@@ -415,6 +421,10 @@ namespace eka2l1 {
             compressor_thread->join();
         }
 
+        if (glyph_prerasterizer) {
+            glyph_prerasterizer->abort();
+        }
+
         clear_all_sessions();
 
         // Destroy chunks.
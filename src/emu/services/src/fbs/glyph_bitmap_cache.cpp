@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <services/fbs/glyph_bitmap_cache.h>
+
+#include <common/hash.h>
+
+namespace eka2l1::epoc {
+    std::size_t glyph_bitmap_key_hash::operator()(const glyph_bitmap_key &key) const noexcept {
+        std::size_t seed = 0x676C7970;
+
+        common::hash_combine(seed, key.adapter_);
+        common::hash_combine(seed, key.typeface_idx_);
+        common::hash_combine(seed, key.scale_x_);
+        common::hash_combine(seed, key.scale_y_);
+        common::hash_combine(seed, key.code_);
+
+        return seed;
+    }
+
+    glyph_bitmap_cache::glyph_bitmap_cache(const std::size_t max_bytes_)
+        : max_bytes(max_bytes_) {
+    }
+
+    static rasterized_glyph_ptr rasterize_glyph(adapter::font_file_adapter_base *adapter, const std::size_t typeface_idx,
+        const float scale_x, const float scale_y, const std::uint32_t code) {
+        std::shared_ptr<rasterized_glyph> glyph = std::make_shared<rasterized_glyph>();
+        std::uint32_t data_size = 0;
+
+        std::uint8_t *data = adapter->get_glyph_bitmap(typeface_idx, code, scale_x, scale_y, &glyph->width_,
+            &glyph->height_, data_size, &glyph->bitmap_type_);
+
+        if (!data && !adapter->does_glyph_exist(typeface_idx, code)) {
+            return glyph;
+        }
+
+        if (data) {
+            glyph->data_.assign(data, data + data_size);
+            adapter->free_glyph_bitmap(data);
+        }
+
+        glyph->metric_ = open_font_character_metric{};
+        adapter->get_glyph_metric(typeface_idx, code, glyph->metric_, 0, scale_x, scale_y);
+
+        glyph->exists_ = true;
+        return glyph;
+    }
+
+    void glyph_bitmap_cache::add(const glyph_bitmap_key &key, rasterized_glyph_ptr &glyph) {
+        auto result = glyphs.emplace(key, glyph);
+
+        if (!result.second) {
+            // Another thread rasterized it first. Share that one
+            glyph = result.first->second;
+            return;
+        }
+
+        insert_order.push_back(key);
+        total_bytes += glyph->data_.size();
+
+        // Always keep the glyph just added
+        while ((total_bytes > max_bytes) && (insert_order.size() > 1)) {
+            auto oldest = glyphs.find(insert_order.front());
+
+            total_bytes -= oldest->second->data_.size();
+            glyphs.erase(oldest);
+
+            insert_order.pop_front();
+        }
+    }
+
+    rasterized_glyph_ptr glyph_bitmap_cache::get(const glyph_bitmap_key &key) const {
+        const std::lock_guard<std::mutex> guard(lock);
+        auto result = glyphs.find(key);
+
+        if (result == glyphs.end()) {
+            return nullptr;
+        }
+
+        return result->second;
+    }
+
+    rasterized_glyph_ptr glyph_bitmap_cache::get_or_rasterize(adapter::font_file_adapter_base *adapter, const std::size_t typeface_idx,
+        const float scale_x, const float scale_y, const std::uint32_t code) {
+        const glyph_bitmap_key key{ adapter, typeface_idx, scale_x, scale_y, code };
+        rasterized_glyph_ptr glyph = get(key);
+
+        if (glyph) {
+            return glyph;
+        }
+
+        glyph = rasterize_glyph(adapter, typeface_idx, scale_x, scale_y, code);
+
+        const std::lock_guard<std::mutex> guard(lock);
+        add(key, glyph);
+
+        return glyph;
+    }
+}
@@ -0,0 +1,501 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <drivers/graphics/graphics.h>
+#include <services/fbs/glyph_cache.h>
+
+#include <common/algorithm.h>
+#include <common/hash.h>
+#include <common/log.h>
+
+#include <algorithm>
+
+namespace eka2l1::epoc {
+    // Number of glyphs rasterized by the adapter in one go
+    static constexpr std::size_t MAX_RASTERIZE_BATCH = 128;
+
+    std::size_t glyph_cache_key_hash::operator()(const glyph_cache_key &key) const noexcept {
+        std::size_t seed = 0x61797068;
+
+        common::hash_combine(seed, key.adapter_);
+        common::hash_combine(seed, key.typeface_idx_);
+        common::hash_combine(seed, key.size_);
+        common::hash_combine(seed, key.code_);
+
+        return seed;
+    }
+
+    static void add_dirty_area(eka2l1::rect &dirty, const eka2l1::rect &area) {
+        if (dirty.empty()) {
+            dirty = area;
+            return;
+        }
+
+        const eka2l1::vec2 start = { common::min(dirty.top.x, area.top.x), common::min(dirty.top.y, area.top.y) };
+        const eka2l1::vec2 end = { common::max(dirty.top.x + dirty.size.x, area.top.x + area.size.x),
+            common::max(dirty.top.y + dirty.size.y, area.top.y + area.size.y) };
+
+        dirty = eka2l1::rect(start, end - start);
+    }
+
+    glyph_cache::glyph_cache(const int page_size_, const std::size_t max_page_count_)
+        : lru_head(INVALID_SLOT)
+        , lru_tail(INVALID_SLOT)
+        , page_size(page_size_)
+        , max_page_count(max_page_count_) {
+    }
+
+    void glyph_cache::lru_unlink(const std::uint32_t slot) {
+        entry &ent = entries[slot];
+
+        if (ent.prev_ != INVALID_SLOT) {
+            entries[ent.prev_].next_ = ent.next_;
+        } else {
+            lru_head = ent.next_;
+        }
+
+        if (ent.next_ != INVALID_SLOT) {
+            entries[ent.next_].prev_ = ent.prev_;
+        } else {
+            lru_tail = ent.prev_;
+        }
+
+        ent.prev_ = INVALID_SLOT;
+        ent.next_ = INVALID_SLOT;
+    }
+
+    void glyph_cache::lru_push_front(const std::uint32_t slot) {
+        entry &ent = entries[slot];
+
+        ent.prev_ = INVALID_SLOT;
+        ent.next_ = lru_head;
+
+        if (lru_head != INVALID_SLOT) {
+            entries[lru_head].prev_ = slot;
+        } else {
+            lru_tail = slot;
+        }
+
+        lru_head = slot;
+    }
+
+    bool glyph_cache::allocate_in_page(page &target, const int width, const int height, int &shelf_idx, int &x) {
+        int best_shelf = -1;
+        std::size_t best_span = 0;
+
+        // Pick the lowest shelf that has room, without wasting too much height
+        for (std::size_t i = 0; i < target.shelves_.size(); i++) {
+            const shelf &current = target.shelves_[i];
+
+            if ((current.height_ < height) || (current.height_ - height > common::max(4, height / 4))) {
+                continue;
+            }
+
+            if ((best_shelf != -1) && (target.shelves_[best_shelf].height_ <= current.height_)) {
+                continue;
+            }
+
+            for (std::size_t j = 0; j < current.free_spans_.size(); j++) {
+                if (current.free_spans_[j].width_ >= width) {
+                    best_shelf = static_cast<int>(i);
+                    best_span = j;
+
+                    break;
+                }
+            }
+        }
+
+        if (best_shelf != -1) {
+            std::vector<shelf_span> &spans = target.shelves_[best_shelf].free_spans_;
+
+            shelf_idx = best_shelf;
+            x = spans[best_span].x_;
+
+            spans[best_span].x_ += width;
+            spans[best_span].width_ -= width;
+
+            if (spans[best_span].width_ == 0) {
+                spans.erase(spans.begin() + best_span);
+            }
+
+            return true;
+        }
+
+        // Open a new shelf below the others
+        const int shelf_height = common::min(static_cast<int>(common::align(height, 4)), page_size);
+
+        if (target.next_shelf_y_ + shelf_height > page_size) {
+            return false;
+        }
+
+        shelf new_shelf;
+        new_shelf.y_ = target.next_shelf_y_;
+        new_shelf.height_ = shelf_height;
+
+        if (width < page_size) {
+            new_shelf.free_spans_.push_back({ width, page_size - width });
+        }
+
+        target.shelves_.push_back(std::move(new_shelf));
+        target.next_shelf_y_ += shelf_height;
+
+        shelf_idx = static_cast<int>(target.shelves_.size() - 1);
+        x = 0;
+
+        return true;
+    }
+
+    void glyph_cache::free_in_page(page &target, const int shelf_idx, const int x, const int width) {
+        std::vector<shelf_span> &spans = target.shelves_[shelf_idx].free_spans_;
+
+        auto ite = std::lower_bound(spans.begin(), spans.end(), x, [](const shelf_span &span, const int pos) {
+            return span.x_ < pos;
+        });
+
+        ite = spans.insert(ite, { x, width });
+
+        // Merge with the neighbour spans
+        if ((ite + 1 != spans.end()) && (ite->x_ + ite->width_ == (ite + 1)->x_)) {
+            ite->width_ += (ite + 1)->width_;
+            spans.erase(ite + 1);
+        }
+
+        if ((ite != spans.begin()) && ((ite - 1)->x_ + (ite - 1)->width_ == ite->x_)) {
+            (ite - 1)->width_ += ite->width_;
+            spans.erase(ite);
+        }
+
+        // Empty shelves at the bottom are given back, so their height can be used by any glyph
+        while (!target.shelves_.empty()) {
+            const shelf &last = target.shelves_.back();
+
+            if ((last.free_spans_.size() != 1) || (last.free_spans_[0].width_ != page_size)) {
+                break;
+            }
+
+            target.next_shelf_y_ = last.y_;
+            target.shelves_.pop_back();
+        }
+    }
+
+    bool glyph_cache::evict_one() {
+        if (lru_tail == INVALID_SLOT) {
+            return false;
+        }
+
+        const std::uint32_t slot = lru_tail;
+        entry &ent = entries[slot];
+
+        // Least recently used one is still in use, so is everything else
+        if (ent.use_serial_ == current_serial) {
+            return false;
+        }
+
+        lru_unlink(slot);
+        slot_lookup.erase(ent.key_);
+
+        if (ent.glyph_.page_ >= 0) {
+            free_in_page(pages[ent.glyph_.page_], ent.shelf_, ent.slot_x_, ent.slot_width_);
+        }
+
+        ent.glyph_.page_ = -1;
+        free_slots.push_back(slot);
+
+        stats.evictions_++;
+        return true;
+    }
+
+    bool glyph_cache::allocate(const int width, const int height, int &page_idx, int &shelf_idx, int &x) {
+        if ((width > page_size) || (height > page_size)) {
+            return false;
+        }
+
+        while (true) {
+            for (std::size_t i = 0; i < pages.size(); i++) {
+                if (allocate_in_page(pages[i], width, height, shelf_idx, x)) {
+                    page_idx = static_cast<int>(i);
+                    return true;
+                }
+            }
+
+            if (pages.size() < max_page_count) {
+                page new_page;
+                new_page.data_.resize(page_size * page_size, 0);
+
+                pages.push_back(std::move(new_page));
+                continue;
+            }
+
+            if (!evict_one()) {
+                return false;
+            }
+        }
+    }
+
+    bool glyph_cache::rasterize(adapter::font_file_adapter_base *adapter, const std::size_t typeface_idx, const int font_size,
+        std::vector<int> &codes, std::vector<adapter::character_info> &infos, std::vector<std::uint8_t> &buffer) {
+        // Adapters only write pixels the glyphs cover
+        buffer.assign(page_size * page_size, 0);
+
+        const std::int32_t handle = adapter->begin_get_atlas(buffer.data(), { page_size, page_size });
+
+        if (handle == -1) {
+            return false;
+        }
+
+        infos.resize(codes.size());
+
+        const bool result = adapter->get_glyph_atlas(handle, typeface_idx, 0, codes.data(), static_cast<char16_t>(codes.size()),
+            font_size, infos.data());
+
+        adapter->end_get_atlas(handle);
+        return result;
+    }
+
+    template <typename F>
+    void glyph_cache::rasterize_batches(adapter::font_file_adapter_base *adapter, const std::size_t typeface_idx, const int font_size,
+        const std::vector<int> &codes, std::vector<std::uint8_t> &buffer, F add_batch) {
+        std::vector<int> batch;
+        std::vector<adapter::character_info> infos;
+
+        for (std::size_t start = 0; start < codes.size(); start += MAX_RASTERIZE_BATCH) {
+            batch.assign(codes.begin() + start, codes.begin() + common::min(start + MAX_RASTERIZE_BATCH, codes.size()));
+
+            if (rasterize(adapter, typeface_idx, font_size, batch, infos, buffer)) {
+                add_batch(batch, infos);
+                continue;
+            }
+
+            // The batch did not fit the buffer. Go one by one
+            for (const int code : batch) {
+                std::vector<int> single_code = { code };
+
+                if (rasterize(adapter, typeface_idx, font_size, single_code, infos, buffer)) {
+                    add_batch(single_code, infos);
+                }
+            }
+        }
+    }
+
+    std::uint32_t glyph_cache::add_glyph(const glyph_cache_key &key, const adapter::character_info &source_info,
+        const std::vector<std::uint8_t> &source, const std::uint64_t use_serial) {
+        const int width = source_info.x1 - source_info.x0;
+        const int height = source_info.y1 - source_info.y0;
+
+        cached_glyph glyph;
+        glyph.info_ = source_info;
+
+        int shelf_idx = -1;
+        int slot_x = 0;
+        int slot_width = 0;
+
+        if ((width > 0) && (height > 0)) {
+            int page_idx = -1;
+            slot_width = width + GLYPH_PADDING;
+
+            if (!allocate(slot_width, height + GLYPH_PADDING, page_idx, shelf_idx, slot_x)) {
+                return INVALID_SLOT;
+            }
+
+            page &target = pages[page_idx];
+            const int slot_y = target.shelves_[shelf_idx].y_;
+
+            // Copy the glyph, and clear the padding left by whatever was there before
+            for (int y = 0; y < height + GLYPH_PADDING; y++) {
+                std::uint8_t *dest_row = target.data_.data() + (slot_y + y) * page_size + slot_x;
+
+                if (y < height) {
+                    const std::uint8_t *source_row = source.data() + (source_info.y0 + y) * page_size + source_info.x0;
+
+                    std::copy(source_row, source_row + width, dest_row);
+                    std::fill(dest_row + width, dest_row + slot_width, 0);
+                } else {
+                    std::fill(dest_row, dest_row + slot_width, 0);
+                }
+            }
+
+            add_dirty_area(target.dirty_, eka2l1::rect({ slot_x, slot_y }, { slot_width, height + GLYPH_PADDING }));
+
+            glyph.page_ = page_idx;
+            glyph.info_.x0 = static_cast<std::uint16_t>(slot_x);
+            glyph.info_.y0 = static_cast<std::uint16_t>(slot_y);
+            glyph.info_.x1 = static_cast<std::uint16_t>(slot_x + width);
+            glyph.info_.y1 = static_cast<std::uint16_t>(slot_y + height);
+        }
+
+        std::uint32_t slot = 0;
+
+        if (!free_slots.empty()) {
+            slot = free_slots.back();
+            free_slots.pop_back();
+        } else {
+            entries.emplace_back();
+            slot = static_cast<std::uint32_t>(entries.size() - 1);
+        }
+
+        entry &ent = entries[slot];
+        ent.key_ = key;
+        ent.glyph_ = glyph;
+        ent.shelf_ = shelf_idx;
+        ent.slot_x_ = slot_x;
+        ent.slot_width_ = slot_width;
+        ent.use_serial_ = use_serial;
+
+        lru_push_front(slot);
+        slot_lookup.emplace(key, slot);
+
+        return slot;
+    }
+
+    bool glyph_cache::get_glyphs(adapter::font_file_adapter_base *adapter, const std::size_t typeface_idx, const int font_size,
+        const std::u16string &text, std::vector<const cached_glyph *> &result) {
+        const std::lock_guard<std::mutex> guard(lock);
+        std::vector<int> missing;
+
+        for (const char16_t code : text) {
+            auto slot_ite = slot_lookup.find({ adapter, typeface_idx, font_size, code });
+
+            if (slot_ite == slot_lookup.end()) {
+                missing.push_back(code);
+                continue;
+            }
+
+            entry &ent = entries[slot_ite->second];
+
+            if (ent.use_serial_ != current_serial) {
+                lru_unlink(slot_ite->second);
+                lru_push_front(slot_ite->second);
+
+                ent.use_serial_ = current_serial;
+            }
+
+            stats.hits_++;
+        }
+
+        std::sort(missing.begin(), missing.end());
+        missing.erase(std::unique(missing.begin(), missing.end()), missing.end());
+
+        stats.misses_ += missing.size();
+
+        rasterize_batches(adapter, typeface_idx, font_size, missing, scratch, [&](const std::vector<int> &codes,
+                                                                                  const std::vector<adapter::character_info> &infos) {
+            for (std::size_t i = 0; i < codes.size(); i++) {
+                add_glyph({ adapter, typeface_idx, font_size, static_cast<char16_t>(codes[i]) }, infos[i], scratch, current_serial);
+            }
+        });
+
+        bool all_cached = true;
+        result.resize(text.length());
+
+        for (std::size_t i = 0; i < text.length(); i++) {
+            auto slot_ite = slot_lookup.find({ adapter, typeface_idx, font_size, text[i] });
+
+            if (slot_ite == slot_lookup.end()) {
+                result[i] = nullptr;
+                all_cached = false;
+            } else {
+                result[i] = &entries[slot_ite->second].glyph_;
+            }
+        }
+
+        return all_cached;
+    }
+
+    std::size_t glyph_cache::prerasterize(adapter::font_file_adapter_base *adapter, const std::size_t typeface_idx, const int font_size,
+        const std::u16string &text) {
+        std::vector<int> missing;
+
+        {
+            const std::lock_guard<std::mutex> guard(lock);
+
+            for (const char16_t code : text) {
+                if (slot_lookup.find({ adapter, typeface_idx, font_size, code }) == slot_lookup.end()) {
+                    missing.push_back(code);
+                }
+            }
+        }
+
+        std::sort(missing.begin(), missing.end());
+        missing.erase(std::unique(missing.begin(), missing.end()), missing.end());
+
+        std::vector<std::uint8_t> buffer;
+        std::size_t added = 0;
+
+        rasterize_batches(adapter, typeface_idx, font_size, missing, buffer, [&](const std::vector<int> &codes,
+                                                                                 const std::vector<adapter::character_info> &infos) {
+            const std::lock_guard<std::mutex> guard(lock);
+
+            for (std::size_t i = 0; i < codes.size(); i++) {
+                const glyph_cache_key key{ adapter, typeface_idx, font_size, static_cast<char16_t>(codes[i]) };
+
+                // Serial 0 is never in use, prerasterized glyphs can be evicted right away if needed
+                if ((slot_lookup.find(key) == slot_lookup.end()) && (add_glyph(key, infos[i], buffer, 0) != INVALID_SLOT)) {
+                    added++;
+                }
+            }
+        });
+
+        return added;
+    }
+
+    void glyph_cache::flush(drivers::graphics_driver *driver, drivers::graphics_command_list_builder *builder) {
+        const std::lock_guard<std::mutex> guard(lock);
+
+        for (page &target : pages) {
+            if (!target.bitmap_) {
+                target.bitmap_ = drivers::create_bitmap(driver, { page_size, page_size });
+
+                if (!target.bitmap_) {
+                    LOG_ERROR("Unable to create glyph page bitmap");
+                    continue;
+                }
+
+                // Content of a new bitmap is undefined, upload the whole page
+                target.dirty_ = eka2l1::rect({ 0, 0 }, { page_size, page_size });
+            }
+
+            if (target.dirty_.empty()) {
+                continue;
+            }
+
+            const eka2l1::rect &area = target.dirty_;
+
+            const std::size_t offset = area.top.y * page_size + area.top.x;
+            const std::size_t size = (area.size.y - 1) * page_size + area.size.x;
+
+            builder->update_bitmap(target.bitmap_, 8, reinterpret_cast<const char *>(target.data_.data() + offset), size,
+                area.top, area.size, page_size);
+
+            stats.uploads_++;
+            stats.bytes_uploaded_ += size;
+
+            target.dirty_ = eka2l1::rect();
+        }
+    }
+
+    drivers::handle glyph_cache::get_page_bitmap(const int page_idx) const {
+        const std::lock_guard<std::mutex> guard(lock);
+
+        if ((page_idx < 0) || (page_idx >= static_cast<int>(pages.size()))) {
+            return 0;
+        }
+
+        return pages[page_idx].bitmap_;
+    }
+}
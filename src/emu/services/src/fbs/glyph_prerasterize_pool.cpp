@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <services/fbs/glyph_bitmap_cache.h>
+#include <services/fbs/glyph_cache.h>
+#include <services/fbs/glyph_prerasterize_pool.h>
+
+#include <common/thread.h>
+
+#include <algorithm>
+#include <string>
+
+namespace eka2l1::epoc {
+    glyph_prerasterize_pool::glyph_prerasterize_pool(glyph_bitmap_cache *bitmap_cache, glyph_cache *atlas_cache,
+        const std::uint32_t thread_count)
+        : bitmap_cache_(bitmap_cache)
+        , atlas_cache_(atlas_cache)
+        , pending_count_(0) {
+        queue_.max_pending_count_ = 256;
+
+        for (std::uint32_t i = 0; i < thread_count; i++) {
+            workers_.emplace_back([this]() {
+                common::set_thread_name("FBS Server glyph rasterizer thread");
+                run();
+            });
+        }
+    }
+
+    glyph_prerasterize_pool::~glyph_prerasterize_pool() {
+        abort();
+    }
+
+    void glyph_prerasterize_pool::queue(const glyph_prerasterize_request &request) {
+        if (workers_.empty() || !request.adapter_) {
+            return;
+        }
+
+        {
+            const std::lock_guard<std::mutex> guard(requested_lock_);
+
+            if (std::find(requested_.begin(), requested_.end(), request) != requested_.end()) {
+                return;
+            }
+
+            requested_.push_back(request);
+        }
+
+        pending_count_++;
+        queue_.push(request);
+    }
+
+    void glyph_prerasterize_pool::prerasterize(const glyph_prerasterize_request &request) {
+        std::u16string text(PRERASTERIZE_GLYPH_COUNT, u'\0');
+
+        for (char16_t i = 0; i < PRERASTERIZE_GLYPH_COUNT; i++) {
+            text[i] = PRERASTERIZE_GLYPH_START + i;
+        }
+
+        if (bitmap_cache_) {
+            for (const char16_t code : text) {
+                bitmap_cache_->get_or_rasterize(request.adapter_, request.typeface_idx_, request.scale_x_, request.scale_y_,
+                    code);
+            }
+        }
+
+        if (atlas_cache_ && (request.font_size_ > 0)) {
+            atlas_cache_->prerasterize(request.adapter_, request.typeface_idx_, request.font_size_, text);
+        }
+    }
+
+    void glyph_prerasterize_pool::run() {
+        while (std::optional<glyph_prerasterize_request> request = queue_.pop()) {
+            prerasterize(request.value());
+            pending_count_--;
+        }
+    }
+
+    void glyph_prerasterize_pool::abort() {
+        queue_.abort();
+
+        for (std::thread &worker : workers_) {
+            if (worker.joinable()) {
+                worker.join();
+            }
+        }
+
+        workers_.clear();
+    }
+}
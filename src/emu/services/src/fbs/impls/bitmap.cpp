@@ -500,6 +500,10 @@ namespace eka2l1 {
             bws_bmp->settings_.current_display_mode(dpm);
 
             bmp = make_new<fbsbitmap>(fbss, bws_bmp, static_cast<bool>(load_options->share), support_dirty_bitmap);
+            fbss->touch_bitmap(bws_bmp);
+
+            // Loaded bitmaps are handed to the client too, which can write to them
+            fbss->mark_bitmap_guest_writable(bws_bmp);
         }
 
         if (load_options->share && !already_cache) {
@@ -572,10 +576,53 @@ namespace eka2l1 {
         }
 
         fbsbitmap *bmp = make_new<fbsbitmap>(this, bws_bmp, false, support_dirty);
+        touch_bitmap(bws_bmp);
 
         return bmp;
     }
 
+    void fbs_bitmap_generation_table::touch(const epoc::bitwise_bitmap *bmp) {
+        const std::lock_guard<std::mutex> guard(lock_);
+        generations_[bmp].generation_ = ++counter_;
+    }
+
+    void fbs_bitmap_generation_table::mark_guest_writable(const epoc::bitwise_bitmap *bmp) {
+        const std::lock_guard<std::mutex> guard(lock_);
+        generations_[bmp].guest_writable_ = true;
+    }
+
+    void fbs_bitmap_generation_table::remove(const epoc::bitwise_bitmap *bmp) {
+        const std::lock_guard<std::mutex> guard(lock_);
+        generations_.erase(bmp);
+    }
+
+    fbs_bitmap_generation fbs_bitmap_generation_table::get(const epoc::bitwise_bitmap *bmp) {
+        const std::lock_guard<std::mutex> guard(lock_);
+        auto generation_ite = generations_.find(bmp);
+
+        if (generation_ite == generations_.end()) {
+            // Nothing is known about its writes
+            fbs_bitmap_generation unknown;
+            unknown.guest_writable_ = true;
+
+            return unknown;
+        }
+
+        return generation_ite->second;
+    }
+
+    void fbs_server::touch_bitmap(const epoc::bitwise_bitmap *bmp) {
+        bitmap_generations.touch(bmp);
+    }
+
+    void fbs_server::mark_bitmap_guest_writable(const epoc::bitwise_bitmap *bmp) {
+        bitmap_generations.mark_guest_writable(bmp);
+    }
+
+    fbs_bitmap_generation fbs_server::get_bitmap_generation(const epoc::bitwise_bitmap *bmp) {
+        return bitmap_generations.get(bmp);
+    }
+
     bool fbs_server::free_bitmap(fbsbitmap *bmp) {
         if (!bmp->bitmap_ || bmp->count > 0) {
             return false;
@@ -586,6 +633,8 @@ namespace eka2l1 {
             return false;
         }
 
+        bitmap_generations.remove(bmp->bitmap_);
+
         // Free the bitwise bitmap.
         if (!free_general_data(bmp->bitmap_)) {
             return false;
@@ -632,6 +681,9 @@ namespace eka2l1 {
             return;
         }
 
+        // Bitmaps created by client are drawn to by guest code
+        fbss->mark_bitmap_guest_writable(bmp->bitmap_);
+
         const std::uint32_t handle_ret = obj_table_.add(bmp);
         const std::uint32_t serv_handle = bmp->id;
         const std::uint32_t addr_off = fbss->host_ptr_to_guest_shared_offset(bmp->bitmap_);
@@ -705,6 +757,9 @@ namespace eka2l1 {
         new_bmp->bitmap_->copy_data(*(bmp->bitmap_), fbss->base_large_chunk);
         bmp->clean_bitmap = new_bmp;
 
+        fbss->touch_bitmap(new_bmp->bitmap_);
+        fbss->mark_bitmap_guest_writable(new_bmp->bitmap_);
+
         // notify dirty bitmap on ref count >= 2
 
         obj_table_.remove(handle);
@@ -600,6 +600,7 @@ namespace eka2l1 {
 
             // S^3 warning!
             font->guest_font_offset = serv->host_ptr_to_guest_shared_offset(bmpfont);
+            serv->prerasterize_font(font);
         }
 
         write_font_handle(ctx, font);
@@ -645,6 +646,8 @@ namespace eka2l1 {
 
         // S^3 warning!
         font->guest_font_offset = serv->host_ptr_to_guest_shared_offset(bmpfont);
+        serv->prerasterize_font(font);
+
         write_font_handle(ctx, font);
     }
 
@@ -721,19 +724,16 @@ namespace eka2l1 {
             //LOG_DEBUG("Trying to rasterize character '{}' (code {})", static_cast<char>(codepoint), codepoint);
         }
 
-        int rasterized_width = 0;
-        int rasterized_height = 0;
-
+        // Add it to session cache
+        fbs_server *serv = server<fbs_server>();
         const epoc::open_font_info *info = &(font->of_info);
-        epoc::glyph_bitmap_type bitmap_type = epoc::glyph_bitmap_type::default_glyph_bitmap;
-        std::uint32_t bitmap_data_size = 0;
 
-        // Get server font handle
-        // The returned bitmap is 8bpp single channel. Luckily Symbian likes this (at least in v3 and upper).
-        std::uint8_t *bitmap_data = info->adapter->get_glyph_bitmap(info->idx, codepoint, info->scale_factor_x,
-            info->scale_factor_y, &rasterized_width, &rasterized_height, bitmap_data_size, &bitmap_type);
+        // Common glyphs are usually already rasterized by the glyph rasterizer threads.
+        // The bitmap is 8bpp single channel. Luckily Symbian likes this (at least in v3 and upper).
+        epoc::rasterized_glyph_ptr glyph = serv->get_glyph_bitmap_cache()->get_or_rasterize(info->adapter, info->idx,
+            info->scale_factor_x, info->scale_factor_y, codepoint);
 
-        if (!bitmap_data && !info->adapter->does_glyph_exist(info->idx, codepoint)) {
+        if (!glyph->exists_) {
             // The glyph is not available. Let the client know. With code 0, we already use '?'
             // On S^3, it expect us to return false here.
             // On lower version, it expect us to return nullptr, so use 0 here is for the best.
@@ -741,12 +741,7 @@ namespace eka2l1 {
             return;
         }
 
-        epoc::open_font_character_metric calculated_metric;
-        font->of_info.adapter->get_glyph_metric(font->of_info.idx, codepoint, calculated_metric, 0, font->of_info.scale_factor_x,
-            font->of_info.scale_factor_y);
-
-        // Add it to session cache
-        fbs_server *serv = server<fbs_server>();
+        const std::uint32_t bitmap_data_size = static_cast<std::uint32_t>(glyph->data_.size());
         kernel::process *pr = ctx->msg->own_thr->owning_process();
 
 #define MAKE_CACHE_ENTRY(entry_ver, type)                                                                                         \
@@ -755,21 +750,18 @@ namespace eka2l1 {
     cache_entry->codepoint = codepoint;                                                                                     \
     cache_entry->glyph_index = codepoint % session_cache->offset_array.offset_array_count;                                  \
     cache_entry->offset = sizeof(epoc::open_font_session_cache_entry_v##entry_ver) + 1;                                     \
-    info->adapter->get_glyph_metric(info->idx, codepoint, cache_entry->metric,                                              \
-        reinterpret_cast<type*>(bmp_font)->algorithic_style.baseline_offsets_in_pixel, info->scale_factor_x, info->scale_factor_y);                  \
-    cache_entry->metric = calculated_metric;                                                                                 \
-    cache_entry->metric.width = rasterized_width;                                                                           \
-    cache_entry->metric.height = rasterized_height;                                                                         \
-    cache_entry->metric.bitmap_type = bitmap_type;                                                               \
+    cache_entry->metric = glyph->metric_;                                                                                   \
+    cache_entry->metric.width = glyph->width_;                                                                              \
+    cache_entry->metric.height = glyph->height_;                                                                            \
+    cache_entry->metric.bitmap_type = glyph->bitmap_type_;                                                                  \
     const auto cache_entry_ptr = serv->host_ptr_to_guest_general_data(cache_entry).ptr_address();                           \
     if (epoc::does_client_use_pointer_instead_of_offset(this)) {                                                            \
         cache_entry->font_offset = static_cast<std::int32_t>(reinterpret_cast<type*>(bmp_font)->openfont.ptr_address());                             \
     } else {                                                                                                                \
         cache_entry->font_offset = static_cast<std::int32_t>(reinterpret_cast<type*>(bmp_font)->openfont.ptr_address() - cache_entry_ptr);           \
     }                                                                                                                       \
-    std::memcpy(reinterpret_cast<std::uint8_t *>(cache_entry) + cache_entry->offset, bitmap_data,                           \
+    std::memcpy(reinterpret_cast<std::uint8_t *>(cache_entry) + cache_entry->offset, glyph->data_.data(),                   \
         bitmap_data_size);                                                                                                  \
-    info->adapter->free_glyph_bitmap(bitmap_data);                                                                          \
     if (epoc::does_client_use_pointer_instead_of_offset(this)) {                                                            \
         cache_entry->offset += static_cast<std::int32_t>(cache_entry_ptr);                                                  \
     }                                                                                                                       \
@@ -822,14 +814,23 @@ namespace eka2l1 {
         ctx->complete(true);
     }
 
-    void fbsfont::deref() {
-        if (count == 1) {
-            atlas.free(serv->get_graphics_driver());
+    void fbs_server::prerasterize_font(fbsfont *font) {
+        if (!glyph_prerasterizer) {
+            return;
         }
 
-        epoc::ref_count_object::deref();
+        epoc::glyph_prerasterize_request request;
+        request.adapter_ = font->of_info.adapter;
+        request.typeface_idx_ = font->of_info.idx;
+        request.scale_x_ = font->of_info.scale_factor_x;
+        request.scale_y_ = font->of_info.scale_factor_y;
+
+        // Same size the window server draws the font with
+        request.font_size_ = font->of_info.metrics.max_height;
+
+        glyph_prerasterizer->queue(request);
     }
-    
+
     fbsfont *fbs_server::get_font(const service::uid id) {
         return font_obj_container.get<fbsfont>(id);
     }
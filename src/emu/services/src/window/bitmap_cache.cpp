@@ -21,6 +21,7 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <services/fbs/fbs.h>
 #include <services/fbs/palette.h>
 #include <services/window/bitmap_cache.h>
 
@@ -30,102 +31,114 @@
 
 #include <algorithm>
 
+#include <common/algorithm.h>
 #include <common/buffer.h>
 #include <common/log.h>
+#include <common/pixconv.h>
 #include <common/runlen.h>
-#include <common/time.h>
 
 #define XXH_INLINE_ALL
 #include <xxhash.h>
 
 namespace eka2l1::epoc {
-    bitmap_cache::bitmap_cache(kernel_system *kern_)
-        : base_large_chunk(nullptr)
-        , kern(kern_) {
-        std::fill(driver_textures.begin(), driver_textures.end(), 0);
-        std::fill(hashes.begin(), hashes.end(), 0);
+    bitmap_cache::bitmap_cache(kernel_system *kern_, const std::uint32_t capacity_)
+        : lru_head(INVALID_SLOT)
+        , lru_tail(INVALID_SLOT)
+        , capacity(common::max<std::uint32_t>(capacity_, 1))
+        , base_large_chunk(nullptr)
+        , kern(kern_)
+        , generations(nullptr) {
+        entries.reserve(capacity);
+        slot_lookup.reserve(capacity);
     }
 
-    bool is_palette_bitmap(epoc::bitwise_bitmap *bw_bmp) {
-        const epoc::display_mode dsp = bw_bmp->settings_.current_display_mode();
-        return (dsp == epoc::display_mode::color16) || (dsp == epoc::display_mode::color256);
+    bitmap_cache::bitmap_cache(fbs_bitmap_generation_table *generations_, std::uint8_t *base_large_chunk_,
+        const std::uint32_t capacity_)
+        : lru_head(INVALID_SLOT)
+        , lru_tail(INVALID_SLOT)
+        , capacity(common::max<std::uint32_t>(capacity_, 1))
+        , base_large_chunk(base_large_chunk_)
+        , kern(nullptr)
+        , generations(generations_) {
+        entries.reserve(capacity);
+        slot_lookup.reserve(capacity);
     }
 
-    static char *converted_one_bpp_to_twenty_four_bpp_bitmap(epoc::bitwise_bitmap *bw_bmp,
-        const std::uint32_t *original_ptr, std::vector<char> &converted_pool) {
-        std::uint32_t byte_width_converted = common::align(bw_bmp->header_.size_pixels.x * 3, 4);
-        converted_pool.resize(byte_width_converted * bw_bmp->header_.size_pixels.y);
-
-        char *return_ptr = &converted_pool[0];
-
-        for (std::size_t y = 0; y < bw_bmp->header_.size_pixels.y; y++) {
-            for (std::size_t x = 0; x < bw_bmp->header_.size_pixels.x; x++) {
-                std::uint32_t word_per_line = (bw_bmp->header_.size_pixels.x + 31) / 32;
-                std::uint32_t color = original_ptr[y * word_per_line + x / 32];
-                std::uint32_t converted_color =  0;
-                if (color & (1 << (x & 0x1F))) {
-                    converted_color = 0xFFFFFF;
-                }
-
-                std::memcpy(return_ptr + byte_width_converted * y + x * 3, reinterpret_cast<const char *>(&converted_color), 3);
-            }
+    static const std::uint32_t GRAY_2_PALETTE[2] = { 0x000000, 0xFFFFFF };
+    static const std::uint32_t GRAY_4_PALETTE[4] = { 0x000000, 0x555555, 0xAAAAAA, 0xFFFFFF };
+    static const std::uint32_t GRAY_16_PALETTE[16] = {
+        0x000000, 0x111111, 0x222222, 0x333333, 0x444444, 0x555555, 0x666666, 0x777777,
+        0x888888, 0x999999, 0xAAAAAA, 0xBBBBBB, 0xCCCCCC, 0xDDDDDD, 0xEEEEEE, 0xFFFFFF
+    };
+
+    /**
+     * \brief Get the palette of a bitmap which pixels are indicies, that GPU doesn't support.
+     * \returns Nullptr if the bitmap pixels are not palette indicies.
+     */
+    static const std::uint32_t *get_conversion_palette(epoc::bitwise_bitmap *bw_bmp) {
+        switch (bw_bmp->settings_.current_display_mode()) {
+        case epoc::display_mode::color16:
+            return epoc::color_16_palette.data();
+
+        case epoc::display_mode::color256:
+            return epoc::color_256_palette.data();
+
+        default:
+            break;
         }
-        return return_ptr;
-    }
 
-    static char *convert_twelve_bpp_to_twenty_four_bpp_bitmap(epoc::bitwise_bitmap *bw_bmp,
-        const std::uint32_t *original_ptr, std::vector<char> &converted_pool) {
-        std::uint32_t byte_width_converted = common::align(bw_bmp->header_.size_pixels.x * 3, 4);
-        converted_pool.resize(byte_width_converted * bw_bmp->header_.size_pixels.y);
+        switch (bw_bmp->header_.bit_per_pixels) {
+        case 1:
+            return GRAY_2_PALETTE;
 
-        char *return_ptr = &converted_pool[0];
-        const std::uint16_t *source = reinterpret_cast<const std::uint16_t*>(original_ptr);
+        case 2:
+            return GRAY_4_PALETTE;
 
-        for (std::size_t y = 0; y < bw_bmp->header_.size_pixels.y; y++) {
-            for (std::size_t x = 0; x < bw_bmp->header_.size_pixels.x; x++) {
-                const std::size_t location = y * byte_width_converted + x * 3;
-                std::uint16_t value = source[y * bw_bmp->byte_width_ / 2 + x];
+        case 4:
+            return GRAY_16_PALETTE;
 
-                // Kind of black magic, get bits from byte
-                return_ptr[location] = (value & 0xF) * 17;
-                return_ptr[location + 1] = ((value >> 4) & 0xF) * 17;
-                return_ptr[location + 2] = ((value >> 8) & 0xF) * 17;
-            }
+        default:
+            break;
         }
 
-        return return_ptr;
+        return nullptr;
     }
 
-    static char *converted_palette_bitmap_to_twenty_four_bitmap(epoc::bitwise_bitmap *bw_bmp,
-        const std::uint8_t *original_ptr, std::vector<char> &converted_pool) {
-        std::uint32_t byte_width_converted = common::align(bw_bmp->header_.size_pixels.x * 3, 4);
-        converted_pool.resize(byte_width_converted * bw_bmp->header_.size_pixels.y);
-
-        char *return_ptr = &converted_pool[0];
+    /**
+     * \brief Get the channel swizzle of the bitmap's texture, after a full upload.
+     * 
+     * Driver textures are recycled between bitmaps, so the swizzle is set on every full upload,
+     * even when it is the identity one.
+     */
+    static drivers::channel_swizzles get_texture_swizzle(epoc::bitwise_bitmap *bw_bmp) {
+        if (get_conversion_palette(bw_bmp) || (bw_bmp->header_.bit_per_pixels == 12)) {
+            // Converted to BGRA on the CPU
+            return { drivers::channel_swizzle::red, drivers::channel_swizzle::green,
+                drivers::channel_swizzle::blue, drivers::channel_swizzle::alpha };
+        }
 
-        for (std::size_t y = 0; y < bw_bmp->header_.size_pixels.y; y++) {
-            for (std::size_t x = 0; x < bw_bmp->header_.size_pixels.x; x++) {
-                switch (bw_bmp->settings_.current_display_mode()) {
-                case epoc::display_mode::color256: {
-                    const std::uint8_t palette_index = original_ptr[y * bw_bmp->byte_width_ + x];
-                    const std::uint32_t palette_color = epoc::color_256_palette[palette_index];
-                    const std::size_t location = byte_width_converted * y + x * 3;
+        switch (bw_bmp->header_.bit_per_pixels) {
+        case 8:
+            return { drivers::channel_swizzle::red, drivers::channel_swizzle::red,
+                drivers::channel_swizzle::red, drivers::channel_swizzle::red };
 
-                    return_ptr[location] = palette_color & 0xFF;
-                    return_ptr[location + 1] = (palette_color >> 8) & 0xFF;
-                    return_ptr[location + 2] = (palette_color >> 16) & 0xFF;
+        case 16:
+        case 24:
+            return { drivers::channel_swizzle::red, drivers::channel_swizzle::green,
+                drivers::channel_swizzle::blue, drivers::channel_swizzle::one };
 
-                    break;
-                }
+        default:
+            break;
+        }
 
-                default:
-                    LOG_ERROR("Unhandled display mode to convert {}", static_cast<int>(bw_bmp->settings_.current_display_mode()));
-                    break;
-                }
-            }
+        // The unused byte of color16mu is garbage, not alpha
+        if (bw_bmp->settings_.current_display_mode() == epoc::display_mode::color16mu) {
+            return { drivers::channel_swizzle::red, drivers::channel_swizzle::green,
+                drivers::channel_swizzle::blue, drivers::channel_swizzle::one };
         }
 
-        return return_ptr;
+        return { drivers::channel_swizzle::red, drivers::channel_swizzle::green,
+            drivers::channel_swizzle::blue, drivers::channel_swizzle::alpha };
     }
 
     std::uint64_t bitmap_cache::hash_bitwise_bitmap(epoc::bitwise_bitmap *bw_bmp) {
@@ -142,8 +155,11 @@ namespace eka2l1::epoc {
         XXH64_update(state, reinterpret_cast<const void *>(&bw_bmp->byte_width_), sizeof(bw_bmp->byte_width_));
         XXH64_update(state, reinterpret_cast<const void *>(&bw_bmp->uid_), sizeof(bw_bmp->uid_));
 
-        // Lastly, we needs to hash the data, to see if anything changed
-        XXH64_update(state, base_large_chunk + bw_bmp->data_offset_, bw_bmp->header_.bitmap_size - sizeof(bw_bmp->header_));
+        // Lastly, where the data lives and the display mode. The data itself is hashed by bands.
+        XXH64_update(state, reinterpret_cast<const void *>(&bw_bmp->data_offset_), sizeof(bw_bmp->data_offset_));
+
+        const epoc::display_mode dsp = bw_bmp->settings_.current_display_mode();
+        XXH64_update(state, reinterpret_cast<const void *>(&dsp), sizeof(dsp));
 
         hash = XXH64_digest(state);
         XXH64_freeState(state);
@@ -151,160 +167,318 @@ namespace eka2l1::epoc {
         return hash;
     }
 
-    std::int64_t bitmap_cache::get_suitable_bitmap_index() {
-        // First time, will scans through the bitmap array to find empty box
-        // Sometimes, app might purges a lot of bitmaps at same time
-        for (std::int64_t i = MAX_CACHE_SIZE - 1; i >= 0; i--) {
-            if (!bitmaps[i]) {
-                return i;
+    void bitmap_cache::hash_bitmap_bands(epoc::bitwise_bitmap *bw_bmp, std::vector<std::uint64_t> &result) {
+        const std::uint8_t *data = base_large_chunk + bw_bmp->data_offset_;
+
+        if (bw_bmp->header_.compression != bitmap_file_no_compression) {
+            result.resize(1);
+            result[0] = XXH64(data, bw_bmp->header_.bitmap_size - bw_bmp->header_.header_len, 0);
+
+            return;
+        }
+
+        const int height = bw_bmp->header_.size_pixels.y;
+        const std::size_t band_count = (height + BITMAP_CACHE_BAND_ROWS - 1) / BITMAP_CACHE_BAND_ROWS;
+
+        result.resize(band_count);
+
+        for (std::size_t i = 0; i < band_count; i++) {
+            const int rows = common::min<int>(BITMAP_CACHE_BAND_ROWS, height - static_cast<int>(i) * BITMAP_CACHE_BAND_ROWS);
+            result[i] = XXH64(data + i * BITMAP_CACHE_BAND_ROWS * bw_bmp->byte_width_, rows * bw_bmp->byte_width_, 0);
+        }
+    }
+
+    void bitmap_cache::upload_rows(drivers::graphics_command_list_builder *builder, const drivers::handle h,
+        epoc::bitwise_bitmap *bmp, int y_start, int y_end) {
+        char *data_pointer = reinterpret_cast<char *>(base_large_chunk + bmp->data_offset_);
+
+        std::vector<std::uint8_t> decompressed;
+        std::uint32_t raw_size = 0;
+
+        if (bmp->header_.compression != bitmap_file_no_compression) {
+            raw_size = bmp->byte_width_ * bmp->header_.size_pixels.y;
+            decompressed.resize(raw_size);
+
+            const std::uint32_t compressed_size = bmp->header_.bitmap_size - bmp->header_.header_len;
+
+            common::wo_buf_stream dest_stream(&decompressed[0], raw_size);
+            common::ro_buf_stream source_stream(reinterpret_cast<std::uint8_t *>(data_pointer), compressed_size);
+
+            switch (bmp->header_.compression) {
+            case bitmap_file_byte_rle_compression:
+                eka2l1::decompress_rle<8>(&source_stream, &dest_stream);
+                break;
+
+            case bitmap_file_twelve_bit_rle_compression:
+                eka2l1::decompress_rle<12>(&source_stream, &dest_stream);
+                break;
+
+            case bitmap_file_sixteen_bit_rle_compression:
+                eka2l1::decompress_rle<16>(&source_stream, &dest_stream);
+                break;
+
+            case bitmap_file_twenty_four_bit_rle_compression:
+                eka2l1::decompress_rle<24>(&source_stream, &dest_stream);
+                break;
+
+            default:
+                LOG_ERROR("Unsupported bitmap format to decode {}", bmp->header_.compression);
+                break;
             }
+
+            data_pointer = reinterpret_cast<char *>(&decompressed[0]);
+
+            y_start = 0;
+            y_end = bmp->header_.size_pixels.y;
         }
 
-        // Next, we will compare the timestamp
-        std::uint64_t oldest_timestamp_idx = 0;
-        for (std::int64_t i = 1; i < MAX_CACHE_SIZE; i++) {
-            if (timestamps[i] < timestamps[oldest_timestamp_idx]) {
-                oldest_timestamp_idx = i;
+        std::uint32_t bpp = bmp->header_.bit_per_pixels;
+        std::size_t pixels_per_line = 0;
+
+        if ((bmp->header_.bit_per_pixels % 8) == 0) {
+            pixels_per_line = bmp->byte_width_ / (bmp->header_.bit_per_pixels >> 3);
+        }
+
+        // Data of the rows in range, before any conversion
+        char *rows_pointer = data_pointer + y_start * bmp->byte_width_;
+        raw_size = (y_end - y_start) * bmp->byte_width_;
+
+        // GPU don't support them. Convert them on CPU, to 32 bpp
+        const std::uint32_t *palette = get_conversion_palette(bmp);
+        std::vector<std::uint32_t> converted;
+
+        if (palette || (bpp == 12)) {
+            const common::pixel_convert_kernels &kernels = common::get_best_pixel_convert_kernels();
+            const std::size_t width = bmp->header_.size_pixels.x;
+
+            converted.resize(width * (y_end - y_start));
+
+            for (int y = y_start; y < y_end; y++) {
+                std::uint32_t *dest_row = converted.data() + (y - y_start) * width;
+                const std::uint8_t *source_row = reinterpret_cast<const std::uint8_t *>(data_pointer + y * bmp->byte_width_);
+
+                if (palette) {
+                    kernels.palette_to_bgra(dest_row, source_row, width, bpp, palette);
+                } else {
+                    kernels.color4k_to_bgra(dest_row, reinterpret_cast<const std::uint16_t *>(source_row), width);
+                }
             }
+
+            rows_pointer = reinterpret_cast<char *>(converted.data());
+            raw_size = static_cast<std::uint32_t>(converted.size() * sizeof(std::uint32_t));
+            bpp = 32;
+
+            // Use default
+            pixels_per_line = 0;
         }
 
-        return oldest_timestamp_idx;
+        stats.uploads_++;
+        stats.bytes_uploaded_ += raw_size;
+
+        builder->update_bitmap(h, bpp, rows_pointer, raw_size, { 0, y_start }, { bmp->header_.size_pixels.x, y_end - y_start },
+            pixels_per_line);
     }
 
-    drivers::handle bitmap_cache::add_or_get(drivers::graphics_driver *driver, drivers::graphics_command_list_builder *builder,
-        epoc::bitwise_bitmap *bmp) {
-        if (!base_large_chunk) {
-            chunk_ptr ch = kern->get_by_name<kernel::chunk>("FbsLargeChunk");
-            base_large_chunk = reinterpret_cast<std::uint8_t*>(ch->host_base());
+    void bitmap_cache::lru_unlink(const std::uint32_t slot) {
+        entry &ent = entries[slot];
+
+        if (ent.prev_ != INVALID_SLOT) {
+            entries[ent.prev_].next_ = ent.next_;
+        } else {
+            lru_head = ent.next_;
         }
 
-        std::int64_t idx = 0;
-        std::uint64_t crr_timestamp = common::get_current_time_in_microseconds_since_1ad();
+        if (ent.next_ != INVALID_SLOT) {
+            entries[ent.next_].prev_ = ent.prev_;
+        } else {
+            lru_tail = ent.prev_;
+        }
 
-        std::uint64_t hash = 0;
+        ent.prev_ = INVALID_SLOT;
+        ent.next_ = INVALID_SLOT;
+    }
 
-        bool should_upload = true;
+    void bitmap_cache::lru_push_front(const std::uint32_t slot) {
+        entry &ent = entries[slot];
 
-        auto bitmap_ite = std::find(bitmaps.begin(), bitmaps.end(), bmp);
-        if (bitmap_ite == bitmaps.end()) {
-            // If the bitmap is not in the bitmap array
-            if (last_free < MAX_CACHE_SIZE) {
-                // Use last free
-                idx = last_free++;
-            } else {
-                idx = get_suitable_bitmap_index();
-            }
+        ent.prev_ = INVALID_SLOT;
+        ent.next_ = lru_head;
 
-            bitmaps[idx] = bmp;
-            driver_textures[idx] = 0;
-            hash = (hashes[idx] == 0) ? hash_bitwise_bitmap(bmp) : hashes[idx];
+        if (lru_head != INVALID_SLOT) {
+            entries[lru_head].prev_ = slot;
         } else {
-            // Else, get the index
-            idx = std::distance(bitmaps.begin(), bitmap_ite);
+            lru_tail = slot;
+        }
+
+        lru_head = slot;
+    }
+
+    void bitmap_cache::recycle_slot(const std::uint32_t slot) {
+        entry &ent = entries[slot];
 
-            // Check if we should upload or not, by calculating the hash
-            hash = hash_bitwise_bitmap(bmp);
-            should_upload = hash != (hashes[idx]);
+        // Only the driver texture is carried over. Its swizzle and content are set again by the full upload.
+        ent.hash_ = 0;
+        ent.generation_ = 0;
+        ent.verified_epoch_ = 0;
+        ent.band_hashes_.clear();
+    }
+
+    std::uint32_t bitmap_cache::acquire_slot() {
+        // Sometimes, app might purges a lot of bitmaps at same time. Reuse those slots first
+        if (!free_slots.empty()) {
+            const std::uint32_t slot = free_slots.back();
+            free_slots.pop_back();
+
+            recycle_slot(slot);
+            return slot;
         }
 
-        if (should_upload) {
-            if (driver_textures[idx])
-                builder->destroy_bitmap(driver_textures[idx]);
+        if (entries.size() < capacity) {
+            entries.emplace_back();
+            return static_cast<std::uint32_t>(entries.size() - 1);
+        }
 
-            driver_textures[idx] = drivers::create_bitmap(driver, bmp->header_.size_pixels);
-            char *data_pointer = reinterpret_cast<char *>(base_large_chunk + bmp->data_offset_);
+        // Full, evict the least recently used one
+        const std::uint32_t slot = lru_tail;
 
-            std::vector<std::uint8_t> decompressed;
-            std::uint32_t raw_size = 0;
+        lru_unlink(slot);
+        slot_lookup.erase(entries[slot].bitmap_);
+        recycle_slot(slot);
 
-            if (bmp->header_.compression != bitmap_file_no_compression) {
-                raw_size = bmp->byte_width_ * bmp->header_.size_pixels.y;
-                decompressed.resize(raw_size);
+        stats.evictions_++;
+        return slot;
+    }
 
-                const std::uint32_t compressed_size = bmp->header_.bitmap_size - bmp->header_.header_len;
+    bool bitmap_cache::remove(epoc::bitwise_bitmap *bmp) {
+        auto slot_ite = slot_lookup.find(bmp);
 
-                common::wo_buf_stream dest_stream(&decompressed[0], raw_size);
-                common::ro_buf_stream source_stream(reinterpret_cast<std::uint8_t *>(data_pointer), compressed_size);
+        if (slot_ite == slot_lookup.end()) {
+            return false;
+        }
 
-                switch (bmp->header_.compression) {
-                case bitmap_file_byte_rle_compression:
-                    eka2l1::decompress_rle<8>(&source_stream, &dest_stream);
-                    break;
+        const std::uint32_t slot = slot_ite->second;
 
-                case bitmap_file_twelve_bit_rle_compression:
-                    eka2l1::decompress_rle<12>(&source_stream, &dest_stream);
-                    break;
+        lru_unlink(slot);
+        slot_lookup.erase(slot_ite);
 
-                case bitmap_file_sixteen_bit_rle_compression:
-                    eka2l1::decompress_rle<16>(&source_stream, &dest_stream);
-                    break;
+        entries[slot].bitmap_ = nullptr;
+        free_slots.push_back(slot);
 
-                case bitmap_file_twenty_four_bit_rle_compression:
-                    eka2l1::decompress_rle<24>(&source_stream, &dest_stream);
-                    break;
+        return true;
+    }
 
-                default:
-                    LOG_ERROR("Unsupported bitmap format to decode {}", bmp->header_.compression);
-                    break;
-                }
+    drivers::handle bitmap_cache::add_or_get(drivers::graphics_driver *driver, drivers::graphics_command_list_builder *builder,
+        epoc::bitwise_bitmap *bmp) {
+        if (!base_large_chunk) {
+            chunk_ptr ch = kern->get_by_name<kernel::chunk>("FbsLargeChunk");
+            base_large_chunk = reinterpret_cast<std::uint8_t*>(ch->host_base());
+        }
 
-                data_pointer = reinterpret_cast<char *>(&decompressed[0]);
-            } else {
-                raw_size = bmp->header_.bitmap_size - bmp->header_.header_len;
+        if (!generations) {
+            fbs_server *fbss = reinterpret_cast<fbs_server *>(&(*kern->get_by_name<service::server>(
+                epoc::get_fbs_server_name_by_epocver(kern->get_epoc_version()))));
+
+            if (fbss) {
+                generations = fbss->get_bitmap_generations();
             }
+        }
 
-            std::vector<char> converted;
-            std::uint32_t bpp = bmp->header_.bit_per_pixels;
-            std::size_t pixels_per_line = 0;
+        std::uint32_t idx = 0;
+        bool full_upload = false;
 
-            if ((bmp->header_.bit_per_pixels % 8) == 0) {
-                pixels_per_line = bmp->byte_width_ / (bmp->header_.bit_per_pixels >> 3);
-            }
+        auto slot_ite = slot_lookup.find(bmp);
+
+        if (slot_ite == slot_lookup.end()) {
+            idx = acquire_slot();
+            slot_lookup.emplace(bmp, idx);
+
+            entries[idx].bitmap_ = bmp;
+            full_upload = true;
+
+            stats.misses_++;
+        } else {
+            idx = slot_ite->second;
+            lru_unlink(idx);
 
-            // GPU don't support them. Convert them on CPU
-            if (is_palette_bitmap(bmp)) {
-                data_pointer = converted_palette_bitmap_to_twenty_four_bitmap(bmp, reinterpret_cast<const std::uint8_t *>(data_pointer),
-                    converted);
-                bpp = 24;
-                raw_size = static_cast<std::uint32_t>(converted.size());
+            stats.hits_++;
+        }
+
+        lru_push_front(idx);
+        entry &ent = entries[idx];
 
-                // Use default
-                pixels_per_line = 0;
+        fbs_bitmap_generation generation;
+        generation.guest_writable_ = true;
+
+        if (generations) {
+            generation = generations->get(bmp);
+        }
+
+        const std::uint64_t hash = hash_bitwise_bitmap(bmp);
+
+        // A bitmap which header changed needs to be uploaded again as a whole
+        if (hash != ent.hash_) {
+            full_upload = true;
+        }
+
+        if (!full_upload && (generation.generation_ == ent.generation_)) {
+            // The server writes to the bitmap bump its generation. Only bitmaps drawn to by the guest
+            // can change behind its back, and those need to be hashed once per batch.
+            if (!generation.guest_writable_ || (ent.verified_epoch_ == current_epoch)) {
+                return ent.driver_texture_;
             }
+        }
 
-            switch (bpp) {
-            case 1:
-                data_pointer = converted_one_bpp_to_twenty_four_bpp_bitmap(bmp, reinterpret_cast<const std::uint32_t *>(data_pointer),
-                    converted);
-                bpp = 24;
-                raw_size = static_cast<std::uint32_t>(converted.size());
-                pixels_per_line = 0;
+        ent.verified_epoch_ = current_epoch;
+        ent.generation_ = generation.generation_;
+        ent.hash_ = hash;
 
-                break;
+        std::vector<std::uint64_t> &old_band_hashes = ent.band_hashes_;
+        std::vector<std::uint64_t> new_band_hashes;
 
-            case 12:
-                data_pointer = convert_twelve_bpp_to_twenty_four_bpp_bitmap(bmp, reinterpret_cast<const std::uint32_t *>(data_pointer),
-                    converted);
-                bpp = 24;
-                raw_size = static_cast<std::uint32_t>(converted.size());
-                pixels_per_line = 0;
+        hash_bitmap_bands(bmp, new_band_hashes);
 
-                break;
+        if (full_upload || (new_band_hashes.size() != old_band_hashes.size())) {
+            const eka2l1::vec2 size = bmp->header_.size_pixels;
 
-            default:
-                break;
+            // Reuse the driver bitmap whenever possible. Creating one requires waiting for the driver.
+            if (!ent.driver_texture_) {
+                ent.driver_texture_ = drivers::create_bitmap(driver, size);
+                ent.texture_size_ = size;
+            } else if (ent.texture_size_ != size) {
+                builder->resize_bitmap(ent.driver_texture_, size);
+                ent.texture_size_ = size;
             }
 
-            builder->update_bitmap(driver_textures[idx], bpp, data_pointer, raw_size, { 0, 0 }, bmp->header_.size_pixels, pixels_per_line);
-            hashes[idx] = hash;
+            upload_rows(builder, ent.driver_texture_, bmp, 0, size.y);
+
+            const drivers::channel_swizzles swizzle = get_texture_swizzle(bmp);
+            builder->set_swizzle(ent.driver_texture_, swizzle[0], swizzle[1], swizzle[2], swizzle[3]);
+        } else {
+            // Upload each run of consecutive dirty bands as one sub-rectangle. Compressed bitmaps
+            // only have one band, and are uploaded whole.
+            const std::size_t band_count = new_band_hashes.size();
+            std::size_t band = 0;
+
+            while (band < band_count) {
+                if (new_band_hashes[band] == old_band_hashes[band]) {
+                    band++;
+                    continue;
+                }
+
+                const std::size_t dirty_start = band;
+
+                while ((band < band_count) && (new_band_hashes[band] != old_band_hashes[band])) {
+                    band++;
+                }
+
+                const int y_start = static_cast<int>(dirty_start) * BITMAP_CACHE_BAND_ROWS;
+                const int y_end = common::min<int>(static_cast<int>(band) * BITMAP_CACHE_BAND_ROWS, bmp->header_.size_pixels.y);
 
-            if (bmp->settings_.current_display_mode() == epoc::display_mode::color16mu) {
-                builder->set_swizzle(driver_textures[idx], drivers::channel_swizzle::red, drivers::channel_swizzle::green,
-                    drivers::channel_swizzle::blue, drivers::channel_swizzle::one);
+                upload_rows(builder, ent.driver_texture_, bmp, y_start, y_end);
             }
         }
 
-        timestamps[idx] = crr_timestamp;
-        return driver_textures[idx];
+        old_band_hashes = std::move(new_band_hashes);
+        return ent.driver_texture_;
     }
 }
@@ -576,9 +576,10 @@ namespace eka2l1::epoc {
         text_font = font_object;
         text_font->ref();
 
-        if (text_font->atlas.atlas_handle_ == 0) {
+        if (!text_font->atlas.is_initialized()) {
             // Initialize the atlas
-            text_font->atlas.init(font_object->of_info.adapter, text_font->of_info.idx, 0x20, 0xFF - 0x20, font_object->of_info.metrics.max_height);
+            text_font->atlas.init(fbs->get_glyph_cache(), font_object->of_info.adapter, text_font->of_info.idx, epoc::PRERASTERIZE_GLYPH_START,
+                epoc::PRERASTERIZE_GLYPH_COUNT, font_object->of_info.metrics.max_height);
         }
 
         context.complete(epoc::error_none);
@@ -37,6 +37,8 @@
 #include <services/window/common.h>
 #include <services/utils.h>
 
+#include <config/config.h>
+
 #include <common/algorithm.h>
 #include <common/cvt.h>
 #include <common/ini.h>
@@ -133,6 +135,9 @@ namespace eka2l1::epoc {
     }
 
     void window_server_client::execute_commands(service::ipc_context &ctx, std::vector<ws_cmd> cmds) {
+        // Guest may have changed bitmaps' content since the last batch
+        get_ws().get_bitmap_cache()->invalidate_verification();
+
         for (auto &cmd : cmds) {
             if (cmd.obj_handle == guest_session->unique_id()) {
                 execute_command(ctx, cmd);
@@ -1099,7 +1104,7 @@ namespace eka2l1 {
     // TODO: Anim scheduler currently has no way to resize number of screens after construction.
     window_server::window_server(system *sys)
         : service::server(sys->get_kernel_system(), sys, get_winserv_name_by_epocver(sys->get_symbian_version_use()), true, true)
-        , bmp_cache(sys->get_kernel_system())
+        , bmp_cache(sys->get_kernel_system(), sys->get_config()->bitmap_cache_capacity)
         , anim_sched(sys->get_kernel_system(), sys->get_ntimer(), 1)
         , screens(nullptr)
         , focus_screen_(nullptr)
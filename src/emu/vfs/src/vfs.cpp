@@ -740,10 +740,7 @@ namespace eka2l1 {
                 info.size = common::file_size(real_path_utf8);
             }
 
-            /* TODO: Recover this code with new EKA2L1's common code.
-            auto last_mod = fs::last_write_time(*real_path);
-            info.last_write = static_cast<uint64_t>(last_mod.time_since_epoch().count());
-            */
+            info.last_write = common::get_last_modifiy_since_ad(*real_path);
 
             std::string path_utf8 = common::ucs2_to_utf8(path);
 
@@ -948,6 +945,7 @@ namespace eka2l1 {
             info.has_raw_attribute = true;
             info.raw_attribute = entry->attrib;
             info.size = entry->size;
+            info.last_write = rom_cache->header.time;
             info.name = common::ucs2_to_utf8(entry->name);
             info.full_path = common::ucs2_to_utf8(path);
 
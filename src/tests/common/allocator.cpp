@@ -22,6 +22,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 
 using namespace eka2l1;
 
@@ -128,4 +129,43 @@ TEST_CASE("bitmap_count_unaligned_start_end", "bitmap_allocator") {
     // First bitmap has 4 valid bits on (from offset 2), plus with bitmap 2 and 3 (4 bits before offset 70),
     // we got 4 + 12 + 4 = 20 bits 
     REQUIRE(alloc.allocated_count(2, 70) == 20);
-}
\ No newline at end of file
+}
+
+TEST_CASE("linear_arena_alignment_and_chunks", "linear_arena") {
+    common::chunk_pool_ptr pool = std::make_shared<common::chunk_pool>(64);
+    common::linear_arena arena(pool);
+
+    std::uint8_t *first = reinterpret_cast<std::uint8_t *>(arena.allocate(3));
+    std::uint8_t *second = reinterpret_cast<std::uint8_t *>(arena.allocate(8, 8));
+
+    REQUIRE(second == first + 8);
+    REQUIRE(arena.chunks().size() == 1);
+
+    // Does not fit in what is left, a new chunk is taken
+    arena.allocate(60);
+    REQUIRE(arena.chunks().size() == 2);
+
+    // Bigger than a chunk, gets its own block
+    arena.allocate(100);
+    REQUIRE(arena.chunks().size() == 3);
+    REQUIRE(arena.chunks().back().size_ == 100);
+}
+
+TEST_CASE("linear_arena_recycle_chunks", "linear_arena") {
+    common::chunk_pool_ptr pool = std::make_shared<common::chunk_pool>(64);
+    void *first_chunk = nullptr;
+
+    {
+        common::linear_arena arena(pool);
+        first_chunk = arena.allocate(16);
+    }
+
+    // The chunk given back on destruction is reused by the next arena
+    common::linear_arena arena(pool);
+    REQUIRE(arena.allocate(32) == first_chunk);
+
+    common::linear_arena moved(std::move(arena));
+
+    REQUIRE(arena.empty());
+    REQUIRE(moved.chunks().size() == 1);
+}
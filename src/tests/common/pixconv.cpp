@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <common/pixconv.h>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace eka2l1;
+
+static constexpr std::size_t MAX_TEST_WIDTH = 67;
+
+TEST_CASE("scalar_known_values", "pixconv") {
+    const common::pixel_convert_kernels *kernels = common::get_pixel_convert_kernels(common::pixel_convert_isa_scalar);
+    REQUIRE(kernels);
+
+    std::uint32_t dest[4] = { 0 };
+
+    // 1 bpp, least significant bit first
+    const std::uint32_t mono_palette[2] = { 0x000000, 0xFFFFFF };
+    const std::uint8_t mono = 0b0101;
+
+    kernels->palette_to_bgra(dest, &mono, 4, 1, mono_palette);
+    REQUIRE(dest[0] == 0xFFFFFFFF);
+    REQUIRE(dest[1] == 0xFF000000);
+    REQUIRE(dest[2] == 0xFFFFFFFF);
+    REQUIRE(dest[3] == 0xFF000000);
+
+    const std::uint16_t color4k = 0x0F81;
+    kernels->color4k_to_bgra(dest, &color4k, 1);
+    REQUIRE(dest[0] == 0xFFFF8811);
+
+    const std::uint16_t color64k = 0xF81F;
+    kernels->color64k_to_bgra(dest, &color64k, 1);
+    REQUIRE(dest[0] == 0xFFFF00FF);
+
+    const std::uint8_t bgr[6] = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66 };
+    kernels->bgr_to_bgra(dest, bgr, 2);
+    REQUIRE(dest[0] == 0xFF332211);
+    REQUIRE(dest[1] == 0xFF665544);
+
+    const std::uint32_t bgra = 0x80112233;
+    kernels->swap_red_blue(dest, &bgra, 1);
+    REQUIRE(dest[0] == 0x80332211);
+
+    kernels->fill_alpha(dest, &bgra, 1);
+    REQUIRE(dest[0] == 0xFF112233);
+}
+
+TEST_CASE("simd_match_scalar", "pixconv") {
+    const common::pixel_convert_kernels *scalar = common::get_pixel_convert_kernels(common::pixel_convert_isa_scalar);
+
+    std::mt19937 rng(0x5EED);
+    std::vector<std::uint8_t> source(MAX_TEST_WIDTH * 4);
+    std::vector<std::uint32_t> palette(256);
+
+    for (auto &byte : source) {
+        byte = static_cast<std::uint8_t>(rng());
+    }
+
+    for (auto &color : palette) {
+        color = rng() & 0xFFFFFF;
+    }
+
+    const std::uint16_t *source16 = reinterpret_cast<const std::uint16_t *>(source.data());
+    const std::uint32_t *source32 = reinterpret_cast<const std::uint32_t *>(source.data());
+
+    for (int isa = common::pixel_convert_isa_scalar + 1; isa < common::pixel_convert_isa_count; isa++) {
+        const common::pixel_convert_kernels *kernels = common::get_pixel_convert_kernels(static_cast<common::pixel_convert_isa>(isa));
+
+        if (!kernels) {
+            continue;
+        }
+
+        INFO(kernels->name);
+
+        // Every width, so that both the vector loops and the scalar tails are covered
+        for (std::size_t width = 0; width <= MAX_TEST_WIDTH; width++) {
+            std::vector<std::uint32_t> expected(width + 1, 0xDEADBEEF);
+            std::vector<std::uint32_t> result(width + 1, 0xDEADBEEF);
+
+            for (const int bpp : { 1, 2, 4, 8 }) {
+                scalar->palette_to_bgra(expected.data(), source.data(), width, bpp, palette.data());
+                kernels->palette_to_bgra(result.data(), source.data(), width, bpp, palette.data());
+                REQUIRE(expected == result);
+            }
+
+            scalar->color4k_to_bgra(expected.data(), source16, width);
+            kernels->color4k_to_bgra(result.data(), source16, width);
+            REQUIRE(expected == result);
+
+            scalar->color64k_to_bgra(expected.data(), source16, width);
+            kernels->color64k_to_bgra(result.data(), source16, width);
+            REQUIRE(expected == result);
+
+            scalar->bgr_to_bgra(expected.data(), source.data(), width);
+            kernels->bgr_to_bgra(result.data(), source.data(), width);
+            REQUIRE(expected == result);
+
+            scalar->swap_red_blue(expected.data(), source32, width);
+            kernels->swap_red_blue(result.data(), source32, width);
+            REQUIRE(expected == result);
+
+            scalar->fill_alpha(expected.data(), source32, width);
+            kernels->fill_alpha(result.data(), source32, width);
+            REQUIRE(expected == result);
+
+            // Nothing written past the row
+            REQUIRE(result[width] == 0xDEADBEEF);
+        }
+    }
+}
+
+TEST_CASE("best_is_available", "pixconv") {
+    const common::pixel_convert_kernels &best = common::get_best_pixel_convert_kernels();
+    REQUIRE(best.name != nullptr);
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <common/ring.h>
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+using namespace eka2l1;
+
+TEST_CASE("capacity_round_up", "spsc_ring_buffer") {
+    common::spsc_ring_buffer<std::int16_t> ring(100);
+
+    REQUIRE(ring.capacity() == 128);
+    REQUIRE(ring.size() == 0);
+    REQUIRE(ring.free_space() == 128);
+}
+
+TEST_CASE("write_read_wrap_around", "spsc_ring_buffer") {
+    common::spsc_ring_buffer<std::int16_t> ring(8);
+
+    std::int16_t source[6] = { 1, 2, 3, 4, 5, 6 };
+    std::int16_t dest[8] = { 0 };
+
+    REQUIRE(ring.write(source, 6) == 6);
+    REQUIRE(ring.read(dest, 4) == 4);
+    REQUIRE(dest[3] == 4);
+
+    // This write crosses the end of the storage
+    REQUIRE(ring.write(source, 6) == 6);
+    REQUIRE(ring.size() == 8);
+
+    // Full, nothing more fits
+    REQUIRE(ring.write(source, 1) == 0);
+
+    REQUIRE(ring.read(dest, 8) == 8);
+
+    const std::int16_t expected[8] = { 5, 6, 1, 2, 3, 4, 5, 6 };
+
+    for (int i = 0; i < 8; i++) {
+        REQUIRE(dest[i] == expected[i]);
+    }
+
+    REQUIRE(ring.read(dest, 1) == 0);
+}
+
+TEST_CASE("skip_all", "spsc_ring_buffer") {
+    common::spsc_ring_buffer<std::uint8_t> ring(16);
+    std::uint8_t source[10] = { 0 };
+
+    ring.write(source, 10);
+    ring.skip_all();
+
+    REQUIRE(ring.size() == 0);
+    REQUIRE(ring.free_space() == 16);
+}
+
+TEST_CASE("producer_consumer_threads", "spsc_ring_buffer") {
+    common::spsc_ring_buffer<std::uint32_t> ring(64);
+    static constexpr std::uint32_t TOTAL = 100000;
+
+    std::thread producer([&]() {
+        std::uint32_t next = 0;
+
+        while (next < TOTAL) {
+            std::uint32_t batch[7];
+            const std::uint32_t count = std::min<std::uint32_t>(7, TOTAL - next);
+
+            for (std::uint32_t i = 0; i < count; i++) {
+                batch[i] = next + i;
+            }
+
+            std::uint32_t written = 0;
+
+            while (written < count) {
+                written += static_cast<std::uint32_t>(ring.write(batch + written, count - written));
+            }
+
+            next += count;
+        }
+    });
+
+    std::uint32_t expected = 0;
+    bool in_order = true;
+
+    while (expected < TOTAL) {
+        std::uint32_t batch[13];
+        const std::size_t count = ring.read(batch, 13);
+
+        for (std::size_t i = 0; i < count; i++) {
+            in_order = in_order && (batch[i] == expected++);
+        }
+    }
+
+    producer.join();
+    REQUIRE(in_order);
+}
@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <catch2/catch.hpp>
+#include <dispatch/dispatcher.h>
+
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace eka2l1;
+
+static void post_test_completion(dispatch::audio_completion_queue &queue, dispatch::dsp_epoc_stream *owner,
+    const std::uint32_t sts_addr) {
+    eka2l1::ptr<epoc::request_status> sts(sts_addr);
+    queue.post(owner, epoc::notify_info(sts, nullptr));
+}
+
+static std::vector<std::uint32_t> get_completion_addresses(const std::vector<dispatch::audio_completion> &completions) {
+    std::vector<std::uint32_t> result;
+
+    for (const dispatch::audio_completion &completion : completions) {
+        result.push_back(completion.info_.sts.ptr_address());
+    }
+
+    return result;
+}
+
+TEST_CASE("audio_completions_in_posting_order", "dispatch_audio") {
+    std::unique_ptr<drivers::dsp_stream> no_stream;
+    dispatch::dsp_epoc_stream first(no_stream);
+    dispatch::dsp_epoc_stream second(no_stream);
+
+    dispatch::audio_completion_queue queue;
+    std::vector<dispatch::audio_completion> delivered;
+
+    REQUIRE_FALSE(queue.take_all(delivered));
+
+    post_test_completion(queue, &first, 0x100);
+    post_test_completion(queue, &second, 0x200);
+    post_test_completion(queue, &first, 0x300);
+
+    REQUIRE(queue.take_all(delivered));
+    REQUIRE(get_completion_addresses(delivered) == std::vector<std::uint32_t>{ 0x100, 0x200, 0x300 });
+
+    // Each completion is delivered once
+    REQUIRE_FALSE(queue.take_all(delivered));
+    REQUIRE(delivered.size() == 3);
+}
+
+TEST_CASE("audio_completions_cancel_before_deliver", "dispatch_audio") {
+    std::unique_ptr<drivers::dsp_stream> no_stream;
+    dispatch::dsp_epoc_stream first(no_stream);
+    dispatch::dsp_epoc_stream second(no_stream);
+
+    dispatch::audio_completion_queue queue;
+
+    post_test_completion(queue, &first, 0x100);
+    post_test_completion(queue, &second, 0x200);
+    post_test_completion(queue, &first, 0x300);
+    post_test_completion(queue, &second, 0x400);
+
+    std::vector<dispatch::audio_completion> cancelled;
+    queue.take_owned_by(&first, cancelled);
+
+    REQUIRE(get_completion_addresses(cancelled) == std::vector<std::uint32_t>{ 0x100, 0x300 });
+
+    // The other stream's completions are untouched, and keep their order
+    std::vector<dispatch::audio_completion> delivered;
+
+    REQUIRE(queue.take_all(delivered));
+    REQUIRE(get_completion_addresses(delivered) == std::vector<std::uint32_t>{ 0x200, 0x400 });
+
+    // Cancelling everything leaves nothing to deliver
+    post_test_completion(queue, &second, 0x500);
+
+    cancelled.clear();
+    queue.take_owned_by(&second, cancelled);
+
+    REQUIRE(get_completion_addresses(cancelled) == std::vector<std::uint32_t>{ 0x500 });
+
+    delivered.clear();
+    REQUIRE_FALSE(queue.take_all(delivered));
+}
+
+TEST_CASE("audio_completions_posted_from_threads", "dispatch_audio") {
+    static constexpr std::uint32_t TOTAL_POSTER = 4;
+    static constexpr std::uint32_t TOTAL_POST_PER_POSTER = 1000;
+
+    std::unique_ptr<drivers::dsp_stream> no_stream;
+    dispatch::dsp_epoc_stream owner(no_stream);
+
+    dispatch::audio_completion_queue queue;
+    std::vector<std::thread> posters;
+
+    // Request status addresses are (poster index << 16) | post index
+    for (std::uint32_t i = 0; i < TOTAL_POSTER; i++) {
+        posters.emplace_back([&queue, &owner, i]() {
+            for (std::uint32_t j = 0; j < TOTAL_POST_PER_POSTER; j++) {
+                post_test_completion(queue, &owner, (i << 16) | j);
+            }
+        });
+    }
+
+    // Deliver while they post, like the kernel does on reschedule
+    std::vector<dispatch::audio_completion> delivered;
+
+    while (delivered.size() < TOTAL_POSTER * TOTAL_POST_PER_POSTER) {
+        queue.take_all(delivered);
+    }
+
+    for (std::thread &poster : posters) {
+        poster.join();
+    }
+
+    std::vector<std::uint32_t> next_post(TOTAL_POSTER, 0);
+
+    for (const std::uint32_t addr : get_completion_addresses(delivered)) {
+        const std::uint32_t poster = addr >> 16;
+
+        REQUIRE(poster < TOTAL_POSTER);
+        REQUIRE((addr & 0xFFFF) == next_post[poster]++);
+    }
+
+    REQUIRE_FALSE(queue.take_all(delivered));
+}
+
+TEST_CASE("audio_event_pool_reuse", "dispatch_audio") {
+    static constexpr std::uint32_t CHUNK_SIZE = dispatch::dsp_epoc_stream::EVENT_POOL_CHUNK_SIZE;
+
+    std::unique_ptr<drivers::dsp_stream> no_stream;
+    dispatch::dsp_epoc_stream stream(no_stream);
+
+    // Like the notify request handler does
+    auto get_test_event = [&](const std::uint32_t sts_addr) {
+        eka2l1::ptr<epoc::request_status> sts(sts_addr);
+
+        dispatch::audio_event *evt = stream.get_event(sts);
+        evt->info_.sts = sts;
+
+        return evt;
+    };
+
+    std::vector<dispatch::audio_event *> events;
+
+    for (std::uint32_t i = 0; i < CHUNK_SIZE; i++) {
+        events.push_back(get_test_event(0x1000 + i * 4));
+    }
+
+    REQUIRE(stream.evt_pool_chunks_.size() == 1);
+
+    // Same request status, same event
+    REQUIRE(get_test_event(0x1000) == events[0]);
+    REQUIRE(get_test_event(0x1000 + (CHUNK_SIZE - 1) * 4) == events[CHUNK_SIZE - 1]);
+
+    // Pool is exhausted, grow it
+    dispatch::audio_event *extra = get_test_event(0x2000);
+
+    REQUIRE(stream.evt_pool_chunks_.size() == 2);
+
+    // Freed events are reused, most recently freed first, and are reset
+    stream.delete_event(events[3]);
+    stream.delete_event(extra);
+
+    REQUIRE(get_test_event(0x3000) == extra);
+    REQUIRE(get_test_event(0x3004) == events[3]);
+    REQUIRE(events[3]->next_ == nullptr);
+    REQUIRE(stream.evt_pool_chunks_.size() == 2);
+
+    // Deleted events are out of the queue
+    std::uint32_t total_queued = 0;
+
+    for (dispatch::audio_event *evt = stream.evt_queue_.next_; evt != nullptr; evt = evt->next_) {
+        REQUIRE(evt->info_.sts.ptr_address() != 0x1000 + 3 * 4);
+        total_queued++;
+    }
+
+    REQUIRE(total_queued == CHUNK_SIZE + 1);
+}
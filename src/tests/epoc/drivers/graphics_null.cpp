@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project
+ * (see bentokun.github.com/EKA2L1).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <drivers/graphics/backend/null/graphics_null.h>
+#include <drivers/itc.h>
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+using namespace eka2l1;
+
+using test_pixel = std::array<std::uint8_t, 4>;
+
+static const test_pixel TEST_BLACK = { 0, 0, 0, 255 };
+static const test_pixel TEST_RED = { 255, 0, 0, 255 };
+static const test_pixel TEST_GREEN = { 0, 255, 0, 255 };
+
+// Commands are executed on the calling thread, so results can be read back right after
+static void execute_test_commands(drivers::null_graphics_driver &driver, const std::function<void(drivers::graphics_command_list_builder &)> &record) {
+    std::unique_ptr<drivers::graphics_command_list> list = driver.new_command_list();
+    std::unique_ptr<drivers::graphics_command_list_builder> builder = driver.new_command_builder(list.get());
+
+    record(*builder);
+
+    static_cast<drivers::server_graphics_command_list *>(list.get())->list_.for_each([&](drivers::command *cmd) {
+        driver.dispatch(cmd);
+    });
+}
+
+static drivers::handle create_test_bitmap(drivers::null_graphics_driver &driver, const eka2l1::vec2 &size) {
+    std::unique_ptr<drivers::graphics_command_list> list = driver.new_command_list();
+
+    drivers::handle result = 0;
+    int status = -100;
+
+    drivers::command *cmd = drivers::make_command(static_cast<drivers::server_graphics_command_list *>(list.get())->list_,
+        drivers::graphics_driver_create_bitmap, &status, size.x, size.y, &result);
+
+    driver.dispatch(cmd);
+    return result;
+}
+
+static test_pixel read_test_pixel(drivers::null_graphics_driver &driver, const drivers::handle h, const int x, const int y) {
+    drivers::null_texture *tex = driver.get_bitmap_texture(h);
+    const std::uint8_t *texel = tex->get_storage() + (y * tex->get_size().x + x) * 4;
+
+    return { texel[0], texel[1], texel[2], texel[3] };
+}
+
+static std::unique_ptr<drivers::null_graphics_driver> make_test_driver() {
+    auto driver = std::make_unique<drivers::null_graphics_driver>();
+    driver->set_software_rendering(true);
+
+    return driver;
+}
+
+TEST_CASE("null_raster_fill_rectangle", "graphics_null") {
+    auto driver = make_test_driver();
+    const drivers::handle target = create_test_bitmap(*driver, { 8, 8 });
+
+    REQUIRE(target != 0);
+
+    execute_test_commands(*driver, [&](drivers::graphics_command_list_builder &builder) {
+        builder.bind_bitmap(target);
+        builder.clear({ 0, 0, 0, 255 }, drivers::draw_buffer_bit_color_buffer);
+        builder.set_brush_color({ 255, 0, 0 });
+        builder.draw_rectangle(eka2l1::rect({ 2, 2 }, { 3, 3 }));
+    });
+
+    REQUIRE(read_test_pixel(*driver, target, 2, 2) == TEST_RED);
+    REQUIRE(read_test_pixel(*driver, target, 4, 2) == TEST_RED);
+    REQUIRE(read_test_pixel(*driver, target, 4, 4) == TEST_RED);
+
+    // Right and bottom edges are exclusive
+    REQUIRE(read_test_pixel(*driver, target, 1, 2) == TEST_BLACK);
+    REQUIRE(read_test_pixel(*driver, target, 5, 2) == TEST_BLACK);
+    REQUIRE(read_test_pixel(*driver, target, 2, 5) == TEST_BLACK);
+    REQUIRE(read_test_pixel(*driver, target, 2, 1) == TEST_BLACK);
+}
+
+TEST_CASE("null_raster_clip_at_buffer_edges", "graphics_null") {
+    auto driver = make_test_driver();
+    const drivers::handle target = create_test_bitmap(*driver, { 8, 8 });
+
+    execute_test_commands(*driver, [&](drivers::graphics_command_list_builder &builder) {
+        builder.bind_bitmap(target);
+        builder.clear({ 0, 0, 0, 255 }, drivers::draw_buffer_bit_color_buffer);
+        builder.set_brush_color({ 255, 0, 0 });
+
+        // Both cross the bitmap bounds
+        builder.draw_rectangle(eka2l1::rect({ -2, -2 }, { 4, 4 }));
+        builder.draw_rectangle(eka2l1::rect({ 6, 6 }, { 10, 10 }));
+    });
+
+    REQUIRE(read_test_pixel(*driver, target, 0, 0) == TEST_RED);
+    REQUIRE(read_test_pixel(*driver, target, 1, 1) == TEST_RED);
+    REQUIRE(read_test_pixel(*driver, target, 2, 2) == TEST_BLACK);
+    REQUIRE(read_test_pixel(*driver, target, 5, 5) == TEST_BLACK);
+    REQUIRE(read_test_pixel(*driver, target, 6, 6) == TEST_RED);
+    REQUIRE(read_test_pixel(*driver, target, 7, 7) == TEST_RED);
+    REQUIRE(read_test_pixel(*driver, target, 7, 0) == TEST_BLACK);
+    REQUIRE(read_test_pixel(*driver, target, 0, 7) == TEST_BLACK);
+}
+
+TEST_CASE("null_raster_scissor", "graphics_null") {
+    auto driver = make_test_driver();
+    const drivers::handle target = create_test_bitmap(*driver, { 8, 8 });
+
+    execute_test_commands(*driver, [&](drivers::graphics_command_list_builder &builder) {
+        builder.bind_bitmap(target);
+        builder.clear({ 0, 0, 0, 255 }, drivers::draw_buffer_bit_color_buffer);
+
+        // Negative height: top-left based rectangle
+        eka2l1::rect clip({ 1, 1 }, { 2, -2 });
+
+        builder.clip_rect(clip);
+        builder.set_clipping(true);
+        builder.set_brush_color({ 0, 255, 0 });
+        builder.draw_rectangle(eka2l1::rect({ 0, 0 }, { 8, 8 }));
+
+        // Positive height: bottom-left based, like OpenGL. This is the bottom right corner.
+        clip = eka2l1::rect({ 6, 0 }, { 2, 2 });
+
+        builder.clip_rect(clip);
+        builder.clear({ 255, 0, 0, 255 }, drivers::draw_buffer_bit_color_buffer);
+    });
+
+    REQUIRE(read_test_pixel(*driver, target, 0, 0) == TEST_BLACK);
+    REQUIRE(read_test_pixel(*driver, target, 1, 1) == TEST_GREEN);
+    REQUIRE(read_test_pixel(*driver, target, 2, 2) == TEST_GREEN);
+    REQUIRE(read_test_pixel(*driver, target, 3, 2) == TEST_BLACK);
+    REQUIRE(read_test_pixel(*driver, target, 2, 3) == TEST_BLACK);
+
+    REQUIRE(read_test_pixel(*driver, target, 6, 6) == TEST_RED);
+    REQUIRE(read_test_pixel(*driver, target, 7, 7) == TEST_RED);
+    REQUIRE(read_test_pixel(*driver, target, 5, 6) == TEST_BLACK);
+    REQUIRE(read_test_pixel(*driver, target, 6, 1) == TEST_BLACK);
+}
+
+TEST_CASE("null_raster_draw_bitmap", "graphics_null") {
+    auto driver = make_test_driver();
+
+    const drivers::handle source = create_test_bitmap(*driver, { 2, 2 });
+    const drivers::handle target = create_test_bitmap(*driver, { 4, 4 });
+
+    // 32 bpp data is BGRA
+    const std::uint8_t source_data[] = {
+        0, 0, 255, 255, 0, 255, 0, 255,
+        255, 0, 0, 255, 255, 255, 255, 255
+    };
+
+    const test_pixel source_red = { 255, 0, 0, 255 };
+    const test_pixel source_green = { 0, 255, 0, 255 };
+    const test_pixel source_blue = { 0, 0, 255, 255 };
+    const test_pixel source_white = { 255, 255, 255, 255 };
+
+    execute_test_commands(*driver, [&](drivers::graphics_command_list_builder &builder) {
+        builder.update_bitmap(source, 32, reinterpret_cast<const char *>(source_data), sizeof(source_data), { 0, 0 }, { 2, 2 });
+        builder.bind_bitmap(target);
+        builder.clear({ 0, 0, 0, 255 }, drivers::draw_buffer_bit_color_buffer);
+
+        // Scaled up twice, nearest filter
+        builder.draw_bitmap(source, 0, eka2l1::rect({ 0, 0 }, { 4, 4 }), eka2l1::rect({ 0, 0 }, { 2, 2 }));
+    });
+
+    REQUIRE(read_test_pixel(*driver, target, 0, 0) == source_red);
+    REQUIRE(read_test_pixel(*driver, target, 1, 1) == source_red);
+    REQUIRE(read_test_pixel(*driver, target, 2, 0) == source_green);
+    REQUIRE(read_test_pixel(*driver, target, 3, 1) == source_green);
+    REQUIRE(read_test_pixel(*driver, target, 0, 2) == source_blue);
+    REQUIRE(read_test_pixel(*driver, target, 1, 3) == source_blue);
+    REQUIRE(read_test_pixel(*driver, target, 2, 2) == source_white);
+    REQUIRE(read_test_pixel(*driver, target, 3, 3) == source_white);
+
+    execute_test_commands(*driver, [&](drivers::graphics_command_list_builder &builder) {
+        builder.clear({ 0, 0, 0, 255 }, drivers::draw_buffer_bit_color_buffer);
+
+        // Only the top left texel of the source lands inside the target
+        builder.draw_bitmap(source, 0, eka2l1::rect({ 3, 3 }, { 2, 2 }), eka2l1::rect({ 0, 0 }, { 2, 2 }));
+    });
+
+    REQUIRE(read_test_pixel(*driver, target, 3, 3) == source_red);
+    REQUIRE(read_test_pixel(*driver, target, 2, 3) == TEST_BLACK);
+    REQUIRE(read_test_pixel(*driver, target, 3, 2) == TEST_BLACK);
+}
+
+TEST_CASE("null_raster_resize_keeps_content", "graphics_null") {
+    auto driver = make_test_driver();
+    const drivers::handle target = create_test_bitmap(*driver, { 4, 4 });
+
+    execute_test_commands(*driver, [&](drivers::graphics_command_list_builder &builder) {
+        builder.bind_bitmap(target);
+        builder.clear({ 255, 0, 0, 255 }, drivers::draw_buffer_bit_color_buffer);
+
+        // Goes through a framebuffer blit from the old texture to the new one
+        builder.resize_bitmap(target, { 6, 6 });
+    });
+
+    REQUIRE(driver->get_bitmap_texture(target)->get_size() == eka2l1::vec2(6, 6));
+
+    REQUIRE(read_test_pixel(*driver, target, 0, 0) == TEST_RED);
+    REQUIRE(read_test_pixel(*driver, target, 3, 3) == TEST_RED);
+    REQUIRE(read_test_pixel(*driver, target, 4, 0) == test_pixel{ 0, 0, 0, 0 });
+    REQUIRE(read_test_pixel(*driver, target, 0, 5) == test_pixel{ 0, 0, 0, 0 });
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <config/config.h>
+#include <kernel/ipc.h>
+#include <kernel/kernel.h>
+#include <kernel/timing.h>
+
+#include <memory>
+
+using namespace eka2l1;
+
+// The kernel keeps 0x1000 message slots. Go well past that.
+static constexpr std::size_t TOTAL_MSG_TO_COMPLETE = 0x1000 * 3;
+
+TEST_CASE("msg_slots_return_to_pool_on_complete", "kernel_ipc") {
+    ntimer timing(1000000, true);
+    config::state conf;
+
+    auto kern = std::make_unique<kernel_system>(nullptr, &timing, nullptr, &conf, nullptr, nullptr, nullptr);
+
+    std::size_t total_completed = 0;
+    kern->register_ipc_complete_callback([&](ipc_msg *msg, const int complete_code) {
+        REQUIRE(complete_code == 0);
+        total_completed++;
+    });
+
+    for (std::size_t i = 0; i < TOTAL_MSG_TO_COMPLETE; i++) {
+        ipc_msg_ptr msg = kern->create_msg(kernel::owner_type::process);
+        REQUIRE(msg);
+        REQUIRE(!msg->free);
+
+        // Same path as the message complete SVCs
+        kern->complete_msg(msg, 0);
+        REQUIRE(msg->free);
+    }
+
+    REQUIRE(total_completed == TOTAL_MSG_TO_COMPLETE);
+}
+
+TEST_CASE("locked_msg_slots_stay_until_destroyed", "kernel_ipc") {
+    ntimer timing(1000000, true);
+    config::state conf;
+
+    auto kern = std::make_unique<kernel_system>(nullptr, &timing, nullptr, &conf, nullptr, nullptr, nullptr);
+
+    // What each thread does with its synchronous message, from creation to destruction
+    for (std::size_t i = 0; i < TOTAL_MSG_TO_COMPLETE; i++) {
+        ipc_msg_ptr sync_msg = kern->create_msg(kernel::owner_type::kernel);
+        REQUIRE(sync_msg);
+
+        sync_msg->lock_free();
+
+        // Completing requests made with it must not give the slot away
+        kern->complete_msg(sync_msg, 0);
+        kern->complete_msg(sync_msg, 0);
+        REQUIRE(!sync_msg->free);
+
+        ipc_msg_ptr other = kern->create_msg(kernel::owner_type::process);
+        REQUIRE(other);
+        REQUIRE(other != sync_msg);
+
+        kern->complete_msg(other, 0);
+
+        kern->destroy_msg(sync_msg);
+        REQUIRE(sync_msg->free);
+    }
+}
+
+TEST_CASE("msg_slots_in_use_are_not_handed_out_again", "kernel_ipc") {
+    ntimer timing(1000000, true);
+    config::state conf;
+
+    auto kern = std::make_unique<kernel_system>(nullptr, &timing, nullptr, &conf, nullptr, nullptr, nullptr);
+
+    ipc_msg_ptr first = kern->create_msg(kernel::owner_type::process);
+    ipc_msg_ptr second = kern->create_msg(kernel::owner_type::process);
+
+    REQUIRE(first);
+    REQUIRE(second);
+    REQUIRE(first->id != second->id);
+
+    // Freeing twice must not put the slot on the free stack twice
+    kern->free_msg(first);
+    kern->free_msg(first);
+
+    ipc_msg_ptr third = kern->create_msg(kernel::owner_type::process);
+    ipc_msg_ptr fourth = kern->create_msg(kernel::owner_type::process);
+
+    REQUIRE(third == first);
+    REQUIRE(fourth != first);
+    REQUIRE(fourth != second);
+}
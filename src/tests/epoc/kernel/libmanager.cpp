@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <kernel/libmanager.h>
+#include <loader/e32img.h>
+#include <vfs/vfs.h>
+
+#include <common/cvt.h>
+#include <common/fileutils.h>
+#include <common/path.h>
+
+#include <fstream>
+#include <memory>
+#include <string>
+
+using namespace eka2l1;
+
+static void write_test_image(const std::string &path, const std::string &content) {
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+    stream << content;
+}
+
+TEST_CASE("image_cache_reparse_modified_image", "libmanager") {
+    const std::string root = "libmanagertest";
+    const std::string image_host_path = eka2l1::add_path(root, "sys/bin/test.dll");
+    const std::u16string image_path = u"C:\\sys\\bin\\test.dll";
+
+    common::create_directories(eka2l1::add_path(root, "sys/bin/"));
+    write_test_image(image_host_path, "first image");
+
+    io_system io;
+    io.init();
+    io.add_filesystem(create_physical_filesystem(epocver::epoc94, ""));
+    io.mount_physical_path(drive_c, drive_media::physical, io_attrib::internal, common::utf8_to_ucs2(root));
+
+    std::optional<entry_info> info = io.get_entry_info(image_path);
+    REQUIRE(info);
+    REQUIRE(info->last_write != 0);
+
+    hle::image_cache cache(4);
+    const hle::parsed_image first{ std::make_shared<loader::e32img>(), nullptr };
+
+    cache.add(image_path, info->last_write, info->size, first);
+
+    // Unchanged file, path case does not matter
+    std::optional<hle::parsed_image> cached = cache.get(u"c:\\SYS\\BIN\\TEST.DLL", info->last_write, info->size, false);
+    REQUIRE(cached);
+    REQUIRE(cached->first == first.first);
+
+    // Cached image is not a ROM image
+    REQUIRE_FALSE(cache.get(image_path, info->last_write, info->size, true));
+
+    cache.add(image_path, info->last_write, info->size, first);
+    write_test_image(image_host_path, "second image, which is longer");
+
+    info = io.get_entry_info(image_path);
+    REQUIRE(info);
+
+    // Modified file must be parsed again
+    REQUIRE_FALSE(cache.get(image_path, info->last_write, info->size, false));
+    REQUIRE(cache.size() == 0);
+
+    const hle::parsed_image second{ std::make_shared<loader::e32img>(), nullptr };
+    cache.add(image_path, info->last_write, info->size, second);
+
+    cached = cache.get(image_path, info->last_write, info->size, false);
+    REQUIRE(cached);
+    REQUIRE(cached->first == second.first);
+
+    io.shutdown();
+    common::remove(image_host_path);
+}
+
+TEST_CASE("image_cache_drop_least_recently_used", "libmanager") {
+    hle::image_cache cache(2);
+    const hle::parsed_image image{ std::make_shared<loader::e32img>(), nullptr };
+
+    cache.add(u"Z:\\sys\\bin\\a.dll", 1, 10, image);
+    cache.add(u"Z:\\sys\\bin\\b.dll", 1, 10, image);
+
+    // Use A, so B becomes the least recently used one
+    REQUIRE(cache.get(u"Z:\\sys\\bin\\a.dll", 1, 10, false));
+
+    cache.add(u"Z:\\sys\\bin\\c.dll", 1, 10, image);
+
+    REQUIRE(cache.size() == 2);
+    REQUIRE(cache.get(u"Z:\\sys\\bin\\a.dll", 1, 10, false));
+    REQUIRE_FALSE(cache.get(u"Z:\\sys\\bin\\b.dll", 1, 10, false));
+
+    cache.remove_in_directory(u"z:\\sys\\bin\\");
+    REQUIRE(cache.size() == 0);
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project
+ * (see bentokun.github.com/EKA2L1).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <kernel/timing.h>
+
+#include <cstdint>
+#include <vector>
+
+using namespace eka2l1;
+
+// One tick per microsecond, so ticks and event times can be compared directly
+static constexpr std::uint32_t TEST_TIMER_HZ = 1000000;
+
+TEST_CASE("timer_fire_in_schedule_order", "timing") {
+    ntimer timing(TEST_TIMER_HZ, true);
+    std::vector<std::uint64_t> fired;
+
+    const int evt = timing.register_event("TestEvent", [&](std::uint64_t userdata, int late) {
+        fired.push_back(userdata);
+    });
+
+    timing.schedule_event(30, evt, 3);
+    timing.schedule_event(10, evt, 1);
+    timing.schedule_event(20, evt, 2);
+
+    // Same deadline: first scheduled, first fired
+    timing.schedule_event(15, evt, 4);
+    timing.schedule_event(15, evt, 5);
+
+    timing.add_ticks(100);
+
+    REQUIRE(fired == std::vector<std::uint64_t>{ 1, 4, 5, 2, 3 });
+    REQUIRE_FALSE(timing.ticks_to_next_event());
+}
+
+TEST_CASE("timer_fire_only_when_due", "timing") {
+    ntimer timing(TEST_TIMER_HZ, true);
+    std::vector<int> lateness;
+
+    const int evt = timing.register_event("TestEvent", [&](std::uint64_t userdata, int late) {
+        lateness.push_back(late);
+    });
+
+    timing.schedule_event(50, evt, 0);
+    timing.add_ticks(49);
+
+    REQUIRE(lateness.empty());
+    REQUIRE(timing.ticks_to_next_event() == 1);
+
+    timing.add_ticks(3);
+
+    REQUIRE(lateness == std::vector<int>{ 2 });
+
+    // Idle jumps straight to the next deadline
+    timing.schedule_event(1000, evt, 0);
+    timing.idle();
+
+    REQUIRE(lateness == std::vector<int>{ 2, 0 });
+    REQUIRE(timing.microseconds() == 1052);
+}
+
+TEST_CASE("timer_unschedule_earliest_first", "timing") {
+    ntimer timing(TEST_TIMER_HZ, true);
+    std::vector<std::uint64_t> fired;
+
+    const int evt = timing.register_event("TestEvent", [&](std::uint64_t userdata, int late) {
+        fired.push_back(timing.microseconds() - late);
+    });
+
+    const int other_evt = timing.register_event("OtherEvent", [&](std::uint64_t userdata, int late) {
+    });
+
+    REQUIRE_FALSE(timing.unschedule_event(evt, 7));
+
+    // Same type and userdata, scheduled out of order
+    timing.schedule_event(30, evt, 7);
+    timing.schedule_event(10, evt, 7);
+    timing.schedule_event(20, evt, 7);
+    timing.schedule_event(5, other_evt, 7);
+
+    REQUIRE(timing.unschedule_event(evt, 7));
+
+    // The one at 10 is gone, the other type is untouched
+    timing.add_ticks(25);
+
+    REQUIRE(fired == std::vector<std::uint64_t>{ 20 });
+
+    REQUIRE(timing.unschedule_event(evt, 7));
+    REQUIRE_FALSE(timing.unschedule_event(evt, 7));
+    REQUIRE_FALSE(timing.unschedule_event(other_evt, 7));
+
+    timing.add_ticks(100);
+
+    REQUIRE(fired == std::vector<std::uint64_t>{ 20 });
+    REQUIRE_FALSE(timing.ticks_to_next_event());
+}
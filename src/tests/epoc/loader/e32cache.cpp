@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project
+ * (see bentokun.github.com/EKA2L1).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <loader/e32cache.h>
+
+#include <common/fileutils.h>
+#include <common/path.h>
+
+#include <fmt/format.h>
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using namespace eka2l1;
+
+static const std::string e32_cache_test_folder = "e32cachetest";
+
+static std::vector<std::uint8_t> make_test_payload(const std::size_t size, const std::uint8_t seed) {
+    std::vector<std::uint8_t> payload(size);
+
+    for (std::size_t i = 0; i < size; i++) {
+        payload[i] = static_cast<std::uint8_t>(seed + i * 7);
+    }
+
+    return payload;
+}
+
+static std::string get_test_payload_path(const std::uint64_t key) {
+    return eka2l1::add_path(e32_cache_test_folder, fmt::format("{:016X}.bin", key));
+}
+
+TEST_CASE("e32_cache_hit_and_miss", "e32cache") {
+    const std::vector<std::uint8_t> payload = make_test_payload(0x400, 3);
+    std::vector<std::uint8_t> result(payload.size());
+
+    {
+        loader::e32_payload_cache cache(e32_cache_test_folder, 0x10000);
+
+        REQUIRE_FALSE(cache.read(1, result.data(), result.size()));
+        REQUIRE(cache.write(1, payload.data(), payload.size()));
+
+        // Read it twice, second time goes through the view kept from the first one
+        REQUIRE(cache.read(1, result.data(), result.size()));
+        REQUIRE(result == payload);
+
+        std::fill(result.begin(), result.end(), 0);
+
+        REQUIRE(cache.read(1, result.data(), result.size()));
+        REQUIRE(result == payload);
+
+        // Size mismatch is a miss
+        REQUIRE_FALSE(cache.read(1, result.data(), result.size() - 1));
+    }
+
+    // Still there on the next run
+    loader::e32_payload_cache cache(e32_cache_test_folder, 0x10000);
+    std::fill(result.begin(), result.end(), 0);
+
+    REQUIRE(cache.read(1, result.data(), result.size()));
+    REQUIRE(result == payload);
+
+    REQUIRE(common::remove(get_test_payload_path(1)));
+}
+
+TEST_CASE("e32_cache_miss_on_modified_payload", "e32cache") {
+    const std::vector<std::uint8_t> payload = make_test_payload(0x400, 5);
+    std::vector<std::uint8_t> result(payload.size());
+
+    loader::e32_payload_cache cache(e32_cache_test_folder, 0x10000);
+
+    REQUIRE(cache.write(2, payload.data(), payload.size()));
+    REQUIRE(cache.read(2, result.data(), result.size()));
+
+    const std::string path = get_test_payload_path(2);
+    std::filesystem::last_write_time(path, std::filesystem::last_write_time(path) + std::chrono::hours(1));
+
+    REQUIRE_FALSE(cache.read(2, result.data(), result.size()));
+
+    // The payload is dropped, not just skipped
+    REQUIRE_FALSE(eka2l1::exists(path));
+    REQUIRE(cache.total_size() == 0);
+}
+
+TEST_CASE("e32_cache_evict_least_recently_used", "e32cache") {
+    const std::vector<std::uint8_t> first = make_test_payload(0x400, 7);
+    const std::vector<std::uint8_t> second = make_test_payload(0x400, 11);
+    const std::vector<std::uint8_t> third = make_test_payload(0x400, 13);
+
+    std::vector<std::uint8_t> result(first.size());
+
+    // Room for only two payloads and their headers
+    loader::e32_payload_cache cache(e32_cache_test_folder, 0x900);
+
+    REQUIRE(cache.write(3, first.data(), first.size()));
+    REQUIRE(cache.write(4, second.data(), second.size()));
+
+    // Use the first one, so the second becomes the least recently used. The first one stays mapped.
+    REQUIRE(cache.read(3, result.data(), result.size()));
+    REQUIRE(cache.read(4, result.data(), result.size()));
+    REQUIRE(cache.read(3, result.data(), result.size()));
+
+    REQUIRE(cache.write(5, third.data(), third.size()));
+
+    REQUIRE_FALSE(eka2l1::exists(get_test_payload_path(4)));
+    REQUIRE_FALSE(cache.read(4, result.data(), result.size()));
+
+    REQUIRE(cache.read(3, result.data(), result.size()));
+    REQUIRE(result == first);
+
+    REQUIRE(cache.read(5, result.data(), result.size()));
+    REQUIRE(result == third);
+
+    // Too big to ever fit
+    const std::vector<std::uint8_t> huge = make_test_payload(0x1000, 17);
+    REQUIRE_FALSE(cache.write(6, huge.data(), huge.size()));
+}
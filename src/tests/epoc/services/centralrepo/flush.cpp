@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <catch2/catch.hpp>
+#include <config/config.h>
+#include <kernel/kernel.h>
+#include <kernel/timing.h>
+#include <services/centralrepo/centralrepo.h>
+
+#include <future>
+#include <memory>
+
+using namespace eka2l1;
+
+static constexpr std::int64_t TEST_FLUSH_IDLE_TIME_US = 100;
+
+TEST_CASE("cenrep_flush_after_idle_time", "centralrepo") {
+    ntimer timing(1000000, true);
+    config::state conf;
+
+    auto kern = std::make_unique<kernel_system>(nullptr, &timing, nullptr, &conf, nullptr, nullptr, nullptr);
+
+    int total_flush = 0;
+    bool kernel_locked_on_flush = false;
+
+    central_repo_idle_flusher flusher(kern.get(), &timing, [&]() {
+        // Try from another thread, the kernel lock is not recursive
+        kernel_locked_on_flush = !std::async(std::launch::async, [&]() {
+            if (!kern->try_lock()) {
+                return false;
+            }
+
+            kern->unlock();
+            return true;
+        }).get();
+
+        total_flush++;
+    }, TEST_FLUSH_IDLE_TIME_US);
+
+    flusher.schedule();
+    timing.add_ticks(60);
+
+    // Another change before the idle time is over pushes the flush back
+    flusher.schedule();
+    timing.add_ticks(60);
+
+    REQUIRE(total_flush == 0);
+    REQUIRE(flusher.is_scheduled());
+
+    timing.add_ticks(40);
+
+    REQUIRE(total_flush == 1);
+    REQUIRE(kernel_locked_on_flush);
+    REQUIRE_FALSE(flusher.is_scheduled());
+    REQUIRE_FALSE(timing.ticks_to_next_event());
+
+    // Flushed once per burst of changes
+    flusher.schedule();
+    flusher.schedule();
+    timing.idle();
+
+    REQUIRE(total_flush == 2);
+    REQUIRE_FALSE(timing.ticks_to_next_event());
+}
+
+TEST_CASE("cenrep_flush_cancelled", "centralrepo") {
+    ntimer timing(1000000, true);
+    config::state conf;
+
+    auto kern = std::make_unique<kernel_system>(nullptr, &timing, nullptr, &conf, nullptr, nullptr, nullptr);
+    int total_flush = 0;
+
+    {
+        central_repo_idle_flusher flusher(kern.get(), &timing, [&]() {
+            total_flush++;
+        }, TEST_FLUSH_IDLE_TIME_US);
+
+        flusher.schedule();
+        flusher.cancel();
+
+        REQUIRE_FALSE(flusher.is_scheduled());
+        REQUIRE_FALSE(timing.ticks_to_next_event());
+
+        // Still waiting when the flusher goes away
+        flusher.schedule();
+    }
+
+    REQUIRE_FALSE(timing.ticks_to_next_event());
+
+    timing.add_ticks(TEST_FLUSH_IDLE_TIME_US * 2);
+    REQUIRE(total_flush == 0);
+}
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2019 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project 
+ * (see bentokun.github.com/EKA2L1).
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <services/centralrepo/repo.h>
+
+#include <algorithm>
+#include <vector>
+
+using namespace eka2l1;
+
+static central_repo_entry_variant make_int_variant(const std::uint64_t value) {
+    central_repo_entry_variant var;
+    var.etype = central_repo_entry_type::integer;
+    var.intd = value;
+
+    return var;
+}
+
+static std::vector<std::uint32_t> get_keys(const std::vector<central_repo_entry *> &entries) {
+    std::vector<std::uint32_t> keys;
+
+    for (central_repo_entry *entry : entries) {
+        keys.push_back(entry->key);
+    }
+
+    return keys;
+}
+
+TEST_CASE("entries_stay_sorted_on_insert", "centralrepo") {
+    central_repo repo;
+
+    const std::vector<std::uint32_t> keys = { 0x500, 0x10, 0x7FFFFFFF, 0x20, 0x1, 0xFFFFFFFF, 0x300 };
+
+    for (const std::uint32_t key : keys) {
+        REQUIRE(repo.add_new_entry(key, make_int_variant(key), 0));
+    }
+
+    // Keys are unique
+    REQUIRE_FALSE(repo.add_new_entry(0x20, make_int_variant(0), 0));
+    REQUIRE(repo.entries.size() == keys.size());
+
+    REQUIRE(std::is_sorted(repo.entries.begin(), repo.entries.end(), [](const central_repo_entry &lhs, const central_repo_entry &rhs) {
+        return lhs.key < rhs.key;
+    }));
+
+    for (const std::uint32_t key : keys) {
+        central_repo_entry *entry = repo.find_entry(key);
+
+        REQUIRE(entry);
+        REQUIRE(entry->key == key);
+        REQUIRE(entry->data.intd == key);
+    }
+
+    REQUIRE_FALSE(repo.find_entry(0));
+    REQUIRE_FALSE(repo.find_entry(0x21));
+}
+
+TEST_CASE("entries_sort_after_direct_fill", "centralrepo") {
+    central_repo repo;
+
+    for (const std::uint32_t key : { 0x30, 0x10, 0x20 }) {
+        central_repo_entry entry;
+        entry.key = key;
+        entry.data = make_int_variant(key);
+        entry.metadata_val = 0;
+
+        repo.entries.push_back(entry);
+    }
+
+    repo.sort_entries();
+
+    REQUIRE(repo.entries[0].key == 0x10);
+    REQUIRE(repo.entries[2].key == 0x30);
+    REQUIRE(repo.find_entry(0x20));
+}
+
+TEST_CASE("entries_range_and_mask_query", "centralrepo") {
+    central_repo repo;
+
+    const std::vector<std::uint32_t> keys = { 0x01000001, 0x01000002, 0x01010001, 0x02000001, 0x02B10B52, 0x07B10B52, 0x07B30B11 };
+
+    for (const std::uint32_t key : keys) {
+        repo.add_new_entry(key, make_int_variant(0), 0);
+    }
+
+    std::vector<central_repo_entry *> result;
+
+    repo.find_entries_in_range(0x01000002, 0x02000001, result);
+    REQUIRE(get_keys(result) == std::vector<std::uint32_t>{ 0x01000002, 0x01010001, 0x02000001 });
+
+    result.clear();
+    repo.find_entries_in_range(0x03000000, 0x02000000, result);
+    REQUIRE(result.empty());
+
+    // Every key with the high byte set to 1
+    result.clear();
+    repo.find_entries_by_mask(0x01FFFFFF, 0xFF000000, result);
+    REQUIRE(get_keys(result) == std::vector<std::uint32_t>{ 0x01000001, 0x01000002, 0x01010001 });
+
+    // Mask with holes, matches must be checked against the mask, not only the range
+    result.clear();
+    repo.find_entries_by_mask(0x00B10000, 0x00FF0000, result);
+    REQUIRE(get_keys(result) == std::vector<std::uint32_t>{ 0x02B10B52, 0x07B10B52 });
+
+    // Empty mask matches everything, full mask is an exact lookup
+    result.clear();
+    repo.find_entries_by_mask(0x12345678, 0, result);
+    REQUIRE(result.size() == keys.size());
+
+    result.clear();
+    repo.find_entries_by_mask(0x07B30B11, 0xFFFFFFFF, result);
+    REQUIRE(get_keys(result) == std::vector<std::uint32_t>{ 0x07B30B11 });
+
+    // Result of the legacy query stays the same as a full scan
+    std::vector<central_repo_entry *> queried;
+    repo.query_entries(0x03B10000, 0xF0FF0000, queried, central_repo_entry_type::integer);
+
+    std::vector<std::uint32_t> expected;
+
+    for (const std::uint32_t key : keys) {
+        if (key & (0x03B10000 & 0xF0FF0000)) {
+            expected.push_back(key);
+        }
+    }
+
+    REQUIRE(get_keys(queried) == expected);
+}
+
+TEST_CASE("repo_dirty_flag", "centralrepo") {
+    central_repo repo;
+    REQUIRE_FALSE(repo.dirty);
+
+    // Nothing changed, nothing to write
+    REQUIRE_FALSE(repo.flush_changes(nullptr, nullptr));
+
+    repo.mark_dirty();
+    REQUIRE(repo.dirty);
+}
@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2019 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project 
+ * (see bentokun.github.com/EKA2L1).
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <services/ecom/registry.h>
+
+#include <common/fileutils.h>
+
+#include <memory>
+#include <string>
+
+using namespace eka2l1;
+
+static ecom_plugin_record make_test_record(const std::u16string &path, const std::uint32_t interface_uid,
+    const std::uint32_t impl_uid) {
+    ecom_plugin_record record;
+    record.path_ = path;
+    record.drv_ = drive_z;
+    record.last_write_ = 1000;
+    record.size_ = 200;
+
+    ecom_implementation_info_ptr impl = std::make_shared<ecom_implementation_info>();
+    impl->uid = impl_uid;
+    impl->version = 2;
+    impl->format = 1;
+    impl->drv = drive_z;
+    impl->original_name = u"testplugin";
+    impl->display_name = u"Test implementation";
+    impl->default_data = "text/plain";
+    impl->opaque_data = "opaque";
+    impl->extended_interfaces = { 0x10001, 0x10002 };
+
+    // Only flags that come from the plugin resource should survive
+    impl->flags = ecom_implementation_info::FLAG_ROM_ONLY | ecom_implementation_info::FLAG_IMPL_CREATE_INFO_CACHED;
+
+    ecom_interface_info interface;
+    interface.uid = interface_uid;
+    interface.implementations.push_back(impl);
+
+    record.interfaces_.push_back(interface);
+    return record;
+}
+
+TEST_CASE("ecom_registry_cache_round_trip", "ecom") {
+    const std::string cache_path = "ecomregistrytest.bin";
+    common::remove(cache_path);
+
+    {
+        ecom_registry_cache cache(cache_path);
+        REQUIRE_FALSE(cache.load());
+
+        cache.add_record(make_test_record(u"Z:\\Resource\\Plugins\\Test.rsc", 0x101F7C8C, 0x20001234));
+        cache.add_record(make_test_record(u"Z:\\Resource\\Plugins\\Other.rsc", 0x101F7C8C, 0x20005678));
+
+        REQUIRE(cache.save());
+    }
+
+    ecom_registry_cache cache(cache_path);
+    REQUIRE(cache.load());
+    REQUIRE(cache.size() == 2);
+
+    // Lookup ignores case, and requires the source to be unchanged
+    REQUIRE(cache.get_record(u"z:\\resource\\plugins\\test.rsc"));
+    REQUIRE(cache.get_up_to_date_record(u"Z:\\Resource\\Plugins\\Test.rsc", 1000, 200));
+    REQUIRE_FALSE(cache.get_up_to_date_record(u"Z:\\Resource\\Plugins\\Test.rsc", 1001, 200));
+    REQUIRE_FALSE(cache.get_up_to_date_record(u"Z:\\Resource\\Plugins\\Test.rsc", 1000, 201));
+
+    ecom_plugin_record *record = cache.get_record(u"Z:\\Resource\\Plugins\\Test.rsc");
+    REQUIRE(record->interfaces_.size() == 1);
+    REQUIRE(record->interfaces_[0].uid == 0x101F7C8C);
+    REQUIRE(record->interfaces_[0].implementations.size() == 1);
+
+    const ecom_implementation_info &impl = *record->interfaces_[0].implementations[0];
+    REQUIRE(impl.uid == 0x20001234);
+    REQUIRE(impl.version == 2);
+    REQUIRE(impl.format == 1);
+    REQUIRE(impl.drv == drive_z);
+    REQUIRE(impl.original_name == u"testplugin");
+    REQUIRE(impl.display_name == u"Test implementation");
+    REQUIRE(impl.default_data == "text/plain");
+    REQUIRE(impl.opaque_data == "opaque");
+    REQUIRE(impl.extended_interfaces == std::vector<std::uint32_t>{ 0x10001, 0x10002 });
+    REQUIRE(impl.flags == ecom_implementation_info::FLAG_ROM_ONLY);
+
+    // Records of sources that are gone are dropped
+    cache.retain_records({ u"Z:\\RESOURCE\\PLUGINS\\OTHER.RSC" });
+    REQUIRE(cache.size() == 1);
+    REQUIRE_FALSE(cache.get_record(u"Z:\\Resource\\Plugins\\Test.rsc"));
+
+    REQUIRE(cache.remove_record(u"Z:\\Resource\\Plugins\\Other.rsc"));
+    REQUIRE(cache.size() == 0);
+
+    common::remove(cache_path);
+}
+
+TEST_CASE("ecom_registry_cache_rejects_truncated_file", "ecom") {
+    const std::string cache_path = "ecomregistrytruncated.bin";
+
+    {
+        ecom_registry_cache cache(cache_path);
+        cache.add_record(make_test_record(u"Z:\\Resource\\Plugins\\Test.rsc", 0x101F7C8C, 0x20001234));
+
+        REQUIRE(cache.save());
+    }
+
+    const std::uint64_t size = common::file_size(cache_path);
+    REQUIRE(common::resize(cache_path, size - 6) == 0);
+
+    ecom_registry_cache cache(cache_path);
+    REQUIRE_FALSE(cache.load());
+    REQUIRE(cache.size() == 0);
+
+    common::remove(cache_path);
+}
+
+TEST_CASE("ecom_plugin_source_invalid_data", "ecom") {
+    ecom_plugin_record record;
+    record.path_ = u"Z:\\Resource\\Plugins\\Broken.rsc";
+
+    REQUIRE_FALSE(parse_ecom_plugin_source(record, nullptr, 0));
+
+    std::vector<ecom_plugin_parse_job> jobs(4);
+
+    for (ecom_plugin_parse_job &job : jobs) {
+        job.record_.path_ = u"Z:\\Private\\10009d8f\\ecom-0-0.spi";
+        job.record_.archive_ = true;
+        job.data_.resize(16, 0xCD);
+    }
+
+    // Invalid sources are only logged, and their buffers are freed
+    parse_ecom_plugin_sources(jobs);
+
+    for (ecom_plugin_parse_job &job : jobs) {
+        REQUIRE(job.record_.interfaces_.empty());
+        REQUIRE(job.data_.empty());
+    }
+}
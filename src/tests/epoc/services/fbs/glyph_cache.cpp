@@ -0,0 +1,326 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <services/fbs/glyph_bitmap_cache.h>
+#include <services/fbs/glyph_cache.h>
+#include <services/fbs/glyph_prerasterize_pool.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace eka2l1;
+
+// Every glyph is a square, packed from left to right in the atlas.
+class square_font_adapter : public epoc::adapter::font_file_adapter_base {
+    struct atlas_target {
+        std::uint8_t *data_;
+        eka2l1::vec2 size_;
+    };
+
+    std::vector<atlas_target> atlases_;
+    std::mutex lock_;
+
+public:
+    int glyph_size_ = 16;
+    std::atomic<int> rasterize_calls_{ 0 };
+
+    bool is_valid() override {
+        return true;
+    }
+
+    bool get_face_attrib(const std::size_t idx, epoc::open_font_face_attrib &face_attrib) override {
+        return false;
+    }
+
+    bool get_metrics(const std::size_t idx, epoc::open_font_metrics &metrics) override {
+        return false;
+    }
+
+    bool get_glyph_metric(const std::size_t idx, std::uint32_t code, epoc::open_font_character_metric &metric,
+        const std::int32_t baseline_horz_off, const float scale_x, const float scale_y) override {
+        return false;
+    }
+
+    std::uint8_t *get_glyph_bitmap(const std::size_t idx, std::uint32_t code, const float scale_x,
+        const float scale_y, int *rasterized_width, int *rasterized_height, std::uint32_t &total_size, epoc::glyph_bitmap_type *bmp_type) override {
+        return nullptr;
+    }
+
+    void free_glyph_bitmap(std::uint8_t *data) override {
+    }
+
+    epoc::glyph_bitmap_type get_output_bitmap_type() const override {
+        return epoc::glyph_bitmap_type::antialised_glyph_bitmap;
+    }
+
+    bool does_glyph_exist(std::size_t idx, std::uint32_t code) override {
+        return true;
+    }
+
+    std::int32_t begin_get_atlas(std::uint8_t *atlas_ptr, const eka2l1::vec2 atlas_size) override {
+        const std::lock_guard<std::mutex> guard(lock_);
+        atlases_.push_back({ atlas_ptr, atlas_size });
+
+        return static_cast<std::int32_t>(atlases_.size() - 1);
+    }
+
+    bool get_glyph_atlas(const std::int32_t handle, const std::size_t idx, const char16_t start_code, int *unicode_point,
+        const char16_t num_code, const int font_size, epoc::adapter::character_info *info) override {
+        atlas_target target;
+
+        {
+            const std::lock_guard<std::mutex> guard(lock_);
+            target = atlases_[handle];
+        }
+
+        const int per_row = target.size_.x / glyph_size_;
+
+        if (num_code > per_row * (target.size_.y / glyph_size_)) {
+            return false;
+        }
+
+        rasterize_calls_++;
+
+        for (char16_t i = 0; i < num_code; i++) {
+            const int x = (i % per_row) * glyph_size_;
+            const int y = (i / per_row) * glyph_size_;
+
+            for (int py = 0; py < glyph_size_; py++) {
+                for (int px = 0; px < glyph_size_; px++) {
+                    target.data_[(y + py) * target.size_.x + x + px] = static_cast<std::uint8_t>(unicode_point[i]);
+                }
+            }
+
+            info[i].x0 = static_cast<std::uint16_t>(x);
+            info[i].y0 = static_cast<std::uint16_t>(y);
+            info[i].x1 = static_cast<std::uint16_t>(x + glyph_size_);
+            info[i].y1 = static_cast<std::uint16_t>(y + glyph_size_);
+            info[i].xoff = 0.0f;
+            info[i].yoff = static_cast<float>(-glyph_size_);
+            info[i].xoff2 = static_cast<float>(glyph_size_);
+            info[i].yoff2 = 0.0f;
+            info[i].xadv = static_cast<float>(glyph_size_);
+        }
+
+        return true;
+    }
+
+    void end_get_atlas(const std::int32_t handle) override {
+    }
+
+    std::size_t count() override {
+        return 1;
+    }
+
+    std::uint32_t unique_id(const std::size_t face_index) override {
+        return 0;
+    }
+};
+
+// A 64x64 page fits 3 rows of 3 glyphs of 16 pixels, padding included
+static constexpr int TEST_PAGE_SIZE = 64;
+static constexpr std::size_t GLYPHS_PER_TEST_PAGE = 9;
+
+TEST_CASE("glyph_cache_hit_after_miss", "glyph_cache") {
+    square_font_adapter adapter;
+    epoc::glyph_cache cache(TEST_PAGE_SIZE, 1);
+    std::vector<const epoc::cached_glyph *> glyphs;
+
+    cache.begin_use();
+    REQUIRE(cache.get_glyphs(&adapter, 0, 16, u"ABA", glyphs));
+    REQUIRE(glyphs.size() == 3);
+    REQUIRE(glyphs[0] == glyphs[2]);
+    REQUIRE(glyphs[0]->page_ == 0);
+    REQUIRE(glyphs[0]->info_.x1 - glyphs[0]->info_.x0 == 16);
+    REQUIRE(cache.get_stats().misses_ == 2);
+    REQUIRE(adapter.rasterize_calls_ == 1);
+
+    cache.begin_use();
+    REQUIRE(cache.get_glyphs(&adapter, 0, 16, u"BA", glyphs));
+    REQUIRE(cache.get_stats().hits_ == 2);
+    REQUIRE(cache.get_stats().misses_ == 2);
+    REQUIRE(adapter.rasterize_calls_ == 1);
+
+    // Same codepoint but another size is another glyph
+    REQUIRE(!cache.contains({ &adapter, 0, 20, u'A' }));
+    REQUIRE(cache.size() == 2);
+}
+
+TEST_CASE("glyph_cache_evict_least_recently_used", "glyph_cache") {
+    square_font_adapter adapter;
+    epoc::glyph_cache cache(TEST_PAGE_SIZE, 1);
+    std::vector<const epoc::cached_glyph *> glyphs;
+
+    std::u16string full_page;
+
+    for (std::size_t i = 0; i < GLYPHS_PER_TEST_PAGE; i++) {
+        full_page += static_cast<char16_t>(u'A' + i);
+    }
+
+    cache.begin_use();
+    REQUIRE(cache.get_glyphs(&adapter, 0, 16, full_page, glyphs));
+    REQUIRE(cache.size() == GLYPHS_PER_TEST_PAGE);
+
+    // Touch the first glyph, B becomes the least recently used
+    cache.begin_use();
+    REQUIRE(cache.get_glyphs(&adapter, 0, 16, u"A", glyphs));
+
+    cache.begin_use();
+    REQUIRE(cache.get_glyphs(&adapter, 0, 16, u"Z", glyphs));
+    REQUIRE(glyphs[0]->page_ == 0);
+
+    REQUIRE(cache.get_stats().evictions_ == 1);
+    REQUIRE(cache.page_count() == 1);
+    REQUIRE(cache.contains({ &adapter, 0, 16, u'A' }));
+    REQUIRE(!cache.contains({ &adapter, 0, 16, u'B' }));
+    REQUIRE(cache.contains({ &adapter, 0, 16, u'Z' }));
+}
+
+TEST_CASE("glyph_cache_keep_glyphs_in_use", "glyph_cache") {
+    square_font_adapter adapter;
+    epoc::glyph_cache cache(TEST_PAGE_SIZE, 1);
+    std::vector<const epoc::cached_glyph *> glyphs;
+
+    std::u16string too_long;
+
+    for (std::size_t i = 0; i <= GLYPHS_PER_TEST_PAGE; i++) {
+        too_long += static_cast<char16_t>(u'A' + i);
+    }
+
+    // The whole string is in use, nothing can be evicted for the last glyph
+    cache.begin_use();
+    REQUIRE(!cache.get_glyphs(&adapter, 0, 16, too_long, glyphs));
+    REQUIRE(cache.get_stats().evictions_ == 0);
+    REQUIRE(cache.size() == GLYPHS_PER_TEST_PAGE);
+
+    std::size_t cached_count = 0;
+
+    for (const epoc::cached_glyph *glyph : glyphs) {
+        if (glyph) {
+            cached_count++;
+        }
+    }
+
+    REQUIRE(cached_count == GLYPHS_PER_TEST_PAGE);
+}
+
+TEST_CASE("glyph_cache_add_pages", "glyph_cache") {
+    square_font_adapter adapter;
+    epoc::glyph_cache cache(TEST_PAGE_SIZE, 2);
+    std::vector<const epoc::cached_glyph *> glyphs;
+
+    std::u16string two_pages;
+
+    for (std::size_t i = 0; i < GLYPHS_PER_TEST_PAGE * 2; i++) {
+        two_pages += static_cast<char16_t>(u'A' + i);
+    }
+
+    cache.begin_use();
+    REQUIRE(cache.get_glyphs(&adapter, 0, 16, two_pages, glyphs));
+    REQUIRE(cache.page_count() == 2);
+    REQUIRE(glyphs.front()->page_ == 0);
+    REQUIRE(glyphs.back()->page_ == 1);
+    REQUIRE(cache.get_stats().evictions_ == 0);
+}
+
+TEST_CASE("glyph_cache_prerasterize_from_threads", "glyph_cache") {
+    square_font_adapter adapter;
+    epoc::glyph_cache cache(TEST_PAGE_SIZE, 2);
+    std::vector<const epoc::cached_glyph *> glyphs;
+
+    std::vector<std::thread> workers;
+
+    // Overlapping ranges, each glyph must still be cached only once
+    for (int i = 0; i < 4; i++) {
+        workers.emplace_back([&, i]() {
+            std::u16string text;
+
+            for (int j = 0; j < 8; j++) {
+                text += static_cast<char16_t>(u'A' + i + j);
+            }
+
+            cache.prerasterize(&adapter, 0, 16, text);
+        });
+    }
+
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+
+    REQUIRE(cache.size() == 11);
+
+    cache.begin_use();
+    REQUIRE(cache.get_glyphs(&adapter, 0, 16, u"ABCDEFGHIJK", glyphs));
+    REQUIRE(cache.get_stats().hits_ == 11);
+    REQUIRE(cache.get_stats().misses_ == 0);
+}
+
+TEST_CASE("glyph_cache_prerasterized_glyphs_are_not_pinned", "glyph_cache") {
+    square_font_adapter adapter;
+    epoc::glyph_cache cache(TEST_PAGE_SIZE, 1);
+    std::vector<const epoc::cached_glyph *> glyphs;
+
+    std::u16string full_page;
+
+    for (std::size_t i = 0; i < GLYPHS_PER_TEST_PAGE; i++) {
+        full_page += static_cast<char16_t>(u'a' + i);
+    }
+
+    REQUIRE(cache.prerasterize(&adapter, 0, 16, full_page) == GLYPHS_PER_TEST_PAGE);
+
+    // Drawing right away can still make room
+    cache.begin_use();
+    REQUIRE(cache.get_glyphs(&adapter, 0, 16, u"XYZ", glyphs));
+    REQUIRE(cache.get_stats().evictions_ == 3);
+}
+
+TEST_CASE("glyph_prerasterize_pool_fill_both_caches", "glyph_cache") {
+    square_font_adapter adapter;
+    epoc::glyph_cache atlas_cache;
+    epoc::glyph_bitmap_cache bitmap_cache;
+
+    epoc::glyph_prerasterize_pool pool(&bitmap_cache, &atlas_cache, 2);
+
+    epoc::glyph_prerasterize_request request;
+    request.adapter_ = &adapter;
+    request.font_size_ = 16;
+
+    pool.queue(request);
+
+    // Already requested, ignored
+    pool.queue(request);
+
+    while (pool.pending_count() != 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    REQUIRE(atlas_cache.size() == epoc::PRERASTERIZE_GLYPH_COUNT);
+    REQUIRE(bitmap_cache.size() == epoc::PRERASTERIZE_GLYPH_COUNT);
+
+    REQUIRE(atlas_cache.contains({ &adapter, 0, 16, u'A' }));
+
+    epoc::rasterized_glyph_ptr glyph = bitmap_cache.get({ &adapter, 0, 1.0f, 1.0f, u'A' });
+    REQUIRE(glyph);
+    REQUIRE(glyph->exists_);
+}
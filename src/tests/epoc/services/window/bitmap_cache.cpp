@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <catch2/catch.hpp>
+#include <drivers/graphics/backend/null/graphics_null.h>
+#include <drivers/itc.h>
+#include <services/fbs/fbs.h>
+#include <services/window/bitmap_cache.h>
+
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace eka2l1;
+
+// Two bands, the second one has only 4 rows
+static const eka2l1::vec2 TEST_BITMAP_SIZE = { 4, epoc::BITMAP_CACHE_BAND_ROWS + 4 };
+static constexpr std::uint32_t TEST_BITMAP_BYTE_WIDTH = 16;
+static constexpr int TEST_BITMAP_DATA_OFFSET = 0x100;
+
+// Textures are created synchronously, so the driver has to run on its own thread
+struct test_driver_thread {
+    drivers::null_graphics_driver driver;
+    std::thread thread;
+
+    test_driver_thread() {
+        driver.set_software_rendering(true);
+        thread = std::thread([this]() { driver.run(); });
+    }
+
+    ~test_driver_thread() {
+        driver.abort();
+        thread.join();
+    }
+};
+
+static void construct_test_bitmap(epoc::bitwise_bitmap &bmp, std::vector<std::uint8_t> &large_chunk) {
+    loader::sbm_header header{};
+    header.header_len = sizeof(loader::sbm_header);
+    header.bitmap_size = TEST_BITMAP_BYTE_WIDTH * TEST_BITMAP_SIZE.y + header.header_len;
+    header.size_pixels = TEST_BITMAP_SIZE;
+    header.bit_per_pixels = 32;
+    header.color = epoc::color_bitmap_with_alpha;
+    header.compression = epoc::bitmap_file_no_compression;
+
+    bmp.construct(header, epoc::display_mode::color16ma, large_chunk.data() + TEST_BITMAP_DATA_OFFSET,
+        large_chunk.data(), true);
+}
+
+static drivers::handle upload_test_bitmap(drivers::null_graphics_driver &driver, epoc::bitmap_cache &cache, epoc::bitwise_bitmap &bmp) {
+    std::unique_ptr<drivers::graphics_command_list> list = driver.new_command_list();
+    std::unique_ptr<drivers::graphics_command_list_builder> builder = driver.new_command_builder(list.get());
+
+    const drivers::handle h = cache.add_or_get(&driver, builder.get(), &bmp);
+
+    // The driver thread waits for the next list, so it's safe to execute the uploads here
+    static_cast<drivers::server_graphics_command_list *>(list.get())->list_.for_each([&](drivers::command *cmd) {
+        driver.dispatch(cmd);
+    });
+
+    return h;
+}
+
+static void write_test_pixel(std::vector<std::uint8_t> &large_chunk, const int x, const int y) {
+    std::uint8_t *pixel = large_chunk.data() + TEST_BITMAP_DATA_OFFSET + y * TEST_BITMAP_BYTE_WIDTH + x * 4;
+
+    pixel[0] = 0;
+    pixel[1] = 0;
+    pixel[2] = 255;
+    pixel[3] = 255;
+}
+
+TEST_CASE("bitmap_cache_reupload_guest_written_bitmap", "bitmap_cache") {
+    test_driver_thread drv;
+    fbs_bitmap_generation_table generations;
+
+    std::vector<std::uint8_t> large_chunk(0x1000);
+    epoc::bitmap_cache cache(&generations, large_chunk.data());
+
+    epoc::bitwise_bitmap bmp{};
+    construct_test_bitmap(bmp, large_chunk);
+
+    // What the server does with a bitmap loaded from a MBM file
+    generations.touch(&bmp);
+    generations.mark_guest_writable(&bmp);
+
+    const drivers::handle h = upload_test_bitmap(drv.driver, cache, bmp);
+
+    REQUIRE(h != 0);
+    REQUIRE(cache.get_stats().uploads_ == 1);
+
+    // Guest writes through the data address, nobody tells the server
+    write_test_pixel(large_chunk, 1, epoc::BITMAP_CACHE_BAND_ROWS + 1);
+
+    // Guest code did not run in this batch as far as the cache knows
+    REQUIRE(upload_test_bitmap(drv.driver, cache, bmp) == h);
+    REQUIRE(cache.get_stats().uploads_ == 1);
+
+    cache.invalidate_verification();
+    REQUIRE(upload_test_bitmap(drv.driver, cache, bmp) == h);
+
+    // Only the second band goes up again
+    REQUIRE(cache.get_stats().uploads_ == 2);
+    REQUIRE(cache.get_stats().bytes_uploaded_ == TEST_BITMAP_BYTE_WIDTH * (TEST_BITMAP_SIZE.y + 4));
+
+    // Nothing changed since then
+    cache.invalidate_verification();
+    upload_test_bitmap(drv.driver, cache, bmp);
+
+    REQUIRE(cache.get_stats().uploads_ == 2);
+}
+
+TEST_CASE("bitmap_cache_trust_server_only_bitmap_generation", "bitmap_cache") {
+    test_driver_thread drv;
+    fbs_bitmap_generation_table generations;
+
+    std::vector<std::uint8_t> large_chunk(0x1000);
+    epoc::bitmap_cache cache(&generations, large_chunk.data());
+
+    epoc::bitwise_bitmap bmp{};
+    construct_test_bitmap(bmp, large_chunk);
+
+    generations.touch(&bmp);
+    upload_test_bitmap(drv.driver, cache, bmp);
+
+    REQUIRE(cache.get_stats().uploads_ == 1);
+
+    // Not hashed again until the server says it wrote to the bitmap
+    write_test_pixel(large_chunk, 0, 0);
+    cache.invalidate_verification();
+    upload_test_bitmap(drv.driver, cache, bmp);
+
+    REQUIRE(cache.get_stats().uploads_ == 1);
+
+    generations.touch(&bmp);
+    upload_test_bitmap(drv.driver, cache, bmp);
+
+    REQUIRE(cache.get_stats().uploads_ == 2);
+    REQUIRE(cache.get_stats().bytes_uploaded_ == TEST_BITMAP_BYTE_WIDTH * (TEST_BITMAP_SIZE.y + epoc::BITMAP_CACHE_BAND_ROWS));
+}
@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project 
+ * (see bentokun.github.com/EKA2L1).
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <loader/btrace.h>
+
+#include <common/buffer.h>
+#include <common/log.h>
+
+#include <fmt/format.h>
+
+#include <bitset>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace eka2l1;
+
+static const char *get_category_name(const std::uint8_t category) {
+    switch (category) {
+    case 0:
+        return "RDebugPrintf";
+    case 1:
+        return "KernPrintf";
+    case 2:
+        return "PlatsecPrintf";
+    case 3:
+        return "ThreadIdentification";
+    case 4:
+        return "CpuUsage";
+    case 5:
+        return "KernPerfLog";
+    case 6:
+        return "ClientServer";
+    case 7:
+        return "Requests";
+    case 8:
+        return "Chunks";
+    case 9:
+        return "CodeSegs";
+    case 10:
+        return "Paging";
+    case 11:
+        return "ThreadPriority";
+    case 12:
+        return "PagingMedia";
+    case 13:
+        return "KernelMemory";
+    case 14:
+        return "Heap";
+    case 15:
+        return "MetaTrace";
+    case 16:
+        return "RamAllocator";
+    case 17:
+        return "FastMutex";
+    case 18:
+        return "Profiling";
+    default:
+        break;
+    }
+
+    return nullptr;
+}
+
+static bool parse_category_filter(const std::string &list, std::bitset<256> &filter) {
+    std::size_t start = 0;
+
+    while (start <= list.length()) {
+        std::size_t end = list.find(',', start);
+
+        if (end == std::string::npos) {
+            end = list.length();
+        }
+
+        const std::string token = list.substr(start, end - start);
+        bool found = false;
+
+        for (int i = 0; i < 256; i++) {
+            const char *name = get_category_name(static_cast<std::uint8_t>(i));
+
+            if (name && (token == name)) {
+                filter.set(i);
+                found = true;
+
+                break;
+            }
+        }
+
+        if (!found) {
+            char *parse_end = nullptr;
+            const unsigned long category = std::strtoul(token.c_str(), &parse_end, 0);
+
+            if (token.empty() || (*parse_end != '\0') || (category > 255)) {
+                LOG_ERROR("Unknown category: {}", token);
+                return false;
+            }
+
+            filter.set(category);
+        }
+
+        start = end + 1;
+    }
+
+    return true;
+}
+
+static void print_record_text(const loader::btrace::record &rec) {
+    const std::uint32_t a0 = rec.args_[0];
+    const std::uint8_t category = loader::btrace::get_header_field(a0, loader::btrace::header_category_index);
+    const char *category_name = get_category_name(category);
+
+    fmt::print("[{:>12}us] Thread {} - {} ({}), subcategory = {}, size = {}, flags = 0x{:X}\n", rec.timestamp_,
+        rec.thread_id_, category_name ? category_name : "Unknown", category,
+        loader::btrace::get_header_field(a0, loader::btrace::header_subcategory_index),
+        loader::btrace::get_header_field(a0, loader::btrace::header_size_index),
+        loader::btrace::get_header_field(a0, loader::btrace::header_flag_index));
+
+    fmt::print("\ta1 = 0x{:X}\n\ta2 = 0x{:X}\n\ta3 = 0x{:X}\n", rec.args_[1], rec.args_[2], rec.args_[3]);
+}
+
+static void print_record_json(const loader::btrace::record &rec, const bool first) {
+    const std::uint32_t a0 = rec.args_[0];
+
+    fmt::print("{}\n    {{ \"timestamp\": {}, \"thread\": {}, \"category\": {}, \"subcategory\": {}, \"size\": {}, "
+               "\"flags\": {}, \"a1\": {}, \"a2\": {}, \"a3\": {} }}",
+        first ? "" : ",", rec.timestamp_, rec.thread_id_,
+        loader::btrace::get_header_field(a0, loader::btrace::header_category_index),
+        loader::btrace::get_header_field(a0, loader::btrace::header_subcategory_index),
+        loader::btrace::get_header_field(a0, loader::btrace::header_size_index),
+        loader::btrace::get_header_field(a0, loader::btrace::header_flag_index),
+        rec.args_[1], rec.args_[2], rec.args_[3]);
+}
+
+static void print_usage() {
+    LOG_INFO("Usage: btracedump [filename] [-json] [-c category,...].");
+    LOG_INFO("Categories can be given by number or by name (for example: ClientServer,Heap).");
+}
+
+int main(int argc, char **argv) {
+    eka2l1::log::setup_log(nullptr);
+
+    if (argc <= 1) {
+        LOG_ERROR("No file provided!");
+        print_usage();
+
+        return -1;
+    }
+
+    const char *target_trace = argv[1];
+
+    bool as_json = false;
+    std::bitset<256> filter;
+
+    for (int i = 2; i < argc; i++) {
+        if (std::strcmp(argv[i], "-json") == 0) {
+            as_json = true;
+        } else if ((std::strcmp(argv[i], "-c") == 0) && (i + 1 < argc)) {
+            if (!parse_category_filter(argv[++i], filter)) {
+                return -1;
+            }
+        } else {
+            LOG_ERROR("Unknown option: {}", argv[i]);
+            print_usage();
+
+            return -1;
+        }
+    }
+
+    // No filter means every category passes
+    if (filter.none()) {
+        filter.set();
+    }
+
+    common::ro_std_file_stream stream(target_trace, true);
+
+    if (!stream.valid()) {
+        LOG_ERROR("Unable to open trace file {}!", target_trace);
+        return -2;
+    }
+
+    std::vector<loader::btrace::record> records;
+
+    if (!loader::btrace::read_capture(&stream, records)) {
+        LOG_ERROR("The file is not a BTrace capture, or was made by a different emulator version!");
+        return -3;
+    }
+
+    bool first = true;
+
+    if (as_json) {
+        fmt::print("[");
+    }
+
+    for (const loader::btrace::record &rec : records) {
+        if (!filter.test(loader::btrace::get_header_field(rec.args_[0], loader::btrace::header_category_index))) {
+            continue;
+        }
+
+        if (as_json) {
+            print_record_json(rec, first);
+        } else {
+            print_record_text(rec);
+        }
+
+        first = false;
+    }
+
+    if (as_json) {
+        fmt::print("\n]\n");
+    }
+
+    return 0;
+}